@@ -1104,6 +1104,20 @@ inline static void pcm_write(const int16_t *samples, int count) { // 450
     ((fn_ptr_t)_sys_table_ptrs[450])(samples, count);
 }
 
+/* Sound mixer channels — snd_open() returns the channel ID or -1 */
+inline static int snd_open(uint32_t sample_rate) { // 483
+    typedef int (*fn_ptr_t)(uint32_t);
+    return ((fn_ptr_t)_sys_table_ptrs[483])(sample_rate);
+}
+inline static void snd_write(int ch, const int16_t *samples, int frames) { // 484
+    typedef void (*fn_ptr_t)(int, const int16_t *, int);
+    ((fn_ptr_t)_sys_table_ptrs[484])(ch, samples, frames);
+}
+inline static void snd_close(int ch) { // 485
+    typedef void (*fn_ptr_t)(int);
+    ((fn_ptr_t)_sys_table_ptrs[485])(ch);
+}
+
 // since API v.30 — MOD playback (HxCModPlayer)
 #include "hxcmod.h"
 
@@ -1148,6 +1162,67 @@ inline static bool psram_is_available(void) { // 493
     return ((fn_ptr_t)_sys_table_ptrs[493])();
 }
 
+// PSRAM allocator statistics: class k covers chunks of [2^k, 2^(k+1))
+// bytes, 8-byte header included
+#define PSRAM_NCLASSES 32
+typedef struct {
+    uint32_t allocs;
+    uint32_t frees;
+    uint32_t failures;
+    uint32_t in_use;
+    uint32_t free_blocks;
+} psram_class_stats_t;
+typedef struct {
+    uint32_t total_bytes;
+    uint32_t free_bytes;
+    uint32_t largest_free;
+    psram_class_stats_t classes[PSRAM_NCLASSES];
+} psram_stats_t;
+inline static void psram_get_stats(psram_stats_t *out) { // 556
+    typedef void (*fn_ptr_t)(psram_stats_t *);
+    ((fn_ptr_t)_sys_table_ptrs[556])(out);
+}
+
+// Sound mixer: per-channel gain (SND_GAIN_UNITY = unchanged, up to twice
+// that) and pan (-127 left .. 0 centre .. 127 right)
+#define SND_GAIN_UNITY 256
+inline static void snd_set_gain(int ch, uint16_t gain, int8_t pan) { // 557
+    typedef void (*fn_ptr_t)(int, uint16_t, int8_t);
+    ((fn_ptr_t)_sys_table_ptrs[557])(ch, gain, pan);
+}
+
+// Mixer load, measured in the DMA IRQ
+typedef struct {
+    uint32_t fills;       // DMA buffers mixed
+    uint32_t last_us;     // time spent on the last one
+    uint32_t max_us;      // ... the worst one
+    uint32_t total_us;    // ... all of them
+    uint32_t budget_us;   // play time of one buffer
+    uint32_t starved;     // frames an open channel had no data for
+} snd_stats_t;
+inline static void snd_get_stats(snd_stats_t *st) { // 558
+    typedef void (*fn_ptr_t)(snd_stats_t *);
+    ((fn_ptr_t)_sys_table_ptrs[558])(st);
+}
+
+// Sound channel with its own ring (PSRAM when present): frames rounded
+// up to a power of 2, plus span frames snd_acquire() may run past the end
+inline static int snd_open_ring(uint32_t sample_rate, uint32_t frames, uint32_t span) { // 559
+    typedef int (*fn_ptr_t)(uint32_t, uint32_t, uint32_t);
+    return ((fn_ptr_t)_sys_table_ptrs[559])(sample_rate, frames, span);
+}
+
+// Decode straight into the channel ring: wait for max_frames free frames,
+// fill *ptr with stereo frames, publish them with snd_commit()
+inline static int snd_acquire(int ch, int16_t **ptr, int max_frames) { // 560
+    typedef int (*fn_ptr_t)(int, int16_t **, int);
+    return ((fn_ptr_t)_sys_table_ptrs[560])(ch, ptr, max_frames);
+}
+inline static void snd_commit(int ch, int frames) { // 561
+    typedef void (*fn_ptr_t)(int, int);
+    ((fn_ptr_t)_sys_table_ptrs[561])(ch, frames);
+}
+
 #define abs(x) (x > 0 ? x : -x)
 
 extern volatile bool marked_to_exit;
@@ -35,6 +35,7 @@ extern "C" {
 #define EMFILE    24  /* Too many open files per process */
 #define ENOSPC    28  /* No space left on device */
 #define ESPIPE    29  /* Illegal seek */
+#define EPIPE     32  /* Broken pipe */
 #define ERANGE    34
 #define ENAMETOOLONG    36
 #define ENOSYS          38
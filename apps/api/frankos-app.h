@@ -1066,6 +1066,12 @@ static inline void wd_radio(int16_t x, int16_t y, const char *label,
     ((fn_t)_sys_table_ptrs[554])(x, y, label, selected);
 }
 
+/* 555: wm_invalidate_rect — repaint only rect r (client coordinates) */
+static inline void wm_invalidate_rect(hwnd_t hwnd, rect_t r) {
+    typedef void (*fn_t)(hwnd_t, rect_t);
+    ((fn_t)_sys_table_ptrs[555])(hwnd, r);
+}
+
 /* Count UTF-8 characters (not bytes) for width calculations */
 static inline int gfx_utf8_charcount(const char *str) {
     int count = 0;
@@ -83,8 +83,14 @@ static inline int fa_rand(void) {
 #define READ_BUF_SIZE  8192
 #define MAX_FRAME_SAMP 1152    /* max samples/channel for MPEG1 Layer3 */
 
-/* PCM output buffer: one MP3 frame stereo + padding for DMA overread */
-#define PCM_BUF_LEN    (MAX_FRAME_SAMP * 2 + 1024)
+/* PCM buffer for the first MP3 frame, decoded before the channel opens */
+#define PCM_BUF_LEN    (MAX_FRAME_SAMP * 2)
+
+/* Output ring: ~186 ms at 44100 Hz, with a span so every decode fits in
+ * one piece; halved down to RING_MIN_FRAMES when memory is short */
+#define RING_FRAMES     8192
+#define RING_MIN_FRAMES 2048
+#define CHUNK_FRAMES    1024   /* MOD/MIDI render size, ~23 ms at 44100 Hz */
 
 /* 7-segment digit dimensions */
 #define DIGIT_W  13
@@ -161,7 +167,8 @@ typedef struct {
     HMP3Decoder     decoder;
     FIL             mp3_file;
     bool            file_open;
-    bool            audio_active;    /* pcm_init called */
+    bool            audio_active;    /* snd_ch is open */
+    int             snd_ch;
 
     /* MOD playback state */
     modcontext      mod_ctx;
@@ -175,7 +182,7 @@ typedef struct {
     uint8_t         read_buf[READ_BUF_SIZE];
     int             read_valid, read_offset;
 
-    /* PCM decode buffer — one frame, written to DMA via pcm_write */
+    /* First MP3 frame, decoded before the sample rate is known */
     int16_t         pcm_buf[PCM_BUF_LEN];
 
     /* Track info */
@@ -199,8 +206,8 @@ typedef struct {
     char            pending_path[MAX_PATH_LEN];
 
     /* Deferred command from event handler (compositor task) — executed
-     * in the main loop (app task) so pcm_init/pcm_cleanup use the
-     * correct FreeRTOS thread-local storage for the snd channel. */
+     * in the main loop (app task), the only task that writes to or
+     * closes the snd channel. */
     volatile int8_t pending_cmd;  /* 0=none, 1=play, 2=stop, 3=next, 4=prev */
 
     /* System */
@@ -276,14 +283,9 @@ static int refill_read_buf(frankamp_t *fa) {
     return fa->read_valid;
 }
 
-/* Decode one MP3 frame into fa->pcm_buf.
+/* Decode one MP3 frame into out (room for MAX_FRAME_SAMP stereo frames).
  * Returns the number of stereo frames decoded, or -1 on error/EOF. */
-static int decode_frame(frankamp_t *fa) {
-    int16_t *out = fa->pcm_buf;
-
-    /* Zero the buffer (including padding) for clean DMA overreads */
-    memset(out, 0, PCM_BUF_LEN * sizeof(int16_t));
-
+static int decode_frame(frankamp_t *fa, int16_t *out) {
     for (int retry = 0; retry < 10; retry++) {
         /* Ensure we have data */
         if (fa->read_valid - fa->read_offset < 512) {
@@ -374,29 +376,24 @@ static audio_format_t detect_format(const char *path) {
  * MOD decoding
  *=========================================================================*/
 
-#define MOD_CHUNK_FRAMES  1024  /* ~23ms at 44100 Hz */
-
-static int decode_frame_mod(frankamp_t *fa) {
-    hxcmod_fillbuffer(&fa->mod_ctx, (msample *)fa->pcm_buf,
-                      MOD_CHUNK_FRAMES, 0);
+static int decode_frame_mod(frankamp_t *fa, int16_t *out) {
+    hxcmod_fillbuffer(&fa->mod_ctx, (msample *)out, CHUNK_FRAMES, 0);
     /* Apply volume */
     if (fa->volume < 100) {
         int shift = ((100 - fa->volume) * 8 + 50) / 100;
         if (shift > 0)
-            for (int i = 0; i < MOD_CHUNK_FRAMES * 2; i++)
-                fa->pcm_buf[i] >>= shift;
+            for (int i = 0; i < CHUNK_FRAMES * 2; i++)
+                out[i] >>= shift;
     }
-    return MOD_CHUNK_FRAMES;
+    return CHUNK_FRAMES;
 }
 
 /*==========================================================================
  * MIDI decoding
  *=========================================================================*/
 
-#define MIDI_CHUNK_FRAMES  1024  /* ~23ms at 44100 Hz */
-
-static int decode_frame_midi(frankamp_t *fa) {
-    int nf = midi_opl_render(fa->midi, fa->pcm_buf, MIDI_CHUNK_FRAMES);
+static int decode_frame_midi(frankamp_t *fa, int16_t *out) {
+    int nf = midi_opl_render(fa->midi, out, CHUNK_FRAMES);
     if (nf > 0) {
         /* Apply OPL gain (×8) and user volume in one 32-bit step.
          * The OPL output is already >>1 and clamped to int16 (±18k peak
@@ -408,16 +405,48 @@ static int decode_frame_midi(frankamp_t *fa) {
                       : 0;
         int net_shift = 4 - vol_shift;  /* <<4 base gain minus >>vol attenuation */
         for (int i = 0; i < nf * 2; i++) {
-            int32_t s = fa->pcm_buf[i];
+            int32_t s = out[i];
             s = (net_shift >= 0) ? (s << net_shift) : (s >> -net_shift);
             if (s > 32767) s = 32767;
             else if (s < -32768) s = -32768;
-            fa->pcm_buf[i] = (int16_t)s;
+            out[i] = (int16_t)s;
         }
     }
     return nf;
 }
 
+/*==========================================================================
+ * Audio output — decoders render straight into the channel's ring
+ *=========================================================================*/
+
+static bool audio_open(frankamp_t *fa, int rate) {
+    fa->snd_ch = -1;
+    for (int frames = RING_FRAMES; frames >= RING_MIN_FRAMES && fa->snd_ch < 0;
+         frames /= 2)
+        fa->snd_ch = snd_open_ring(rate, frames, MAX_FRAME_SAMP);
+    fa->audio_active = fa->snd_ch >= 0;
+    if (!fa->audio_active)
+        dbg_printf("[frankamp] no sound channel\n");
+    return fa->audio_active;
+}
+
+static void audio_close(frankamp_t *fa) {
+    if (fa->audio_active) {
+        snd_close(fa->snd_ch);
+        fa->audio_active = false;
+    }
+}
+
+/* Room for frames stereo frames in the ring, waiting while it is full.
+ * The span behind the ring keeps it in one piece; NULL if the channel
+ * is gone. */
+static int16_t *audio_acquire(frankamp_t *fa, int frames) {
+    int16_t *out;
+    if (snd_acquire(fa->snd_ch, &out, frames) < frames)
+        return NULL;
+    return out;
+}
+
 /*==========================================================================
  * Playback control
  *=========================================================================*/
@@ -428,10 +457,7 @@ static void play_stop(frankamp_t *fa) {
 
     fa->play_state = PS_STOPPED;
 
-    if (fa->audio_active) {
-        pcm_cleanup();
-        fa->audio_active = false;
-    }
+    audio_close(fa);
 
     if (fa->format == FMT_MIDI) {
         if (fa->midi) {
@@ -490,14 +516,13 @@ static bool play_start(frankamp_t *fa, int playlist_idx) {
         fa->total_ms = 0;  /* MIDI duration unknown */
         fa->elapsed_ms = 0;
 
-        pcm_init(44100, 2);
-        fa->audio_active = true;
+        if (!audio_open(fa, 44100)) {
+            midi_opl_free(fa->midi);
+            fa->midi = 0;
+            return false;
+        }
         fa->play_state = PS_PLAYING;
 
-        /* Decode and write first chunk to kick off DMA */
-        int nf = decode_frame_midi(fa);
-        if (nf > 0) pcm_write(fa->pcm_buf, nf);
-
         dbg_printf("[frankamp] playing MIDI: %s (44100 Hz, stereo, OPL FM)\n",
                    path);
     } else if (fa->format == FMT_MOD) {
@@ -545,14 +570,14 @@ static bool play_start(frankamp_t *fa, int playlist_idx) {
         fa->total_ms = 0;  /* MOD loops — no fixed duration */
         fa->elapsed_ms = 0;
 
-        pcm_init(44100, 2);
-        fa->audio_active = true;
+        if (!audio_open(fa, 44100)) {
+            hxcmod_unload(&fa->mod_ctx);
+            psram_free(fa->mod_data);
+            fa->mod_data = 0;
+            return false;
+        }
         fa->play_state = PS_PLAYING;
 
-        /* Decode and write first chunk to kick off DMA */
-        int nf = decode_frame_mod(fa);
-        pcm_write(fa->pcm_buf, nf);
-
         dbg_printf("[frankamp] playing MOD: %s (44100 Hz, stereo)\n", path);
     } else {
         /* === MP3 playback === */
@@ -576,7 +601,7 @@ static bool play_start(frankamp_t *fa, int playlist_idx) {
         fa->read_offset = 0;
         skip_id3v2(fa);
 
-        int nf = decode_frame(fa);
+        int nf = decode_frame(fa, fa->pcm_buf);
         if (nf <= 0) {
             dbg_printf("[frankamp] first decode failed\n");
             play_stop(fa);
@@ -588,11 +613,17 @@ static bool play_start(frankamp_t *fa, int playlist_idx) {
 
         int sr = fa->info.samprate;
         if (sr <= 0) sr = 44100;
-        pcm_init(sr, 2);
-        fa->audio_active = true;
-        fa->play_state = PS_PLAYING;
+        fa->play_state = PS_PLAYING;     /* so play_stop() cleans up */
+        if (!audio_open(fa, sr)) {
+            play_stop(fa);
+            return false;
+        }
 
-        pcm_write(fa->pcm_buf, nf);
+        int16_t *out = audio_acquire(fa, nf);
+        if (out) {
+            memcpy(out, fa->pcm_buf, (size_t)nf * 4);
+            snd_commit(fa->snd_ch, nf);
+        }
 
         dbg_printf("[frankamp] playing: %s (%d Hz, %d kbps, %d ch)\n",
                    path, fa->info.samprate, fa->info.bitrate / 1000,
@@ -640,25 +671,30 @@ static void play_prev(frankamp_t *fa) {
     play_start(fa, prev);
 }
 
-/* Decode one frame and push to I2S (blocking).  Returns false at EOF. */
+/* Decode one frame into the ring (blocking while it is full).
+ * Returns false at EOF. */
 static bool audio_step(frankamp_t *fa) {
+    int16_t *out = audio_acquire(fa, fa->format == FMT_MP3 ? MAX_FRAME_SAMP
+                                                           : CHUNK_FRAMES);
+    if (!out)
+        return false;
     if (fa->format == FMT_MIDI) {
-        int nf = decode_frame_midi(fa);
+        int nf = decode_frame_midi(fa, out);
         if (nf <= 0) return false;
-        pcm_write(fa->pcm_buf, nf);
+        snd_commit(fa->snd_ch, nf);
         fa->elapsed_ms += nf * 1000 / 44100;
         return midi_opl_playing(fa->midi);
     }
     if (fa->format == FMT_MOD) {
-        int nf = decode_frame_mod(fa);
-        pcm_write(fa->pcm_buf, nf);
-        fa->elapsed_ms += MOD_CHUNK_FRAMES * 1000 / 44100;
+        int nf = decode_frame_mod(fa, out);
+        snd_commit(fa->snd_ch, nf);
+        fa->elapsed_ms += CHUNK_FRAMES * 1000 / 44100;
         return true;  /* MOD loops forever */
     }
-    int nf = decode_frame(fa);
+    int nf = decode_frame(fa, out);
     if (nf <= 0)
         return false;
-    pcm_write(fa->pcm_buf, nf);
+    snd_commit(fa->snd_ch, nf);
     fa->elapsed_ms += (uint32_t)((uint64_t)nf * 1000 / fa->info.samprate);
     return true;
 }
@@ -1137,9 +1173,9 @@ static bool hit_rem_btn(int16_t mx, int16_t my) {
  * Action helpers (shared by event handler, menu, and keyboard)
  *=========================================================================*/
 
-/* Defer playback commands to the main loop (app task context) so that
- * pcm_init / pcm_cleanup use the correct FreeRTOS thread-local storage.
- * The event handler runs in the compositor task — wrong TLS for audio. */
+/* Defer playback commands to the main loop (app task context).  The
+ * event handler runs in the compositor task, and closing the channel
+ * there would free the ring while the app task decodes into it. */
 #define PCMD_NONE 0
 #define PCMD_PLAY 1
 #define PCMD_STOP 2
@@ -1487,13 +1523,11 @@ static bool main_event(hwnd_t hwnd, const window_event_t *ev) {
     if (ev->type == WM_CLOSE) {
         dbg_printf("[frankamp] WM_CLOSE\n");
 
-        /* Stop audio DMA to unblock any blocked pcm_write() in the app task.
-         * Do NOT free MIDI/MP3/MOD resources here — the app task may still
-         * be inside audio_step(). Cleanup happens after the main loop exits. */
-        if (fa->audio_active) {
-            pcm_cleanup();
-            fa->audio_active = false;
-        }
+        /* Do NOT close the channel or free MIDI/MP3/MOD resources here —
+         * the app task may still be inside audio_step(), decoding into the
+         * ring.  The DMA keeps draining it, so a waiting snd_acquire()
+         * returns within one ring's play time; cleanup happens after the
+         * main loop exits. */
 
         if (fa->ui_timer) {
             xTimerStop(fa->ui_timer, portMAX_DELAY);
@@ -1690,7 +1724,7 @@ int main(int argc, char **argv) {
         }
 
         /* Process deferred transport commands (must run in app task
-         * context so pcm_init/pcm_cleanup use the correct TLS). */
+         * context, which owns the snd channel). */
         if (fa->pending_cmd) {
             int8_t cmd = fa->pending_cmd;
             fa->pending_cmd = PCMD_NONE;
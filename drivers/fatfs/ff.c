@@ -22,10 +22,12 @@
 #include <string.h>
 #include "ff.h"			/* Declarations of FatFs API */
 #include "diskio.h"		/* Declarations of device I/O functions */
+#include "ffcache.h"		/* Sector cache below diskio */
 
 #include "FreeRTOS.h"
 #include "task.h"
 #include "queue.h"
+#include "psram.h"
 
 #include "graphics.h"
 #include "sys_table.h"
@@ -1050,9 +1052,10 @@ static FRESULT __in_hfa() sync_window (	/* Returns FR_OK or FR_DISK_ERR */
 #endif
 
 
-static FRESULT __in_hfa() move_window (	/* Returns FR_OK or FR_DISK_ERR */
+static FRESULT __in_hfa() move_window_cls (	/* Returns FR_OK or FR_DISK_ERR */
 	FATFS* fs,		/* Filesystem object */
-	LBA_t sect		/* Sector LBA to make appearance in the fs->win[] */
+	LBA_t sect,		/* Sector LBA to make appearance in the fs->win[] */
+	BYTE cls		/* Sector class for the cache (FFC_META/FFC_DATA) */
 )
 {
 	FRESULT res = FR_OK;
@@ -1063,7 +1066,7 @@ static FRESULT __in_hfa() move_window (	/* Returns FR_OK or FR_DISK_ERR */
 		res = sync_window(fs);		/* Flush the window */
 #endif
 		if (res == FR_OK) {			/* Fill sector window with new data */
-			if (disk_read(fs->pdrv, fs->win, sect, 1) != RES_OK) {
+			if (ffc_read(fs->pdrv, fs->win, sect, cls) != RES_OK) {
 				sect = (LBA_t)0 - 1;	/* Invalidate window if read data is not valid */
 				res = FR_DISK_ERR;
 			}
@@ -1073,6 +1076,20 @@ static FRESULT __in_hfa() move_window (	/* Returns FR_OK or FR_DISK_ERR */
 	return res;
 }
 
+/* FAT, directory and boot sectors */
+static FRESULT __in_hfa() move_window (FATFS* fs, LBA_t sect)
+{
+	return move_window_cls(fs, sect, FFC_META);
+}
+
+#if FF_FS_TINY
+/* File data */
+static FRESULT __in_hfa() move_data_window (FATFS* fs, LBA_t sect)
+{
+	return move_window_cls(fs, sect, FFC_DATA);
+}
+#endif
+
 
 
 
@@ -3845,10 +3862,8 @@ FRESULT __in_hfa() f_open (
 	BYTE mode			/* Access mode and open mode flags */
 )
 {
-    vTaskSuspendAll();;
 	FRESULT res = _f_open(fp, path, mode);
 	fp->chained = 0;
-	xTaskResumeAll();;
 	return res;
 }
 
@@ -3939,7 +3954,7 @@ inline static FRESULT __always_inline(_f_read) (
 		rcnt = SS(fs) - (UINT)fp->fptr % SS(fs);	/* Number of bytes remains in the sector */
 		if (rcnt > btr) rcnt = btr;					/* Clip it by btr if needed */
 #if FF_FS_TINY
-		if (move_window(fs, fp->sect) != FR_OK) ABORT(fs, FR_DISK_ERR);	/* Move sector window */
+		if (move_data_window(fs, fp->sect) != FR_OK) ABORT(fs, FR_DISK_ERR);	/* Move sector window */
 		memcpy(rbuff, fs->win + fp->fptr % SS(fs), rcnt);	/* Extract partial sector */
 #else
 		memcpy(rbuff, fp->buf + fp->fptr % SS(fs), rcnt);	/* Extract partial sector */
@@ -3948,28 +3963,221 @@ inline static FRESULT __always_inline(_f_read) (
 	LEAVE_FF(fs, FR_OK);
 }
 
+/*-----------------------------------------------------------------------*/
+/* Pipes                                                                 */
+/*-----------------------------------------------------------------------*/
+/* f_open_pipe() joins two FILs through one PIPE, kept in fptr of both ends
+/  (clust 1 marks the read end). The ring has a single producer and a single
+/  consumer: only the writer moves head and only the reader moves tail, so
+/  blocks are copied without locking. An end that has to wait parks its task
+/  handle and sleeps on a task notification; the other end wakes it after
+/  moving head or tail, and on close. The last end to close frees the pipe. */
+
+typedef struct {
+	BYTE*	buf;
+	UINT	size;						/* Ring size (power of 2) */
+	volatile UINT	head;				/* Bytes written so far */
+	volatile UINT	tail;				/* Bytes read so far */
+	TaskHandle_t volatile	reader;		/* Task waiting for data */
+	TaskHandle_t volatile	writer;		/* Task waiting for space */
+	volatile BYTE	rclosed;
+	volatile BYTE	wclosed;
+} PIPE;
+
+#define PIPE_OF(fp)		((PIPE*)(uintptr_t)(fp)->fptr)
+#define PIPE_WAIT		pdMS_TO_TICKS(100)	/* Re-check period of a blocked end */
+
+static void pipe_wake (TaskHandle_t volatile* waiter)
+{
+	TaskHandle_t th;
+
+	__sync_synchronize();	/* Publish head/tail/closed before looking at the waiter */
+	th = *waiter;
+	if (th) xTaskNotifyGive(th);
+}
+
+/* Park on waiter until ready() may have changed */
+static void pipe_sleep (PIPE* p, TaskHandle_t volatile* waiter, bool (*ready)(PIPE*))
+{
+	*waiter = xTaskGetCurrentTaskHandle();
+	__sync_synchronize();
+	if (!ready(p)) ulTaskNotifyTake(pdTRUE, PIPE_WAIT);
+	*waiter = 0;
+}
+
+static bool pipe_readable (PIPE* p)
+{
+	return p->head != p->tail || p->wclosed;
+}
+
+static bool pipe_writable (PIPE* p)
+{
+	return p->head - p->tail < p->size || p->rclosed;
+}
+
+/* Wait for data and copy out up to btr bytes; 0 when the writer has closed
+/  and the ring is drained */
+static UINT pipe_read (PIPE* p, BYTE* buff, UINT btr)
+{
+	UINT n, t, ofs, c;
+
+	while (!pipe_readable(p)) pipe_sleep(p, &p->reader, pipe_readable);
+	__sync_synchronize();	/* head may have moved just before wclosed was set */
+	t = p->tail;
+	n = MIN(p->head - t, btr);
+	ofs = t & (p->size - 1);
+	c = MIN(n, p->size - ofs);
+	memcpy(buff, p->buf + ofs, c);
+	memcpy(buff + c, p->buf, n - c);
+	__sync_synchronize();	/* Finish copying before handing the space back */
+	p->tail = t + n;
+	if (n) pipe_wake(&p->writer);
+	return n;
+}
+
+/* Copy in all of btw, waiting for space as needed; FR_DENIED once the
+/  reader has closed */
+static FRESULT pipe_write (PIPE* p, const BYTE* buff, UINT btw, UINT* bw)
+{
+	UINT n, h, ofs, c;
+
+	*bw = 0;
+	while (btw) {
+		while (!pipe_writable(p)) pipe_sleep(p, &p->writer, pipe_writable);
+		if (p->rclosed) return FR_DENIED;
+		h = p->head;
+		n = MIN(p->size - (h - p->tail), btw);
+		ofs = h & (p->size - 1);
+		c = MIN(n, p->size - ofs);
+		memcpy(p->buf + ofs, buff, c);
+		memcpy(p->buf, buff + c, n - c);
+		__sync_synchronize();	/* Data before the new head */
+		p->head = h + n;
+		pipe_wake(&p->reader);
+		buff += n; btw -= n; *bw += n;
+	}
+	return FR_OK;
+}
+
+static void pipe_close (FIL* fp)
+{
+	PIPE* p = PIPE_OF(fp);
+	bool last;
+
+	fp->fptr = 0;
+	if (!p) return;
+	vTaskSuspendAll();
+	if (fp->clust) {
+		p->rclosed = 1;
+		last = p->wclosed;
+		if (!last) pipe_wake(&p->writer);
+	} else {
+		p->wclosed = 1;
+		last = p->rclosed;
+		if (!last) pipe_wake(&p->reader);
+	}
+	xTaskResumeAll();
+	if (last) {
+		psram_free(p->buf);
+		vPortFree(p);
+	}
+}
+
+bool __in_hfa() f_is_pipe (FIL* fp)
+{
+	return (uintptr_t)fp > 2 && fp->chained;
+}
+
+int __in_hfa() f_pipe_avail (FIL* fp)
+{
+	PIPE* p = PIPE_OF(fp);
+	UINT n;
+
+	if (!p) return -1;
+	if (fp->clust) {
+		if (p->head != p->tail) return p->head - p->tail;
+		if (!p->wclosed) return 0;
+		__sync_synchronize();
+		n = p->head - p->tail;
+		return n ? (int)n : -1;
+	}
+	if (p->rclosed) return -1;
+	return p->size - (p->head - p->tail);
+}
+
+void __in_hfa() f_pipe_set_waiter (FIL* fp, void* task)
+{
+	PIPE* p = PIPE_OF(fp);
+
+	if (!p) return;
+	if (fp->clust) p->reader = (TaskHandle_t)task;
+	else p->writer = (TaskHandle_t)task;
+	__sync_synchronize();
+}
+
 int  __in_hfa() f_getc(FIL* fp) {
 	uint8_t c;
 	int res = -1;
 	if  (fp->chained && fp->clust) { // "from" in pipe
-		if(!fp->fptr || (fp->sect && 0 == uxQueueMessagesWaiting(fp->fptr))) { // already closed or chained closed and empty queue
-			return -1;
-		}
-	//     goutf("f_getc: %p\n", fp->chained);
-		xQueueReceive(fp->fptr, &c, portMAX_DELAY);
-		res = c;
-    //     goutf("f_getc passed: %d\n", res);
+		if (fp->fptr && pipe_read(PIPE_OF(fp), &c, 1)) res = c;
 	} else {
 		UINT br;
-	    vTaskSuspendAll();;
-	    if (FR_OK == _f_read(fp, &c, 1, &br)) {
+		if (f_read(fp, &c, 1, &br) == FR_OK && br == 1) {
 			res = c;
 		}
-      	xTaskResumeAll();;
 	}
 	return res;
 }
 
+#if FF_FS_REENTRANT
+/* Let tasks waiting for the volume in between slices of a long transfer */
+static void yield_volume (void)
+{
+	if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING) taskYIELD();
+}
+#endif
+
+#if FF_FS_REENTRANT && FF_FS_TINY
+/* The part of a read that needs no volume lock: bytes in the current
+/  cluster of the file whose sectors the sector cache holds. Only the file
+/  object and the mount geometry are used, so a reader isn't held up while
+/  another task keeps the volume busy with a write. Stops at the first
+/  sector that needs the FAT, the window or the device. */
+static UINT read_cached (
+	FIL* fp,
+	BYTE* rbuff,
+	UINT btr
+)
+{
+	FATFS *fs = fp->obj.fs;
+	FSIZE_t remain;
+	LBA_t sect;
+	UINT rcnt, ofs, csect, n = 0;
+
+	if (!fs || !fs->fs_type || fp->obj.id != fs->id || fp->err || !(fp->flag & FA_READ)) return 0;
+	remain = fp->obj.objsize - fp->fptr;
+	if (btr > remain) btr = (UINT)remain;
+	while (btr > 0) {
+		ofs = (UINT)(fp->fptr % SS(fs));
+		csect = (UINT)(fp->fptr / SS(fs) & (fs->csize - 1));
+		if (ofs == 0 && csect == 0) break;		/* Next cluster: the FAT is needed */
+		sect = clst2sect(fs, fp->clust);
+		if (sect == 0) break;
+		sect += csect;
+		if (fs->winsect == sect) break;			/* The window may hold it newer */
+		rcnt = SS(fs) - ofs;
+		if (rcnt > btr) rcnt = btr;
+		if (!ffc_peek(fs->pdrv, rbuff, sect, ofs, rcnt)) break;
+		fp->sect = sect;
+		fp->fptr += rcnt;
+		rbuff += rcnt;
+		btr -= rcnt;
+		n += rcnt;
+	}
+	return n;
+}
+#endif
+
 FRESULT __in_hfa() f_read (
 	FIL* fp, 	/* Open file to be read */
 	void* buff,	/* Data buffer to store the read data */
@@ -3985,25 +4193,29 @@ FRESULT __in_hfa() f_read (
 		// TODO:
 		return FR_INVALID_DRIVE;
 	}
-	FRESULT res;
-	vTaskSuspendAll();;
+	FRESULT res = FR_OK;
+	BYTE *rbuff = (BYTE*)buff;
+	UINT n, got;
 	if  (fp->chained && fp->clust) { // "from" in pipe
-	    uint32_t sz = uxQueueMessagesWaiting(fp->fptr);
-		if(!fp->fptr || (fp->sect && 0 == sz)) { // already closed or chained closed and empty queue
-			return -1;
-		}
-		sz = MIN(sz, btr);
-	    // goutf("f_read: %p\n", fp->chained);
-		for(int i = 0; i < sz; ++i) { // todo: uxQueueMessagesWaiting
-			xQueueReceive(fp->fptr, buff + i, portMAX_DELAY);
-		}
-		res = FR_OK;
-		*br = sz;
-        // goutf("f_read passed: %d\n", *br);
-	} else {
-	    res = _f_read(fp, buff, btr, br);
+		/* Blocks until there is data; -1 with nothing read at the end */
+		*br = fp->fptr ? pipe_read(PIPE_OF(fp), buff, btr) : 0;
+		return *br || !btr ? FR_OK : (FRESULT)-1;
+	}
+	*br = 0;
+	for (;;) {
+#if FF_FS_REENTRANT && FF_FS_TINY
+		n = read_cached(fp, rbuff, btr);
+		rbuff += n; btr -= n; *br += n;
+		if (n && !btr) break;
+#endif
+		n = (FF_FS_SLICE && btr > FF_FS_SLICE) ? FF_FS_SLICE : btr;
+		res = _f_read(fp, rbuff, n, &got);
+		rbuff += got; btr -= got; *br += got;
+		if (res != FR_OK || got < n || !btr) break;
+#if FF_FS_REENTRANT
+		yield_volume();
+#endif
 	}
-	xTaskResumeAll();;
 	return res;
 }
 
@@ -4112,7 +4324,7 @@ inline static FRESULT __always_inline (_f_write) (
 		wcnt = SS(fs) - (UINT)fp->fptr % SS(fs);	/* Number of bytes remains in the sector */
 		if (wcnt > btw) wcnt = btw;					/* Clip it by btw if needed */
 #if FF_FS_TINY
-		if (move_window(fs, fp->sect) != FR_OK) ABORT(fs, FR_DISK_ERR);	/* Move sector window */
+		if (move_data_window(fs, fp->sect) != FR_OK) ABORT(fs, FR_DISK_ERR);	/* Move sector window */
 		memcpy(fs->win + fp->fptr % SS(fs), wbuff, wcnt);	/* Fit data to the sector */
 		fs->wflag = 1;
 #else
@@ -4133,23 +4345,25 @@ FRESULT __in_hfa() f_write (
 )
 {
 	FRESULT res;
+	const BYTE *wbuff = (const BYTE*)buff;
+	UINT n, done;
 	if (fp->chained) {
-	    // goutf("f_write: %p (%d)\n", fp->chained, btw);
 		if (!fp->fptr) {
 			*bw = 0;
-	        // goutf("f_write: %p (%d) failed\n", fp->chained, btw);
 			return FR_DENIED;
 		}
-		for (uint32_t off = 0; off < btw; ++off) {
-			xQueueSend(fp->fptr, buff + off, portMAX_DELAY);
-		}
-	    // goutf("f_write: %p (%d) passed\n", fp->chained, btw);
-		*bw = btw;
-		res = FR_OK;
+		res = pipe_write(PIPE_OF(fp), buff, btw, bw);
 	} else {
-		vTaskSuspendAll();;
-		res = _f_write(fp, buff, btw, bw);
-		xTaskResumeAll();;
+		*bw = 0;
+		for (;;) {
+			n = (FF_FS_SLICE && btw > FF_FS_SLICE) ? FF_FS_SLICE : btw;
+			res = _f_write(fp, wbuff, n, &done);
+			wbuff += done; btw -= done; *bw += done;
+			if (res != FR_OK || done < n || !btw) break;
+#if FF_FS_REENTRANT
+			yield_volume();
+#endif
+		}
 	}
 	return res;
 }
@@ -4234,9 +4448,7 @@ inline static FRESULT __always_inline (_f_sync) (
 FRESULT  __in_hfa() f_sync (
 	FIL* fp		/* Open file to be synced */
 ) {
-	vTaskSuspendAll();;
 	FRESULT res = _f_sync(fp);
-	xTaskResumeAll();;
 	return res;
 }
 
@@ -4256,14 +4468,10 @@ FRESULT  __in_hfa() f_close (
 	FRESULT res;
 	FATFS *fs;
     if(fp->chained) {
-		// goutf("f_close[%p]\n", fp);
-        fp->chained->sect = 1; // notify chained
-		if(fp->fptr && fp->clust) vQueueDelete(fp->fptr);
-		fp->fptr = 0;
-		return FR_OK;
-	}
+        pipe_close(fp);
+        return FR_OK;
+    }
 
-	vTaskSuspendAll();;
 #if !FF_FS_READONLY
 	res = f_sync(fp);					/* Flush cached data */
 	if (res == FR_OK)
@@ -4282,7 +4490,6 @@ FRESULT  __in_hfa() f_close (
 #endif
 		}
 	}
-	xTaskResumeAll();;
 	return res;
 }
 
@@ -4322,7 +4529,6 @@ FRESULT f_chdir (
 	FATFS *fs;
 	DEF_NAMBUF
 
-	vTaskSuspendAll();;
 	/* Get logical drive */
 	res = mount_volume(&path, &fs, 0);
 	if (res == FR_OK) {
@@ -4366,7 +4572,6 @@ FRESULT f_chdir (
 		}
 #endif
 	}
-	xTaskResumeAll();;
 	LEAVE_FF(fs, res);
 }
 
@@ -4487,7 +4692,6 @@ FRESULT __in_hfa() f_lseek (
 	DWORD *tbl;
 	LBA_t dsc;
 #endif
-	vTaskSuspendAll();;
 	res = validate(&fp->obj, &fs);		/* Check validity of the file object */
 	if (res == FR_OK) res = (FRESULT)fp->err;
 #if FF_FS_EXFAT && !FF_FS_READONLY
@@ -4496,7 +4700,6 @@ FRESULT __in_hfa() f_lseek (
 	}
 #endif
 	if (res != FR_OK) {
-		xTaskResumeAll();;
 		LEAVE_FF(fs, res);
 	}
 
@@ -4628,7 +4831,6 @@ FRESULT __in_hfa() f_lseek (
 			fp->sect = nsect;
 		}
 	}
-	xTaskResumeAll();;
 	LEAVE_FF(fs, res);
 }
 
@@ -4650,7 +4852,6 @@ FRESULT  __in_hfa() f_opendir (
 
 	if (!dp) return FR_INVALID_OBJECT;
 
-	vTaskSuspendAll();;
 	/* Get logical drive */
 	res = mount_volume(&path, &fs, 0);
 	if (res == FR_OK) {
@@ -4694,7 +4895,6 @@ FRESULT  __in_hfa() f_opendir (
 		if (res == FR_NO_FILE) res = FR_NO_PATH;
 	}
 	if (res != FR_OK) dp->obj.fs = 0;		/* Invalidate the directory object if function faild */
-	xTaskResumeAll();;
 	LEAVE_FF(fs, res);
 }
 
@@ -4712,7 +4912,6 @@ FRESULT  __in_hfa() f_closedir (
 	FRESULT res;
 	FATFS *fs;
 
-    vTaskSuspendAll();;
 
 	res = validate(&dp->obj, &fs);	/* Check validity of the file object */
 	if (res == FR_OK) {
@@ -4726,7 +4925,6 @@ FRESULT  __in_hfa() f_closedir (
 		unlock_fs(fs, FR_OK);		/* Unlock volume */
 #endif
 	}
-	xTaskResumeAll();;
 	return res;
 }
 
@@ -4745,7 +4943,6 @@ FRESULT  __in_hfa() f_readdir (
 	FRESULT res;
 	FATFS *fs;
 	DEF_NAMBUF
-	vTaskSuspendAll();;
 
 	res = validate(&dp->obj, &fs);	/* Check validity of the directory object */
 	if (res == FR_OK) {
@@ -4763,7 +4960,6 @@ FRESULT  __in_hfa() f_readdir (
 			FREE_NAMBUF();
 		}
 	}
-	xTaskResumeAll();;
 
 	LEAVE_FF(fs, res);
 }
@@ -4835,7 +5031,6 @@ FRESULT  __in_hfa() f_stat (
 	FRESULT res;
 	DIR dj;
 	DEF_NAMBUF
-	vTaskSuspendAll();
 
 	/* Get logical drive */
 	res = mount_volume(&path, &dj.obj.fs, 0);
@@ -4851,7 +5046,6 @@ FRESULT  __in_hfa() f_stat (
 		}
 		FREE_NAMBUF();
 	}
-	xTaskResumeAll();;
 	LEAVE_FF(dj.obj.fs, res);
 }
 
@@ -4999,9 +5193,7 @@ inline static FRESULT __always_inline( _f_truncate ) (
 FRESULT  __in_hfa() f_truncate (
 	FIL* fp		/* Pointer to the file object */
 ) {
-	vTaskSuspendAll();;
 	FRESULT res = _f_truncate(fp);
-	xTaskResumeAll();
 	return res;
 }
 
@@ -5023,7 +5215,6 @@ FRESULT  __in_hfa() f_unlink (
 	FFOBJID obj;
 #endif
 	DEF_NAMBUF
-	vTaskSuspendAll();;
 
 	/* Get logical drive */
 	res = mount_volume(&path, &fs, FA_WRITE);
@@ -5094,7 +5285,6 @@ FRESULT  __in_hfa() f_unlink (
 		}
 		FREE_NAMBUF();
 	}
-	xTaskResumeAll();;
 	LEAVE_FF(fs, res);
 }
 
@@ -5116,7 +5306,6 @@ FRESULT  __in_hfa() f_mkdir (
 	DWORD dcl, pcl, tm;
 	DEF_NAMBUF
 
-	vTaskSuspendAll();;
 	res = mount_volume(&path, &fs, FA_WRITE);	/* Get logical drive */
 	if (res == FR_OK) {
 		dj.obj.fs = fs;
@@ -5178,7 +5367,6 @@ FRESULT  __in_hfa() f_mkdir (
 		}
 		FREE_NAMBUF();
 	}
-	xTaskResumeAll();;
 	LEAVE_FF(fs, res);
 }
 
@@ -5201,7 +5389,6 @@ FRESULT  __in_hfa() f_rename (
 	LBA_t sect;
 	DEF_NAMBUF
 
-	vTaskSuspendAll();;
 	get_ldnumber(&path_new);						/* Snip the drive number of new name off */
 	res = mount_volume(&path_old, &fs, FA_WRITE);	/* Get logical drive of the old object */
 	if (res == FR_OK) {
@@ -5283,7 +5470,6 @@ FRESULT  __in_hfa() f_rename (
 		}
 		FREE_NAMBUF();
 	}
-	xTaskResumeAll();;
 	LEAVE_FF(fs, res);
 }
 
@@ -5739,7 +5925,7 @@ FRESULT f_forward (
 		if (sect == 0) ABORT(fs, FR_INT_ERR);
 		sect += csect;
 #if FF_FS_TINY
-		if (move_window(fs, sect) != FR_OK) ABORT(fs, FR_DISK_ERR);	/* Move sector window to the file data */
+		if (move_data_window(fs, sect) != FR_OK) ABORT(fs, FR_DISK_ERR);	/* Move sector window to the file data */
 		dbuf = fs->win;
 #else
 		if (fp->sect != sect) {		/* Fill sector cache with file data */
@@ -7172,18 +7358,30 @@ FRESULT f_setcp (
 #endif	/* FF_CODE_PAGE == 0 */
 
 bool __in_hfa() f_eof(FIL* fp) {
-	// if (fp->chained && fp->chained->obj.fs) return false;
+	if (fp->chained) return fp->clust && f_pipe_avail(fp) < 0;
 	return ((int)((fp)->fptr == (fp)->obj.objsize));
 }
 
 FRESULT __in_hfa() f_open_pipe(FIL* to, FIL* from) {
+	UINT size = FF_PIPE_SIZE;
+	PIPE* p = pvPortMalloc(sizeof(PIPE));
+	if (!p) return FR_NOT_ENOUGH_CORE;
+	memset(p, 0, sizeof(PIPE));
+	p->buf = size > FF_PIPE_SRAM_MAX ? psram_alloc(size) : 0;
+	if (!p->buf) {
+		size = MIN(size, FF_PIPE_SRAM_MAX);
+		p->buf = pvPortMalloc(size);
+	}
+	if (!p->buf) {
+		vPortFree(p);
+		return FR_NOT_ENOUGH_CORE;
+	}
+	p->size = size;
     from->chained = to;
     to->chained = from;
-	QueueHandle_t q = xQueueCreate(512, sizeof(char));
-	to->fptr = q;
+	to->fptr = from->fptr = (FSIZE_t)(uintptr_t)p;
 	to->clust = 0;
-	from->clust = 1; // remove queue only on from close
-	from->fptr = q;
+	from->clust = 1; // read end
 	to->sect = 0;
 	from->sect = 0;
 	return FR_OK;
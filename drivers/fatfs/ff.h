@@ -341,6 +341,9 @@ TCHAR* f_gets (TCHAR* buff, int len, FIL* fp);						/* Get a string from the fil
 bool f_eof(FIL* fp);
 int f_getc(FIL* fp);
 FRESULT f_open_pipe(FIL* to, FIL* from);
+bool f_is_pipe(FIL* fp);											/* True for either end of a pipe */
+int f_pipe_avail(FIL* fp);											/* Bytes to read or space to write, -1 when the other end is gone */
+void f_pipe_set_waiter(FIL* fp, void* task);						/* Task to notify when the pipe end becomes ready (NULL: none) */
 
 #define f_error(fp) ((fp)->err)
 #define f_tell(fp) ((fp)->fptr)
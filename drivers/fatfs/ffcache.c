@@ -0,0 +1,472 @@
+/*-----------------------------------------------------------------------*/
+/* Sector cache between FatFs and the block device (see ffcache.h)        */
+/*-----------------------------------------------------------------------*/
+
+#include <string.h>
+#include "ffcache.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "psram.h"
+#if FF_CACHE_TRACE
+#include <stdio.h>
+#endif
+
+#define FFC_VALID	0x01
+#define FFC_DIRTY	0x02
+#define FFC_CMETA	0x04
+
+#define PS_LINES	(FF_CACHE_SETS * FF_CACHE_WAYS)
+#define N_LINES		(FF_CACHE_SRAM + PS_LINES)
+
+typedef struct {
+	LBA_t	sect;
+	BYTE*	buf;
+	DWORD	stamp;			/* Last use */
+	BYTE	pdrv;
+	BYTE	flag;
+} LINE;
+
+/* Lines [0, FF_CACHE_SRAM) are the SRAM tier, the rest the PSRAM tier,
+/  set s holding lines FF_CACHE_SRAM + s * FF_CACHE_WAYS onwards */
+static LINE Line[N_LINES];
+#if FF_CACHE_SRAM
+static BYTE SramBuf[FF_CACHE_SRAM][FF_MIN_SS] __attribute__((aligned(4)));
+#endif
+static BYTE PsTier;			/* PSRAM tier allocated */
+static BYTE* WbBuf;			/* FF_CACHE_WB_MAX sectors for coalescing, PSRAM */
+static DWORD Clock;
+static FFC_STATS Stat;
+static SemaphoreHandle_t IoLock;	/* Disk functions, device I/O included */
+static SemaphoreHandle_t LineLock;	/* Line identity and contents, for ffc_peek() */
+
+#if FF_CACHE_TRACE
+#define TRACE(...)	printf(__VA_ARGS__)
+#else
+#define TRACE(...)
+#endif
+
+
+/*-----------------------------------------------------------------------*/
+/* Locks                                                                 */
+/*-----------------------------------------------------------------------*/
+
+/* 1: taken, 0: not needed (no scheduler yet, or before disk_initialize),
+/  -1: busy. With the scheduler suspended nothing may block, so a busy
+/  lock fails the call instead. */
+static int lock (SemaphoreHandle_t m)
+{
+	if (!m) return 0;
+	switch (xTaskGetSchedulerState()) {
+	case taskSCHEDULER_NOT_STARTED:
+		return 0;
+	case taskSCHEDULER_RUNNING:
+		return xSemaphoreTake(m, portMAX_DELAY) == pdTRUE ? 1 : -1;
+	default:
+		return xSemaphoreTake(m, 0) == pdTRUE ? 1 : -1;
+	}
+}
+
+static void unlock (SemaphoreHandle_t m, int held)
+{
+	if (held > 0) xSemaphoreGive(m);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* Lines                                                                 */
+/*-----------------------------------------------------------------------*/
+
+/* Lines are only changed with IoLock held; changes ffc_peek() could see
+/  half done, identity and contents, also take LineLock. A line being
+/  filled from the device stays invalid until claim() publishes it. */
+
+static void init_lines (void)
+{
+	UINT i;
+	BYTE* ps;
+
+#if FF_CACHE_SRAM
+	for (i = 0; i < FF_CACHE_SRAM; i++) Line[i].buf = SramBuf[i];
+#endif
+	if (PsTier || !PS_LINES || !psram_is_available()) return;
+	ps = psram_alloc((size_t)(PS_LINES + FF_CACHE_WB_MAX) * FF_MIN_SS);
+	if (!ps) return;
+	for (i = 0; i < PS_LINES; i++) Line[FF_CACHE_SRAM + i].buf = ps + i * FF_MIN_SS;
+	WbBuf = ps + PS_LINES * FF_MIN_SS;
+	PsTier = 1;
+}
+
+static LINE* ps_set (LBA_t sect)
+{
+	return &Line[FF_CACHE_SRAM + (UINT)(sect % FF_CACHE_SETS) * FF_CACHE_WAYS];
+}
+
+static LINE* find (BYTE pdrv, LBA_t sect)
+{
+	UINT i;
+	LINE* ln;
+
+	for (i = 0; i < FF_CACHE_SRAM; i++) {
+		ln = &Line[i];
+		if ((ln->flag & FFC_VALID) && ln->sect == sect && ln->pdrv == pdrv) return ln;
+	}
+	if (PsTier) {
+		ln = ps_set(sect);
+		for (i = 0; i < FF_CACHE_WAYS; i++, ln++) {
+			if ((ln->flag & FFC_VALID) && ln->sect == sect && ln->pdrv == pdrv) return ln;
+		}
+	}
+	return 0;
+}
+
+/* Victim among n lines: a free one, else the LRU data line, else the LRU
+/  metadata line */
+static LINE* victim (LINE* ln, UINT n)
+{
+	LINE* v = 0;
+	UINT i;
+
+	for (i = 0; i < n; i++, ln++) {
+		if (!(ln->flag & FFC_VALID)) return ln;
+		if (!v || (ln->flag & FFC_CMETA) < (v->flag & FFC_CMETA)
+			|| ((ln->flag & FFC_CMETA) == (v->flag & FFC_CMETA) && (long)(ln->stamp - v->stamp) < 0)) {
+			v = ln;
+		}
+	}
+	return v;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* Write-back                                                            */
+/*-----------------------------------------------------------------------*/
+
+static LINE* find_dirty (BYTE pdrv, LBA_t sect)
+{
+	LINE* ln = find(pdrv, sect);
+	return (ln && (ln->flag & FFC_DIRTY)) ? ln : 0;
+}
+
+/* Write back the run of consecutive dirty sectors around ln */
+static DRESULT flush_run (LINE* ln)
+{
+	BYTE pdrv = ln->pdrv;
+	LBA_t top = ln->sect;
+	UINT n, i;
+	LINE* run[FF_CACHE_WB_MAX];
+	DRESULT res;
+
+	if (WbBuf) {
+		while (top > 0 && ln->sect - top < FF_CACHE_WB_MAX - 1 && find_dirty(pdrv, top - 1)) top--;
+	}
+	for (n = 0; n < (WbBuf ? FF_CACHE_WB_MAX : 1); n++) {
+		run[n] = find_dirty(pdrv, top + n);
+		if (!run[n]) break;
+	}
+	if (n == 1) {
+		res = sd_disk_write(pdrv, run[0]->buf, top, 1);
+	} else {
+		for (i = 0; i < n; i++) memcpy(WbBuf + i * FF_MIN_SS, run[i]->buf, FF_MIN_SS);
+		res = sd_disk_write(pdrv, WbBuf, top, n);
+	}
+	if (res != RES_OK) return res;
+	for (i = 0; i < n; i++) run[i]->flag &= ~FFC_DIRTY;
+	Stat.writebacks += n;
+	Stat.dev_writes += n;
+	Stat.wb_runs++;
+	return RES_OK;
+}
+
+static DRESULT flush_all (BYTE pdrv)
+{
+	UINT i;
+	LINE* ln;
+	DRESULT res;
+
+	for (;;) {		/* Lowest dirty sector first, so runs start at their top */
+		ln = 0;
+		for (i = 0; i < N_LINES; i++) {
+			if ((Line[i].flag & FFC_DIRTY) && Line[i].pdrv == pdrv && (!ln || Line[i].sect < ln->sect)) ln = &Line[i];
+		}
+		if (!ln) return RES_OK;
+		res = flush_run(ln);
+		if (res != RES_OK) return res;
+	}
+}
+
+/* Free ln for a new sector: demote its content to the PSRAM tier, or
+/  write it back if it has nowhere to go */
+static DRESULT evict (LINE* ln)
+{
+	LINE* d = 0;
+	DRESULT res;
+	int held;
+
+	if (!(ln->flag & FFC_VALID)) return RES_OK;
+	if (PsTier && ln < &Line[FF_CACHE_SRAM]) {
+		d = victim(ps_set(ln->sect), FF_CACHE_WAYS);
+		if ((d->flag & FFC_DIRTY) && (res = flush_run(d)) != RES_OK) return res;
+	} else if (ln->flag & FFC_DIRTY) {
+		res = flush_run(ln);
+		if (res != RES_OK) return res;
+	}
+	held = lock(LineLock);
+	if (d) {
+		memcpy(d->buf, ln->buf, FF_MIN_SS);
+		d->sect = ln->sect;
+		d->pdrv = ln->pdrv;
+		d->stamp = ln->stamp;
+		d->flag = ln->flag;
+	}
+	ln->flag = 0;
+	unlock(LineLock, held);
+	return RES_OK;
+}
+
+/* An empty line for a sector not in the cache, or 0 */
+static LINE* alloc_line (LBA_t sect)
+{
+	LINE* ln;
+
+	if (FF_CACHE_SRAM) {
+		ln = victim(&Line[0], FF_CACHE_SRAM);
+	} else if (PsTier) {
+		ln = victim(ps_set(sect), FF_CACHE_WAYS);
+	} else {
+		return 0;
+	}
+	if (evict(ln) != RES_OK) return 0;
+	return ln;
+}
+
+/* Publish a filled line */
+static void claim (LINE* ln, BYTE pdrv, LBA_t sect, BYTE flag)
+{
+	int held = lock(LineLock);
+
+	ln->sect = sect;
+	ln->pdrv = pdrv;
+	ln->stamp = ++Clock;
+	ln->flag = flag;
+	unlock(LineLock, held);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* Disk I/O                                                              */
+/*-----------------------------------------------------------------------*/
+
+DSTATUS disk_initialize (BYTE pdrv)
+{
+	UINT i;
+	int io, held;
+	DSTATUS st;
+
+	if (!IoLock) IoLock = xSemaphoreCreateMutex();
+	if (!LineLock) LineLock = xSemaphoreCreateMutex();
+	if (!IoLock || !LineLock) return STA_NOINIT;
+	io = lock(IoLock);
+	if (io < 0) return STA_NOINIT;
+	held = lock(LineLock);
+	for (i = 0; i < N_LINES; i++) {		/* A new card: forget everything */
+		if (Line[i].pdrv == pdrv) Line[i].flag = 0;
+	}
+	unlock(LineLock, held);
+	init_lines();
+	st = sd_disk_initialize(pdrv);
+	unlock(IoLock, io);
+	return st;
+}
+
+DSTATUS disk_status (BYTE pdrv)
+{
+	return sd_disk_status(pdrv);
+}
+
+static DRESULT read_line (BYTE pdrv, BYTE* buff, LBA_t sector, BYTE cls)
+{
+	LINE* ln;
+	DRESULT res;
+
+	TRACE("ffc R %lu 1 %u\n", (unsigned long)sector, cls);
+	Stat.reads++;
+	if (cls == FFC_META) Stat.meta_reads++;
+	ln = find(pdrv, sector);
+	if (ln) {
+		Stat.read_hits++;
+		if (cls == FFC_META) {
+			Stat.meta_hits++;
+			ln->flag |= FFC_CMETA;
+		}
+		ln->stamp = ++Clock;
+	} else {
+		ln = alloc_line(sector);
+		Stat.dev_reads++;
+		if (!ln) return sd_disk_read(pdrv, buff, sector, 1);
+		res = sd_disk_read(pdrv, ln->buf, sector, 1);
+		if (res != RES_OK) return res;
+		claim(ln, pdrv, sector, FFC_VALID | (cls == FFC_META ? FFC_CMETA : 0));
+	}
+	memcpy(buff, ln->buf, FF_MIN_SS);
+	return RES_OK;
+}
+
+DRESULT ffc_read (BYTE pdrv, BYTE* buff, LBA_t sector, BYTE cls)
+{
+	DRESULT res;
+	int io = lock(IoLock);
+
+	if (io < 0) return RES_NOTRDY;
+	res = read_line(pdrv, buff, sector, cls);
+	unlock(IoLock, io);
+	return res;
+}
+
+int ffc_peek (BYTE pdrv, BYTE* buff, LBA_t sector, UINT ofs, UINT len)
+{
+	LINE* ln;
+	int held, hit = 0;
+
+	if (!LineLock || (held = lock(LineLock)) < 0) return 0;
+	TRACE("ffc P %lu\n", (unsigned long)sector);
+	Stat.peeks++;
+	ln = find(pdrv, sector);
+	if (ln) {
+		memcpy(buff, ln->buf + ofs, len);
+		ln->stamp = ++Clock;
+		Stat.peek_hits++;
+		hit = 1;
+	}
+	unlock(LineLock, held);
+	return hit;
+}
+
+DRESULT disk_read (BYTE pdrv, BYTE* buff, LBA_t sector, UINT count)
+{
+	UINT i;
+	LINE* ln;
+	DRESULT res;
+	int io;
+
+	if (count == 1) return ffc_read(pdrv, buff, sector, FFC_DATA);
+
+	/* Bulk: from the device, then overlay sectors the cache holds newer */
+	io = lock(IoLock);
+	if (io < 0) return RES_NOTRDY;
+	TRACE("ffc R %lu %u 0\n", (unsigned long)sector, count);
+	Stat.bypass++;
+	Stat.dev_reads += count;
+	res = sd_disk_read(pdrv, buff, sector, count);
+	if (res == RES_OK) {
+		for (i = 0; i < N_LINES; i++) {
+			ln = &Line[i];
+			if ((ln->flag & FFC_DIRTY) && ln->pdrv == pdrv && ln->sect - sector < count) {
+				memcpy(buff + (ln->sect - sector) * FF_MIN_SS, ln->buf, FF_MIN_SS);
+			}
+		}
+	}
+	unlock(IoLock, io);
+	return res;
+}
+
+#if !FF_FS_READONLY
+DRESULT disk_write (BYTE pdrv, const BYTE* buff, LBA_t sector, UINT count)
+{
+	UINT i;
+	LINE* ln;
+	DRESULT res;
+	int io, held;
+
+	io = lock(IoLock);
+	if (io < 0) return RES_NOTRDY;
+	TRACE("ffc W %lu %u\n", (unsigned long)sector, count);
+	if (count == 1) {		/* Absorb it; written back on sync or eviction */
+		Stat.writes++;
+		ln = find(pdrv, sector);
+		if (ln) {
+			held = lock(LineLock);
+			memcpy(ln->buf, buff, FF_MIN_SS);
+			ln->flag |= FFC_DIRTY;
+			ln->stamp = ++Clock;
+			unlock(LineLock, held);
+		} else if ((ln = alloc_line(sector)) != 0) {
+			memcpy(ln->buf, buff, FF_MIN_SS);
+			claim(ln, pdrv, sector, FFC_VALID | FFC_DIRTY);
+		}
+		if (ln) {
+			unlock(IoLock, io);
+			return RES_OK;
+		}
+	} else {
+		Stat.bypass++;
+	}
+
+	/* Bulk: straight to the device; cached copies take the new data */
+	Stat.dev_writes += count;
+	res = sd_disk_write(pdrv, buff, sector, count);
+	if (res == RES_OK) {
+		held = lock(LineLock);
+		for (i = 0; i < N_LINES; i++) {
+			ln = &Line[i];
+			if ((ln->flag & FFC_VALID) && ln->pdrv == pdrv && ln->sect - sector < count) {
+				memcpy(ln->buf, buff + (ln->sect - sector) * FF_MIN_SS, FF_MIN_SS);
+				ln->flag &= ~FFC_DIRTY;
+			}
+		}
+		unlock(LineLock, held);
+	}
+	unlock(IoLock, io);
+	return res;
+}
+#endif
+
+DRESULT disk_ioctl (BYTE pdrv, BYTE cmd, void* buff)
+{
+	UINT i;
+	LBA_t* range;
+	DRESULT res = RES_OK;
+	int io, held;
+
+	io = lock(IoLock);
+	if (io < 0) return RES_NOTRDY;
+	switch (cmd) {
+	case CTRL_SYNC:
+		TRACE("ffc S\n");
+		res = flush_all(pdrv);
+		break;
+	case CTRL_TRIM:		/* Trimmed sectors are garbage: drop them unwritten */
+		range = (LBA_t*)buff;
+		held = lock(LineLock);
+		for (i = 0; i < N_LINES; i++) {
+			if (Line[i].pdrv == pdrv && Line[i].sect - range[0] <= range[1] - range[0]) Line[i].flag = 0;
+		}
+		unlock(LineLock, held);
+		break;
+	}
+	if (res == RES_OK) res = sd_disk_ioctl(pdrv, cmd, buff);
+	unlock(IoLock, io);
+	return res;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/* Statistics                                                            */
+/*-----------------------------------------------------------------------*/
+
+void ffc_get_stats (FFC_STATS* st)
+{
+	UINT i;
+
+	*st = Stat;
+	st->lines = FF_CACHE_SRAM + (PsTier ? PS_LINES : 0);
+	st->dirty = 0;
+	for (i = 0; i < N_LINES; i++) {
+		if (Line[i].flag & FFC_DIRTY) st->dirty++;
+	}
+}
+
+void ffc_reset_stats (void)
+{
+	memset(&Stat, 0, sizeof Stat);
+}
@@ -0,0 +1,61 @@
+/*-----------------------------------------------------------------------*/
+/* Sector cache between FatFs and the block device                        */
+/*-----------------------------------------------------------------------*/
+/* ffcache.c implements the diskio.h functions and keeps recently used
+/  sectors in two tiers: FF_CACHE_SRAM lines in SRAM that take every new
+/  sector, and an FF_CACHE_WAYS-way set-associative tier in PSRAM that
+/  catches what the SRAM tier evicts. Eviction takes file data before
+/  FAT and directory sectors. Written sectors stay dirty in the cache until
+/  CTRL_SYNC (f_sync/f_close) or eviction, and are written back in runs of
+/  consecutive sectors. Multi-sector transfers go straight to the device
+/  and only reconcile with the cached copies.
+/
+/  One lock serializes the disk functions, device I/O included; a second
+/  one, never held across device I/O, guards line contents so ffc_peek()
+/  can copy out of the cache without waiting for the device. */
+
+#ifndef FFCACHE_DEFINED
+#define FFCACHE_DEFINED
+
+#include "ff.h"
+#include "diskio.h"
+
+/* Sector classes, as FatFs reads them through its window */
+#define FFC_DATA	0	/* File data */
+#define FFC_META	1	/* FAT, directory, boot sectors: evicted last */
+
+typedef struct {
+	DWORD	reads;			/* Single-sector reads */
+	DWORD	read_hits;
+	DWORD	meta_reads;		/* ... of them FFC_META */
+	DWORD	meta_hits;
+	DWORD	writes;			/* Single-sector writes (absorbed) */
+	DWORD	bypass;			/* Multi-sector transfers */
+	DWORD	writebacks;		/* Dirty sectors written back */
+	DWORD	wb_runs;		/* disk_write calls doing it */
+	DWORD	dev_reads;		/* Sectors read from the device */
+	DWORD	dev_writes;		/* Sectors written to the device */
+	DWORD	peeks;			/* ffc_peek() calls */
+	DWORD	peek_hits;
+	WORD	lines;			/* Configured lines, SRAM + PSRAM */
+	WORD	dirty;			/* Dirty lines now */
+} FFC_STATS;
+
+/* Read one sector as FatFs's window does, tagging it with its class */
+DRESULT ffc_read (BYTE pdrv, BYTE* buff, LBA_t sector, BYTE cls);
+
+/* Copy len bytes at ofs of a sector if the cache holds it: 1, else 0.
+/  Never touches the device, so it doesn't wait for a transfer in progress. */
+int ffc_peek (BYTE pdrv, BYTE* buff, LBA_t sector, UINT ofs, UINT len);
+
+void ffc_get_stats (FFC_STATS* st);
+void ffc_reset_stats (void);
+
+/* The block device underneath (drivers/sdcard/sdcard.c) */
+DSTATUS sd_disk_initialize (BYTE pdrv);
+DSTATUS sd_disk_status (BYTE pdrv);
+DRESULT sd_disk_read (BYTE pdrv, BYTE* buff, LBA_t sector, UINT count);
+DRESULT sd_disk_write (BYTE pdrv, const BYTE* buff, LBA_t sector, UINT count);
+DRESULT sd_disk_ioctl (BYTE pdrv, BYTE cmd, void* buff);
+
+#endif
@@ -38,7 +38,7 @@
 /* This option switches fast seek function. (0:Disable or 1:Enable) */
 
 
-#define FF_USE_EXPAND	0
+#define FF_USE_EXPAND	1
 /* This option switches f_expand function. (0:Disable or 1:Enable) */
 
 
@@ -280,8 +280,8 @@
 
 #include "FreeRTOS.h"
 #include "semphr.h"
-#define FF_FS_REENTRANT	0
-#define FF_FS_TIMEOUT	pdMS_TO_TICKS(1000)
+#define FF_FS_REENTRANT	1
+#define FF_FS_TIMEOUT	portMAX_DELAY
 #define FF_SYNC_t		   SemaphoreHandle_t
 /* The option FF_FS_REENTRANT switches the re-entrancy (thread safe) of the FatFs
 /  module itself. Note that regardless of this option, file access to different
@@ -301,5 +301,30 @@
 /  included somewhere in the scope of ff.h. */
 
 
+#define FF_FS_SLICE		16384
+/* f_read() and f_write() give the volume up between slices of FF_FS_SLICE
+/  bytes, so a large transfer doesn't keep other tasks off the volume for its
+/  whole length. Sector multiple; 0 holds the volume for the whole call. */
+
+
+
+#define FF_PIPE_SIZE		8192
+#define FF_PIPE_SRAM_MAX	1024
+/* FF_PIPE_SIZE is the ring size of a pipe made by f_open_pipe(), a power of 2.
+/  Rings larger than FF_PIPE_SRAM_MAX are allocated in PSRAM; without PSRAM
+/  they are capped at FF_PIPE_SRAM_MAX and allocated from the FreeRTOS heap. */
+
+
+#define FF_CACHE_SRAM		8
+#define FF_CACHE_SETS		32
+#define FF_CACHE_WAYS		4
+#define FF_CACHE_WB_MAX		16
+#define FF_CACHE_TRACE		0
+/* Sector cache below FatFs (ffcache.c). FF_CACHE_SRAM sectors are kept in
+/  SRAM; FF_CACHE_SETS x FF_CACHE_WAYS more in PSRAM when it is present.
+/  Dirty sectors are written back in runs of up to FF_CACHE_WB_MAX.
+/  FF_CACHE_TRACE 1 prints every access ("ffc R/W/S/P ...") for replay with
+/  tools/hostbench/cachebench. */
+
 
 /*--- End of configuration options ---*/
@@ -4,19 +4,36 @@
 
 #include "ff.h"
 #include "FreeRTOS.h"
+#include "task.h"
 #include "semphr.h"
 
 #if FF_FS_REENTRANT   /* Mutual exclusion enabled */
 
+/* One recursive mutex per volume, so a task that already holds the volume
+ * can't deadlock on it.
+ *
+ * Before the scheduler runs there is nobody to exclude; with it suspended
+ * nobody else can run either, but a task preempted inside FatFs may hold
+ * the volume, and waiting for it would never end: fail with FR_TIMEOUT
+ * instead of blocking. */
+static BaseType_t grant_wait (void)
+{
+    switch (xTaskGetSchedulerState()) {
+    case taskSCHEDULER_NOT_STARTED: return -1;
+    case taskSCHEDULER_SUSPENDED:   return 0;
+    default:                        return 1;
+    }
+}
+
 /*-----------------------------------------------------------------------*/
 /* Create a Synchronization Object                                       */
 /*-----------------------------------------------------------------------*/
 
 int ff_cre_syncobj (BYTE vol, FF_SYNC_t *sobj)
 {
-    (void)vol; // том можно использовать при желании, но обычно не нужно
+    (void)vol;
 
-    SemaphoreHandle_t m = xSemaphoreCreateMutex();
+    SemaphoreHandle_t m = xSemaphoreCreateRecursiveMutex();
     if (m == NULL) {
         return 0;
     }
@@ -48,7 +65,10 @@ int ff_req_grant (FF_SYNC_t sobj)
     if (sobj == NULL)
         return 0;
 
-    if (xSemaphoreTake(sobj, FF_FS_TIMEOUT) == pdTRUE)
+    BaseType_t wait = grant_wait();
+    if (wait < 0)
+        return 1;
+    if (xSemaphoreTakeRecursive(sobj, wait ? FF_FS_TIMEOUT : 0) == pdTRUE)
         return 1;
 
     return 0; // timeout
@@ -61,8 +81,8 @@ int ff_req_grant (FF_SYNC_t sobj)
 
 void ff_rel_grant (FF_SYNC_t sobj)
 {
-    if (sobj != NULL) {
-        xSemaphoreGive(sobj);
+    if (sobj != NULL && grant_wait() >= 0) {
+        xSemaphoreGiveRecursive(sobj);
     }
 }
 
@@ -67,6 +67,9 @@ static volatile uint8_t mouse_rx_head = 0;  // ISR writes here
 static volatile uint8_t mouse_rx_tail = 0;  // Main loop reads from here
 static volatile bool mouse_streaming = false;
 
+// Called from the IRQ when there is something to read
+static ps2_wake_fn_t ps2_wake = NULL;
+
 // Error counters
 static uint32_t mouse_frame_errors = 0;
 static uint32_t mouse_parity_errors = 0;
@@ -90,12 +93,28 @@ static void pio_sm_restart_rx(PIO pio, uint sm) {
 }
 
 //=============================================================================
-// Mouse PIO Interrupt Handler
+// PIO Interrupt Handler (mouse, and keyboard wakeups)
 //=============================================================================
 
+static uint8_t mouse_rx_available(void);
+
+static inline void kbd_irq_enable(bool on) {
+    pio_set_irqn_source_enabled(ps2_pio, 1, pis_sm0_rx_fifo_not_empty + kbd_sm, on);
+}
+
 static void mouse_pio_irq_handler(void) {
+    bool wake = false;
+
+    // Keyboard bytes are left in the FIFO for ps2_kbd_get_byte(); mask
+    // the source until it has drained them, or this would fire forever
+    if (ps2_wake && kbd_initialized &&
+        !pio_sm_is_rx_fifo_empty(ps2_pio, kbd_sm)) {
+        kbd_irq_enable(false);
+        wake = true;
+    }
+
     // Read all available frames from PIO FIFO into ring buffer
-    while (!pio_sm_is_rx_fifo_empty(ps2_pio, mouse_sm)) {
+    while (mouse_streaming && !pio_sm_is_rx_fifo_empty(ps2_pio, mouse_sm)) {
         uint32_t raw = pio_sm_get(ps2_pio, mouse_sm);
         
         // Skip all-zero frames (noise/glitch)
@@ -111,12 +130,18 @@ static void mouse_pio_irq_handler(void) {
                 mouse_rx_head = next_head;
             }
             // If buffer full, drop the byte (better than blocking ISR)
+            // Wake the reader once a whole packet is in, counting what
+            // ps2_mouse_poll() already took of it
+            if (mouse_rx_available() + mouse_packet_idx >= mouse_packet_size)
+                wake = true;
         } else {
             // Track errors but don't block
             if (result == -1) mouse_frame_errors++;
             else mouse_parity_errors++;
         }
     }
+
+    if (wake && ps2_wake) ps2_wake();
 }
 
 static void mouse_enable_irq(void) {
@@ -521,8 +546,9 @@ static bool mouse_reset_and_init(void) {
     mouse_rx_tail = 0;
     
     // NOW enable PIO interrupt for non-blocking reception of mouse data
-    mouse_enable_irq();
+    // (the handler only drains the mouse FIFO while streaming)
     mouse_streaming = true;
+    mouse_enable_irq();
     
     printf("Mouse: Streaming mode enabled with interrupts\n");
     return true;
@@ -749,8 +775,26 @@ uint32_t ps2_kbd_get_raw(void) {
 
 int ps2_kbd_get_byte(void) {
     if (pio_sm_is_rx_fifo_empty(ps2_pio, kbd_sm)) {
+        // Drained: let the next byte wake the reader again
+        if (ps2_wake && kbd_initialized) kbd_irq_enable(true);
         return -1;
     }
     uint32_t raw = pio_sm_get(ps2_pio, kbd_sm);
     return ps2_rx_decode_frame(raw);
 }
+
+//=============================================================================
+// Public API - Wakeup
+//=============================================================================
+
+void ps2_set_wake_handler(ps2_wake_fn_t fn) {
+    if (!ps2_pio || (!kbd_initialized && !mouse_streaming)) return;
+    uint irq_num = (ps2_pio == pio0) ? PIO0_IRQ_1 : PIO1_IRQ_1;
+
+    irq_set_enabled(irq_num, false);
+    ps2_wake = fn;
+    if (kbd_initialized) kbd_irq_enable(fn != NULL);
+    // Same handler as the mouse: both state machines share IRQ index 1
+    irq_set_exclusive_handler(irq_num, mouse_pio_irq_handler);
+    irq_set_enabled(irq_num, true);
+}
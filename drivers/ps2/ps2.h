@@ -119,6 +119,21 @@ int ps2_kbd_get_byte(void);
  */
 uint32_t ps2_kbd_get_raw(void);
 
+//=============================================================================
+// Wakeup
+//=============================================================================
+
+typedef void (*ps2_wake_fn_t)(void);
+
+/**
+ * Install a handler the PS/2 interrupt calls when keyboard bytes or a
+ * complete mouse packet arrive, so the reader can sleep instead of
+ * polling.  Runs in interrupt context.  Keyboard bytes stay in the PIO
+ * FIFO; the keyboard interrupt is masked until ps2_kbd_get_byte() finds
+ * the FIFO empty.  Call after ps2_init() and mouse initialization.
+ */
+void ps2_set_wake_handler(ps2_wake_fn_t fn);
+
 #ifdef __cplusplus
 }
 #endif
@@ -7,7 +7,7 @@
  */
 
 /*
- * PSRAM detection and free-list allocator for FRANK OS.
+ * PSRAM detection and segregated-fit allocator for FRANK OS.
  *
  * Both detection and the allocator use the UNCACHED XIP window
  * (0x15000000) for all PSRAM access.  Using the cached window
@@ -17,7 +17,8 @@
  * and leads to hard faults in downstream code (e.g. ELF relocation).
  *
  * Thread safety: psram_alloc/psram_free suspend the FreeRTOS scheduler
- * during free-list manipulation (same approach as FreeRTOS heap_4.c).
+ * during bin manipulation (same approach as FreeRTOS heap_4.c); both
+ * run in constant time, so the suspended window stays short.
  */
 
 #include "psram.h"
@@ -73,82 +74,174 @@ unsigned int __not_in_flash_func(butter_psram_size)(void) {
 }
 
 /*==========================================================================
- * Free-list allocator  (uses uncached PSRAM_BASE = 0x15000000)
+ * Segregated-fit allocator  (uses uncached PSRAM_BASE = 0x15000000)
+ *
+ * Free chunks sit in PSRAM_NCLASSES doubly linked bins, bin k holding
+ * chunks of [2^k, 2^(k+1)) bytes; bin_map has bit k set while bin k is
+ * non-empty.  A request scans a few chunks of its own bin, then takes
+ * the head of the next non-empty larger bin (found with one ctz), so
+ * neither path walks the heap.  Boundary tags make coalescing O(1):
+ * every chunk header carries the size of the chunk before it, valid
+ * while that chunk is free (PINUSE clear), and a permanently used
+ * sentinel header at the top of PSRAM ends the chain.
  *=========================================================================*/
 
-typedef struct block_hdr {
-    size_t             size;  /* usable bytes (excludes header) */
-    struct block_hdr  *next;
-} block_hdr_t;
+typedef struct chunk {
+    size_t        prev_size;  /* size of the previous chunk if it is free */
+    size_t        head;       /* chunk size (header included) | flags */
+    /* free chunks only — overlaid on the payload */
+    struct chunk *next;
+    struct chunk *prev;
+} chunk_t;
+
+#define CINUSE       1u          /* this chunk is allocated */
+#define PINUSE       2u          /* the previous chunk is allocated */
+#define FLAG_MASK    7u
+
+#define HDR_SIZE     (2 * sizeof(size_t))  /* 8 bytes on 32-bit */
+#define ALIGN        8
+#define ALIGN_UP(x)  (((x) + (ALIGN - 1)) & ~(size_t)(ALIGN - 1))
+#define MIN_CHUNK    (HDR_SIZE + 16)  /* minimum payload 16 bytes */
+#define BIN_SCAN     8           /* own-bin chunks tried before larger bins */
+
+#define CHUNK_SIZE(c)    ((c)->head & ~(size_t)FLAG_MASK)
+#define CHUNK_AT(c, off) ((chunk_t *)((uint8_t *)(c) + (off)))
+#define CHUNK_MEM(c)     ((void *)((uint8_t *)(c) + HDR_SIZE))
+#define MEM_CHUNK(p)     ((chunk_t *)((uint8_t *)(p) - HDR_SIZE))
+
+static chunk_t  *bins[PSRAM_NCLASSES];
+static uint32_t  bin_map;
+static size_t    detected_size = 0;
+static uintptr_t heap_top;       /* address of the sentinel header */
+static size_t    free_bytes;
+static psram_class_stats_t class_stats[PSRAM_NCLASSES];
+
+static inline int size_class(size_t size) {
+    return 31 - __builtin_clz((uint32_t)size);
+}
+
+static inline bool chunk_in_heap(const chunk_t *c) {
+    return (uintptr_t)c >= PSRAM_BASE && (uintptr_t)c < heap_top;
+}
 
-#define HDR_SIZE     (sizeof(block_hdr_t))  /* 8 bytes on 32-bit */
-#define ALIGN        4
-#define ALIGN_UP(x)  (((x) + (ALIGN - 1)) & ~(ALIGN - 1))
-#define MIN_BLOCK    16  /* minimum usable size to avoid fragmentation */
+static void bin_insert(chunk_t *c, size_t size) {
+    int k = size_class(size);
+    c->prev = NULL;
+    c->next = bins[k];
+    if (c->next) c->next->prev = c;
+    bins[k] = c;
+    bin_map |= 1u << k;
+    class_stats[k].free_blocks++;
+    free_bytes += size;
+}
 
-static block_hdr_t *free_list = NULL;
-static size_t        detected_size = 0;
+static void bin_remove(chunk_t *c, size_t size) {
+    int k = size_class(size);
+    if (c->prev) c->prev->next = c->next;
+    else         bins[k] = c->next;
+    if (c->next) c->next->prev = c->prev;
+    if (!bins[k]) bin_map &= ~(1u << k);
+    class_stats[k].free_blocks--;
+    free_bytes -= size;
+}
+
+/* Mark c (size bytes) free: write its tags and tell the next chunk */
+static void chunk_set_free(chunk_t *c, size_t size) {
+    c->head = size | (c->head & PINUSE);
+    chunk_t *nx = CHUNK_AT(c, size);
+    nx->prev_size = size;
+    nx->head &= ~(size_t)PINUSE;
+}
 
 void psram_heap_init(void) {
     unsigned int sz = butter_psram_size();
     detected_size = sz;
+    bin_map = 0;
+    memset(bins, 0, sizeof(bins));
+    memset(class_stats, 0, sizeof(class_stats));
+    free_bytes = 0;
 
-    if (sz == 0) {
-        free_list = NULL;
+    if (sz == 0)
         return;
+
+    /* One free chunk spanning all of PSRAM, then the sentinel */
+    heap_top = PSRAM_BASE + sz - HDR_SIZE;
+    chunk_t *top = (chunk_t *)heap_top;
+    top->head = CINUSE;
+
+    chunk_t *c = (chunk_t *)(intptr_t)PSRAM_BASE;
+    c->prev_size = 0;
+    c->head = PINUSE;
+    chunk_set_free(c, heap_top - PSRAM_BASE);
+    bin_insert(c, heap_top - PSRAM_BASE);
+}
+
+/* Find and unlink a free chunk of at least need bytes */
+static chunk_t *bin_take(size_t need) {
+    int k = size_class(need);
+
+    /* Own bin: chunks may be smaller than need — short first-fit scan */
+    chunk_t *c = bins[k];
+    for (int n = 0; c && n < BIN_SCAN; n++, c = c->next) {
+        if (CHUNK_SIZE(c) >= need) {
+            bin_remove(c, CHUNK_SIZE(c));
+            return c;
+        }
     }
 
-    /* Initialise a single free block spanning all of PSRAM
-     * using the uncached address window */
-    block_hdr_t *blk = (block_hdr_t *)(intptr_t)PSRAM_BASE;
-    blk->size = sz - HDR_SIZE;
-    blk->next = NULL;
-    free_list = blk;
+    /* Any chunk of a larger class fits */
+    uint32_t larger = k + 1 < PSRAM_NCLASSES ? bin_map & (~0u << (k + 1)) : 0;
+    if (larger) {
+        c = bins[__builtin_ctz(larger)];
+        bin_remove(c, CHUNK_SIZE(c));
+        return c;
+    }
+
+    /* Nothing larger: the rest of the own bin is the last chance */
+    for (; c; c = c->next) {
+        if (CHUNK_SIZE(c) >= need) {
+            bin_remove(c, CHUNK_SIZE(c));
+            return c;
+        }
+    }
+    return NULL;
 }
 
 void *psram_alloc(size_t size) {
-    if (!free_list || size == 0)
+    if (!detected_size || size == 0 || size > detected_size)
         return NULL;
 
-    size = ALIGN_UP(size);
-    if (size < MIN_BLOCK)
-        size = MIN_BLOCK;
+    size_t need = ALIGN_UP(size + HDR_SIZE);
+    if (need < MIN_CHUNK)
+        need = MIN_CHUNK;
 
     vTaskSuspendAll();
 
-    /* First-fit search (with corruption guard) */
-    block_hdr_t **prev = &free_list;
-    block_hdr_t  *cur  = free_list;
-    void *result = NULL;
-    int steps = 0;
-    const int max_steps = (int)(detected_size / MIN_BLOCK);
-
-    while (cur) {
-        if (++steps > max_steps) {
-            printf("[psram_alloc] CORRUPT free list at %p, %d steps\n", cur, steps);
-            break;
-        }
-        if (cur->size >= size) {
-            /* Can we split? Need room for header + MIN_BLOCK. */
-            if (cur->size >= size + HDR_SIZE + MIN_BLOCK) {
-                block_hdr_t *rest = (block_hdr_t *)((uint8_t *)cur + HDR_SIZE + size);
-                rest->size = cur->size - size - HDR_SIZE;
-                rest->next = cur->next;
-                cur->size  = size;
-                *prev = rest;
-            } else {
-                *prev = cur->next;
-            }
-            cur->next = NULL;
-            result = (void *)((uint8_t *)cur + HDR_SIZE);
-            break;
-        }
-        prev = &cur->next;
-        cur  = cur->next;
+    chunk_t *c = bin_take(need);
+    if (!c) {
+        class_stats[size_class(need)].failures++;
+        (void)xTaskResumeAll();
+        return NULL;
     }
 
+    /* Split off the tail when it can hold a chunk of its own */
+    size_t csize = CHUNK_SIZE(c);
+    if (csize - need >= MIN_CHUNK) {
+        chunk_t *rest = CHUNK_AT(c, need);
+        rest->head = PINUSE;
+        chunk_set_free(rest, csize - need);
+        bin_insert(rest, csize - need);
+        csize = need;
+    }
+    c->head = csize | (c->head & PINUSE) | CINUSE;
+    CHUNK_AT(c, csize)->head |= PINUSE;
+
+    psram_class_stats_t *st = &class_stats[size_class(csize)];
+    st->allocs++;
+    st->in_use++;
+
     (void)xTaskResumeAll();
-    return result;
+    return CHUNK_MEM(c);
 }
 
 void psram_free(void *ptr) {
@@ -162,69 +255,71 @@ void psram_free(void *ptr) {
         return;
     }
 
-    block_hdr_t *blk = (block_hdr_t *)((uint8_t *)ptr - HDR_SIZE);
+    chunk_t *c = MEM_CHUNK(ptr);
+    size_t size = CHUNK_SIZE(c);
 
-    /* Sanity: block header must be inside PSRAM */
-    uintptr_t blk_addr = (uintptr_t)blk;
-    if (blk_addr < PSRAM_BASE || blk_addr >= (PSRAM_BASE + detected_size)) {
-        printf("[psram_free] BAD ptr %p (hdr %p outside PSRAM)\n", ptr, blk);
+    /* Sanity: header inside the heap, chunk ends at or before the top */
+    if (!chunk_in_heap(c) || (addr & (ALIGN - 1)) || size < MIN_CHUNK ||
+        (uintptr_t)c + size > heap_top) {
+        printf("[psram_free] BAD ptr %p (size %u)\n", ptr, (unsigned)size);
         return;
     }
 
     vTaskSuspendAll();
 
-    /* Insert into free list in address order and coalesce.
-     * Guard against corrupted free list (cycle detection). */
-    block_hdr_t **prev = &free_list;
-    block_hdr_t  *cur  = free_list;
-    int steps = 0;
-    const int max_steps = (int)(detected_size / MIN_BLOCK);
-
-    while (cur && cur < blk) {
-        if (++steps > max_steps) {
-            /* Free list is corrupted — break to avoid infinite loop */
-            (void)xTaskResumeAll();
-            printf("[psram_free] CORRUPT free list at %p (freeing %p), %d steps\n",
-                   cur, ptr, steps);
-            return;
-        }
-        /* Validate that next pointer stays within PSRAM */
-        if (cur->next && ((uintptr_t)cur->next < PSRAM_BASE ||
-                          (uintptr_t)cur->next >= (PSRAM_BASE + detected_size))) {
-            (void)xTaskResumeAll();
-            printf("[psram_free] CORRUPT node %p->next=%p (freeing %p)\n",
-                   cur, cur->next, ptr);
-            return;
-        }
-        prev = &cur->next;
-        cur  = cur->next;
-    }
-
-    /* Detect double-free: blk should not already be in the free list */
-    if (cur == blk) {
+    if (!(c->head & CINUSE)) {
         (void)xTaskResumeAll();
         printf("[psram_free] DOUBLE FREE %p\n", ptr);
         return;
     }
 
-    blk->next = cur;
-    *prev = blk;
+    psram_class_stats_t *st = &class_stats[size_class(size)];
+    st->frees++;
+    st->in_use--;
 
-    /* Coalesce with next block */
-    if (cur && (uint8_t *)blk + HDR_SIZE + blk->size == (uint8_t *)cur) {
-        blk->size += HDR_SIZE + cur->size;
-        blk->next  = cur->next;
+    /* Coalesce with the next chunk */
+    chunk_t *nx = CHUNK_AT(c, size);
+    if (!(nx->head & CINUSE)) {
+        size_t nsize = CHUNK_SIZE(nx);
+        bin_remove(nx, nsize);
+        size += nsize;
     }
 
-    /* Coalesce with previous block */
-    if (prev != &free_list) {
-        block_hdr_t *prv = (block_hdr_t *)((char *)prev - offsetof(block_hdr_t, next));
-        if ((uint8_t *)prv + HDR_SIZE + prv->size == (uint8_t *)blk) {
-            prv->size += HDR_SIZE + blk->size;
-            prv->next  = blk->next;
+    /* Coalesce with the previous chunk */
+    if (!(c->head & PINUSE)) {
+        chunk_t *pv = CHUNK_AT(c, -(intptr_t)c->prev_size);
+        if (!chunk_in_heap(pv) || CHUNK_SIZE(pv) != c->prev_size) {
+            (void)xTaskResumeAll();
+            printf("[psram_free] CORRUPT boundary tag at %p (freeing %p)\n",
+                   c, ptr);
+            return;
         }
+        bin_remove(pv, c->prev_size);
+        size += c->prev_size;
+        c = pv;
     }
 
+    chunk_set_free(c, size);
+    bin_insert(c, size);
+
+    (void)xTaskResumeAll();
+}
+
+void psram_get_stats(psram_stats_t *out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    if (!detected_size) return;
+
+    vTaskSuspendAll();
+    out->total_bytes = (uint32_t)(heap_top - PSRAM_BASE);
+    out->free_bytes  = (uint32_t)free_bytes;
+    memcpy(out->classes, class_stats, sizeof(class_stats));
+    /* Largest free chunk lives in the highest non-empty bin */
+    if (bin_map) {
+        for (chunk_t *c = bins[size_class(bin_map)]; c; c = c->next)
+            if (CHUNK_SIZE(c) > out->largest_free)
+                out->largest_free = (uint32_t)CHUNK_SIZE(c);
+    }
     (void)xTaskResumeAll();
 }
 
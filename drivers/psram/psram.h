@@ -24,7 +24,26 @@
  * Returns detected size in bytes, or 0 if no PSRAM present. */
 unsigned int butter_psram_size(void);
 
-/* Initialize the PSRAM free-list allocator.
+/* Allocator size classes: class k covers chunks of [2^k, 2^(k+1)) bytes,
+ * header included (8 bytes; the smallest chunk is 24 bytes, class 4) */
+#define PSRAM_NCLASSES  32
+
+typedef struct {
+    uint32_t allocs;        /* successful allocations */
+    uint32_t frees;
+    uint32_t failures;      /* requests no free chunk could satisfy */
+    uint32_t in_use;        /* allocated chunks now */
+    uint32_t free_blocks;   /* free chunks waiting in the bin */
+} psram_class_stats_t;
+
+typedef struct {
+    uint32_t total_bytes;   /* heap size (0 if no PSRAM) */
+    uint32_t free_bytes;    /* sum of free chunks, headers included */
+    uint32_t largest_free;  /* biggest single free chunk */
+    psram_class_stats_t classes[PSRAM_NCLASSES];
+} psram_stats_t;
+
+/* Initialize the PSRAM allocator.
  * Call once at boot after psram_init() (if PSRAM HW init was done). */
 void psram_heap_init(void);
 
@@ -32,9 +51,12 @@ void psram_heap_init(void);
 void *psram_alloc(size_t size);
 
 /* Free a pointer.  If ptr is in the PSRAM range, returns it to the PSRAM
- * free list; otherwise falls through to vPortFree(). */
+ * heap; otherwise falls through to vPortFree(). */
 void psram_free(void *ptr);
 
+/* Snapshot of the allocator counters (all zero when PSRAM is absent) */
+void psram_get_stats(psram_stats_t *out);
+
 /* Returns true if PSRAM was detected and the allocator is active. */
 bool psram_is_available(void);
 
@@ -35,12 +35,36 @@ static inline void sd_yield(void) {
 
 #include "ff.h"
 #include "diskio.h"
+#include "ffcache.h"
+#include "psram.h"
+#include <string.h>
 
 /* DMA channels (claimed at init) */
 static int sd_dma_tx = -1;
 static int sd_dma_rx = -1;
 static uint8_t sd_dma_dummy = 0xFF;
 
+/* Upper bound for the negotiated SPI clock; the card's CSD rate applies
+ * below it.  Boards with long traces or level shifters may lower it. */
+#ifndef SD_CLK_MAX
+#define SD_CLK_MAX      (50 * MHZ)
+#endif
+
+/* Sequential read-ahead: SD_RA_WINDOWS readers followed at once, each
+ * prefetching SD_RA_SECTORS past its last read.  Scattered reads (FAT,
+ * directories) take windows too, hence the margin over the number of
+ * files typically streamed together.  Windows live in PSRAM; without it
+ * only the open CMD18 stream is kept between calls. */
+#ifndef SD_RA_WINDOWS
+#define SD_RA_WINDOWS   4
+#endif
+#ifndef SD_RA_SECTORS
+#define SD_RA_SECTORS   8
+#endif
+
+#define SD_READ_RETRIES 3
+#define SD_CLK_PROBES   4
+
 /*--------------------------------------------------------------------------
    Module Private Functions
 ---------------------------------------------------------------------------*/
@@ -75,10 +99,13 @@ static uint8_t sd_dma_dummy = 0xFF;
 #define CT_BLOCK       0x08
 
 #define CLK_SLOW	(100 * KHZ)
-#define CLK_FAST	(10 * MHZ)
+#define CLK_FAST	(10 * MHZ)	/* Floor for negotiation, always safe */
+#define CLK_MIN		(1 * MHZ)	/* Floor after repeated CRC errors */
 
 static volatile DSTATUS Stat = STA_NOINIT;
 static BYTE CardType;
+static LBA_t CardSectors;		/* Read-ahead never passes the end */
+static uint32_t sd_clk = CLK_FAST;	/* Current data clock */
 
 #ifdef SDCARD_PIO
 pio_spi_inst_t pio_spi = {
@@ -113,12 +140,6 @@ static void FCLK_SLOW(void) {
 #endif
 }
 
-static void FCLK_FAST(void) {
-#ifndef SDCARD_PIO
-    spi_set_baudrate(SDCARD_SPI_BUS, CLK_FAST);
-#endif
-}
-
 static void CS_HIGH(void) { cs_deselect(SDCARD_PIN_SPI0_CS); }
 static void CS_LOW(void) { cs_select(SDCARD_PIN_SPI0_CS); }
 
@@ -139,8 +160,9 @@ static void init_spi(void) {
     gpio_set_function(SDCARD_PIN_SPI0_MOSI, GPIO_FUNC_SPI);
     spi_init(SDCARD_SPI_BUS, CLK_SLOW);
     spi_set_format(SDCARD_SPI_BUS, 8, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
-    sd_dma_tx = dma_claim_unused_channel(true);
-    sd_dma_rx = dma_claim_unused_channel(true);
+    /* disk_initialize() may run several times while mounting */
+    if (sd_dma_tx < 0) sd_dma_tx = dma_claim_unused_channel(true);
+    if (sd_dma_rx < 0) sd_dma_rx = dma_claim_unused_channel(true);
 #else
     gpio_set_dir(SDCARD_PIN_SPI0_SCK, GPIO_OUT);
     gpio_set_dir(SDCARD_PIN_SPI0_MISO, GPIO_OUT);
@@ -163,24 +185,62 @@ static BYTE xchg_spi(BYTE dat) {
     return (BYTE)*buff;
 }
 
-/* Receive multiple bytes — chunked with FreeRTOS yields */
-static void rcvr_spi_multi(BYTE *buff, UINT btr) {
-    uint8_t *b = (uint8_t *)buff;
+/* Start receiving btr bytes by DMA: the TX channel clocks out 0xFF from
+ * sd_dma_dummy while the RX channel drains the FIFO into buff.  The FIFOs
+ * are empty here — every blocking SPI call drains them. */
+static void rcvr_spi_start(BYTE *buff, UINT btr) {
+#ifndef SDCARD_PIO
+    spi_hw_t *hw = spi_get_hw(SDCARD_SPI_BUS);
+    dma_channel_config c = dma_channel_get_default_config(sd_dma_rx);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_dreq(&c, spi_get_dreq(SDCARD_SPI_BUS, false));
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    dma_channel_configure(sd_dma_rx, &c, buff, &hw->dr, btr, false);
+
+    c = dma_channel_get_default_config(sd_dma_tx);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_dreq(&c, spi_get_dreq(SDCARD_SPI_BUS, true));
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, false);
+    dma_channel_configure(sd_dma_tx, &c, &hw->dr, &sd_dma_dummy, btr, false);
+
+    dma_start_channel_mask((1u << sd_dma_tx) | (1u << sd_dma_rx));
+#else
+    pio_spi_repeat8_read8_blocking(&pio_spi, 0xff, buff, btr);
+#endif
+}
+
+/* Wait for rcvr_spi_start(), letting other tasks run meanwhile */
+static void rcvr_spi_wait(void) {
 #ifndef SDCARD_PIO
-    const UINT chunk_size = 32;
-    while (btr > 0) {
-        UINT chunk = (btr > chunk_size) ? chunk_size : btr;
-        spi_read_blocking(SDCARD_SPI_BUS, 0xff, b, chunk);
-        b += chunk;
-        btr -= chunk;
+    while (dma_channel_is_busy(sd_dma_rx)) {
         tight_loop_contents();
         sd_yield();
     }
-#else
-    pio_spi_repeat8_read8_blocking(&pio_spi, 0xff, b, btr);
 #endif
 }
 
+/* Receive multiple bytes */
+static void rcvr_spi_multi(BYTE *buff, UINT btr) {
+    rcvr_spi_start(buff, btr);
+    rcvr_spi_wait();
+}
+
+/* CRC16-CCITT (x^16 + x^12 + x^5 + 1) of a data block, as the card sends
+ * it after every block even with CRC checking off in SPI mode */
+static WORD crc16(const BYTE *p, UINT n) {
+    WORD crc = 0;
+    while (n--) {
+        crc = (WORD)((crc >> 8) | (crc << 8));
+        crc ^= *p++;
+        crc ^= (BYTE)crc >> 4;
+        crc ^= (WORD)(crc << 12);
+        crc ^= (WORD)((crc & 0xFF) << 5);
+    }
+    return crc;
+}
+
 /*-----------------------------------------------------------------------*/
 /* Wait for card ready                                                   */
 /*-----------------------------------------------------------------------*/
@@ -209,7 +269,7 @@ static int _select(void) {
     return 0;
 }
 
-static int rcvr_datablock(BYTE *buff, UINT btr) {
+static int wait_token(void) {
     BYTE token;
     const uint32_t timeout = 200;
     uint32_t t = _millis();
@@ -217,13 +277,43 @@ static int rcvr_datablock(BYTE *buff, UINT btr) {
         token = xchg_spi(0xFF);
         tight_loop_contents();
     } while (token == 0xFF && _millis() < t + timeout);
-    if (token != 0xFE) return 0;
+    return token == 0xFE;
+}
+
+static int rcvr_datablock(BYTE *buff, UINT btr) {
+    if (!wait_token()) return 0;
     rcvr_spi_multi(buff, btr);
     xchg_spi(0xFF);
     xchg_spi(0xFF);
     return 1;
 }
 
+/* A received sector whose CRC is still to be checked */
+typedef struct {
+    const BYTE *data;
+    WORD crc;
+} crc_job_t;
+
+static int crc_job_ok(crc_job_t *job) {
+    int ok = !job->data || crc16(job->data, 512) == job->crc;
+    job->data = NULL;
+    return ok;
+}
+
+/* Receive one 512-byte sector.  The CRC of the previous sector (job) is
+ * computed while this one is in flight; this one becomes the new job. */
+static int rcvr_sector(BYTE *buff, crc_job_t *job) {
+    if (!wait_token()) return 0;
+    rcvr_spi_start(buff, 512);
+    int ok = crc_job_ok(job);
+    rcvr_spi_wait();
+    WORD crc = (WORD)xchg_spi(0xFF) << 8;
+    crc |= xchg_spi(0xFF);
+    job->data = buff;
+    job->crc = crc;
+    return ok;
+}
+
 static BYTE send_cmd(BYTE cmd, DWORD arg) {
     BYTE n, res;
 
@@ -257,16 +347,171 @@ static BYTE send_cmd(BYTE cmd, DWORD arg) {
     return res;
 }
 
+/*-----------------------------------------------------------------------*/
+/* Streamed reads                                                        */
+/*                                                                       */
+/* A CMD18 transfer is left open after disk_read(): the card stays       */
+/* selected and its next data block is sector stream_next, so a read     */
+/* continuing there costs no command at all.  Anything else stops it     */
+/* with CMD12 first.                                                     */
+/*-----------------------------------------------------------------------*/
+
+static bool  stream_open;
+static LBA_t stream_next;
+
+static void stream_stop(void) {
+    if (!stream_open) return;
+    stream_open = false;
+    send_cmd(CMD12, 0);
+    deselect();
+}
+
+/* Position the card at sector: continue the open stream, else start a
+ * CMD18 (or a CMD17 for a lone sector, which needs no CMD12 later) */
+static int stream_seek(LBA_t sector, UINT count) {
+    if (stream_open && stream_next == sector) return 1;
+    stream_stop();
+    DWORD addr = (CardType & CT_BLOCK) ? (DWORD)sector : (DWORD)sector * 512;
+    if (count == 1) return send_cmd(CMD17, addr) == 0;
+    if (send_cmd(CMD18, addr) != 0) return 0;
+    stream_open = true;
+    stream_next = sector;
+    return 1;
+}
+
+/* Read count sectors into buff, then ra more into ra_buf, CRC-checked */
+static int read_sectors(BYTE *buff, LBA_t sector, UINT count, BYTE *ra_buf, UINT ra) {
+    crc_job_t job = { 0 };
+    int ok = stream_seek(sector, count + ra);
+    for (UINT i = 0; ok && i < count + ra; i++) {
+        ok = rcvr_sector(i < count ? buff + i * 512 : ra_buf + (i - count) * 512, &job);
+        if (stream_open) stream_next++;
+    }
+    ok = crc_job_ok(&job) && ok;
+    if (!ok) stream_stop();
+    if (!stream_open) deselect();
+    return ok;
+}
+
+/*-----------------------------------------------------------------------*/
+/* Read-ahead windows                                                    */
+/*                                                                       */
+/* Each window follows one sequential reader — in practice one open file */
+/* — by the sector where its last read ended.  A read starting there     */
+/* pulls the next SD_RA_SECTORS into the window with the same burst.     */
+/*-----------------------------------------------------------------------*/
+
+typedef struct {
+    BYTE    *buf;       /* SD_RA_SECTORS * 512, NULL = tracking only */
+    LBA_t    base;      /* first sector held */
+    UINT     valid;     /* sectors held */
+    LBA_t    next;      /* where the reader's last read ended */
+    uint32_t last_use;
+} ra_win_t;
+
+static ra_win_t ra_win[SD_RA_WINDOWS];
+static uint32_t ra_clock;
+
+static ra_win_t *ra_holding(LBA_t sector) {
+    for (int i = 0; i < SD_RA_WINDOWS; i++) {
+        ra_win_t *w = &ra_win[i];
+        if (w->valid && sector >= w->base && sector < w->base + w->valid) return w;
+    }
+    return NULL;
+}
+
+/* The window following a reader that now asks for sector; a miss
+ * recycles the least recently used window to start following it */
+static ra_win_t *ra_follow(LBA_t sector, bool *sequential) {
+    ra_win_t *lru = &ra_win[0];
+    for (int i = 0; i < SD_RA_WINDOWS; i++) {
+        ra_win_t *w = &ra_win[i];
+        if (w->next == sector && w->last_use) {
+            *sequential = true;
+            return w;
+        }
+        if (w->last_use < lru->last_use) lru = w;
+    }
+    *sequential = false;
+    lru->valid = 0;
+    return lru;
+}
+
+static void ra_invalidate(LBA_t sector, UINT count) {
+    for (int i = 0; i < SD_RA_WINDOWS; i++) {
+        ra_win_t *w = &ra_win[i];
+        if (w->valid && sector < w->base + w->valid && w->base < sector + count)
+            w->valid = 0;
+    }
+}
+
+static void ra_reset(void) {
+    for (int i = 0; i < SD_RA_WINDOWS; i++) {
+        ra_win[i].valid = 0;
+        ra_win[i].last_use = 0;
+    }
+}
+
+/*-----------------------------------------------------------------------*/
+/* Clock negotiation                                                     */
+/*-----------------------------------------------------------------------*/
+
+static void set_clock(uint32_t hz) {
+#ifndef SDCARD_PIO
+    sd_clk = spi_set_baudrate(SDCARD_SPI_BUS, hz);
+#else
+    (void)hz;
+#endif
+}
+
+/* TRAN_SPEED from the CSD, in Hz */
+static uint32_t csd_tran_speed(const BYTE *csd) {
+    static const uint8_t mult[16] = { 0, 10, 12, 13, 15, 20, 25, 30, 35, 40, 45, 50, 55, 60, 70, 80 };
+    static const uint32_t unit[4] = { 10 * KHZ, 100 * KHZ, 1 * MHZ, 10 * MHZ };
+    if ((csd[3] & 7) > 3) return 0;
+    return unit[csd[3] & 7] * mult[(csd[3] >> 3) & 15];
+}
+
+/* Read sector 0 a few times; every copy must pass its CRC */
+static int clock_ok(void) {
+    BYTE buf[512];
+    for (int i = 0; i < SD_CLK_PROBES; i++)
+        if (!read_sectors(buf, 0, 1, NULL, 0)) return 0;
+    return 1;
+}
+
+/* Start at the card's rated clock and step down until reads verify */
+static void negotiate_clock(void) {
+    BYTE csd[16];
+    uint32_t rated = 0;
+    if (send_cmd(CMD9, 0) == 0 && rcvr_datablock(csd, 16)) rated = csd_tran_speed(csd);
+    deselect();
+    if (rated > SD_CLK_MAX) rated = SD_CLK_MAX;
+    for (uint32_t f = rated; f > CLK_FAST; f = f * 3 / 4) {
+        set_clock(f);
+        if (clock_ok()) return;
+    }
+    set_clock(CLK_FAST);
+}
+
+/* A transfer failed: retry slower */
+static void clock_down(void) {
+    uint32_t f = sd_clk * 3 / 4;
+    set_clock(f < CLK_MIN ? CLK_MIN : f);
+}
+
 /*--------------------------------------------------------------------------
    Public Functions
 ---------------------------------------------------------------------------*/
 
-DSTATUS disk_initialize(BYTE drv) {
+DSTATUS sd_disk_initialize(BYTE drv) {
     BYTE n, cmd, ty, ocr[4];
     const uint32_t timeout = 1000;
     uint32_t t;
 
     if (drv) return STA_NOINIT;
+    stream_open = false;
+    ra_reset();
     init_spi();
     sleep_ms(10);
 
@@ -303,8 +548,10 @@ DSTATUS disk_initialize(BYTE drv) {
     deselect();
 
     if (ty) {
-        FCLK_FAST();
         Stat &= ~STA_NOINIT;
+        negotiate_clock();
+        DWORD n_sect;
+        CardSectors = sd_disk_ioctl(drv, GET_SECTOR_COUNT, &n_sect) == RES_OK ? n_sect : 0;
     } else {
         Stat = STA_NOINIT;
     }
@@ -312,32 +559,51 @@ DSTATUS disk_initialize(BYTE drv) {
     return Stat;
 }
 
-DSTATUS disk_status(BYTE drv) {
+DSTATUS sd_disk_status(BYTE drv) {
     if (drv) return STA_NOINIT;
     return Stat;
 }
 
-DRESULT disk_read(BYTE drv, BYTE *buff, LBA_t sector, UINT count) {
+DRESULT sd_disk_read(BYTE drv, BYTE *buff, LBA_t sector, UINT count) {
     if (drv || !count) return RES_PARERR;
     if (Stat & STA_NOINIT) return RES_NOTRDY;
 
-    if (!(CardType & CT_BLOCK)) sector *= 512;
-
-    if (count == 1) {
-        if ((send_cmd(CMD17, sector) == 0) && rcvr_datablock(buff, 512)) {
-            count = 0;
-        }
-    } else {
-        if (send_cmd(CMD18, sector) == 0) {
-            do {
-                if (!rcvr_datablock(buff, 512)) break;
-                buff += 512;
-            } while (--count);
-            send_cmd(CMD12, 0);
+    /* Serve what the windows already hold */
+    ra_win_t *w;
+    while (count && (w = ra_holding(sector)) != NULL) {
+        UINT n = w->base + w->valid - sector;
+        if (n > count) n = count;
+        memcpy(buff, w->buf + (sector - w->base) * 512, n * 512);
+        w->next = sector + n;
+        w->last_use = ++ra_clock;
+        buff += n * 512;
+        sector += n;
+        count -= n;
+    }
+    if (!count) return RES_OK;
+
+    bool seq;
+    w = ra_follow(sector, &seq);
+    UINT ra = 0;
+    if (seq) {
+        if (!w->buf) w->buf = (BYTE *)psram_alloc(SD_RA_SECTORS * 512);
+        if (w->buf) ra = SD_RA_SECTORS;
+        if (CardSectors && sector + count + ra > CardSectors)
+            ra = sector + count < CardSectors ? CardSectors - (sector + count) : 0;
+    }
+    w->valid = 0;
+    w->next = sector + count;
+    w->last_use = ++ra_clock;
+
+    for (int attempt = 0; attempt < SD_READ_RETRIES; attempt++) {
+        if (read_sectors(buff, sector, count, w->buf, ra)) {
+            w->base = sector + count;
+            w->valid = ra;
+            return RES_OK;
         }
+        clock_down();
     }
-    deselect();
-    return count ? RES_ERROR : RES_OK;
+    return RES_ERROR;
 }
 
 #if !FF_FS_READONLY
@@ -365,11 +631,13 @@ static int xmit_datablock(const BYTE *buff, BYTE token) {
     return 1;
 }
 
-DRESULT disk_write(BYTE drv, const BYTE *buff, LBA_t sector, UINT count) {
+DRESULT sd_disk_write(BYTE drv, const BYTE *buff, LBA_t sector, UINT count) {
     if (drv || !count) return RES_PARERR;
     if (Stat & STA_NOINIT) return RES_NOTRDY;
     if (Stat & STA_PROTECT) return RES_WRPRT;
 
+    stream_stop();
+    ra_invalidate(sector, count);
     if (!(CardType & CT_BLOCK)) sector *= 512;
 
     if (!_select()) return RES_NOTRDY;
@@ -393,7 +661,7 @@ DRESULT disk_write(BYTE drv, const BYTE *buff, LBA_t sector, UINT count) {
 }
 #endif
 
-DRESULT disk_ioctl(BYTE drv, BYTE cmd, void *buff) {
+DRESULT sd_disk_ioctl(BYTE drv, BYTE cmd, void *buff) {
     DRESULT res;
     BYTE n, csd[16];
     DWORD *dp, st, ed, csize;
@@ -401,6 +669,7 @@ DRESULT disk_ioctl(BYTE drv, BYTE cmd, void *buff) {
     if (drv) return RES_PARERR;
     if (Stat & STA_NOINIT) return RES_NOTRDY;
 
+    stream_stop();
     res = RES_ERROR;
 
     switch (cmd) {
@@ -446,7 +715,7 @@ DRESULT disk_ioctl(BYTE drv, BYTE cmd, void *buff) {
 
     case CTRL_TRIM:
         if (!(CardType & CT_SDC)) break;
-        if (disk_ioctl(drv, MMC_GET_CSD, csd)) break;
+        if (sd_disk_ioctl(drv, MMC_GET_CSD, csd)) break;
         if (!(csd[0] >> 6) && !(csd[10] & 0x40)) break;
         dp = buff; st = dp[0]; ed = dp[1];
         if (!(CardType & CT_BLOCK)) { st *= 512; ed *= 512; }
@@ -32,6 +32,8 @@ static volatile int     mouse_has_update = 0;
 static volatile int keyboard_connected = 0;
 static volatile int mouse_connected = 0;
 
+static void (*wake_handler)(void) = NULL;
+
 #define KEY_ACTION_QUEUE_SIZE 32
 typedef struct {
     uint8_t keycode;
@@ -184,6 +186,7 @@ void tuh_hid_report_received_cb(uint8_t dev_addr, uint8_t instance,
             break;
     }
 
+    if (wake_handler) wake_handler();
     tuh_hid_receive_report(dev_addr, instance);
 }
 
@@ -225,6 +228,10 @@ void usbhid_get_mouse_state(usbhid_mouse_state_t *state) {
     mouse_has_update = 0;
 }
 
+void usbhid_set_wake_handler(void (*fn)(void)) {
+    wake_handler = fn;
+}
+
 int usbhid_get_key_action(uint8_t *keycode, int *down) {
     if (key_action_head == key_action_tail)
         return 0;
@@ -43,6 +43,13 @@ int usbhid_get_key_action(uint8_t *keycode, int *down);
  */
 void usbhid_get_mouse_state(usbhid_mouse_state_t *state);
 
+/*
+ * Set a function called after each keyboard or mouse report is queued,
+ * so the reader can sleep until input arrives.  Runs in the task that
+ * calls usbhid_task().
+ */
+void usbhid_set_wake_handler(void (*fn)(void));
+
 #ifdef __cplusplus
 }
 #endif
@@ -42,7 +42,8 @@ static hwnd_t   at_original_focus;     /* focus before overlay opened */
 
 typedef struct {
     hwnd_t        hwnd;
-    const uint8_t *icon;               /* pointer to 32x32 icon data */
+    const gfx_icon_t *icon;            /* window's packed 32x32 icon */
+    const uint8_t *raw;                /* 32x32 icon data when icon is NULL */
     char          title[24];
 } at_entry_t;
 
@@ -78,11 +79,21 @@ static const uint8_t *get_default_icon32(void) {
     return at_default_icon32;
 }
 
+/* Drop the icon references the entry list holds, so a window closed
+ * while the overlay is open doesn't free an icon it still draws */
+static void release_icons(void) {
+    for (int i = 0; i < at_count; i++) {
+        gfx_icon_put(at_entries[i].icon);
+        at_entries[i].icon = NULL;
+    }
+}
+
 /* Build the entry list from current windows.
  * Includes all ALIVE | BORDER windows regardless of minimised/suspended state.
  * Order: top of z-stack first (most recent), so the first entry is the
  * currently focused window and the second is the "switch to" target. */
 static void build_list(void) {
+    release_icons();
     at_count = 0;
     /* Iterate windows 1..WM_MAX_WINDOWS.  We want z-order top→bottom,
      * so sort by z_order descending. Simple selection: WM_MAX_WINDOWS ≤ 16. */
@@ -112,7 +123,8 @@ static void build_list(void) {
         window_t *w = wm_get_window(sorted[i]);
         at_entry_t *e = &at_entries[at_count];
         e->hwnd = sorted[i];
-        e->icon = w->icon32 ? w->icon32 : get_default_icon32();
+        e->icon = gfx_icon_ref(w->icon32);
+        e->raw  = get_default_icon32();
         strncpy(e->title, w->title, sizeof(e->title) - 1);
         e->title[sizeof(e->title) - 1] = '\0';
         at_count++;
@@ -122,7 +134,8 @@ static void build_list(void) {
     if (desktop_has_shortcuts() && at_count < AT_MAX_ENTRIES) {
         at_entry_t *e = &at_entries[at_count];
         e->hwnd = HWND_NULL;  /* sentinel: means "desktop" */
-        e->icon = desktop_get_icon32();
+        e->icon = NULL;
+        e->raw  = desktop_get_icon32();
         strncpy(e->title, L(STR_ALTTAB_DESKTOP), sizeof(e->title) - 1);
         e->title[sizeof(e->title) - 1] = '\0';
         at_count++;
@@ -169,6 +182,7 @@ void alttab_cycle(void) {
 void alttab_commit(void) {
     if (!at_active) return;
     at_active = false;
+    release_icons();
 
     hwnd_t target = at_entries[at_sel].hwnd;
 
@@ -210,6 +224,7 @@ void alttab_commit(void) {
 void alttab_cancel(void) {
     if (!at_active) return;
     at_active = false;
+    release_icons();
     /* Restore focus to the window that was active before the overlay */
     wm_set_focus(at_original_focus);
     wm_force_full_repaint();
@@ -262,7 +277,10 @@ void alttab_draw(void) {
         }
 
         /* Draw 32x32 icon */
-        gfx_draw_icon_32(icon_x, icon_y, e->icon);
+        if (e->icon)
+            gfx_draw_icon(icon_x, icon_y, e->icon);
+        else
+            gfx_draw_icon_32(icon_x, icon_y, e->raw);
     }
 
     /* ── Title of selected entry (centered below icons, clipped) ── */
@@ -25,13 +25,21 @@
 #include "../drivers/psram/psram.h"
 #include "dialog.h"
 #include "window.h"
+#include "window_event.h"
 #include "swap.h"
+#include "app_cache.h"
+#include "fxe.h"
 #include <hardware/watchdog.h>
 
 extern void snd_deinit(void);
 
 #define APP_TASK_PRIORITY 1
 
+/* Load apps from, and write, pre-linked <app>.fxe images (fxe.h) */
+#ifndef APP_FXE
+#define APP_FXE 1
+#endif
+
 extern const char TEMP[];
 const char _flash_me[] = ".flash_me";
 extern uint32_t butter_psram_size_var;
@@ -267,186 +275,6 @@ void __in_hfa() run_app(char * name) {
     xTaskCreate(vAppTask, name, 2048, NULL, APP_TASK_PRIORITY, NULL);
 }
 
-// Декодирование и обновление инструкции BL для ссылки типа R_ARM_THM_PC22
-// Функция для разрешения ссылки типа R_ARM_THM_PC22
-void __in_hfa() resolve_thm_pc22(uint16_t* addr, uint16_t* addr_ref, uint32_t sym_val) {
-    uint16_t instr0 = *addr;
-    uint16_t instr = *(addr + 1);
-    // Декодирование текущего смещения
-    uint32_t S = (instr0 >> 10) & 1;
-    uint32_t J1 = (instr >> 13) & 1;
-    uint32_t J2 = (instr >> 11) & 1;
-    uint32_t imm10 = instr0 & 0x03FF;
-    uint32_t imm11 = instr & 0x07FF;
-
-    uint32_t I1 = (~(J1 ^ S) & 1);
-    uint32_t I2 = (~(J2 ^ S) & 1);
-    uint32_t offset = (I1 << 23) | (I2 << 22) | (imm10 << 12) | (imm11 << 1);
-    if (S) {
-        offset |= 0xFF800000; // знак расширение
-    }
-
-    // Вычисление нового смещения
-    uint32_t new_offset = (uint32_t)((int32_t)offset + (int32_t)sym_val - (int32_t)addr_ref);
-    S = new_offset >> 31;
-    I1 = (new_offset >> 23) & 1;
-    I2 = (new_offset >> 22) & 1;
-    imm10 = (new_offset >> 12) & 0x03FF;
-    imm11 = (new_offset >> 1) & 0x07FF;
-
-    J1 = (~(I1 ^ S) & 1);
-    J2 = (~(I2 ^ S) & 1);
-    //goutf("ov: %ph off: %ph noff: %ph -> %d:%d:%d:%x:%x", *addr, offset, new_offset, S, J1, J2, imm10, imm11);
-
-    // Обновление инструкции
-    *addr++ = 0xF000 | (S << 10) | imm10;
-    *addr = (0b11010 << 11) | (J1 << 13) | (J2 << 11) | imm11;
-    //goutf("%04X %04X -> %04X %04X [%p]\n" , instr0, instr, *(addr-1), *addr, addr - 1);
-}
-
-// Разрешение ссылки типа R_ARM_THM_JUMP24 (B.W в Thumb-2)
-// Mirrors resolve_thm_pc22 (BL) logic, but emits B.W encoding instead of BL.
-static void __in_hfa() resolve_thm_jump24(uint16_t* addr, uint16_t* addr_ref, uint32_t sym_val) {
-    uint16_t instr0 = addr[0];
-    uint16_t instr1 = addr[1];
-
-    // Декодирование текущего смещения (same as BL)
-    uint32_t S     = (instr0 >> 10) & 1;
-    uint32_t J1    = (instr1 >> 13) & 1;
-    uint32_t J2    = (instr1 >> 11) & 1;
-    uint32_t imm10 = instr0 & 0x03FF;
-    uint32_t imm11 = instr1 & 0x07FF;
-
-    uint32_t I1 = (~(J1 ^ S)) & 1;
-    uint32_t I2 = (~(J2 ^ S)) & 1;
-
-    uint32_t offset = (I1 << 23) | (I2 << 22) | (imm10 << 12) | (imm11 << 1);
-    if (S) {
-        offset |= 0xFF800000;
-    }
-
-    // Вычисление нового смещения (same formula as resolve_thm_pc22)
-    uint32_t new_offset = (uint32_t)((int32_t)offset + (int32_t)sym_val - (int32_t)addr_ref);
-
-    S     = new_offset >> 31;
-    I1    = (new_offset >> 23) & 1;
-    I2    = (new_offset >> 22) & 1;
-    imm10 = (new_offset >> 12) & 0x03FF;
-    imm11 = (new_offset >> 1)  & 0x07FF;
-
-    J1 = (~(I1 ^ S)) & 1;
-    J2 = (~(I2 ^ S)) & 1;
-
-    // B.W encoding: upper = 11110 S imm10, lower = 10 J1 1 J2 imm11
-    addr[0] = (uint16_t)(0xF000 | (S << 10) | imm10);
-    addr[1] = (uint16_t)(0x9000 | (J1 << 13) | (J2 << 11) | imm11);
-}
-
-// Разрешение ссылки типа R_ARM_THM_JUMP19 (B<cond>.W в Thumb-2)
-// Conditional branch with 21-bit signed offset (±1 MB range).
-// Encoding differs from B.W: J1/J2 are NOT XOR-inverted with S;
-// upper = 11110 S cond imm6, lower = 10 J1 0 J2 imm11.
-static void __in_hfa() resolve_thm_jump19(uint16_t* addr, uint16_t* addr_ref, uint32_t sym_val) {
-    uint16_t instr0 = addr[0];
-    uint16_t instr1 = addr[1];
-
-    // Decode current offset from B<cond>.W
-    uint32_t S     = (instr0 >> 10) & 1;
-    uint32_t cond4 = (instr0 >> 6) & 0xF;  // condition code (preserved)
-    uint32_t imm6  = instr0 & 0x3F;
-    uint32_t J1    = (instr1 >> 13) & 1;
-    uint32_t J2    = (instr1 >> 11) & 1;
-    uint32_t imm11 = instr1 & 0x7FF;
-
-    // offset = SignExtend(S:J2:J1:imm6:imm11:0, 21)
-    uint32_t offset = (S << 20) | (J2 << 19) | (J1 << 18) | (imm6 << 12) | (imm11 << 1);
-    if (S) {
-        offset |= 0xFFE00000; // sign extend from bit 20
-    }
-
-    // Calculate new offset
-    uint32_t new_offset = (uint32_t)((int32_t)offset + (int32_t)sym_val - (int32_t)addr_ref);
-
-    // Re-encode
-    S     = (new_offset >> 20) & 1;
-    J2    = (new_offset >> 19) & 1;
-    J1    = (new_offset >> 18) & 1;
-    imm6  = (new_offset >> 12) & 0x3F;
-    imm11 = (new_offset >> 1)  & 0x7FF;
-
-    // B<cond>.W: upper = 11110 S cond imm6, lower = 10 J1 0 J2 imm11
-    addr[0] = (uint16_t)(0xF000 | (S << 10) | (cond4 << 6) | imm6);
-    addr[1] = (uint16_t)(0x8000 | (J1 << 13) | (J2 << 11) | imm11);
-}
-
-// вставить где-то рядом с resolve_thm_pc22/resolve_thm_jump24
-// value -- (A + S) — итоговое 32-битное значение, которое нужно вставить (MOVW/MOVT берут 16 бит)
-static void __in_hfa() resolve_thm_alu_abs_g0_nc(uint16_t* addr, uint32_t base_value)
-{
-    // addr указывает на пару halfword'ов MOVW (32-bit Thumb)
-    uint16_t instr0 = addr[0];
-    uint16_t instr1 = addr[1];
-
-    // -------------------------------
-    // 1. ДЕКОДИРУЕМ addend (imm16)
-    // -------------------------------
-    uint32_t imm4  = instr0 & 0x000F;
-    uint32_t i_bit = (instr0 >> 10) & 0x1;
-    uint32_t imm3  = (instr1 >> 12) & 0x7;
-    uint32_t imm8  = instr1 & 0x00FF;
-
-    uint32_t addend = (imm4 << 12) | (i_bit << 11) | (imm3 << 8) | imm8;
-
-    // -------------------------------
-    // 2. full = (адрес символа) + addend
-    // base_value = sec_addr_ref + st_value
-    // -------------------------------
-    uint32_t full = base_value + addend;
-
-    uint32_t new_imm16 = full & 0xFFFF;  // G0_NC – lower 16 bits
-
-    // -------------------------------
-    // 3. Разбираем new_imm16 обратно по полям
-    // -------------------------------
-    uint32_t new_imm4  = (new_imm16 >> 12) & 0xF;
-    uint32_t new_i     = (new_imm16 >> 11) & 1;
-    uint32_t new_imm3  = (new_imm16 >> 8)  & 0x7;
-    uint32_t new_imm8  =  new_imm16        & 0xFF;
-
-    // -------------------------------
-    // 4. Собираем новый MOVW
-    // -------------------------------
-    uint16_t new_instr0 = instr0;
-    uint16_t new_instr1 = instr1;
-
-    // imm4 (bits 3..0)
-    new_instr0 &= ~0x000F;
-    new_instr0 |= new_imm4;
-
-    // i bit (bit 10)
-    new_instr0 &= ~(1u << 10);
-    new_instr0 |= (new_i << 10);
-
-    // imm3 (bits 14..12)
-    new_instr1 &= ~0x7000;
-    new_instr1 |= (new_imm3 << 12);
-
-    // imm8 (bits 7..0)
-    new_instr1 &= ~0x00FF;
-    new_instr1 |= new_imm8;
-
-    // -------------------------------
-    // 5. Записываем обратно
-    // -------------------------------
-    addr[0] = new_instr0;
-    addr[1] = new_instr1;
-
-#if DEBUG_APP_LOAD
-    goutf("REL G0_NC: addend=%04X base=%08X -> imm16=%04X (%04X %04X)\n",
-          addend, base_value, new_imm16, addr[0], addr[1]);
-#endif
-}
-
 typedef struct {
     FIL *f2;
     elf32_header *pehdr;
@@ -457,34 +285,42 @@ typedef struct {
     list_t* /*sect_entry_t*/ sections_lst;
     elf32_sym* symtab_arr;  /* entire .symtab cached in RAM (PSRAM) */
     uint32_t   symtab_cnt;  /* number of entries in symtab_arr       */
+    /* Section header table, read once; per-section load address and
+     * state (SEC_*), indexed by section number */
+    elf32_shdr* shdrs;
+    uint8_t**  sec_addr;
+    uint8_t*   sec_state;
+    app_cache_t* cache;     /* shared read-only sections, may be NULL */
 } load_sec_ctx;
 
-static char* __in_hfa() sec_prg_addr(const load_sec_ctx* ctx, int sec_num) {
-    node_t* n = ctx->sections_lst->first;
-    while (n) {
-        sect_entry_t* se = (sect_entry_t*)n->data;
-        if (se->sec_num == sec_num) {
-            return se->prg_addr;
-        }
-        n = n->next;
-    }
-    return 0;
-}
+/* Section load state.  A section is SHARED when it lives in the app code
+ * cache: read-only, and every relocation in it resolved to itself or to
+ * another SHARED section, so its bytes are the same for every instance.
+ * A section still LOADING (reference cycle) counts as private. */
+#define SEC_UNLOADED 0
+#define SEC_LOADING  1
+#define SEC_PRIVATE  2
+#define SEC_SHARED   3
 
-static void __in_hfa() add_sec(load_sec_ctx* ctx, char* del_addr, char* prg_addr, int num) {
+static sect_entry_t* __in_hfa() add_sec(load_sec_ctx* ctx, char* del_addr, char* prg_addr, int num) {
     sect_entry_t* se = (sect_entry_t*)pvPortMalloc(sizeof(sect_entry_t));
-    if (!se) { goutf("add_sec: out of memory for section #%d\n", num); return; }
+    if (!se) { goutf("add_sec: out of memory for section #%d\n", num); return NULL; }
     // goutf("sec: [%p]\n", se);
     se->del_addr = del_addr;
     se->prg_addr = prg_addr;
     se->sec_num = num;
     list_push_back(ctx->sections_lst, se);
+    return se;
 }
 
 /* When true, alloc_zeroed() places *executable* sections in SRAM so that
  * code runs directly without XIP cache thrashing.  Data sections always go
  * to PSRAM.  Only code↔code references use BL/B.W (±16 MB); code→data
- * references use R_ARM_ABS32 with no range limit, so mixed placement is safe. */
+ * references use R_ARM_ABS32 with no range limit, so mixed placement is safe.
+ * Code placed in SRAM is never handed to the app code cache: app_cache_put()
+ * only takes PSRAM sections, since idle cache entries are evicted only when
+ * a PSRAM allocation fails and would otherwise pin the scarce SRAM heap.
+ * Such apps are read and relocated again on every launch. */
 static bool g_sram_for_code = false;
 
 static uint8_t* alloc_zeroed(size_t sz, bool executable) {
@@ -495,6 +331,9 @@ static uint8_t* alloc_zeroed(size_t sz, bool executable) {
     }
     if (psram_is_available()) {
         p = (uint8_t*)psram_alloc(sz);
+        /* Code kept for idle apps gives way to the app being loaded */
+        while (!p && app_cache_trim())
+            p = (uint8_t*)psram_alloc(sz);
         if (p) memset(p, 0, sz);
     }
     if (!p)
@@ -648,6 +487,9 @@ void __in_hfa() cleanup_bootb_ctx(cmd_ctx_t* ctx) {
         delete_list(bootb_ctx->sections);
         bootb_ctx->sections = 0;
     }
+    /* Shared sections belong to the code cache, not to the list */
+    app_cache_release(bootb_ctx->code_cache);
+    bootb_ctx->code_cache = 0;
     vPortFree(bootb_ctx);
     ctx->pboot_ctx = 0;
     // gouta("cleanup_bootb_ctx <<\n");
@@ -662,8 +504,25 @@ bool __in_hfa() run_new_app(cmd_ctx_t* ctx) {
 static uint32_t load_sec2mem_wrapper(load_sec_ctx* pctx, uint32_t req_idx, bool try_to_use_flash);
 
 static uint8_t* __in_hfa() load_sec2mem(load_sec_ctx * c, uint16_t sec_num, bool try_to_use_flash) {
-    uint8_t* prg_addr = sec_prg_addr(c, sec_num);
+    if (sec_num >= c->pehdr->sh_num) {
+        goutf("Unable to read section #%d info\n", sec_num);
+        return 0;
+    }
+    /* Sections are loaded on first reference only — by an entry symbol
+     * or by a relocation in a section being loaded */
+    uint8_t* prg_addr = c->sec_addr[sec_num];
+    if (prg_addr != 0) {
+        return prg_addr;
+    }
+    /* Already relocated by an earlier launch of the same file */
+    prg_addr = app_cache_find(c->cache, sec_num);
     if (prg_addr != 0) {
+        if (!add_sec(c, 0, prg_addr, sec_num)) return 0;
+        c->sec_addr[sec_num] = prg_addr;
+        c->sec_state[sec_num] = SEC_SHARED;
+        #if DEBUG_APP_LOAD
+        goutf("Program section #%d shared @ %ph\n", sec_num, prg_addr);
+        #endif
         return prg_addr;
     }
     size_t prev_flash_addr = flash_addr;
@@ -671,14 +530,9 @@ static uint8_t* __in_hfa() load_sec2mem(load_sec_ctx * c, uint16_t sec_num, bool
     UINT rb;
     uint8_t* real_ram_addr = 0;
     uint8_t* del_addr = 0;
-    elf32_shdr* psh = (elf32_shdr*)pvPortMalloc(sizeof(elf32_shdr));
-    if (!psh) {
-        gouta("Not enough RAM\n");
-        return prg_addr;
-    }
-    if (f_lseek(c->f2, c->pehdr->sh_offset + sizeof(elf32_shdr) * sec_num) == FR_OK &&
-        f_read(c->f2, psh, sizeof(elf32_shdr), &rb) == FR_OK && rb == sizeof(elf32_shdr)
-    ) {
+    sect_entry_t* se = 0;
+    const elf32_shdr* psh = &c->shdrs[sec_num];
+    {
         // goutf("free_sz: %d; psh->sh_size: %d\n", free_sz, psh->sh_size);
         if (!psram_is_available() && psh->sh_size + psh->sh_addralign + RESERVED_RAM > xPortGetFreeHeapSize()) {
             gouta("Not enough RAM.\n");
@@ -710,17 +564,19 @@ static uint8_t* __in_hfa() load_sec2mem(load_sec_ctx * c, uint16_t sec_num, bool
         #if DEBUG_APP_LOAD
         goutf("Program section #%d (%d bytes) allocated into %ph\n", sec_num, psh->sh_size, prg_addr);
         #endif
-        add_sec(c, del_addr, prg_addr, sec_num);
-        uint32_t target_sec_size = psh->sh_size; /* save before psh is reused */
+        se = add_sec(c, del_addr, prg_addr, sec_num);
+        if (!se) goto e1;
+        c->sec_addr[sec_num] = prg_addr;
+        c->sec_state[sec_num] = SEC_LOADING;
+        uint32_t target_sec_size = psh->sh_size;
+        bool shareable = !try_to_use_flash && c->cache &&
+                         (psh->sh_flags & (SHF_ALLOC | SHF_WRITE)) == SHF_ALLOC &&
+                         psh->sh_type != SHT_NOBITS;
         // links and relocations
-        if (f_lseek(c->f2, c->pehdr->sh_offset) != FR_OK) {
-            goutf("Unable to locate sections @ %ph\n", c->pehdr->sh_offset);
-            goto e1;
-        }
-        while (f_read(c->f2, psh, sizeof(elf32_shdr), &rb) == FR_OK && rb == sizeof(elf32_shdr)) {
+        for (uint16_t ri = 0; ri < c->pehdr->sh_num; ++ri) {
+            psh = &c->shdrs[ri];
             // goutf("Section info: %d type: %d\n", psh->sh_info, psh->sh_type);
             if (psh->sh_type == REL_SEC && psh->sh_info == sec_num) {
-                uint32_t r2 = f_tell(c->f2);
                 uint32_t rel_cnt = psh->sh_size / sizeof(elf32_rel);
 
                 /* Batch-read entire relocation section into RAM to avoid
@@ -794,65 +650,48 @@ static uint8_t* __in_hfa() load_sec2mem(load_sec_ctx * c, uint16_t sec_num, bool
                             if (rel_buf) vPortFree(rel_buf);
                             goto e1;
                         }
+                        /* Points at per-instance memory: not shareable */
+                        if (c->sec_state[c->psym->st_shndx] != SEC_SHARED)
+                            shareable = false;
                     }
                     uint32_t A = sec_addr_ref;
                     // Разрешение ссылки
-                    switch (rel_type) {
-                        case 2: // R_ARM_ABS32
-                        case 38: // R_ARM_TARGET1 (resolved as ABS32)
-                            // goutf("rel_type: %d; *rel_addr += A: %ph + S: %ph\n", rel_type, A, S);
-                            *rel_addr_real += S + A;
-                            break;
-                        case 3: {// R_ARM_REL32:
-                            uint32_t S_addr = A + S;
-                            int32_t addend = (int32_t)(*rel_addr_real);
-                            uint32_t P_addr = (uint32_t)rel_addr_ref;
-                            int32_t new_val = (int32_t)S_addr + addend - (int32_t)P_addr;
-                            *rel_addr_real  = (uint32_t)new_val;
-                            break;
-                        }
-                        case 10: //R_ARM_THM_PC22:
-                            resolve_thm_pc22(rel_addr_real, rel_addr_ref, A + S);
-                            break;
-                        case 30: // R_ARM_THM_JUMP24
-                            resolve_thm_jump24(rel_addr_real, rel_addr_ref, A + S);
-                            break;
-                        case 51: // R_ARM_THM_JUMP19 (B<cond>.W)
-                            resolve_thm_jump19((uint16_t*)rel_addr_real, (uint16_t*)rel_addr_ref, A + S);
-                            break;
-                        case 102: // R_ARM_THM_ALU_ABS_G0_NC
-                            if (((uintptr_t)rel_addr_real & 0x1) || ((uintptr_t)rel_addr_real & 0x2)) {
-                                goutf("WARN: REL type 102 misaligned addr: %p\n", rel_addr_real);
-                                goutf("REL type %d -> symbol: %s\n", rel_type, c->pstrtab + c->psym->st_name);
-                                break;
-                            }
-                            resolve_thm_alu_abs_g0_nc((uint16_t*)rel_addr_real, S + A);
-                            break;
-                        default:
-                            goutf("WARN: Unsupported REL type %d -> symbol: %s\n", rel_type, c->pstrtab + c->psym->st_name);
-                            if (rel_buf) vPortFree(rel_buf);
-                            goto e1;
+                    int rc = fxe_rel_apply((uint8_t*)rel_addr_real, (uint32_t)rel_addr_ref, rel_type, A + S);
+                    if (rc == FXE_REL_SKIPPED) {
+                        goutf("WARN: REL type 102 misaligned addr: %p\n", rel_addr_real);
+                        goutf("REL type %d -> symbol: %s\n", rel_type, c->pstrtab + c->psym->st_name);
+                    } else if (rc != FXE_REL_OK) {
+                        goutf("WARN: Unsupported REL type %d -> symbol: %s\n", rel_type, c->pstrtab + c->psym->st_name);
+                        if (rel_buf) vPortFree(rel_buf);
+                        goto e1;
                     }
                     //goutf("= %ph\n", *rel_addr);
                 }
                 if (rel_buf) vPortFree(rel_buf);
-                f_lseek(c->f2, r2);
             }
         }
+        c->sec_state[sec_num] = SEC_PRIVATE;
+        if (shareable && app_cache_put(c->cache, sec_num, del_addr, prg_addr, target_sec_size)) {
+            se->del_addr = 0; /* owned by the cache now */
+            c->sec_state[sec_num] = SEC_SHARED;
+        }
         #if DEBUG_APP_LOAD
-        goutf("Section #%d - load completed @%ph\n", sec_num, prg_addr);
+        goutf("Section #%d - load completed @%ph%s\n", sec_num, prg_addr,
+              c->sec_state[sec_num] == SEC_SHARED ? " (shared)" : "");
         #endif
-    } else {
-        goutf("Unable to read section #%d info\n", sec_num);
-        goto e1;
     }
     goto e2;
 e1:
     prg_addr = 0;
     flash_addr = prev_flash_addr;
+    if (se) {
+        /* The section list owns del_addr now and frees it at cleanup */
+        c->sec_state[sec_num] = SEC_PRIVATE;
+        c->sec_addr[sec_num] = 0;
+        del_addr = 0;
+    }
     vTaskDelay(3000);
 e2:
-    vPortFree(psh);
     size_t sz = new_flash_addr - prev_flash_addr;
     if (prg_addr && sz) {
         to_flash_rec_t* o = (to_flash_rec_t*)pvPortMalloc(sizeof(to_flash_rec_t));
@@ -935,6 +774,230 @@ e3:
     return 0;
 }
 
+#if APP_FXE
+/* Try the pre-linked image <fn>.fxe (fxe.h).  Returns 1 when the app was
+ * loaded from it, 0 when there is no up-to-date image (the caller loads
+ * the ELF and writes one), -1 when the image is current but could not be
+ * used (load the ELF, keep the image). */
+static int __in_hfa() load_fxe(bootb_ctx_t* bootb_ctx, const char* fn) {
+    FILINFO fno;
+    if (f_stat(fn, &fno) != FR_OK) return 0;
+    char* xfn = concat(fn, FXE_EXT);
+    FIL* f = (FIL*)pvPortMalloc(sizeof(FIL));
+    if (!xfn || !f || f_open(f, xfn, FA_READ) != FR_OK) {
+        vPortFree(f);
+        vPortFree(xfn);
+        return 0;
+    }
+    vPortFree(xfn);
+    int res = 0;
+    UINT rb;
+    fxe_header_t h;
+    fxe_sec_t* secs = 0;
+    fxe_rel_t* rels = 0;
+    uint32_t* addr = 0;       /* per image section: load address */
+    uint8_t** real = 0;       /* where its bytes are written */
+    sect_entry_t** se = 0;    /* NULL once the section is shared */
+    load_sec_ctx lc;
+    memset(&lc, 0, sizeof(lc));
+    if (f_read(f, &h, sizeof(h), &rb) != FR_OK || rb != sizeof(h) ||
+        h.magic != FXE_MAGIC || h.version != FXE_VERSION ||
+        h.elf_size != fno.fsize || h.elf_fdate != fno.fdate || h.elf_ftime != fno.ftime)
+        goto out;
+    res = -1;
+    /* sec_count 0 marks an ELF the format can't represent */
+    if (!fxe_header_ok(&h, f_size(f)))
+        goto out;
+    uint32_t n = h.sec_count;
+    secs = (fxe_sec_t*)pvPortMalloc(n * sizeof(fxe_sec_t));
+    addr = (uint32_t*)pvPortCalloc(n, sizeof(uint32_t));
+    real = (uint8_t**)pvPortCalloc(n, sizeof(uint8_t*));
+    se = (sect_entry_t**)pvPortCalloc(n, sizeof(sect_entry_t*));
+    if (!secs || !addr || !real || !se ||
+        f_read(f, secs, n * sizeof(fxe_sec_t), &rb) != FR_OK || rb != n * sizeof(fxe_sec_t))
+        goto out;
+
+    lc.sections_lst = new_list_v(0, sect_entry_deallocator, 0);
+    bootb_ctx->sections = lc.sections_lst;
+    bootb_ctx->code_cache = app_cache_acquire(fn, h.elf_sh_num);
+    g_sram_for_code = (h.code_bytes <= xPortGetFreeHeapSize());
+
+    /* Sections and their blobs, front to back */
+    for (uint32_t i = 0; i < n; i++) {
+        const fxe_sec_t* s = &secs[i];
+        if (s->flags & FXE_SEC_PURE) {
+            addr[i] = (uint32_t)app_cache_find(bootb_ctx->code_cache, s->elf_index);
+            if (addr[i]) {
+                if (!add_sec(&lc, 0, (char*)addr[i], s->elf_index)) goto out;
+                continue;
+            }
+        }
+        if (!psram_is_available() && s->size + s->align + RESERVED_RAM > xPortGetFreeHeapSize()) {
+            gouta("Not enough RAM.\n");
+            goto out;
+        }
+        uint8_t* del_addr = 0;
+        uint8_t* prg_addr = sec_align(s->size, &del_addr, &real[i], s->align, true,
+                                      (s->flags & FXE_SEC_EXEC) != 0);
+        if (!prg_addr) goto out;
+        se[i] = add_sec(&lc, (char*)del_addr, (char*)prg_addr, s->elf_index);
+        if (!se[i]) {
+            psram_free(del_addr);
+            goto out;
+        }
+        addr[i] = (uint32_t)prg_addr;
+        if (s->flags & FXE_SEC_NOBITS) {
+            memset(real[i], 0, s->size);
+            continue;
+        }
+        if ((f_tell(f) != s->offset && f_lseek(f, s->offset) != FR_OK) ||
+            f_read(f, real[i], s->size, &rb) != FR_OK || rb != s->size)
+            goto out;
+    }
+
+    /* Base deltas; sections from the cache are final already */
+    if (h.rel_count) {
+        UINT rl = h.rel_count * sizeof(fxe_rel_t);
+        if (psram_is_available())
+            rels = (fxe_rel_t*)psram_alloc(rl);
+        if (!rels)
+            rels = (fxe_rel_t*)pvPortMalloc(rl);
+        if (!rels ||
+            (f_tell(f) != h.rel_offset && f_lseek(f, h.rel_offset) != FR_OK) ||
+            f_read(f, rels, rl, &rb) != FR_OK || rb != rl)
+            goto out;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        const fxe_sec_t* s = &secs[i];
+        if (!se[i]) continue;
+        if (s->rel_first > h.rel_count || s->rel_count > h.rel_count - s->rel_first)
+            goto out;
+        for (uint32_t j = 0; j < s->rel_count; j++) {
+            const fxe_rel_t* r = &rels[s->rel_first + j];
+            if (r->target >= n || s->size < sizeof(uint32_t) || r->offset > s->size - sizeof(uint32_t) ||
+                fxe_rel_apply(real[i] + r->offset, addr[i], r->type, addr[r->target]) != FXE_REL_OK)
+                goto out;
+        }
+    }
+
+    /* Hand PURE sections to the code cache once everything they point
+     * at is shared; cycles stay private, as on the ELF path */
+    bool more = bootb_ctx->code_cache != 0;
+    while (more) {
+        more = false;
+        for (uint32_t i = 0; i < n; i++) {
+            const fxe_sec_t* s = &secs[i];
+            if (!se[i] || !(s->flags & FXE_SEC_PURE)) continue;
+            bool deps_shared = true;
+            for (uint32_t j = 0; j < s->rel_count && deps_shared; j++) {
+                uint16_t t = rels[s->rel_first + j].target;
+                if (t != i && se[t]) deps_shared = false;
+            }
+            if (deps_shared && app_cache_put(bootb_ctx->code_cache, s->elf_index,
+                                             se[i]->del_addr, (void*)addr[i], s->size)) {
+                se[i]->del_addr = 0; /* owned by the cache now */
+                se[i] = 0;
+                more = true;
+            }
+        }
+    }
+
+    uint32_t fns[FXE_NENTRIES];
+    for (int k = 0; k < FXE_NENTRIES; k++)
+        fns[k] = h.entries[k].sec < n ? addr[h.entries[k].sec] + h.entries[k].value : 0;
+    bootb_ctx->req_ver_fn = (bootb_req_ver_ptr_t)fns[FXE_ENTRY_REQ_VER];
+    bootb_ctx->_init_fn   = (bootb_init_ptr_t)fns[FXE_ENTRY_INIT];
+    bootb_ctx->main_fn    = (bootb_main_ptr_t)fns[FXE_ENTRY_MAIN];
+    bootb_ctx->_fini_fn   = (bootb_fini_ptr_t)fns[FXE_ENTRY_FINI];
+    bootb_ctx->sig_fn     = (bootb_sig_ptr_t)fns[FXE_ENTRY_SIGNAL];
+    bootb_ctx->flags_fn   = (bootb_flags_ptr_t)fns[FXE_ENTRY_FLAGS];
+    printf("[load_app] %s: %u sections, %u relocations from image\n",
+           fn, (unsigned)n, (unsigned)h.rel_count);
+    res = 1;
+out:
+    g_sram_for_code = false;
+    if (res != 1 && bootb_ctx->sections) {
+        delete_list(bootb_ctx->sections);
+        bootb_ctx->sections = 0;
+        app_cache_release(bootb_ctx->code_cache);
+        bootb_ctx->code_cache = 0;
+    }
+    psram_free(rels); /* handles both SRAM and PSRAM pointers */
+    vPortFree(se);
+    vPortFree(real);
+    vPortFree(addr);
+    vPortFree(secs);
+    f_close(f);
+    vPortFree(f);
+    return res;
+}
+
+typedef struct {
+    FIL* elf;
+    FIL* out;
+} fxe_files_t;
+
+static bool fxe_f_read(void* ctx, uint32_t off, void* buf, uint32_t len) {
+    FIL* f = ((fxe_files_t*)ctx)->elf;
+    UINT rb;
+    return (f_tell(f) == off || f_lseek(f, off) == FR_OK) &&
+           f_read(f, buf, len, &rb) == FR_OK && rb == len;
+}
+
+static bool fxe_f_write(void* ctx, uint32_t off, const void* buf, uint32_t len) {
+    FIL* f = ((fxe_files_t*)ctx)->out;
+    UINT bw;
+    return (f_tell(f) == off || f_lseek(f, off) == FR_OK) &&
+           f_write(f, buf, len, &bw) == FR_OK && bw == len;
+}
+
+/* Write <fn>.fxe after a successful ELF load, before the app has run.
+ * The builder keeps its buffers in PSRAM; without it there is no image. */
+static void __in_hfa() save_fxe(const char* fn) {
+    FILINFO fno;
+    if (!psram_is_available() || f_stat(fn, &fno) != FR_OK) return;
+    char* xfn = concat(fn, FXE_EXT);
+    FIL* in = (FIL*)pvPortMalloc(sizeof(FIL));
+    FIL* out = (FIL*)pvPortMalloc(sizeof(FIL));
+    if (xfn && in && out && f_open(in, fn, FA_READ) == FR_OK) {
+        if (f_open(out, xfn, FA_WRITE | FA_CREATE_ALWAYS) == FR_OK) {
+            fxe_files_t files = { in, out };
+            fxe_io_t io = { &files, fxe_f_read, fxe_f_write, psram_alloc, psram_free };
+            fxe_elf_id_t id = { (uint32_t)fno.fsize, fno.fdate, fno.ftime };
+            uint32_t sz = 0;
+            int rc = fxe_build(&io, &id, &sz);
+            if (rc == FXE_E_FORMAT || rc == FXE_E_NOMAIN || rc == FXE_E_LINK) {
+                /* Not representable: leave a bare header so later launches
+                 * go straight to the ELF instead of retrying */
+                fxe_header_t h;
+                memset(&h, 0, sizeof(h));
+                h.magic      = FXE_MAGIC;
+                h.version    = FXE_VERSION;
+                h.image_size = sizeof(h);
+                h.elf_size   = id.size;
+                h.elf_fdate  = id.fdate;
+                h.elf_ftime  = id.ftime;
+                UINT bw;
+                f_lseek(out, 0);
+                f_truncate(out);
+                f_write(out, &h, sizeof(h), &bw);
+            }
+            f_close(out);
+            if (rc == FXE_OK) {
+                printf("[load_app] wrote %s (%u bytes)\n", xfn, (unsigned)sz);
+            } else {
+                printf("[load_app] %s: %s\n", xfn, fxe_strerror(rc));
+                if (rc == FXE_E_IO || rc == FXE_E_NOMEM) f_unlink(xfn);
+            }
+        }
+        f_close(in);
+    }
+    vPortFree(out);
+    vPortFree(in);
+    vPortFree(xfn);
+}
+#endif
+
 bool __in_hfa() load_app(cmd_ctx_t* ctx) {
     if (!ctx->orig_cmd) {
         gouta("Unable to load file: NULL\n");
@@ -951,6 +1014,10 @@ a:
     }
     bootb_ctx_t* bootb_ctx = ctx->pboot_ctx;
     memset(bootb_ctx, 0, sizeof(bootb_ctx_t)); // ensure context is empty
+#if APP_FXE
+    int fxe = load_fxe(bootb_ctx, fn);
+    if (fxe > 0) goto loaded;
+#endif
     FIL* f = (FIL*)pvPortMalloc(sizeof(FIL));
     if (!f) {
         goto a;
@@ -996,21 +1063,29 @@ a1:
     }
     printf("[load_app] ELF hdr ok, sh_off=%u sh_num=%u sh_stridx=%u\n",
            (unsigned)pehdr->sh_offset, (unsigned)pehdr->sh_num, (unsigned)pehdr->sh_str_index);
-    elf32_shdr* psh = (elf32_shdr*)pvPortMalloc(sizeof(elf32_shdr));
-    if (!psh) {
+    /* Read the whole section header table once: the loader consults it
+     * for every section it loads (PSRAM preferred, like .symtab below) */
+    UINT shdrs_len = sizeof(elf32_shdr) * pehdr->sh_num;
+    elf32_shdr* shdrs = NULL;
+    if (psram_is_available())
+        shdrs = (elf32_shdr*)psram_alloc(shdrs_len);
+    if (!shdrs)
+        shdrs = (elf32_shdr*)pvPortMalloc(shdrs_len);
+    if (!shdrs) {
 a2:
         vPortFree(pehdr);
         goto a1;
     }
-    bool ok = f_lseek(f, pehdr->sh_offset + sizeof(elf32_shdr) * pehdr->sh_str_index) == FR_OK;
-    if (!ok || f_read(f, psh, sizeof(elf32_shdr), &rb) != FR_OK || rb != sizeof(elf32_shdr)) {
-        goutf("Unable to read .shstrtab section header @ %d+%d (read: %d)\n", f_tell(f), sizeof(elf32_shdr), rb);
+    bool ok = f_lseek(f, pehdr->sh_offset) == FR_OK;
+    if (!ok || f_read(f, shdrs, shdrs_len, &rb) != FR_OK || rb != shdrs_len) {
+        goutf("Unable to read section headers @ %d+%d (read: %d)\n", pehdr->sh_offset, shdrs_len, rb);
         goto a3;
     }
+    elf32_shdr* psh = &shdrs[pehdr->sh_str_index];
     char* symtab = (char*)pvPortMalloc(psh->sh_size);
     if (!symtab) {
 a3:
-        vPortFree(psh);
+        psram_free(shdrs); /* handles both SRAM and PSRAM pointers */
         goto a2;
     }
     ok = f_lseek(f, psh->sh_offset) == FR_OK;
@@ -1018,11 +1093,12 @@ a3:
         goutf("Unable to read .shstrtab section @ %d+%d (read: %d)\n", f_tell(f), psh->sh_size, rb);
         goto a4;
     }
-    f_lseek(f, pehdr->sh_offset);
     int symtab_off = -1;
     int strtab_off = -1;
     UINT symtab_len, strtab_len = 0;
-    while ((symtab_off < 0 || strtab_off < 0) && f_read(f, psh, sizeof(elf32_shdr), &rb) == FR_OK && rb == sizeof(elf32_shdr)) { 
+    for (uint16_t i = 0; i < pehdr->sh_num && (symtab_off < 0 || strtab_off < 0); ++i) {
+        psh = &shdrs[i];
+        if (psh->sh_name >= shdrs[pehdr->sh_str_index].sh_size) continue;
         if(psh->sh_type == 2 && 0 == strcmp(symtab + psh->sh_name, ".symtab")) {
             symtab_off = psh->sh_offset;
             symtab_len = psh->sh_size;
@@ -1109,6 +1185,17 @@ a6:
     pctx->strtab_len = strtab_len;
     pctx->symtab_arr = symtab_cache;
     pctx->symtab_cnt = symtab_cnt;
+    pctx->shdrs = shdrs;
+    pctx->sec_addr = (uint8_t**)pvPortCalloc(pehdr->sh_num, sizeof(uint8_t*));
+    pctx->sec_state = (uint8_t*)pvPortCalloc(pehdr->sh_num, sizeof(uint8_t));
+    if (!pctx->sec_addr || !pctx->sec_state) {
+        vPortFree(pctx->sec_addr);
+        vPortFree(pctx->sec_state);
+        vPortFree(pctx);
+        goto a6;
+    }
+    pctx->cache = app_cache_acquire(fn, pehdr->sh_num);
+    bootb_ctx->code_cache = pctx->cache;
     pctx->sections_lst = new_list_v(0, sect_entry_deallocator, 0);
 
     /* Scan symtab for well-known entry points.  Use cached array when
@@ -1161,12 +1248,10 @@ a6:
      * BL/B.W (±16 MB) only link code↔code; code→data uses R_ARM_ABS32. */
     {
         size_t code_alloc = 0;
-        f_lseek(f, pehdr->sh_offset);
         for (uint32_t i = 0; i < pehdr->sh_num; i++) {
-            if (f_read(f, psh, sizeof(elf32_shdr), &rb) == FR_OK && rb == sizeof(elf32_shdr)) {
-                if ((psh->sh_flags & SHF_ALLOC) && (psh->sh_flags & SHF_EXECINSTR))
-                    code_alloc += psh->sh_size + psh->sh_addralign;
-            }
+            psh = &shdrs[i];
+            if ((psh->sh_flags & SHF_ALLOC) && (psh->sh_flags & SHF_EXECINSTR))
+                code_alloc += psh->sh_size + psh->sh_addralign;
         }
         size_t free_heap = xPortGetFreeHeapSize();
         g_sram_for_code = (code_alloc <= free_heap);
@@ -1210,6 +1295,8 @@ a6:
         char* alloc = (char*)pvPortCalloc(1, FLASH_SECTOR_SIZE + 511);
         if (!alloc) {
     a7:
+            vPortFree(pctx->sec_addr);
+            vPortFree(pctx->sec_state);
             vPortFree(pctx);
             goto a6;
         }
@@ -1270,12 +1357,14 @@ e3:
 e2:
     vPortFree(symtab);
 e11:
-    vPortFree(psh);
+    psram_free(shdrs);
 e1:
     vPortFree(pehdr);
     f_close(f);
     vPortFree(f);
     bootb_ctx->sections = pctx->sections_lst;
+    vPortFree(pctx->sec_addr);
+    vPortFree(pctx->sec_state);
 /*
     goutf("Sections read:     %u\n", pctx->total_sections_read);
     goutf("Sections loaded:   %u\n", pctx->total_sections_loaded);
@@ -1286,6 +1375,10 @@ e1:
 ///    debug_sections(bootb_ctx->sect_entries);
     goutf("[%p][%p][%p][%p]\n", bootb_ctx->req_ver_fn, bootb_ctx->_init_fn, bootb_ctx->main_fn, bootb_ctx->_fini_fn);
     #endif
+#if APP_FXE
+    if (fxe == 0 && bootb_ctx->main_fn) save_fxe(fn);
+loaded:
+#endif
     /* Query app flags (e.g. APPFLAG_BACKGROUND) — 0 if not exported */
     bootb_ctx->app_flags = bootb_ctx->flags_fn ? bootb_ctx->flags_fn() : 0;
     if (bootb_ctx->main_fn == 0) {
@@ -1388,16 +1481,16 @@ void task_mem_defer_free(void* ptr) {
 }
 
 
-/* ---- Static task creation: shared SRAM stack + PSRAM TCB ---- */
+/* ---- Static task creation: SRAM stack slot + PSRAM TCB ---- */
 
 /* Background apps (e.g. FrankAmp) need their own stack in PSRAM since they
- * keep running while suspended apps share the single SRAM stack block. */
+ * keep running while suspended apps share the SRAM stack slots. */
 typedef struct {
     StackType_t stack[2048];   /* 8KB on ARM (StackType_t = uint32_t) */
     StaticTask_t tcb;
 } app_task_mem_bg_t;
 
-/* Foreground apps: TCB lives in PSRAM (small, ~200 bytes), stack is shared */
+/* Foreground apps: TCB lives in PSRAM (small, ~200 bytes), stack is a slot */
 typedef struct {
     StaticTask_t tcb;
 } app_tcb_mem_t;
@@ -1420,27 +1513,25 @@ static TaskHandle_t create_app_task_psram(
             return xTaskCreateStatic(fn, name, 2048, param, priority,
                                      mem->stack, &mem->tcb);
         }
-    } else if (!swap_is_stack_busy()) {
+    } else {
         /* Foreground app: TCB in SRAM (accessed by PendSV ISR, must be
-         * fast), stack is the shared SRAM block.
-         * Only one task may use the shared stack at a time; if another
-         * terminal already has a foreground app running, fall through
-         * to the PSRAM/heap fallback below. */
+         * fast), stack is an SRAM slot from the swap pool.
+         * A slot holds one running task; if every slot is running one
+         * (e.g. apps in several terminals), fall through to the heap
+         * fallback below. */
         app_tcb_mem_t* mem = (app_tcb_mem_t*)pvPortCalloc(1, sizeof(app_tcb_mem_t));
         if (!mem && psram_is_available()) {
             mem = (app_tcb_mem_t*)psram_alloc(sizeof(app_tcb_mem_t));
             if (mem) memset(mem, 0, sizeof(app_tcb_mem_t));
         }
         if (mem) {
-            *out_mem = mem;
-            swap_stack_acquire();
-            /* Re-fill shared stack with watermark before each new task */
-            StackType_t *ss = swap_get_shared_stack();
-            uint32_t words = swap_get_stack_words();
-            for (uint32_t i = 0; i < words; i++)
-                ss[i] = 0xa5a5a5a5;
-            return xTaskCreateStatic(fn, name, words, param, priority,
-                                     ss, &mem->tcb);
+            TaskHandle_t h = swap_create_task(fn, name, param, priority,
+                                              &mem->tcb);
+            if (h) {
+                *out_mem = mem;
+                return h;
+            }
+            psram_free(mem);
         }
     }
     /* Allocation failed — fall back to dynamic SRAM allocation */
@@ -1487,10 +1578,10 @@ static void __in_hfa() vAppDetachedTask(void *pv) {
     /* ================================== */
     /* Elevate priority above compositor (pri 2) so the deferred resume
      * is not processed until after vTaskDelete — prevents the compositor
-     * from overwriting our shared stack while we're still using it. */
+     * from overwriting our stack slot while we're still using it. */
     vTaskPrioritySet(NULL, configMAX_PRIORITIES - 1);
     void* mem = ctx->task_mem;
-    if (mem) swap_stack_release();  /* release only if we used shared stack */
+    swap_stack_release(th);
     /* Unregister from swap manager and auto-resume previous app */
     swap_unregister_by_task(th);
     swap_resume_previous();
@@ -1558,13 +1649,13 @@ void __in_hfa() __exit(int status) {
     set_cp866_handler(0);
     /* Elevate priority above compositor (pri 2) so the deferred resume
      * is not processed until after vTaskDelete — prevents the compositor
-     * from overwriting our shared stack while we're still using it. */
+     * from overwriting our stack slot while we're still using it. */
     vTaskPrioritySet(NULL, configMAX_PRIORITIES - 1);
     /* Swap operations only for detached (parentless) tasks.
      * Attached tasks have a parent shell that handles swap_stack_release
      * and doesn't participate in the window swap system. */
     if (!ctx || !ctx->parent_task) {
-        if (mem) swap_stack_release();  /* release only if we used shared stack */
+        swap_stack_release(th);
         swap_unregister_by_task(th);
         swap_resume_previous();
     }
@@ -1617,7 +1708,8 @@ void __in_hfa() exec(cmd_ctx_t* ctx) { // like init proc flow
              * its notification — a post-create drain would eat it. */
             ulTaskNotifyTake(pdTRUE, 0);
             void* tmem;
-            create_app_task_psram(vAppAttachedTask, ctx->argv[0], ctx, APP_TASK_PRIORITY, &tmem, false);
+            TaskHandle_t child_task = create_app_task_psram(
+                vAppAttachedTask, ctx->argv[0], ctx, APP_TASK_PRIORITY, &tmem, false);
             ctx->task_mem = tmem;
             #if DEBUG_APP_LOAD
             goutf("ctx [%p], ulTaskNotifyTake[%p]\n", ctx, ctx->parent_task);
@@ -1635,7 +1727,7 @@ void __in_hfa() exec(cmd_ctx_t* ctx) { // like init proc flow
                     /* Child didn't get to defer-free its own task_mem */
                     if (tmem) task_mem_defer_free(tmem);
                 }
-                if (tmem) swap_stack_release();
+                swap_stack_release(child_task);
                 cleanup_bootb_ctx(ctx);
                 set_usb_detached_handler(0);
                 set_scancode_handler(0);
@@ -1645,7 +1737,14 @@ void __in_hfa() exec(cmd_ctx_t* ctx) { // like init proc flow
                 vTaskPrioritySet(NULL, 1);
                 return;
             }
-            if (tmem) swap_stack_release();  /* release only if child used shared stack */
+            /* The child notifies before it is done with its stack (exit
+             * handlers, vTaskDelete): let it finish before the slot can
+             * be freed or handed to the next launch.  Yielding keeps the
+             * idle task — which frees the child's TCB — from running, so
+             * the handle stays valid until it reads eDeleted. */
+            while (eTaskGetState(child_task) != eDeleted)
+                taskYIELD();
+            swap_stack_release(child_task);
             deliver_signals(ctx);
             #if DEBUG_APP_LOAD
             goutf("ctx [%p], ulTaskNotifyTake passed\n", ctx);
@@ -1820,8 +1919,8 @@ e:
 void __in_hfa() launch_elf_app(const char *path) {
     /* Cancel any pending deferred resume before launching a new app.
      * If a previous app just exited and set a deferred resume, firing
-     * it now would overwrite the shared stack while the new app task
-     * is running on it.  swap_switch_to(HWND_NULL) may early-return
+     * it now would wake the previous app behind the new one, or spill
+     * it just as the new task wants its slot.  swap_switch_to(HWND_NULL) may early-return
      * if active_fg is already HWND_NULL, so we cancel explicitly. */
     swap_cancel_deferred();
 
@@ -1921,7 +2020,7 @@ void __in_hfa() launch_elf_app_with_files(const char *app_path,
 
 /*==========================================================================
  * Deferred app launch — safe to call from ELF app context.
- * The compositor loop polls app_launch_check_pending() each frame.
+ * The compositor loop checks app_launch_check_pending() each pass.
  *=========================================================================*/
 
 #define APP_DEFERRED_PATH_MAX 256
@@ -1936,6 +2035,7 @@ void app_launch_deferred(const char *app_path, const char *file_path) {
     strncpy(app_launch_file, file_path, APP_DEFERRED_PATH_MAX - 1);
     app_launch_file[APP_DEFERRED_PATH_MAX - 1] = '\0';
     app_launch_pending = true;
+    wm_wake_compositor();
 }
 
 void app_launch_check_pending(void) {
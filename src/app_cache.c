@@ -0,0 +1,206 @@
+/*
+ * FRANK OS — Shared App Code Cache
+ * Copyright (c) 2026 Mikhail Matveev <xtreme@rh1.tech>
+ * https://rh1.tech
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "app_cache.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "ff.h"
+#include "../drivers/psram/psram.h"
+#include <string.h>
+#include <stdlib.h>
+
+/* Cached bytes are capped at this fraction of PSRAM */
+#define APP_CACHE_BUDGET_DIV  4
+
+typedef struct {
+    void *del_addr;   /* allocation to free */
+    void *prg_addr;   /* aligned load address, NULL = not cached */
+} cache_sec_t;
+
+struct app_cache {
+    char        *path;
+    FSIZE_t      fsize;
+    WORD         fdate, ftime;
+    uint16_t     sh_num;
+    uint16_t     refs;
+    bool         retired;   /* file changed — freed on last release */
+    uint32_t     bytes;     /* sum of cached section sizes */
+    TickType_t   last_use;
+    cache_sec_t *secs;      /* sh_num slots, allocated on first put */
+};
+
+/*==========================================================================
+ * Internal state
+ *
+ * Lookups and list changes are short, so they run with the scheduler
+ * suspended like the PSRAM allocator itself; the expensive work
+ * (reading and relocating sections) happens in the loader, outside.
+ *=========================================================================*/
+
+static app_cache_t *entries[APP_CACHE_MAX_FILES];
+static uint32_t     cached_bytes;
+
+static void entry_free(app_cache_t *c) {
+    if (c->secs) {
+        for (uint16_t i = 0; i < c->sh_num; i++)
+            if (c->secs[i].prg_addr) psram_free(c->secs[i].del_addr);
+        psram_free(c->secs);
+    }
+    cached_bytes -= c->bytes;
+    vPortFree(c->path);
+    vPortFree(c);
+}
+
+/* Index of the LRU unreferenced entry other than keep, or -1 */
+static int lru_victim(const app_cache_t *keep) {
+    int victim = -1;
+    for (int i = 0; i < APP_CACHE_MAX_FILES; i++) {
+        app_cache_t *c = entries[i];
+        if (!c || c == keep || c->refs) continue;
+        if (victim < 0 ||
+            (int32_t)(c->last_use - entries[victim]->last_use) < 0)
+            victim = i;
+    }
+    return victim;
+}
+
+/*==========================================================================
+ * Public API
+ *=========================================================================*/
+
+app_cache_t *app_cache_acquire(const char *path, uint16_t sh_num) {
+    if (!path || path[0] != '/' || !psram_is_available())
+        return NULL;
+
+    FILINFO fno;
+    if (f_stat(path, &fno) != FR_OK)
+        return NULL;
+
+    vTaskSuspendAll();
+    app_cache_t *hit = NULL;
+    for (int i = 0; i < APP_CACHE_MAX_FILES; i++) {
+        app_cache_t *c = entries[i];
+        if (!c || strcmp(c->path, path) != 0) continue;
+        if (c->fsize == fno.fsize && c->fdate == fno.fdate &&
+            c->ftime == fno.ftime && c->sh_num == sh_num) {
+            hit = c;
+            break;
+        }
+        /* Stale: nobody new may use it; the last user frees it */
+        entries[i] = NULL;
+        if (c->refs) c->retired = true;
+        else         entry_free(c);
+    }
+    if (hit) {
+        hit->refs++;
+        hit->last_use = xTaskGetTickCount();
+    }
+    (void)xTaskResumeAll();
+    if (hit) return hit;
+
+    app_cache_t *c = (app_cache_t *)pvPortMalloc(sizeof(app_cache_t));
+    char *p = (char *)pvPortMalloc(strlen(path) + 1);
+    if (!c || !p) {
+        vPortFree(c);
+        vPortFree(p);
+        return NULL;
+    }
+    memset(c, 0, sizeof(*c));
+    strcpy(p, path);
+    c->path   = p;
+    c->fsize  = fno.fsize;
+    c->fdate  = fno.fdate;
+    c->ftime  = fno.ftime;
+    c->sh_num = sh_num;
+    c->refs   = 1;
+    c->last_use = xTaskGetTickCount();
+
+    /* Take a free slot, else the LRU idle entry's; if every file is in
+     * use the new entry stays private and is freed on release */
+    vTaskSuspendAll();
+    int slot = -1;
+    for (int i = 0; i < APP_CACHE_MAX_FILES && slot < 0; i++)
+        if (!entries[i]) slot = i;
+    if (slot < 0) {
+        slot = lru_victim(NULL);
+        if (slot >= 0) entry_free(entries[slot]);
+    }
+    if (slot >= 0) entries[slot] = c;
+    else           c->retired = true;
+    (void)xTaskResumeAll();
+    return c;
+}
+
+void app_cache_release(app_cache_t *c) {
+    if (!c) return;
+    vTaskSuspendAll();
+    c->last_use = xTaskGetTickCount();
+    if (--c->refs == 0 && c->retired)
+        entry_free(c);
+    (void)xTaskResumeAll();
+}
+
+void *app_cache_find(app_cache_t *c, uint16_t sec_num) {
+    if (!c || !c->secs || sec_num >= c->sh_num) return NULL;
+    return c->secs[sec_num].prg_addr;
+}
+
+bool app_cache_put(app_cache_t *c, uint16_t sec_num,
+                   void *del_addr, void *prg_addr, uint32_t size) {
+    if (!c || c->retired || sec_num >= c->sh_num || !prg_addr)
+        return false;
+    uintptr_t a = (uintptr_t)del_addr;
+    if (a < PSRAM_BASE || a >= PSRAM_BASE + psram_detected_bytes())
+        return false;
+
+    cache_sec_t *secs = NULL;
+    if (!c->secs) {
+        size_t sz = c->sh_num * sizeof(cache_sec_t);
+        secs = (cache_sec_t *)psram_alloc(sz);
+        if (!secs) return false;
+        memset(secs, 0, sz);
+    }
+
+    uint32_t budget = psram_detected_bytes() / APP_CACHE_BUDGET_DIV;
+    bool ok = false;
+    vTaskSuspendAll();
+    if (!c->secs) {
+        c->secs = secs;
+        secs = NULL;
+    }
+    while (cached_bytes + size > budget) {
+        int v = lru_victim(c);
+        if (v < 0) break;
+        app_cache_t *old = entries[v];
+        entries[v] = NULL;
+        entry_free(old);
+    }
+    /* Another instance loading the same file may have got here first */
+    if (cached_bytes + size <= budget && !c->secs[sec_num].prg_addr) {
+        c->secs[sec_num].del_addr = del_addr;
+        c->secs[sec_num].prg_addr = prg_addr;
+        c->bytes     += size;
+        cached_bytes += size;
+        ok = true;
+    }
+    (void)xTaskResumeAll();
+    if (secs) psram_free(secs);   /* lost the race to set up the table */
+    return ok;
+}
+
+bool app_cache_trim(void) {
+    vTaskSuspendAll();
+    int v = lru_victim(NULL);
+    if (v >= 0) {
+        app_cache_t *c = entries[v];
+        entries[v] = NULL;
+        entry_free(c);
+    }
+    (void)xTaskResumeAll();
+    return v >= 0;
+}
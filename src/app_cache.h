@@ -0,0 +1,49 @@
+/*
+ * FRANK OS — Shared App Code Cache
+ * Copyright (c) 2026 Mikhail Matveev <xtreme@rh1.tech>
+ * https://rh1.tech
+ *
+ * Keeps relocated read-only ELF sections in PSRAM after an app exits so
+ * the next launch of the same file (same path, size and mtime) reuses
+ * them instead of reading and relocating them again.  A section is only
+ * shareable when every relocation in it resolves to another shared
+ * section — anything pointing at per-instance data is loaded privately.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef APP_CACHE_H
+#define APP_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Files kept at most; least recently used unreferenced ones go first */
+#define APP_CACHE_MAX_FILES  8
+
+typedef struct app_cache app_cache_t;
+
+/* Take a reference on the cache entry for an absolute ELF path with
+ * sh_num sections, creating it if needed.  An entry whose file changed
+ * is retired.  Returns NULL when caching is unavailable (no PSRAM,
+ * relative path, f_stat failure, out of memory). */
+app_cache_t *app_cache_acquire(const char *path, uint16_t sh_num);
+
+/* Drop a reference taken by app_cache_acquire (NULL is ignored) */
+void app_cache_release(app_cache_t *c);
+
+/* Load address of a cached section, or NULL */
+void *app_cache_find(app_cache_t *c, uint16_t sec_num);
+
+/* Hand a relocated section to the cache.  On success the cache owns
+ * del_addr (the allocation behind prg_addr) and frees it when the entry
+ * is dropped; on failure the caller keeps it.  Only PSRAM sections are
+ * accepted, so code the loader placed in SRAM always stays private. */
+bool app_cache_put(app_cache_t *c, uint16_t sec_num,
+                   void *del_addr, void *prg_addr, uint32_t size);
+
+/* Free the least recently used unreferenced entry.  Returns false when
+ * there was none — used to make room when a PSRAM allocation fails. */
+bool app_cache_trim(void);
+
+#endif /* APP_CACHE_H */
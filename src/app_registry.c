@@ -0,0 +1,400 @@
+/*
+ * FRANK OS — App Registry
+ * Copyright (c) 2026 Mikhail Matveev <xtreme@rh1.tech>
+ * https://rh1.tech
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "app_registry.h"
+#include "ico.h"
+#include "lang.h"
+#include "ff.h"
+#include "sdcard_init.h"
+#include "FreeRTOS.h"
+#include <string.h>
+#include <stdio.h>
+#include <ctype.h>
+
+#define REG_MAGIC      0x47455246   /* "FREG" */
+#define REG_VERSION    1
+#define REG_INF_MAX    256          /* bytes of an .inf that are parsed */
+#define REG_ICO_MAX    4096
+#define REG_HASH_SEED  2166136261u
+
+/*==========================================================================
+ * Cache file layout
+ *
+ * File: header + bases[nbases] + fa_app_t[count] + reg_extra_t[count]
+ * The records are written as they are in memory; the header carries
+ * their sizes so a build with a different layout rebuilds the cache.
+ *=========================================================================*/
+
+typedef struct {
+    char titles[APPREG_LANGS][APPREG_TITLE_LEN];
+    bool has_ico;
+} reg_extra_t;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t app_size;     /* sizeof(fa_app_t)    */
+    uint16_t extra_size;   /* sizeof(reg_extra_t) */
+    uint16_t count;        /* registered apps     */
+    uint16_t nbases;       /* every .inf in /fos, registered or not */
+    uint16_t reserved;
+    uint32_t inf_sum;      /* .inf and .ico files */
+    uint32_t base_sum;     /* files named like an .inf's base */
+} reg_header_t;
+
+/*==========================================================================
+ * Internal state
+ *=========================================================================*/
+
+static fa_app_t    reg_apps[APPREG_MAX_APPS];
+static reg_extra_t reg_extra[APPREG_MAX_APPS];
+static int         reg_count;
+
+/* Codes of the "name.XX=" lines, indexed by LANG_* */
+static const char *const reg_lang_codes[APPREG_LANGS] = { "en", "ru" };
+
+/*==========================================================================
+ * Listing digest
+ *
+ * Names hash case-insensitively, as FAT matches them.  Each file adds
+ * the hash of its name, size and date to a sum, so the result does not
+ * depend on directory order.
+ *=========================================================================*/
+
+static uint32_t reg_name_hash(const char *s, int n) {
+    uint32_t h = REG_HASH_SEED;
+    for (int i = 0; i < n; i++)
+        h = (h ^ (uint8_t)tolower((unsigned char)s[i])) * 16777619u;
+    return h;
+}
+
+static uint32_t reg_file_hash(uint32_t name_hash, const FILINFO *fno) {
+    uint32_t meta[2] = {
+        (uint32_t)fno->fsize,
+        ((uint32_t)fno->fdate << 16) | fno->ftime
+    };
+    uint32_t h = name_hash;
+    for (unsigned i = 0; i < sizeof(meta); i++)
+        h = (h ^ ((const uint8_t *)meta)[i]) * 16777619u;
+    return h;
+}
+
+/* True if name (len chars) ends in ext, any case */
+static bool reg_ext_is(const char *name, int len, const char *ext) {
+    int elen = (int)strlen(ext);
+    if (len <= elen) return false;
+    for (int i = 0; i < elen; i++)
+        if (tolower((unsigned char)name[len - elen + i]) != ext[i])
+            return false;
+    return true;
+}
+
+static bool reg_is_meta(const char *name, int len) {
+    return reg_ext_is(name, len, ".inf") || reg_ext_is(name, len, ".ico");
+}
+
+/* Sum the /fos listing the way reg_rebuild() records it */
+static bool reg_sum_listing(const uint32_t *bases, int nbases,
+                            uint32_t *inf_sum, uint32_t *base_sum) {
+    DIR dir;
+    FILINFO fno;
+    if (f_opendir(&dir, "/fos") != FR_OK) return false;
+
+    *inf_sum = *base_sum = 0;
+    while (f_readdir(&dir, &fno) == FR_OK && fno.fname[0]) {
+        if (fno.fattrib & AM_DIR) continue;
+        int len = (int)strlen(fno.fname);
+        uint32_t h = reg_name_hash(fno.fname, len);
+        if (reg_is_meta(fno.fname, len)) {
+            *inf_sum += reg_file_hash(h, &fno);
+            continue;
+        }
+        for (int i = 0; i < nbases; i++) {
+            if (bases[i] == h) {
+                *base_sum += reg_file_hash(h, &fno);
+                break;
+            }
+        }
+    }
+    f_closedir(&dir);
+    return true;
+}
+
+/*==========================================================================
+ * .inf / .ico parsing
+ *
+ *   <display name>\n
+ *   ext:<comma-separated extensions>\n
+ *   name.XX=<display name in language XX>\n
+ *=========================================================================*/
+
+static void reg_parse_exts(char *p, fa_app_t *app) {
+    while (*p && app->ext_count < FA_MAX_EXTS) {
+        while (*p == ',' || *p == ';' || *p == ' ') p++;
+        if (!*p) break;
+
+        char *start = p;
+        while (*p && *p != ',' && *p != ';' && *p != ' ')
+            p++;
+
+        int len = (int)(p - start);
+        if (len > 0 && len < FA_EXT_LEN) {
+            char *ext = app->exts[app->ext_count++];
+            for (int i = 0; i < len; i++)
+                ext[i] = (char)tolower((unsigned char)start[i]);
+            ext[len] = '\0';
+        }
+    }
+}
+
+static void reg_parse_inf(char *buf, fa_app_t *app, reg_extra_t *x) {
+    bool first = true;
+    for (char *line = buf; line; ) {
+        char *nl = strchr(line, '\n');
+        if (nl) *nl = '\0';
+        char *cr = strchr(line, '\r');
+        if (cr) *cr = '\0';
+
+        if (first) {
+            strncpy(x->titles[0], line, APPREG_TITLE_LEN - 1);
+            strncpy(app->name, line, FA_NAME_LEN - 1);
+            first = false;
+        } else {
+            while (*line == ' ') line++;
+            if (strncmp(line, "ext:", 4) == 0) {
+                reg_parse_exts(line + 4, app);
+            } else if (strncmp(line, "name.", 5) == 0) {
+                for (int l = 1; l < APPREG_LANGS; l++) {
+                    const char *code = reg_lang_codes[l];
+                    if (strncmp(line + 5, code, 2) == 0 && line[7] == '='
+                        && line[8])
+                        strncpy(x->titles[l], line + 8, APPREG_TITLE_LEN - 1);
+                }
+            }
+        }
+        line = nl ? nl + 1 : NULL;
+    }
+}
+
+/* Icons from <path>.ico; the terminal icons when there is none */
+static void reg_load_icons(const char *path, fa_app_t *app, reg_extra_t *x) {
+    char ico_path[FA_PATH_LEN + 4];
+    snprintf(ico_path, sizeof(ico_path), "%s.ico", path);
+
+    FIL f;
+    if (f_open(&f, ico_path, FA_READ) == FR_OK) {
+        FSIZE_t fsize = f_size(&f);
+        uint8_t *buf = NULL;
+        if (fsize >= 22 && fsize <= REG_ICO_MAX)   /* min ICO = ~22 bytes */
+            buf = (uint8_t *)pvPortMalloc((size_t)fsize);
+        if (buf) {
+            UINT br;
+            if (f_read(&f, buf, (UINT)fsize, &br) == FR_OK
+                && br == (UINT)fsize) {
+                app->has_icon   = ico_parse_16(buf, br, app->icon);
+                app->has_icon32 = ico_parse_32(buf, br, app->icon32);
+            }
+            vPortFree(buf);
+        }
+        f_close(&f);
+    }
+
+    x->has_ico = app->has_icon || app->has_icon32;
+    if (!x->has_ico) {
+        extern const uint8_t *fn_icon16_terminal_get(void);
+        extern const uint8_t *fn_icon32_terminal_get(void);
+        memcpy(app->icon,   fn_icon16_terminal_get(), FA_ICON_SIZE);
+        memcpy(app->icon32, fn_icon32_terminal_get(), FA_ICON32_SIZE);
+        app->has_icon   = true;
+        app->has_icon32 = true;
+    }
+
+    /* Ensure 32x32 is always available: upscale from 16x16 if needed */
+    if (app->has_icon && !app->has_icon32) {
+        for (int r = 0; r < 32; r++)
+            for (int c = 0; c < 32; c++)
+                app->icon32[r * 32 + c] = app->icon[(r / 2) * 16 + (c / 2)];
+        app->has_icon32 = true;
+    }
+}
+
+/* Register the app at path from its .inf.  False if the .inf is
+ * unreadable or has no display name. */
+static bool reg_parse_app(const char *path, fa_app_t *app, reg_extra_t *x) {
+    static char buf[REG_INF_MAX];   /* static to keep the compositor stack small */
+    char inf_path[FA_PATH_LEN + 4];
+    snprintf(inf_path, sizeof(inf_path), "%s.inf", path);
+
+    FIL f;
+    UINT br;
+    if (f_open(&f, inf_path, FA_READ) != FR_OK) return false;
+    FRESULT fr = f_read(&f, buf, sizeof(buf) - 1, &br);
+    f_close(&f);
+    if (fr != FR_OK || br == 0) return false;
+    buf[br] = '\0';
+
+    memset(app, 0, sizeof(*app));
+    memset(x, 0, sizeof(*x));
+    strncpy(app->path, path, FA_PATH_LEN - 1);
+    reg_parse_inf(buf, app, x);
+    if (!app->name[0]) return false;
+
+    reg_load_icons(path, app, x);
+    return true;
+}
+
+/*==========================================================================
+ * Build, save, load
+ *=========================================================================*/
+
+/* Parse every app in /fos into the registry and fill in the header and
+ * bases.  False if the listing can't be described by a cache (no /fos,
+ * or more .inf files than APPREG_MAX_BASES). */
+static bool reg_rebuild(reg_header_t *hdr, uint32_t *bases) {
+    memset(hdr, 0, sizeof(*hdr));
+    reg_count = 0;
+
+    DIR dir;
+    FILINFO fno;
+    if (f_opendir(&dir, "/fos") != FR_OK) return false;
+
+    bool complete = true;
+    while (f_readdir(&dir, &fno) == FR_OK && fno.fname[0]) {
+        if (fno.fattrib & AM_DIR) continue;
+        int len = (int)strlen(fno.fname);
+        if (!reg_is_meta(fno.fname, len)) continue;
+        hdr->inf_sum += reg_file_hash(reg_name_hash(fno.fname, len), &fno);
+
+        /* An .inf whose base executable exists is an app */
+        int base_len = len - 4;
+        if (!reg_ext_is(fno.fname, len, ".inf") ||
+            base_len >= FA_PATH_LEN - 5 ||
+            reg_is_meta(fno.fname, base_len))
+            continue;
+        if (hdr->nbases == APPREG_MAX_BASES) {
+            complete = false;
+            continue;
+        }
+        uint32_t bh = reg_name_hash(fno.fname, base_len);
+        bases[hdr->nbases++] = bh;
+
+        char path[FA_PATH_LEN];
+        snprintf(path, sizeof(path), "/fos/%.*s", base_len, fno.fname);
+        FILINFO fi;
+        if (f_stat(path, &fi) != FR_OK || (fi.fattrib & AM_DIR)) continue;
+        hdr->base_sum += reg_file_hash(bh, &fi);
+
+        if (reg_count < APPREG_MAX_APPS &&
+            reg_parse_app(path, &reg_apps[reg_count], &reg_extra[reg_count]))
+            reg_count++;
+    }
+    f_closedir(&dir);
+
+    hdr->magic      = REG_MAGIC;
+    hdr->version    = REG_VERSION;
+    hdr->app_size   = sizeof(fa_app_t);
+    hdr->extra_size = sizeof(reg_extra_t);
+    hdr->count      = (uint16_t)reg_count;
+    return complete;
+}
+
+static void reg_save(const reg_header_t *hdr, const uint32_t *bases) {
+    FIL f;
+    UINT bw;
+    if (f_open(&f, APPREG_CACHE_PATH, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK)
+        return;
+    UINT nb = hdr->nbases * sizeof(bases[0]);
+    UINT na = hdr->count * sizeof(fa_app_t);
+    UINT nx = hdr->count * sizeof(reg_extra_t);
+    bool ok = f_write(&f, hdr, sizeof(*hdr), &bw) == FR_OK && bw == sizeof(*hdr)
+           && f_write(&f, bases, nb, &bw) == FR_OK && bw == nb
+           && f_write(&f, reg_apps, na, &bw) == FR_OK && bw == na
+           && f_write(&f, reg_extra, nx, &bw) == FR_OK && bw == nx;
+    if (f_close(&f) != FR_OK) ok = false;
+    if (!ok) f_unlink(APPREG_CACHE_PATH);
+}
+
+static bool reg_read(FIL *f, void *buf, UINT n) {
+    UINT br;
+    return f_read(f, buf, n, &br) == FR_OK && br == n;
+}
+
+void app_registry_load(void) {
+    static uint32_t bases[APPREG_MAX_BASES];
+    reg_header_t hdr;
+
+    reg_count = 0;
+    if (!sdcard_is_mounted()) return;
+
+    FIL f;
+    if (f_open(&f, APPREG_CACHE_PATH, FA_READ) == FR_OK) {
+        uint32_t inf_sum, base_sum;
+        bool ok = reg_read(&f, &hdr, sizeof(hdr))
+               && hdr.magic == REG_MAGIC && hdr.version == REG_VERSION
+               && hdr.app_size == sizeof(fa_app_t)
+               && hdr.extra_size == sizeof(reg_extra_t)
+               && hdr.count <= APPREG_MAX_APPS
+               && hdr.nbases <= APPREG_MAX_BASES
+               && reg_read(&f, bases, hdr.nbases * sizeof(bases[0]))
+               && reg_sum_listing(bases, hdr.nbases, &inf_sum, &base_sum)
+               && inf_sum == hdr.inf_sum && base_sum == hdr.base_sum
+               && reg_read(&f, reg_apps, hdr.count * sizeof(fa_app_t))
+               && reg_read(&f, reg_extra, hdr.count * sizeof(reg_extra_t));
+        f_close(&f);
+        if (ok) {
+            reg_count = hdr.count;
+            return;
+        }
+    }
+
+    if (reg_rebuild(&hdr, bases))
+        reg_save(&hdr, bases);
+    else
+        f_unlink(APPREG_CACHE_PATH);
+}
+
+/*==========================================================================
+ * Query API
+ *=========================================================================*/
+
+int app_registry_count(void) {
+    return reg_count;
+}
+
+const fa_app_t *app_registry_apps(int *count) {
+    if (count) *count = reg_count;
+    return reg_apps;
+}
+
+const fa_app_t *app_registry_get(int idx) {
+    return (idx >= 0 && idx < reg_count) ? &reg_apps[idx] : NULL;
+}
+
+const char *app_registry_title(int idx) {
+    if (idx < 0 || idx >= reg_count) return "";
+    uint8_t lang = lang_get();
+    if (lang < APPREG_LANGS && reg_extra[idx].titles[lang][0])
+        return reg_extra[idx].titles[lang];
+    return reg_extra[idx].titles[0];
+}
+
+bool app_registry_has_ico(int idx) {
+    return idx >= 0 && idx < reg_count && reg_extra[idx].has_ico;
+}
+
+int app_registry_find(const char *path) {
+    for (int i = 0; i < reg_count; i++) {
+        const char *a = reg_apps[i].path, *b = path;
+        while (*a && tolower((unsigned char)*a) == tolower((unsigned char)*b)) {
+            a++;
+            b++;
+        }
+        if (!*a && !*b) return i;
+    }
+    return -1;
+}
@@ -0,0 +1,55 @@
+/*
+ * FRANK OS — App Registry
+ * Copyright (c) 2026 Mikhail Matveev <xtreme@rh1.tech>
+ * https://rh1.tech
+ *
+ * One in-memory index of the apps in /fos (an executable with a
+ * companion .inf): display names, extensions and icons.  The start
+ * menu, file associations, desktop shortcuts and Navigator all read it
+ * instead of opening the .inf and .ico files themselves.
+ *
+ * The index is saved to /fos/registry.cache.  FAT does not touch a
+ * directory's date when files in it change, so the cache is validated
+ * against the /fos listing instead: one readdir pass sums the name,
+ * size and date of every .inf and .ico and of every file named like an
+ * .inf's base, and the cache is used only if both sums still match.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef APP_REGISTRY_H
+#define APP_REGISTRY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "file_assoc.h"
+
+#define APPREG_MAX_APPS    FA_MAX_APPS
+#define APPREG_MAX_BASES   (FA_MAX_APPS * 2)  /* .inf files tracked   */
+#define APPREG_TITLE_LEN   32                 /* UTF-8 start menu name */
+#define APPREG_LANGS       2                  /* LANG_EN, LANG_RU      */
+
+#define APPREG_CACHE_PATH  "/fos/registry.cache"
+
+/* Build the index: load the cache if the listing still matches it,
+ * otherwise parse every .inf and .ico and rewrite the cache.
+ * Cheap when nothing changed — safe to call after installing apps. */
+void app_registry_load(void);
+
+/* Registered apps, in /fos directory order */
+int app_registry_count(void);
+const fa_app_t *app_registry_apps(int *count);
+const fa_app_t *app_registry_get(int idx);
+
+/* Display name in the current language ("name.XX=" line of the .inf),
+ * falling back to the first line */
+const char *app_registry_title(int idx);
+
+/* True if the app's icons came from its .ico (otherwise they are the
+ * terminal icons) */
+bool app_registry_has_ico(int idx);
+
+/* Index of the app at path (e.g. "/fos/notepad", any case), or -1 */
+int app_registry_find(const char *path);
+
+#endif /* APP_REGISTRY_H */
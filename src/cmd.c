@@ -194,6 +194,11 @@ FIL* __in_hfa() get_stderr() {
     cmd_ctx_t* pctx = get_cmd_ctx();
     return pctx ? pctx->std_err : ctx.std_err;
 }
+FIL* __in_hfa() get_std_pipe(cmd_ctx_t* pctx, int std_fd) {
+    if (!pctx) return NULL;
+    FIL* fp = std_fd == 0 ? pctx->std_in : std_fd == 1 ? pctx->std_out : pctx->std_err;
+    return fp && f_is_pipe(fp) ? fp : NULL;
+}
 char* __in_hfa() get_curr_dir() {
     cmd_ctx_t* pctx = get_cmd_ctx();
     return get_ctx_var(pctx ? pctx : &ctx, "CD");
@@ -63,6 +63,7 @@ typedef struct {
     list_t* /*sect_entry_t*/ sections;
     void* _fini_ctx;
     uint32_t app_flags;
+    struct app_cache* code_cache; // shared read-only sections (app_cache.h)
 } bootb_ctx_t;
 
 typedef struct {
@@ -140,6 +141,8 @@ void remove_ctx(cmd_ctx_t*);
 void set_ctx_var(cmd_ctx_t*, const char* key, const char* val);
 char* get_ctx_var(cmd_ctx_t*, const char* key);
 void cleanup_ctx(cmd_ctx_t* src);
+/* Pipe end behind stdin/stdout/stderr (0/1/2) of a pipeline stage, or NULL */
+FIL* get_std_pipe(cmd_ctx_t* ctx, int std_fd);
 
 char* next_token(char* t);
 char* concat(const char* s1, const char* s2);
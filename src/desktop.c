@@ -9,6 +9,7 @@
 #include "desktop.h"
 #include "lang.h"
 #include "file_assoc.h"
+#include "app_registry.h"
 #include "filemanager.h"
 #include "terminal.h"
 #include "window.h"
@@ -114,6 +115,7 @@ static void nn_downscale_32_to_16(const uint8_t *src, uint8_t *dst) {
 /* Check if path is an app (has .inf or .xa1 companion) */
 static bool is_app_path(const char *path) {
     if (path[0] == ':') return true;   /* built-in apps */
+    if (app_registry_find(path) >= 0) return true;
     char chk[DESKTOP_PATH_MAX + 4];
     FILINFO fi;
     snprintf(chk, sizeof(chk), "%s.inf", path);
@@ -124,6 +126,7 @@ static bool is_app_path(const char *path) {
 
 /* Check if path is a cc-compiled executable (.xa1 companion, no .inf) */
 static bool is_cc_executable(const char *path) {
+    if (app_registry_find(path) >= 0) return false;  /* ELF app */
     char chk[DESKTOP_PATH_MAX + 4];
     FILINFO fi;
     snprintf(chk, sizeof(chk), "%s.inf", path);
@@ -166,8 +169,20 @@ static bool load_ico_icon(desktop_shortcut_t *sc) {
     return load_ico_from(ico_path, sc);
 }
 
-/* Load 32x32 icon: try .ico first, then fall back to .inf data */
+/* Load 32x32 icon: try .ico first, then fall back to .inf data.
+ * Apps in the registry are served from memory. */
 static void load_app_icon(desktop_shortcut_t *sc) {
+    int idx = app_registry_find(sc->path);
+    if (idx >= 0) {
+        /* No .ico: keep the default icon, as a text .inf has none */
+        if (app_registry_has_ico(idx)) {
+            memcpy(sc->icon, app_registry_get(idx)->icon32,
+                   DESKTOP_ICON32_SIZE);
+            sc->has_icon = true;
+        }
+        return;
+    }
+
     /* Prefer .ico file */
     if (load_ico_icon(sc)) return;
 
@@ -207,6 +222,12 @@ static void load_app_icon(desktop_shortcut_t *sc) {
 
 /* Load display name from .inf file */
 static void load_app_name(desktop_shortcut_t *sc) {
+    const fa_app_t *app = app_registry_get(app_registry_find(sc->path));
+    if (app) {
+        strncpy(sc->name, app->name, DESKTOP_NAME_MAX - 1);
+        return;
+    }
+
     char inf[DESKTOP_PATH_MAX + 4];
     snprintf(inf, sizeof(inf), "%s.inf", sc->path);
 
@@ -7,9 +7,11 @@
  */
 
 #include "display.h"
+#include "raster4.h"
 #include "disphstx.h"
 #include "FreeRTOS.h"
 #include "portable.h"
+#include "task.h"
 #include <string.h>
 #include <stdio.h>
 
@@ -63,6 +65,10 @@ uint8_t  display_bpp        = 4;
 uint8_t  display_video_mode = VIDEO_MODE_640x480x16;
 volatile uint8_t display_compositor_idle = 0;
 
+static void (*mode_hook)(void);
+
+display_clip_t display_clip = { 0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT };
+
 // Convert RGB888 to RGB565
 static inline u16 rgb888_to_rgb565(uint32_t rgb888) {
     uint8_t r = (rgb888 >> 16) & 0xFF;
@@ -185,6 +191,7 @@ void display_init(void) {
     display_fb_stride  = FB_STRIDE;
     display_bpp        = 4;
     display_video_mode = VIDEO_MODE_640x480x16;
+    display_reset_clip();
 
     start_mode_640x480x16();
 
@@ -215,6 +222,11 @@ void display_init(void) {
  * Used to make the compositor enter bypass BEFORE the real switch. */
 void display_request_mode(uint8_t mode) {
     display_video_mode = mode;
+    if (mode_hook) mode_hook();
+}
+
+void display_set_mode_hook(void (*fn)(void)) {
+    mode_hook = fn;
 }
 
 /* Reconfigure the ACTIVE vmode descriptor in-place during vblank.
@@ -225,6 +237,7 @@ static void reconfigure_vmode_inplace(int hdbl, int vdbl, int format,
 
     /* Clear framebuffer first (while old mode still displays) */
     memset(framebuffer_a, 0, sizeof(framebuffer_a));
+    display_sprites_reset();
     display_draw_buffer_ptr = draw_buffer;
     display_show_buffer_ptr = framebuffer_a;
 
@@ -265,8 +278,10 @@ do_switch:
         display_fb_stride  = 320;
         display_bpp        = 4;
         display_video_mode = VIDEO_MODE_640x480x16;
+        display_reset_clip();
         reconfigure_vmode_inplace(1, 1, DISPHSTX_FORMAT_4_PAL,
                                    cga_palette_rgb565);
+        if (mode_hook) mode_hook();
         return 0;
 
     case VIDEO_MODE_320x240x256:
@@ -275,8 +290,10 @@ do_switch:
         display_fb_stride  = 320;
         display_bpp        = 8;
         display_video_mode = VIDEO_MODE_320x240x256;
+        display_reset_clip();
         reconfigure_vmode_inplace(2, 2, DISPHSTX_FORMAT_8_PAL,
                                    palette_256_rgb565);
+        if (mode_hook) mode_hook();
         return 0;
 
     default:
@@ -292,15 +309,38 @@ void display_set_palette_entry(uint8_t index, uint32_t rgb888) {
     palette_256_rgb565[index] = rgb888_to_rgb565(rgb888);
 }
 
-// Set pixel in the draw buffer — mode-aware
+void display_set_clip(int x, int y, int w, int h) {
+    int x1 = x + w;
+    int y1 = y + h;
+    if (x < 0) x = 0;
+    if (y < 0) y = 0;
+    if (x1 > (int)display_width)  x1 = display_width;
+    if (y1 > (int)display_height) y1 = display_height;
+    /* Empty clip: collapse so every containment test fails */
+    if (x >= x1 || y >= y1) { x1 = x; y1 = y; }
+    display_clip.x0 = (int16_t)x;
+    display_clip.y0 = (int16_t)y;
+    display_clip.x1 = (int16_t)x1;
+    display_clip.y1 = (int16_t)y1;
+}
+
+void display_reset_clip(void) {
+    display_clip.x0 = 0;
+    display_clip.y0 = 0;
+    display_clip.x1 = (int16_t)display_width;
+    display_clip.y1 = (int16_t)display_height;
+}
+
+// Set pixel in the draw buffer — mode-aware, honours the clip rect
+// (which is always a subset of the screen, so it doubles as bounds check)
 void display_set_pixel(int x, int y, uint8_t color) {
+    if (x < display_clip.x0 || x >= display_clip.x1 ||
+        y < display_clip.y0 || y >= display_clip.y1) return;
     if (display_bpp == 8) {
         // 8bpp: 1 byte per pixel
-        if ((unsigned)x >= display_width || (unsigned)y >= display_height) return;
         draw_buffer[y * display_fb_stride + x] = color;
     } else {
         // 4bpp: 2 pixels per byte (pair-encoded)
-        if ((unsigned)x >= DISPLAY_WIDTH || (unsigned)y >= FB_HEIGHT) return;
         color &= 0x0F;
         uint8_t *p = &draw_buffer[y * FB_STRIDE + (x >> 1)];
         if (x & 1)
@@ -323,7 +363,20 @@ void display_swap_buffers(void) {
     /* No-op: single-buffer mode — kept for sys_table backward compat */
 }
 
+/* Every mode scans out 640x480@60: 525 lines of 31.8 us, the beam
+ * counter running from the first visible line.  The margin covers the
+ * tick the sleep may overrun by and getting scheduled back in. */
+#define VSYNC_LINE_US    32
+#define VSYNC_MARGIN_US  1500
+
 void display_wait_vsync(void) {
+    int line = pDispHstxVMode->line;
+    if (line >= 0 && line < DISPLAY_HEIGHT &&
+        xTaskGetSchedulerState() == taskSCHEDULER_RUNNING) {
+        uint32_t us = (uint32_t)(DISPLAY_HEIGHT - line) * VSYNC_LINE_US;
+        if (us >= VSYNC_MARGIN_US + 1000)
+            vTaskDelay(pdMS_TO_TICKS((us - VSYNC_MARGIN_US) / 1000));
+    }
     DispHstxWaitVSync();
 }
 
@@ -369,69 +422,40 @@ void display_hline_fast(int x0, int y, int w, uint8_t color) {
         return;
     }
 
-    /* 4bpp: pair-encoded nibbles */
-    uint8_t *row = &draw_buffer[y * FB_STRIDE];
-    int x_end = x0 + w;
-    uint8_t fill = (color << 4) | color;
-
-    if (x0 & 1) {
-        uint8_t *p = &row[x0 >> 1];
-        *p = (*p & 0xF0) | color;
-        x0++;
-    }
-
-    if (x_end & 1) {
-        x_end--;
-        uint8_t *p = &row[x_end >> 1];
-        *p = (*p & 0x0F) | (color << 4);
-    }
-
-    int byte0 = x0 >> 1;
-    int byte1 = x_end >> 1;
-    if (byte1 > byte0)
-        memset(&row[byte0], fill, byte1 - byte0);
+    /* 4bpp: pair-encoded nibbles, word stores (raster4.c) */
+    r4_span(&draw_buffer[y * FB_STRIDE], x0, x0 + w, color);
 }
 
 /*==========================================================================
- * Bounds-checked horizontal span — clips to screen, mode-aware
+ * Bounds-checked horizontal span — clips to the clip rect, mode-aware
  *=========================================================================*/
 void display_hline_safe(int x0, int y, int w, uint8_t color) {
     if (w <= 0) return;
+    if (y < display_clip.y0 || y >= display_clip.y1) return;
 
-    if (display_bpp == 8) {
-        if (y < 0 || y >= (int)display_height) return;
-        int x1 = x0 + w;
-        if (x0 < 0) x0 = 0;
-        if (x1 > (int)display_width) x1 = (int)display_width;
-        if (x0 >= x1) return;
+    int x1 = x0 + w;
+    if (x0 < display_clip.x0) x0 = display_clip.x0;
+    if (x1 > display_clip.x1) x1 = display_clip.x1;
+    if (x0 >= x1) return;
+
+    if (display_bpp == 8)
         memset(&draw_buffer[y * display_fb_stride + x0], color, x1 - x0);
-    } else {
-        if (y < 0 || y >= FB_HEIGHT) return;
-        int x1 = x0 + w;
-        if (x0 < 0) x0 = 0;
-        if (x1 > DISPLAY_WIDTH) x1 = DISPLAY_WIDTH;
-        if (x0 >= x1) return;
+    else
         display_hline_fast(x0, y, x1 - x0, color & 0x0F);
-    }
 }
 
 /*==========================================================================
- * Fast 8-wide glyph blitter (4bpp mode only)
+ * Fast 8-wide glyph blitter
  *
- * Requires x to be even (true for any 8px font grid).  Writes 4 bytes
- * per font row using a 4-entry lookup table that maps each pair of font
- * bits to a framebuffer byte.
+ * Requires x to be even (true for any 8px font grid).  In 4bpp mode
+ * each font row becomes one 32-bit store: r4_glyph_lsb expands the 8
+ * font bits into a nibble mask that selects between the replicated
+ * fg and bg words.
  *
  * Font bit ordering: bit 0 = leftmost pixel (matches gfx_char's
  * "bits & (1 << col)" convention).
  *
  * Pixel packing: high nibble = even-x (left), low nibble = odd-x (right).
- * So for a pair of pixels at positions (2k, 2k+1):
- *   byte = (left_color << 4) | right_color
- *
- * Bit pair (bit 2k, bit 2k+1) from the font byte:
- *   bit 2k   → left pixel  (even x) → high nibble
- *   bit 2k+1 → right pixel (odd x)  → low nibble
  *=========================================================================*/
 void display_blit_glyph_8wide(int x, int y, const uint8_t *glyph,
                                int h, uint8_t fg, uint8_t bg) {
@@ -448,23 +472,220 @@ void display_blit_glyph_8wide(int x, int y, const uint8_t *glyph,
         return;
     }
 
-    /* 4bpp: pair-encoded LUT path */
-    uint8_t lut[4];
-    lut[0] = (bg << 4) | bg;
-    lut[1] = (fg << 4) | bg;
-    lut[2] = (bg << 4) | fg;
-    lut[3] = (fg << 4) | fg;
-
+    /* 4bpp: one word per font row */
+    uint32_t fgw = r4_fill_word(fg);
+    uint32_t bgw = r4_fill_word(bg);
     int byte_x = x >> 1;
 
     for (int r = 0; r < h; r++) {
         int py = y + r;
         if ((unsigned)py >= (unsigned)display_height) continue;
-        uint8_t bits = glyph[r];
-        uint8_t *dst = &draw_buffer[py * FB_STRIDE + byte_x];
-        dst[0] = lut[(bits >> 0) & 3];
-        dst[1] = lut[(bits >> 2) & 3];
-        dst[2] = lut[(bits >> 4) & 3];
-        dst[3] = lut[(bits >> 6) & 3];
+        r4_store32(&draw_buffer[py * FB_STRIDE + byte_x],
+                   r4_glyph_word(r4_glyph_lsb[glyph[r]], fgw, bgw));
     }
 }
+
+/*==========================================================================
+ * Vertical block move
+ *
+ * Rows are copied in the order that never reads an already-overwritten
+ * source row (top-down when moving up, bottom-up when moving down).
+ * In 4bpp mode odd left/right edges are merged per nibble so the pixels
+ * just outside the rect are left alone.
+ *=========================================================================*/
+void display_move_rows(int x, int y, int w, int h, int dy) {
+    int n = h - (dy < 0 ? -dy : dy);
+    if (w <= 0 || dy == 0 || n <= 0) return;
+
+    int step  = dy < 0 ? 1 : -1;
+    int dst_y = dy < 0 ? y : y + h - 1;
+
+    for (int i = 0; i < n; i++, dst_y += step) {
+        uint8_t       *d = &draw_buffer[dst_y * display_fb_stride];
+        const uint8_t *s = &draw_buffer[(dst_y - dy) * display_fb_stride];
+
+        if (display_bpp == 8) {
+            memcpy(d + x, s + x, w);
+            continue;
+        }
+
+        int x0 = x, x1 = x + w;
+        if (x0 & 1) {
+            d[x0 >> 1] = (d[x0 >> 1] & 0xF0) | (s[x0 >> 1] & 0x0F);
+            x0++;
+        }
+        if (x1 & 1) {
+            x1--;
+            d[x1 >> 1] = (d[x1 >> 1] & 0x0F) | (s[x1 >> 1] & 0xF0);
+        }
+        if (x1 > x0)
+            memcpy(d + (x0 >> 1), s + (x0 >> 1), (x1 - x0) >> 1);
+    }
+}
+
+/*==========================================================================
+ * Sprites
+ *
+ * The requested state (image, packed position, shown) is written by any
+ * task with single stores and only read here, so it needs no lock: the
+ * compositor compares it with what it stamped and catches up in
+ * display_sprites_present().  Every sprite keeps the bytes it covers as
+ * a save-under — whole bytes in 4bpp mode, so the odd edge nibbles come
+ * back with them.  A sprite may only be lifted while none stamped after
+ * it is still on top, hence lifts run from the last index down.
+ *=========================================================================*/
+
+#define SPRITE_SAVE_BYTES (DISPLAY_SPRITE_MAX * DISPLAY_SPRITE_MAX)
+
+typedef struct {
+    const display_sprite_t *volatile img;
+    volatile uint32_t pos;          /* x | y << 16 */
+    volatile bool     shown;
+
+    /* What is on the framebuffer */
+    bool                    stamped;
+    const display_sprite_t *st_img;
+    uint32_t                st_pos;
+    int16_t                 x0, y0, x1, y1;     /* covered pixels, half-open */
+    uint8_t                 save[SPRITE_SAVE_BYTES];
+} sprite_t;
+
+static sprite_t sprites[DISPLAY_SPRITES];
+
+static inline bool sprite_wanted(const sprite_t *s) {
+    return s->shown && s->img;
+}
+
+static bool sprite_dirty(const sprite_t *s) {
+    if (!s->stamped) return sprite_wanted(s);
+    return !sprite_wanted(s) || s->img != s->st_img || s->pos != s->st_pos;
+}
+
+/* Byte columns of the framebuffer a pixel span covers */
+static inline void sprite_bytes(const sprite_t *s, int *bx, int *bpr) {
+    if (display_bpp == 8) {
+        *bx  = s->x0;
+        *bpr = s->x1 - s->x0;
+    } else {
+        *bx  = s->x0 >> 1;
+        *bpr = ((s->x1 - 1) >> 1) - *bx + 1;
+    }
+}
+
+static void sprite_stamp(sprite_t *s) {
+    const display_sprite_t *img = s->img;
+    uint32_t pos = s->pos;
+    if (!img) return;
+    s->stamped = true;
+    s->st_img  = img;
+    s->st_pos  = pos;
+
+    int ox = (int16_t)(pos & 0xFFFF) - img->hot_x;
+    int oy = (int16_t)(pos >> 16) - img->hot_y;
+    s->x0 = ox < 0 ? 0 : ox;
+    s->y0 = oy < 0 ? 0 : oy;
+    s->x1 = ox + img->w > (int)display_width  ? display_width  : ox + img->w;
+    s->y1 = oy + img->h > (int)display_height ? display_height : oy + img->h;
+    if (s->x0 >= s->x1 || s->y0 >= s->y1) {
+        s->x1 = s->x0;      /* off screen: nothing saved */
+        return;
+    }
+
+    uint8_t *fb = display_show_buffer_ptr;
+    int bx, bpr;
+    sprite_bytes(s, &bx, &bpr);
+    uint8_t *dst = s->save;
+    for (int y = s->y0; y < s->y1; y++, dst += bpr)
+        memcpy(dst, &fb[y * display_fb_stride + bx], bpr);
+
+    for (int y = s->y0; y < s->y1; y++) {
+        const uint8_t *src = &img->bitmap[(y - oy) * img->w];
+        uint8_t *row = &fb[y * display_fb_stride];
+        for (int x = s->x0; x < s->x1; x++) {
+            uint8_t code = src[x - ox];
+            if (!code) continue;
+            uint8_t color = img->colors[code - 1];
+            if (display_bpp == 8) {
+                row[x] = color;
+            } else {
+                uint8_t *p = &row[x >> 1];
+                if (x & 1)
+                    *p = (*p & 0xF0) | (color & 0x0F);
+                else
+                    *p = (*p & 0x0F) | (color << 4);
+            }
+        }
+    }
+}
+
+static void sprite_restore(sprite_t *s) {
+    s->stamped = false;
+    if (s->x0 >= s->x1) return;
+    uint8_t *fb = display_show_buffer_ptr;
+    int bx, bpr;
+    sprite_bytes(s, &bx, &bpr);
+    const uint8_t *src = s->save;
+    for (int y = s->y0; y < s->y1; y++, src += bpr)
+        memcpy(&fb[y * display_fb_stride + bx], src, bpr);
+}
+
+/* Lift every stamped sprite from index k up */
+static void sprites_lift_from(int k) {
+    for (int i = DISPLAY_SPRITES - 1; i >= k; i--)
+        if (sprites[i].stamped)
+            sprite_restore(&sprites[i]);
+}
+
+bool display_sprite_set(int id, const display_sprite_t *img) {
+    if (id < 0 || id >= DISPLAY_SPRITES) return false;
+    if (img && (img->w > DISPLAY_SPRITE_MAX || img->h > DISPLAY_SPRITE_MAX))
+        return false;
+    sprites[id].img = img;
+    return true;
+}
+
+void display_sprite_move(int id, int16_t x, int16_t y) {
+    if (id < 0 || id >= DISPLAY_SPRITES) return;
+    sprites[id].pos = (uint16_t)x | (uint32_t)(uint16_t)y << 16;
+}
+
+void display_sprite_show(int id, bool show) {
+    if (id < 0 || id >= DISPLAY_SPRITES) return;
+    sprites[id].shown = show;
+}
+
+bool display_sprites_pending(void) {
+    for (int i = 0; i < DISPLAY_SPRITES; i++)
+        if (sprite_dirty(&sprites[i]))
+            return true;
+    return false;
+}
+
+void display_sprites_lift(int x, int y, int w, int h) {
+    for (int i = 0; i < DISPLAY_SPRITES; i++) {
+        const sprite_t *s = &sprites[i];
+        if (s->stamped && s->x0 < x + w && x < s->x1 &&
+            s->y0 < y + h && y < s->y1) {
+            sprites_lift_from(i);
+            return;
+        }
+    }
+}
+
+void display_sprites_lift_all(void) {
+    sprites_lift_from(0);
+}
+
+void display_sprites_present(void) {
+    int k = 0;
+    while (k < DISPLAY_SPRITES && !sprite_dirty(&sprites[k])) k++;
+    sprites_lift_from(k);
+    for (int i = 0; i < DISPLAY_SPRITES; i++)
+        if (!sprites[i].stamped && sprite_wanted(&sprites[i]))
+            sprite_stamp(&sprites[i]);
+}
+
+void display_sprites_reset(void) {
+    for (int i = 0; i < DISPLAY_SPRITES; i++)
+        sprites[i].stamped = false;
+}
@@ -10,6 +10,7 @@
 #define DISPLAY_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <string.h>
 
 /* ======================================================================
@@ -61,6 +62,10 @@ int  display_set_video_mode(uint8_t mode);
 /* Returns the current VIDEO_MODE_* value. */
 uint8_t display_get_video_mode(void);
 
+/* Called after display_request_mode() or display_set_video_mode() changes
+ * the mode flag, so tasks sleeping on it can look again. */
+void display_set_mode_hook(void (*fn)(void));
+
 /* Set one entry in the 256-color palette (only meaningful in 320x240x256).
  * index 0..255, rgb888 is 0xRRGGBB. */
 void display_set_palette_entry(uint8_t index, uint32_t rgb888);
@@ -68,11 +73,43 @@ void display_set_palette_entry(uint8_t index, uint32_t rgb888);
 void display_set_pixel(int x, int y, uint8_t color);
 void display_clear(uint8_t color);
 void display_swap_buffers(void);
+/* Returns at the start of vblank.  From a task, sleeps through most of
+ * the visible frame and spins only for the last lines. */
 void display_wait_vsync(void);
 uint16_t display_get_scanline(void);
 void display_wait_scanline(int16_t y);
 void display_draw_test_pattern(void);
 
+/* ======================================================================
+ * Clip rectangle — screen coordinates, half-open [x0,x1) x [y0,y1)
+ *
+ * Defaults to the whole screen.  The compositor narrows it while it
+ * repaints a damaged region, so a paint handler can redraw its entire
+ * client area and only the damaged pixels reach the framebuffer.
+ * Honoured by display_set_pixel, display_hline_safe and the gfx_* / wd_*
+ * primitives built on them.  The *_fast helpers, display_blit_glyph_8wide
+ * and wd_fb_ptr() do NOT check it — callers test display_clip_contains()
+ * before taking those paths.
+ * ====================================================================== */
+
+typedef struct {
+    int16_t x0, y0, x1, y1;
+} display_clip_t;
+
+extern display_clip_t display_clip;
+
+/* Narrow the clip to (x, y, w, h) intersected with the screen */
+void display_set_clip(int x, int y, int w, int h);
+
+/* Reset the clip to the full screen of the current video mode */
+void display_reset_clip(void);
+
+/* True if the rect (x, y, w, h) lies entirely inside the clip */
+static inline bool display_clip_contains(int x, int y, int w, int h) {
+    return x >= display_clip.x0 && x + w <= display_clip.x1 &&
+           y >= display_clip.y0 && y + h <= display_clip.y1;
+}
+
 /* Direct draw-buffer pointer — updated by display_init / display_swap_buffers */
 extern uint8_t *display_draw_buffer_ptr;
 
@@ -115,7 +152,7 @@ static inline void display_set_pixel_8bpp_fast(int x, int y, uint8_t color) {
  * 4bpp (640x480x16) mode only. */
 void display_hline_fast(int x0, int y, int w, uint8_t color);
 
-/* Bounds-checked horizontal span — clips to screen, then calls hline_fast.
+/* Bounds-checked horizontal span — clips to the clip rect, then calls hline_fast.
  * Mode-aware: works in both 4bpp and 8bpp modes. */
 void display_hline_safe(int x0, int y, int w, uint8_t color);
 
@@ -127,4 +164,62 @@ void display_hline_safe(int x0, int y, int w, uint8_t color);
 void display_blit_glyph_8wide(int x, int y, const uint8_t *glyph,
                                int h, uint8_t fg, uint8_t bg);
 
+/* Vertical block move — shifts the pixels of rect (x, y, w, h) by dy rows
+ * (negative = up) within the rect.  The |dy| rows uncovered at the
+ * leading edge keep their old contents; the caller repaints them.
+ * No clipping: the rect must lie on screen.  Mode-aware. */
+void display_move_rows(int x, int y, int w, int h, int dy);
+
+/* ======================================================================
+ * Sprites — small overlays kept off the compositor's frame
+ *
+ * Up to DISPLAY_SPRITES images (the mouse cursor among them) float over
+ * the framebuffer.  Any task moves, switches or hides one with plain
+ * stores; nothing is drawn until the compositor presents them, right
+ * after vblank.  Presenting stamps each sprite with a save-under and
+ * restores the old pixels wherever one moved.
+ *
+ * The compositor lifts the sprites off a rect before painting it, so
+ * windows never see sprite pixels, and presents again when done.
+ * Sprites are stamped in index order; the cursor uses the last one so
+ * it stays on top.
+ * ====================================================================== */
+
+#define DISPLAY_SPRITES       4
+#define DISPLAY_SPRITE_MAX    24    /* max width and height in pixels */
+#define DISPLAY_SPRITE_CURSOR (DISPLAY_SPRITES - 1)
+
+typedef struct {
+    const uint8_t *bitmap;  /* w * h codes, row-major, 0 = transparent */
+    const uint8_t *colors;  /* color index for code n at colors[n - 1] */
+    uint8_t w, h;
+    uint8_t hot_x, hot_y;   /* pixel placed at the sprite position */
+} display_sprite_t;
+
+/* Set a sprite's image (NULL hides it).  Returns false if the image is
+ * larger than DISPLAY_SPRITE_MAX in either direction. */
+bool display_sprite_set(int id, const display_sprite_t *img);
+
+/* Place a sprite's hotspot at screen (x, y) */
+void display_sprite_move(int id, int16_t x, int16_t y);
+
+void display_sprite_show(int id, bool show);
+
+/* True if a sprite moved, changed or was shown/hidden since the last
+ * display_sprites_present() */
+bool display_sprites_pending(void);
+
+/* Compositor only.  Restore the pixels under every stamped sprite that
+ * overlaps (x, y, w, h) — and those stamped over it — before painting
+ * there. */
+void display_sprites_lift(int x, int y, int w, int h);
+void display_sprites_lift_all(void);
+
+/* Compositor only, after painting: lift what moved or changed and stamp
+ * every visible sprite that isn't on the framebuffer */
+void display_sprites_present(void);
+
+/* Forget the stamps without restoring (the framebuffer was cleared) */
+void display_sprites_reset(void);
+
 #endif
@@ -57,8 +57,9 @@ typedef struct {
  * API
  *=========================================================================*/
 
-/* Scan /fos/*.inf and build the file association registry.
- * Called once at boot or when the SD card is inserted. */
+/* Load the app registry (app_registry.h) the associations come from.
+ * Called at boot or when the SD card is inserted; only re-reads the
+ * .inf and .ico files if /fos changed since the registry was cached. */
 void file_assoc_scan(void);
 
 /* Find the default (first registered) app for a file extension.
@@ -23,9 +23,12 @@
 #include "ff.h"
 #include "sdcard_init.h"
 #include "file_assoc.h"
+#include "app_registry.h"
 #include "desktop.h"
 #include "ico.h"
+#include "fxe.h"
 #include "controls.h"
+#include "psram.h"
 #include "FreeRTOS.h"
 #include "task.h"
 #include <string.h>
@@ -176,62 +179,228 @@ static int entry_cmp(const void *a, const void *b) {
     return sort_asc ? result : -result;
 }
 
-/* Check if a file exists at the given path.
- * Uses caller-provided FILINFO to avoid extra stack usage. */
-static bool fm_file_exists(const char *path, FILINFO *tmp) {
-    return f_stat(path, tmp) == FR_OK;
+/*--------------------------------------------------------------------------
+ * Directory model
+ *
+ * fm_refresh() reads the directory once into chunks of FN_CHUNK_ENTRIES,
+ * then resolves the .inf / .ico / .xa1 companions against a hash of the
+ * names instead of an f_stat() per file.  Names match case-insensitively,
+ * as FAT does.  If the hash can't be allocated the names are scanned
+ * linearly — still in memory.
+ *------------------------------------------------------------------------*/
+
+static void *fm_alloc(size_t size) {
+    void *p = psram_is_available() ? psram_alloc(size) : NULL;
+    return p ? p : pvPortMalloc(size);
 }
 
-static void fm_refresh(filemanager_t *fm) {
+/* Entry by read index, and by shown position */
+static inline fn_entry_t *fm_raw_entry(filemanager_t *fm, unsigned k) {
+    return &fm->chunks[k / FN_CHUNK_ENTRIES][k % FN_CHUNK_ENTRIES];
+}
+
+static inline fn_entry_t *fm_entry(filemanager_t *fm, int i) {
+    return fm_raw_entry(fm, fm->order[i]);
+}
+
+static void fm_free_listing(filemanager_t *fm) {
+    for (int c = 0; c < FN_MAX_CHUNKS && fm->chunks[c]; c++) {
+        psram_free(fm->chunks[c]);  /* handles SRAM pointers too */
+        fm->chunks[c] = NULL;
+    }
+    psram_free(fm->order);
+    fm->order = NULL;
     fm->entry_count = 0;
-    fm->scroll_y = 0;
-    fm->focus_index = -1;
-    fm->anchor_index = -1;
-    fm->selection_count = 0;
-    fn_app_icon_count = 0;
+}
+
+static inline char fm_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char)(c + 'a' - 'A') : c;
+}
+
+/* FNV-1a over lower-cased bytes; chains so hash(base + ext) can be taken
+ * without building the string */
+static uint32_t fm_name_hash(const char *s, int n, uint32_t h) {
+    for (int i = 0; i < n; i++)
+        h = (h ^ (uint8_t)fm_lower(s[i])) * 16777619u;
+    return h;
+}
+
+#define FM_HASH_SEED 2166136261u
+
+typedef struct {
+    filemanager_t *fm;
+    unsigned       count;   /* entries read */
+    uint16_t      *slots;   /* read index + 1, 0 = empty; NULL = scan */
+    uint32_t       mask;
+} fm_names_t;
+
+static bool fm_name_is(const char *name, const char *base, int blen,
+                       const char *ext) {
+    for (int i = 0; i < blen; i++, name++)
+        if (fm_lower(*name) != fm_lower(base[i])) return false;
+    for (; *ext; ext++, name++)
+        if (fm_lower(*name) != fm_lower(*ext)) return false;
+    return *name == '\0';
+}
+
+static void fm_names_build(fm_names_t *nt, filemanager_t *fm, unsigned count) {
+    uint32_t size = 16;
+    while (size < count * 2) size <<= 1;
+    nt->fm = fm;
+    nt->count = count;
+    nt->mask = size - 1;
+    nt->slots = (uint16_t *)fm_alloc(size * sizeof(uint16_t));
+    if (!nt->slots) return;
+    memset(nt->slots, 0, size * sizeof(uint16_t));
+    for (unsigned k = 0; k < count; k++) {
+        const char *name = fm_raw_entry(fm, k)->name;
+        uint32_t h = fm_name_hash(name, (int)strlen(name), FM_HASH_SEED);
+        while (nt->slots[h & nt->mask]) h++;
+        nt->slots[h & nt->mask] = (uint16_t)(k + 1);
+    }
+}
+
+/* True if the directory holds a file named base[0..blen) + ext */
+static bool fm_names_has(const fm_names_t *nt, const char *base, int blen,
+                         const char *ext) {
+    if (!nt->slots) {
+        for (unsigned k = 0; k < nt->count; k++)
+            if (fm_name_is(fm_raw_entry(nt->fm, k)->name, base, blen, ext))
+                return true;
+        return false;
+    }
+    uint32_t h = fm_name_hash(ext, (int)strlen(ext),
+                              fm_name_hash(base, blen, FM_HASH_SEED));
+    for (uint16_t s; (s = nt->slots[h & nt->mask]) != 0; h++)
+        if (fm_name_is(fm_raw_entry(nt->fm, s - 1u)->name, base, blen, ext))
+            return true;
+    return false;
+}
+
+/* Put a 16x16 icon into the icon cache, sharing a slot between entries
+ * with the same icon (e.g. all .txt -> notepad) */
+static void fm_cache_icon(fn_entry_t *e, const uint8_t *icon) {
+    for (int k = 0; k < (int)fn_app_icon_count; k++) {
+        if (memcmp(fn_app_icons[k], icon, 256) == 0) {
+            e->icon_idx = (int8_t)k;
+            return;
+        }
+    }
+    if (fn_app_icon_count < FN_MAX_APP_ICONS) {
+        memcpy(fn_app_icons[fn_app_icon_count], icon, 256);
+        e->icon_idx = fn_app_icon_count;
+        fn_app_icon_count++;
+    }
+}
+
+/* Load an app's 16x16 icon from <name>.ico into the icon cache; apps in
+ * the registry come from memory */
+static void fm_load_app_icon(filemanager_t *fm, fn_entry_t *e) {
+    char path[FN_PATH_MAX + 4];
+    if (fm->path[1] == '\0')
+        snprintf(path, FN_PATH_MAX, "/%s", e->name);
+    else
+        snprintf(path, FN_PATH_MAX, "%s/%s", fm->path, e->name);
+    int idx = app_registry_find(path);
+    if (idx >= 0) {
+        if (app_registry_has_ico(idx))
+            fm_cache_icon(e, app_registry_get(idx)->icon);
+        return;
+    }
+
+    if (fn_app_icon_count >= FN_MAX_APP_ICONS) return;
+    strcat(path, ".ico");
+    FIL ico;
+    if (f_open(&ico, path, FA_READ) != FR_OK) return;
+    FSIZE_t fsize = f_size(&ico);
+    if (fsize >= 22 && fsize <= 2048) {
+        uint8_t ibuf[2048];
+        UINT ibr;
+        if (f_read(&ico, ibuf, (UINT)fsize, &ibr) == FR_OK
+            && ibr == (UINT)fsize) {
+            if (ico_parse_16(ibuf, ibr, fn_app_icons[fn_app_icon_count])) {
+                e->icon_idx = fn_app_icon_count;
+                fn_app_icon_count++;
+            }
+        }
+    }
+    f_close(&ico);
+}
+
+/* For a non-executable file, show its associated app's icon */
+static void fm_assoc_icon(fn_entry_t *e) {
+    const char *dot = strrchr(e->name, '.');
+    if (!dot || !dot[1]) return;
+    const fa_app_t *app = file_assoc_find(dot + 1);
+    if (!app || !app->has_icon) return;
+    fm_cache_icon(e, app->icon);
+}
+
+/* Stable merge sort of order[]: directories first, then by the current
+ * sort column/order.  Falls back to insertion sort without scratch. */
+static void fm_sort(filemanager_t *fm) {
+    int n = fm->entry_count;
+    if (n < 2) return;
+    sort_col = fm->sort_column;
+    sort_asc = fm->sort_ascending;
 
+    uint16_t *tmp = (uint16_t *)fm_alloc(n * sizeof(uint16_t));
+    if (!tmp) {
+        uint16_t *a = fm->order;
+        for (int i = 1; i < n; i++) {
+            uint16_t k = a[i];
+            int j = i - 1;
+            while (j >= 0 && entry_cmp(fm_raw_entry(fm, k),
+                                       fm_raw_entry(fm, a[j])) < 0) {
+                a[j + 1] = a[j];
+                j--;
+            }
+            a[j + 1] = k;
+        }
+        return;
+    }
+
+    uint16_t *src = fm->order, *dst = tmp;
+    for (int w = 1; w < n; w *= 2) {
+        for (int lo = 0; lo < n; lo += 2 * w) {
+            int mid = lo + w < n ? lo + w : n;
+            int hi  = lo + 2 * w < n ? lo + 2 * w : n;
+            int i = lo, j = mid, k = lo;
+            while (i < mid && j < hi) {
+                /* Take from the right run only if strictly smaller */
+                if (entry_cmp(fm_raw_entry(fm, src[j]),
+                              fm_raw_entry(fm, src[i])) < 0)
+                    dst[k++] = src[j++];
+                else
+                    dst[k++] = src[i++];
+            }
+            while (i < mid) dst[k++] = src[i++];
+            while (j < hi)  dst[k++] = src[j++];
+        }
+        uint16_t *t = src; src = dst; dst = t;
+    }
+    if (src != fm->order)
+        memcpy(fm->order, src, n * sizeof(uint16_t));
+    psram_free(tmp);
+}
+
+/* Read the whole directory into chunks; returns the number of entries */
+static unsigned fm_read_dir(filemanager_t *fm) {
     DIR dir;
     FILINFO fno;
-    if (f_opendir(&dir, fm->path) != FR_OK) return;
-
-    /* Reuse a single path buffer for .inf checks (avoids stack bloat) */
-    char chk_path[FN_PATH_MAX];
+    if (f_opendir(&dir, fm->path) != FR_OK) return 0;
 
-    while (fm->entry_count < FN_MAX_ENTRIES) {
+    unsigned count = 0;
+    while (count < FN_MAX_ENTRIES) {
         if (f_readdir(&dir, &fno) != FR_OK || fno.fname[0] == 0)
             break;
-        /* Skip hidden files */
-        if (fno.fattrib & AM_HID) continue;
-        if (fno.fname[0] == '.') continue;
-
-        /* Skip .inf companion files when the base executable exists */
-        if (!(fno.fattrib & AM_DIR)) {
-            const char *dot = strrchr(fno.fname, '.');
-            if (dot && strcmp(dot, ".inf") == 0) {
-                /* Build base name (strip .inf extension) */
-                int blen = (int)(dot - fno.fname);
-                if (blen > 0 && blen < FN_NAME_MAX) {
-                    if (fm->path[1] == '\0')
-                        snprintf(chk_path, sizeof(chk_path), "/%.63s",
-                                 fno.fname);
-                    else
-                        snprintf(chk_path, sizeof(chk_path), "%s/%.63s",
-                                 fm->path, fno.fname);
-                    /* Trim the .inf from the check path */
-                    char *ext = strrchr(chk_path, '.');
-                    if (ext) *ext = '\0';
-                    /* If base file exists, skip this .inf */
-                    FILINFO tmp;
-                    if (fm_file_exists(chk_path, &tmp))
-                        continue;
-                }
-            }
-            /* Skip .xa1 sidecar files (cc extended attribute markers) */
-            if (dot && strcmp(dot, ".xa1") == 0)
-                continue;
+        unsigned c = count / FN_CHUNK_ENTRIES;
+        if (!fm->chunks[c]) {
+            fm->chunks[c] = (fn_entry_t *)fm_alloc(
+                FN_CHUNK_ENTRIES * sizeof(fn_entry_t));
+            if (!fm->chunks[c]) break;
         }
-
-        fn_entry_t *e = &fm->entries[fm->entry_count];
+        fn_entry_t *e = fm_raw_entry(fm, count++);
         strncpy(e->name, fno.fname, FN_NAME_MAX - 1);
         e->name[FN_NAME_MAX - 1] = '\0';
         e->size = (uint32_t)fno.fsize;
@@ -240,108 +409,62 @@ static void fm_refresh(filemanager_t *fm) {
         e->is_executable = 0;
         e->icon_idx = -1;
         e->custom_order = -1;
-
-        /* Detect executables: non-directory files with a companion .inf */
-        if (!(fno.fattrib & AM_DIR)) {
-            if (fm->path[1] == '\0')
-                snprintf(chk_path, sizeof(chk_path), "/%s.inf", fno.fname);
-            else
-                snprintf(chk_path, sizeof(chk_path), "%s/%s.inf",
-                         fm->path, fno.fname);
-            FILINFO tmp;
-            if (fm_file_exists(chk_path, &tmp)) {
-                e->is_executable = 1;
-                /* Load 16x16 icon from .ico file into cache */
-                if (fn_app_icon_count < FN_MAX_APP_ICONS) {
-                    char ico_path[FN_PATH_MAX];
-                    if (fm->path[1] == '\0')
-                        snprintf(ico_path, sizeof(ico_path), "/%s.ico",
-                                 e->name);
-                    else
-                        snprintf(ico_path, sizeof(ico_path), "%s/%s.ico",
-                                 fm->path, e->name);
-                    FIL ico;
-                    if (f_open(&ico, ico_path, FA_READ) == FR_OK) {
-                        FSIZE_t fsize = f_size(&ico);
-                        if (fsize >= 22 && fsize <= 2048) {
-                            uint8_t ibuf[2048];
-                            UINT ibr;
-                            if (f_read(&ico, ibuf, (UINT)fsize, &ibr) == FR_OK
-                                && ibr == (UINT)fsize) {
-                                if (ico_parse_16(ibuf, ibr,
-                                        fn_app_icons[fn_app_icon_count])) {
-                                    e->icon_idx = fn_app_icon_count;
-                                    fn_app_icon_count++;
-                                }
-                            }
-                        }
-                        f_close(&ico);
-                    }
-                    /* No .ico → terminal icon is used by fn_get_icon_16() */
-                }
-            }
-
-            /* Also detect cc-compiled executables via .xa1 sidecar */
-            if (!e->is_executable) {
-                if (fm->path[1] == '\0')
-                    snprintf(chk_path, sizeof(chk_path), "/%s.xa1",
-                             fno.fname);
-                else
-                    snprintf(chk_path, sizeof(chk_path), "%s/%s.xa1",
-                             fm->path, fno.fname);
-                FILINFO tmp2;
-                if (fm_file_exists(chk_path, &tmp2))
-                    e->is_executable = 2;  /* cc-compiled executable */
-            }
-        }
-
-        /* For non-executable files, check file association registry.
-         * If the associated app has an icon, cache it so the file
-         * displays the app icon instead of a generic document icon. */
-        if (!(fno.fattrib & AM_DIR) && !e->is_executable && e->icon_idx < 0) {
-            const char *dot = strrchr(e->name, '.');
-            if (dot && dot[1]) {
-                const fa_app_t *app = file_assoc_find(dot + 1);
-                if (app && app->has_icon) {
-                    /* Reuse an existing cache slot for the same app icon
-                     * (many files may share, e.g. all .txt → notepad) */
-                    int8_t found = -1;
-                    for (int k = 0; k < (int)fn_app_icon_count; k++) {
-                        if (memcmp(fn_app_icons[k], app->icon, 256) == 0) {
-                            found = (int8_t)k;
-                            break;
-                        }
-                    }
-                    if (found >= 0) {
-                        e->icon_idx = found;
-                    } else if (fn_app_icon_count < FN_MAX_APP_ICONS) {
-                        memcpy(fn_app_icons[fn_app_icon_count],
-                               app->icon, 256);
-                        e->icon_idx = fn_app_icon_count;
-                        fn_app_icon_count++;
-                    }
-                }
-            }
-        }
-
-        fm->entry_count++;
     }
     f_closedir(&dir);
+    return count;
+}
 
-    /* Sort: directories first, then by current sort column/order */
-    sort_col = fm->sort_column;
-    sort_asc = fm->sort_ascending;
-    if (fm->entry_count > 1) {
-        /* Simple insertion sort — avoids qsort linking issues */
-        for (int i = 1; i < (int)fm->entry_count; i++) {
-            fn_entry_t tmp = fm->entries[i];
-            int j = i - 1;
-            while (j >= 0 && entry_cmp(&tmp, &fm->entries[j]) < 0) {
-                fm->entries[j + 1] = fm->entries[j];
-                j--;
+static void fm_refresh(filemanager_t *fm) {
+    fm_free_listing(fm);
+    fm->scroll_y = 0;
+    fm->focus_index = -1;
+    fm->anchor_index = -1;
+    fm->selection_count = 0;
+    fn_app_icon_count = 0;
+
+    unsigned count = fm_read_dir(fm);
+    if (count)
+        fm->order = (uint16_t *)fm_alloc(count * sizeof(uint16_t));
+    if (fm->order) {
+        fm_names_t names;
+        fm_names_build(&names, fm, count);
+
+        for (unsigned k = 0; k < count; k++) {
+            fn_entry_t *e = fm_raw_entry(fm, k);
+            /* Skip hidden files */
+            if (e->attrib & AM_HID) continue;
+            if (e->name[0] == '.') continue;
+
+            if (!(e->attrib & AM_DIR)) {
+                int len = (int)strlen(e->name);
+                const char *dot = strrchr(e->name, '.');
+                /* Skip .inf companions and pre-linked .fxe images when
+                 * the base executable exists, and .xa1 sidecars (cc
+                 * extended attributes) */
+                if (dot && (strcmp(dot, ".inf") == 0 ||
+                            strcmp(dot, FXE_EXT) == 0) && dot > e->name &&
+                    fm_names_has(&names, e->name, (int)(dot - e->name), ""))
+                    continue;
+                if (dot && strcmp(dot, ".xa1") == 0)
+                    continue;
+
+                /* Executables: a companion .inf (ELF, icon from .ico)
+                 * or .xa1 (cc-compiled) */
+                if (fm_names_has(&names, e->name, len, ".inf")) {
+                    e->is_executable = 1;
+                    /* No .ico → terminal icon is used by fn_get_icon_16() */
+                    if (fm_names_has(&names, e->name, len, ".ico"))
+                        fm_load_app_icon(fm, e);
+                } else if (fm_names_has(&names, e->name, len, ".xa1")) {
+                    e->is_executable = 2;
+                } else {
+                    fm_assoc_icon(e);
+                }
             }
-            fm->entries[j + 1] = tmp;
+            fm->order[fm->entry_count++] = (uint16_t)k;
         }
+        psram_free(names.slots);
+        fm_sort(fm);
     }
 
     /* Give keyboard focus to the first item (if any) */
@@ -424,7 +547,7 @@ static void fm_go_up(filemanager_t *fm) {
 static int16_t fm_hit_test(filemanager_t *fm, int16_t mx, int16_t my,
                             int16_t client_w) {
     /* Adjust for file area start */
-    int16_t fy = my - FN_HEADER_HEIGHT + fm->scroll_y;
+    int32_t fy = my - FN_HEADER_HEIGHT + fm->scroll_y;
     if (fy < 0 || my < FN_HEADER_HEIGHT) return -1;
 
     int16_t file_w = client_w - FN_SCROLLBAR_W;
@@ -467,7 +590,7 @@ static int16_t fm_hit_test(filemanager_t *fm, int16_t mx, int16_t my,
  * Content height calculation
  *=========================================================================*/
 
-static int16_t fm_calc_content_height(filemanager_t *fm, int16_t client_w) {
+static int32_t fm_calc_content_height(filemanager_t *fm, int16_t client_w) {
     int16_t file_w = client_w - FN_SCROLLBAR_W;
     int cols, cell_h;
     int extra = 0;
@@ -491,7 +614,7 @@ static int16_t fm_calc_content_height(filemanager_t *fm, int16_t client_w) {
         return 0;
     }
     int rows = (fm->entry_count + cols - 1) / cols;
-    return (int16_t)(rows * cell_h + extra);
+    return rows * cell_h + extra;
 }
 
 /*==========================================================================
@@ -500,20 +623,20 @@ static int16_t fm_calc_content_height(filemanager_t *fm, int16_t client_w) {
 
 static void fm_clear_selection(filemanager_t *fm) {
     for (int i = 0; i < (int)fm->entry_count; i++)
-        fm->entries[i].sel_flags &= ~FN_SEL_SELECTED;
+        fm_entry(fm, i)->sel_flags &= ~FN_SEL_SELECTED;
     fm->selection_count = 0;
 }
 
 static void fm_select_all(filemanager_t *fm) {
     for (int i = 0; i < (int)fm->entry_count; i++)
-        fm->entries[i].sel_flags |= FN_SEL_SELECTED;
+        fm_entry(fm, i)->sel_flags |= FN_SEL_SELECTED;
     fm->selection_count = fm->entry_count;
 }
 
 static void fm_update_selection_count(filemanager_t *fm) {
     fm->selection_count = 0;
     for (int i = 0; i < (int)fm->entry_count; i++)
-        if (fm->entries[i].sel_flags & FN_SEL_SELECTED)
+        if (fm_entry(fm, i)->sel_flags & FN_SEL_SELECTED)
             fm->selection_count++;
 }
 
@@ -527,7 +650,7 @@ static int16_t fm_file_area_height(int16_t client_h) {
 
 static void fm_clamp_scroll(filemanager_t *fm, int16_t client_h) {
     int16_t fah = fm_file_area_height(client_h);
-    int16_t max_scroll = fm->content_height - fah;
+    int32_t max_scroll = fm->content_height - fah;
     if (max_scroll < 0) max_scroll = 0;
     if (fm->scroll_y > max_scroll) fm->scroll_y = max_scroll;
     if (fm->scroll_y < 0) fm->scroll_y = 0;
@@ -568,9 +691,9 @@ static void fm_scroll_into_view(filemanager_t *fm, int16_t client_w,
     int16_t fah = fm_file_area_height(client_h);
 
     if (item_top < fm->scroll_y)
-        fm->scroll_y = (int16_t)item_top;
+        fm->scroll_y = item_top;
     else if (item_bot > fm->scroll_y + fah)
-        fm->scroll_y = (int16_t)(item_bot - fah);
+        fm->scroll_y = item_bot - fah;
 
     fm_clamp_scroll(fm, client_h);
 }
@@ -747,21 +870,34 @@ static void fm_ellipsis(char *buf, size_t bufsz, const char *name, int max_px) {
  * Painting: large icon view
  *=========================================================================*/
 
+/* Entries [*first, *end) of a grid whose cells lie wholly inside the
+ * file area: rows whose top is at or below the scroll position and
+ * above its bottom (avail = file area height less any header) */
+static void fm_visible_range(filemanager_t *fm, int cols, int cell_h,
+                             int avail, int *first, int *end) {
+    int r0 = (fm->scroll_y + cell_h - 1) / cell_h;
+    int r1 = (fm->scroll_y + avail + cell_h - 1) / cell_h;
+    *first = r0 * cols;
+    *end = r1 * cols;
+    if (*end > (int)fm->entry_count) *end = fm->entry_count;
+}
+
 static void fm_paint_large_icons(filemanager_t *fm, int16_t cw, int16_t ch) {
     int16_t file_w = cw - FN_SCROLLBAR_W;
     int cols = file_w / LARGE_CELL_W;
     if (cols < 1) cols = 1;
 
-    for (int i = 0; i < (int)fm->entry_count; i++) {
-        fn_entry_t *e = &fm->entries[i];
+    /* Only items inside the file area (not under toolbar / status bar) */
+    int first, end;
+    fm_visible_range(fm, cols, LARGE_CELL_H, fm_file_area_height(ch),
+                     &first, &end);
+    for (int i = first; i < end; i++) {
+        fn_entry_t *e = fm_entry(fm, i);
         int col = i % cols;
         int row = i / cols;
         int16_t cx = col * LARGE_CELL_W;
         int16_t cy = FN_HEADER_HEIGHT + row * LARGE_CELL_H - fm->scroll_y;
 
-        /* Clip: skip items outside file area (toolbar / status bar) */
-        if (cy < FN_HEADER_HEIGHT || cy >= ch - FN_STATUSBAR_H) continue;
-
         bool selected = (e->sel_flags & FN_SEL_SELECTED) != 0;
         bool dimmed = (e->sel_flags & FN_SEL_CUT) != 0;
 
@@ -826,15 +962,16 @@ static void fm_paint_small_icons(filemanager_t *fm, int16_t cw, int16_t ch) {
     int cols = file_w / SMALL_CELL_W;
     if (cols < 1) cols = 1;
 
-    for (int i = 0; i < (int)fm->entry_count; i++) {
-        fn_entry_t *e = &fm->entries[i];
+    int first, end;
+    fm_visible_range(fm, cols, SMALL_CELL_H, fm_file_area_height(ch),
+                     &first, &end);
+    for (int i = first; i < end; i++) {
+        fn_entry_t *e = fm_entry(fm, i);
         int col = i % cols;
         int row = i / cols;
         int16_t cx = col * SMALL_CELL_W;
         int16_t cy = FN_HEADER_HEIGHT + row * SMALL_CELL_H - fm->scroll_y;
 
-        if (cy < FN_HEADER_HEIGHT || cy >= ch - FN_STATUSBAR_H) continue;
-
         bool selected = (e->sel_flags & FN_SEL_SELECTED) != 0;
         bool dimmed = (e->sel_flags & FN_SEL_CUT) != 0;
 
@@ -922,13 +1059,13 @@ static void fm_paint_list(filemanager_t *fm, int16_t cw, int16_t ch) {
                            hy + (LIST_HDR_H - 4) / 2, fm->sort_ascending);
 
     /* Rows */
-    for (int i = 0; i < (int)fm->entry_count; i++) {
-        fn_entry_t *e = &fm->entries[i];
+    int first, end;
+    fm_visible_range(fm, 1, LIST_ROW_H, fm_file_area_height(ch) - LIST_HDR_H,
+                     &first, &end);
+    for (int i = first; i < end; i++) {
+        fn_entry_t *e = fm_entry(fm, i);
         int16_t ry = FN_HEADER_HEIGHT + LIST_HDR_H + i * LIST_ROW_H - fm->scroll_y;
 
-        if (ry < FN_HEADER_HEIGHT + LIST_HDR_H ||
-            ry >= ch - FN_STATUSBAR_H) continue;
-
         bool selected = (e->sel_flags & FN_SEL_SELECTED) != 0;
         bool dimmed = (e->sel_flags & FN_SEL_CUT) != 0;
 
@@ -1145,7 +1282,7 @@ static void fm_do_delete(filemanager_t *fm) {
     int total = 0, done = 0;
     /* Count selected items */
     for (int i = 0; i < (int)fm->entry_count; i++)
-        if (fm->entries[i].sel_flags & FN_SEL_SELECTED) total++;
+        if (fm_entry(fm, i)->sel_flags & FN_SEL_SELECTED) total++;
 
     cursor_set_type(CURSOR_WAIT);
     wm_mark_dirty();
@@ -1156,18 +1293,20 @@ static void fm_do_delete(filemanager_t *fm) {
         fm_show_progress(L(STR_FM_DELETING), 0);
 
     for (int i = 0; i < (int)fm->entry_count; i++) {
-        if (!(fm->entries[i].sel_flags & FN_SEL_SELECTED)) continue;
+        if (!(fm_entry(fm, i)->sel_flags & FN_SEL_SELECTED)) continue;
         if (fm->path[1] == '\0')
-            snprintf(full, sizeof(full), "/%s", fm->entries[i].name);
+            snprintf(full, sizeof(full), "/%s", fm_entry(fm, i)->name);
         else
-            snprintf(full, sizeof(full), "%s/%s", fm->path, fm->entries[i].name);
+            snprintf(full, sizeof(full), "%s/%s", fm->path, fm_entry(fm, i)->name);
         fm_delete_recursive(full);
         /* Also delete companion files for executables */
-        if (fm->entries[i].is_executable == 1) {
+        if (fm_entry(fm, i)->is_executable == 1) {
             char inf[FN_PATH_MAX];
             snprintf(inf, sizeof(inf), "%s.inf", full);
             f_unlink(inf);
-        } else if (fm->entries[i].is_executable == 2) {
+            snprintf(inf, sizeof(inf), "%s" FXE_EXT, full);
+            f_unlink(inf);
+        } else if (fm_entry(fm, i)->is_executable == 2) {
             char xa1[FN_PATH_MAX];
             snprintf(xa1, sizeof(xa1), "%s.xa1", full);
             f_unlink(xa1);
@@ -1190,12 +1329,12 @@ static void fm_rename_selected(filemanager_t *fm) {
     if (fm->focus_index < 0 || fm->focus_index >= (int)fm->entry_count) return;
     fm->pending_rename = 1;
     dialog_input_show(fm->hwnd, L(STR_FM_RENAME_DLG),
-                      L(STR_FM_NEW_NAME), fm->entries[fm->focus_index].name, 60);
+                      L(STR_FM_NEW_NAME), fm_entry(fm, fm->focus_index)->name, 60);
 }
 
 static void fm_open_item(filemanager_t *fm, int idx) {
     if (idx < 0 || idx >= (int)fm->entry_count) return;
-    fn_entry_t *e = &fm->entries[idx];
+    fn_entry_t *e = fm_entry(fm, idx);
 
     char full[FN_PATH_MAX];
     if (fm->path[1] == '\0')
@@ -1211,45 +1350,54 @@ static void fm_open_item(filemanager_t *fm, int idx) {
         static uint8_t app_icon16[256];
         static uint8_t app_icon32[1024];
         const uint8_t *icon = default_icon_16x16;
-        bool got_icon32 = false;
-
-        /* Try .ico file first */
-        char ico_path[FN_PATH_MAX];
-        snprintf(ico_path, sizeof(ico_path), "%s.ico", full);
-        FIL f;
-        if (f_open(&f, ico_path, FA_READ) == FR_OK) {
-            FSIZE_t fsize = f_size(&f);
-            if (fsize >= 22 && fsize <= 2048) {
-                uint8_t ico_buf[2048];
-                UINT br;
-                if (f_read(&f, ico_buf, (UINT)fsize, &br) == FR_OK
-                    && br == (UINT)fsize) {
-                    if (ico_parse_16(ico_buf, br, app_icon16))
-                        icon = app_icon16;
-                    if (ico_parse_32(ico_buf, br, app_icon32))
-                        got_icon32 = true;
-                }
+        const uint8_t *icon32 = NULL;
+
+        int reg = app_registry_find(full);
+        if (reg >= 0) {
+            /* Registered app — its icons are already in memory */
+            if (app_registry_has_ico(reg)) {
+                icon   = app_registry_get(reg)->icon;
+                icon32 = app_registry_get(reg)->icon32;
             }
-            f_close(&f);
-        }
-
-        /* Fall back to .inf for 16x16 icon */
-        if (icon == default_icon_16x16) {
-            char inf_path[FN_PATH_MAX];
-            snprintf(inf_path, sizeof(inf_path), "%s.inf", full);
-            if (f_open(&f, inf_path, FA_READ) == FR_OK) {
-                UINT br;
-                char ch;
-                while (f_read(&f, &ch, 1, &br) == FR_OK && br == 1) {
-                    if (ch == '\n') break;
+        } else {
+            /* Try .ico file first */
+            char ico_path[FN_PATH_MAX];
+            snprintf(ico_path, sizeof(ico_path), "%s.ico", full);
+            FIL f;
+            if (f_open(&f, ico_path, FA_READ) == FR_OK) {
+                FSIZE_t fsize = f_size(&f);
+                if (fsize >= 22 && fsize <= 2048) {
+                    uint8_t ico_buf[2048];
+                    UINT br;
+                    if (f_read(&f, ico_buf, (UINT)fsize, &br) == FR_OK
+                        && br == (UINT)fsize) {
+                        if (ico_parse_16(ico_buf, br, app_icon16))
+                            icon = app_icon16;
+                        if (ico_parse_32(ico_buf, br, app_icon32))
+                            icon32 = app_icon32;
+                    }
                 }
-                if (f_read(&f, app_icon16, 256, &br) == FR_OK && br == 256)
-                    icon = app_icon16;
                 f_close(&f);
             }
+
+            /* Fall back to .inf for 16x16 icon */
+            if (icon == default_icon_16x16) {
+                char inf_path[FN_PATH_MAX];
+                snprintf(inf_path, sizeof(inf_path), "%s.inf", full);
+                if (f_open(&f, inf_path, FA_READ) == FR_OK) {
+                    UINT br;
+                    char ch;
+                    while (f_read(&f, &ch, 1, &br) == FR_OK && br == 1) {
+                        if (ch == '\n') break;
+                    }
+                    if (f_read(&f, app_icon16, 256, &br) == FR_OK && br == 256)
+                        icon = app_icon16;
+                    f_close(&f);
+                }
+            }
         }
         wm_set_pending_icon(icon);
-        if (got_icon32) wm_set_pending_icon32(app_icon32);
+        if (icon32) wm_set_pending_icon32(icon32);
         launch_elf_app(full);
     } else if (e->is_executable == 2) {
         /* cc-compiled executable — launch pshell in exec mode */
@@ -1268,25 +1416,37 @@ static void fm_open_item(filemanager_t *fm, int idx) {
  * Clipboard operations
  *=========================================================================*/
 
+/* Add an ELF's pre-linked image (if it has one yet) to the clipboard */
+static void fm_clip_add_fxe(const char *elf) {
+    if (fn_clipboard.count >= 16) return;
+    char *xp = fn_clipboard.paths[fn_clipboard.count];
+    FILINFO fno;
+    snprintf(xp, FN_PATH_MAX, "%s" FXE_EXT, elf);
+    if (f_stat(xp, &fno) == FR_OK)
+        fn_clipboard.count++;
+}
+
 static void fm_clip_cut(filemanager_t *fm) {
     fn_clipboard.count = 0;
     fn_clipboard.is_cut = true;
     for (int i = 0; i < (int)fm->entry_count && fn_clipboard.count < 16; i++) {
-        if (!(fm->entries[i].sel_flags & FN_SEL_SELECTED)) continue;
+        if (!(fm_entry(fm, i)->sel_flags & FN_SEL_SELECTED)) continue;
         char *p = fn_clipboard.paths[fn_clipboard.count];
         if (fm->path[1] == '\0')
-            snprintf(p, FN_PATH_MAX, "/%s", fm->entries[i].name);
+            snprintf(p, FN_PATH_MAX, "/%s", fm_entry(fm, i)->name);
         else
-            snprintf(p, FN_PATH_MAX, "%s/%s", fm->path, fm->entries[i].name);
-        fm->entries[i].sel_flags |= FN_SEL_CUT;
+            snprintf(p, FN_PATH_MAX, "%s/%s", fm->path, fm_entry(fm, i)->name);
+        fm_entry(fm, i)->sel_flags |= FN_SEL_CUT;
         fn_clipboard.count++;
         /* Also add companion .inf or .xa1 for executables */
-        if (fm->entries[i].is_executable && fn_clipboard.count < 16) {
+        if (fm_entry(fm, i)->is_executable && fn_clipboard.count < 16) {
             char *ip = fn_clipboard.paths[fn_clipboard.count];
             snprintf(ip, FN_PATH_MAX, "%s.%s", p,
-                     fm->entries[i].is_executable == 2 ? "xa1" : "inf");
+                     fm_entry(fm, i)->is_executable == 2 ? "xa1" : "inf");
             fn_clipboard.count++;
         }
+        if (fm_entry(fm, i)->is_executable == 1)
+            fm_clip_add_fxe(p);
     }
     fm_invalidate(fm, FM_DIRTY_FILES | FM_DIRTY_STATUSBAR);
 }
@@ -1295,20 +1455,22 @@ static void fm_clip_copy(filemanager_t *fm) {
     fn_clipboard.count = 0;
     fn_clipboard.is_cut = false;
     for (int i = 0; i < (int)fm->entry_count && fn_clipboard.count < 16; i++) {
-        if (!(fm->entries[i].sel_flags & FN_SEL_SELECTED)) continue;
+        if (!(fm_entry(fm, i)->sel_flags & FN_SEL_SELECTED)) continue;
         char *p = fn_clipboard.paths[fn_clipboard.count];
         if (fm->path[1] == '\0')
-            snprintf(p, FN_PATH_MAX, "/%s", fm->entries[i].name);
+            snprintf(p, FN_PATH_MAX, "/%s", fm_entry(fm, i)->name);
         else
-            snprintf(p, FN_PATH_MAX, "%s/%s", fm->path, fm->entries[i].name);
+            snprintf(p, FN_PATH_MAX, "%s/%s", fm->path, fm_entry(fm, i)->name);
         fn_clipboard.count++;
         /* Also add companion .inf or .xa1 for executables */
-        if (fm->entries[i].is_executable && fn_clipboard.count < 16) {
+        if (fm_entry(fm, i)->is_executable && fn_clipboard.count < 16) {
             char *ip = fn_clipboard.paths[fn_clipboard.count];
             snprintf(ip, FN_PATH_MAX, "%s.%s", p,
-                     fm->entries[i].is_executable == 2 ? "xa1" : "inf");
+                     fm_entry(fm, i)->is_executable == 2 ? "xa1" : "inf");
             fn_clipboard.count++;
         }
+        if (fm_entry(fm, i)->is_executable == 1)
+            fm_clip_add_fxe(p);
     }
 }
 
@@ -1506,11 +1668,11 @@ static void fm_show_context_menu(filemanager_t *fm, int16_t sx, int16_t sy,
         /* --- Determine if the focused entry is a regular file --- */
         int fi = fm->focus_index;
         bool is_file = (fi >= 0 && fi < (int)fm->entry_count
-                        && !(fm->entries[fi].attrib & AM_DIR)
-                        && !fm->entries[fi].is_executable);
+                        && !(fm_entry(fm, fi)->attrib & AM_DIR)
+                        && !fm_entry(fm, fi)->is_executable);
         const char *ext = NULL;
         if (is_file) {
-            ext = strrchr(fm->entries[fi].name, '.');
+            ext = strrchr(fm_entry(fm, fi)->name, '.');
             if (ext) ext++;  /* skip the dot */
         }
 
@@ -1631,8 +1793,8 @@ static void fm_batch_open(filemanager_t *fm) {
     bool opened_any = false;
 
     for (int i = 0; i < (int)fm->entry_count; i++) {
-        if (!(fm->entries[i].sel_flags & FN_SEL_SELECTED)) continue;
-        fn_entry_t *e = &fm->entries[i];
+        if (!(fm_entry(fm, i)->sel_flags & FN_SEL_SELECTED)) continue;
+        fn_entry_t *e = fm_entry(fm, i);
         if ((e->attrib & AM_DIR) || e->is_executable) {
             fm_open_item(fm, i);
             opened_any = true;
@@ -1736,7 +1898,14 @@ static bool fm_event(hwnd_t hwnd, const window_event_t *event) {
                     fm->sort_ascending = !fm->sort_ascending;
                 else { fm->sort_column = 2; fm->sort_ascending = 1; }
             }
-            fm_refresh(fm);
+            /* Re-sort the listing in memory; selection and focus follow
+             * their entries */
+            {
+                int focus = fm->focus_index >= 0 ? fm->order[fm->focus_index] : -1;
+                fm_sort(fm);
+                for (int i = 0; i < (int)fm->entry_count; i++)
+                    if (fm->order[i] == focus) fm->focus_index = fm->anchor_index = i;
+            }
             fm_invalidate(fm, FM_DIRTY_ALL);
             return true;
         }
@@ -1745,7 +1914,7 @@ static bool fm_event(hwnd_t hwnd, const window_event_t *event) {
         {
             int32_t new_pos;
             if (scrollbar_event(&fm->vscroll, event, &new_pos)) {
-                fm->scroll_y = (int16_t)new_pos;
+                fm->scroll_y = new_pos;
                 fm_invalidate(fm, FM_DIRTY_FILES | FM_DIRTY_SCROLLBAR);
                 return true;
             }
@@ -1769,7 +1938,7 @@ static bool fm_event(hwnd_t hwnd, const window_event_t *event) {
             /* Selection logic */
             uint8_t mods = event->mouse.modifiers;
             if (mods & KMOD_CTRL) {
-                fm->entries[idx].sel_flags ^= FN_SEL_SELECTED;
+                fm_entry(fm, idx)->sel_flags ^= FN_SEL_SELECTED;
                 fm->focus_index = idx;
             } else if (mods & KMOD_SHIFT) {
                 if (fm->anchor_index >= 0) {
@@ -1777,12 +1946,12 @@ static bool fm_event(hwnd_t hwnd, const window_event_t *event) {
                     int lo = fm->anchor_index < idx ? fm->anchor_index : idx;
                     int hi = fm->anchor_index > idx ? fm->anchor_index : idx;
                     for (int i = lo; i <= hi; i++)
-                        fm->entries[i].sel_flags |= FN_SEL_SELECTED;
+                        fm_entry(fm, i)->sel_flags |= FN_SEL_SELECTED;
                 }
                 fm->focus_index = idx;
             } else {
                 fm_clear_selection(fm);
-                fm->entries[idx].sel_flags |= FN_SEL_SELECTED;
+                fm_entry(fm, idx)->sel_flags |= FN_SEL_SELECTED;
                 fm->focus_index = idx;
                 fm->anchor_index = idx;
             }
@@ -1832,7 +2001,7 @@ static bool fm_event(hwnd_t hwnd, const window_event_t *event) {
         {
             int32_t new_pos;
             if (scrollbar_event(&fm->vscroll, event, &new_pos)) {
-                fm->scroll_y = (int16_t)new_pos;
+                fm->scroll_y = new_pos;
                 fm_invalidate(fm, FM_DIRTY_FILES | FM_DIRTY_SCROLLBAR);
                 return true;
             }
@@ -1918,17 +2087,17 @@ static bool fm_event(hwnd_t hwnd, const window_event_t *event) {
             for (int i = 0; i < (int)fm->entry_count; i++) {
                 int col = i % cols;
                 int row = i / cols;
-                int16_t ex = col * cell_w;
-                int16_t ey = y_off + row * cell_h - fm->scroll_y;
-                int16_t ex2 = ex + cell_w;
-                int16_t ey2 = ey + cell_h;
+                int ex = col * cell_w;
+                int ey = y_off + row * cell_h - fm->scroll_y;
+                int ex2 = ex + cell_w;
+                int ey2 = ey + cell_h;
 
                 bool intersects = !(ex2 <= rx0 || ex >= rx1 ||
                                     ey2 <= ry0 || ey >= ry1);
                 if (intersects)
-                    fm->entries[i].sel_flags |= FN_SEL_SELECTED;
+                    fm_entry(fm, i)->sel_flags |= FN_SEL_SELECTED;
                 else if (!(event->mouse.modifiers & KMOD_CTRL))
-                    fm->entries[i].sel_flags &= ~FN_SEL_SELECTED;
+                    fm_entry(fm, i)->sel_flags &= ~FN_SEL_SELECTED;
             }
             fm_update_selection_count(fm);
             fm_invalidate(fm, FM_DIRTY_FILES | FM_DIRTY_STATUSBAR);
@@ -1939,7 +2108,7 @@ static bool fm_event(hwnd_t hwnd, const window_event_t *event) {
         {
             int32_t new_pos;
             if (scrollbar_event(&fm->vscroll, event, &new_pos)) {
-                fm->scroll_y = (int16_t)new_pos;
+                fm->scroll_y = new_pos;
                 fm_invalidate(fm, FM_DIRTY_FILES | FM_DIRTY_SCROLLBAR);
                 return true;
             }
@@ -1979,9 +2148,9 @@ static bool fm_event(hwnd_t hwnd, const window_event_t *event) {
 
         int16_t idx = fm_hit_test(fm, mx, my, cw);
 
-        if (idx >= 0 && !(fm->entries[idx].sel_flags & FN_SEL_SELECTED)) {
+        if (idx >= 0 && !(fm_entry(fm, idx)->sel_flags & FN_SEL_SELECTED)) {
             fm_clear_selection(fm);
-            fm->entries[idx].sel_flags |= FN_SEL_SELECTED;
+            fm_entry(fm, idx)->sel_flags |= FN_SEL_SELECTED;
             fm->focus_index = idx;
             fm_update_selection_count(fm);
             fm_invalidate(fm, FM_DIRTY_FILES | FM_DIRTY_STATUSBAR);
@@ -2058,7 +2227,7 @@ static bool fm_event(hwnd_t hwnd, const window_event_t *event) {
                 fm->focus_index = 0;
                 fm->anchor_index = 0;
                 fm_clear_selection(fm);
-                fm->entries[0].sel_flags |= FN_SEL_SELECTED;
+                fm_entry(fm, 0)->sel_flags |= FN_SEL_SELECTED;
                 fm_update_selection_count(fm);
                 fm_scroll_into_view(fm, cw, ch);
                 fm_invalidate(fm, FM_DIRTY_FILES | FM_DIRTY_STATUSBAR);
@@ -2095,11 +2264,11 @@ static bool fm_event(hwnd_t hwnd, const window_event_t *event) {
                 int lo = fm->anchor_index < new_idx ? fm->anchor_index : new_idx;
                 int hi = fm->anchor_index > new_idx ? fm->anchor_index : new_idx;
                 for (int i = lo; i <= hi; i++)
-                    fm->entries[i].sel_flags |= FN_SEL_SELECTED;
+                    fm_entry(fm, i)->sel_flags |= FN_SEL_SELECTED;
             } else if (!(mods & KMOD_CTRL)) {
                 /* Normal move: select just the focused item */
                 fm_clear_selection(fm);
-                fm->entries[new_idx].sel_flags |= FN_SEL_SELECTED;
+                fm_entry(fm, new_idx)->sel_flags |= FN_SEL_SELECTED;
                 fm->anchor_index = new_idx;
             }
             /* Ctrl+arrow: move focus without changing selection */
@@ -2113,7 +2282,7 @@ static bool fm_event(hwnd_t hwnd, const window_event_t *event) {
         /* Space: toggle selection on focused item (Ctrl-style) */
         if (sc == 0x2C /* HID SPACE */ && !(mods & KMOD_CTRL)) {
             if (fm->focus_index >= 0 && fm->focus_index < (int)fm->entry_count) {
-                fm->entries[fm->focus_index].sel_flags ^= FN_SEL_SELECTED;
+                fm_entry(fm, fm->focus_index)->sel_flags ^= FN_SEL_SELECTED;
                 fm->anchor_index = fm->focus_index;
                 fm_update_selection_count(fm);
                 fm_invalidate(fm, FM_DIRTY_FILES | FM_DIRTY_STATUSBAR);
@@ -2126,14 +2295,14 @@ static bool fm_event(hwnd_t hwnd, const window_event_t *event) {
                 fm->focus_index = 0;
                 if (!(mods & KMOD_CTRL)) {
                     fm_clear_selection(fm);
-                    fm->entries[0].sel_flags |= FN_SEL_SELECTED;
+                    fm_entry(fm, 0)->sel_flags |= FN_SEL_SELECTED;
                     fm->anchor_index = 0;
                 }
                 if (mods & KMOD_SHIFT) {
                     if (fm->anchor_index < 0) fm->anchor_index = 0;
                     fm_clear_selection(fm);
                     for (int i = 0; i <= fm->anchor_index; i++)
-                        fm->entries[i].sel_flags |= FN_SEL_SELECTED;
+                        fm_entry(fm, i)->sel_flags |= FN_SEL_SELECTED;
                 }
                 fm_update_selection_count(fm);
                 fm_scroll_into_view(fm, cw, ch);
@@ -2149,7 +2318,7 @@ static bool fm_event(hwnd_t hwnd, const window_event_t *event) {
                 fm->focus_index = (int16_t)last;
                 if (!(mods & KMOD_CTRL)) {
                     fm_clear_selection(fm);
-                    fm->entries[last].sel_flags |= FN_SEL_SELECTED;
+                    fm_entry(fm, last)->sel_flags |= FN_SEL_SELECTED;
                     fm->anchor_index = last;
                 }
                 if (mods & KMOD_SHIFT) {
@@ -2158,7 +2327,7 @@ static bool fm_event(hwnd_t hwnd, const window_event_t *event) {
                     int lo = fm->anchor_index < last ? fm->anchor_index : last;
                     int hi = fm->anchor_index > last ? fm->anchor_index : last;
                     for (int i = lo; i <= hi; i++)
-                        fm->entries[i].sel_flags |= FN_SEL_SELECTED;
+                        fm_entry(fm, i)->sel_flags |= FN_SEL_SELECTED;
                 }
                 fm_update_selection_count(fm);
                 fm_scroll_into_view(fm, cw, ch);
@@ -2190,7 +2359,7 @@ static bool fm_event(hwnd_t hwnd, const window_event_t *event) {
                 fm->focus_index = (int16_t)idx;
                 if (!(mods & KMOD_SHIFT)) {
                     fm_clear_selection(fm);
-                    fm->entries[idx].sel_flags |= FN_SEL_SELECTED;
+                    fm_entry(fm, idx)->sel_flags |= FN_SEL_SELECTED;
                     fm->anchor_index = idx;
                 } else {
                     if (fm->anchor_index < 0) fm->anchor_index = idx;
@@ -2198,7 +2367,7 @@ static bool fm_event(hwnd_t hwnd, const window_event_t *event) {
                     int lo = fm->anchor_index < idx ? fm->anchor_index : idx;
                     int hi = fm->anchor_index > idx ? fm->anchor_index : idx;
                     for (int i = lo; i <= hi; i++)
-                        fm->entries[i].sel_flags |= FN_SEL_SELECTED;
+                        fm_entry(fm, i)->sel_flags |= FN_SEL_SELECTED;
                 }
                 fm_update_selection_count(fm);
                 fm_scroll_into_view(fm, cw, ch);
@@ -2268,23 +2437,28 @@ static bool fm_event(hwnd_t hwnd, const window_event_t *event) {
                     char old[FN_PATH_MAX];
                     if (fm->path[1] == '\0') {
                         snprintf(old, sizeof(old), "/%s",
-                                 fm->entries[fm->focus_index].name);
+                                 fm_entry(fm, fm->focus_index)->name);
                         snprintf(full, sizeof(full), "/%s", text);
                     } else {
                         snprintf(old, sizeof(old), "%s/%s",
-                                 fm->path, fm->entries[fm->focus_index].name);
+                                 fm->path, fm_entry(fm, fm->focus_index)->name);
                         snprintf(full, sizeof(full), "%s/%s", fm->path, text);
                     }
                     f_rename(old, full);
                     /* Also rename companion .inf or .xa1 for executables */
-                    if (fm->entries[fm->focus_index].is_executable) {
+                    if (fm_entry(fm, fm->focus_index)->is_executable) {
                         char old_c[FN_PATH_MAX], new_c[FN_PATH_MAX];
                         const char *ext =
-                            fm->entries[fm->focus_index].is_executable == 2
+                            fm_entry(fm, fm->focus_index)->is_executable == 2
                                 ? ".xa1" : ".inf";
                         snprintf(old_c, sizeof(old_c), "%s%s", old, ext);
                         snprintf(new_c, sizeof(new_c), "%s%s", full, ext);
                         f_rename(old_c, new_c);
+                        if (fm_entry(fm, fm->focus_index)->is_executable == 1) {
+                            snprintf(old_c, sizeof(old_c), "%s" FXE_EXT, old);
+                            snprintf(new_c, sizeof(new_c), "%s" FXE_EXT, full);
+                            f_rename(old_c, new_c);
+                        }
                     }
                 }
             } else {
@@ -2316,6 +2490,7 @@ static bool fm_event(hwnd_t hwnd, const window_event_t *event) {
             return true;
         case FN_CMD_CLOSE:
             wm_destroy_window(hwnd);
+            fm_free_listing(fm);
             vPortFree(fm);
             return true;
 
@@ -2373,7 +2548,7 @@ static bool fm_event(hwnd_t hwnd, const window_event_t *event) {
 
         case FN_CMD_CTX_SEND_DESKTOP: {
             if (fm->focus_index >= 0 && fm->focus_index < (int)fm->entry_count) {
-                fn_entry_t *e = &fm->entries[fm->focus_index];
+                fn_entry_t *e = fm_entry(fm, fm->focus_index);
                 char full[FN_PATH_MAX];
                 if (fm->path[1] == '\0')
                     snprintf(full, sizeof(full), "/%s", e->name);
@@ -2391,7 +2566,7 @@ static bool fm_event(hwnd_t hwnd, const window_event_t *event) {
                 int app_idx = id - FN_CMD_CTX_OPEN_WITH_BASE;
                 if (fm->focus_index >= 0 &&
                     fm->focus_index < (int)fm->entry_count) {
-                    fn_entry_t *e = &fm->entries[fm->focus_index];
+                    fn_entry_t *e = fm_entry(fm, fm->focus_index);
                     /* Re-derive the extension and find matching apps */
                     const char *dot = strrchr(e->name, '.');
                     const char *ext = dot ? dot + 1 : NULL;
@@ -2426,6 +2601,7 @@ static bool fm_event(hwnd_t hwnd, const window_event_t *event) {
 
     case WM_CLOSE:
         wm_destroy_window(hwnd);
+        fm_free_listing(fm);
         vPortFree(fm);
         return true;
 
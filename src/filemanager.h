@@ -17,7 +17,9 @@
  * General constants
  *=========================================================================*/
 
-#define FN_MAX_ENTRIES      128
+#define FN_CHUNK_ENTRIES    64      /* entries per listing chunk */
+#define FN_MAX_CHUNKS       128
+#define FN_MAX_ENTRIES      (FN_CHUNK_ENTRIES * FN_MAX_CHUNKS)
 #define FN_PATH_MAX         256
 #define FN_NAME_MAX         64
 #define FN_HISTORY_DEPTH    8
@@ -117,13 +119,17 @@ typedef struct {
     char     path[FN_PATH_MAX];
 
     /* --- directory listing --------------------------------------------- */
-    fn_entry_t entries[FN_MAX_ENTRIES];
-    uint16_t   entry_count;
+    /* Everything the directory holds, companions and hidden files
+     * included, in read order; order[] picks the shown entries in
+     * sort order.  All of it lives in PSRAM when present. */
+    fn_entry_t *chunks[FN_MAX_CHUNKS];  /* FN_CHUNK_ENTRIES each */
+    uint16_t   *order;                  /* shown position -> entry  */
+    uint16_t    entry_count;            /* shown entries            */
 
     /* --- view / scroll ------------------------------------------------- */
     uint8_t  view_mode;         /* FN_VIEW_*                    */
-    int16_t  scroll_y;
-    int16_t  content_height;
+    int32_t  scroll_y;
+    int32_t  content_height;
 
     /* --- selection / focus --------------------------------------------- */
     int16_t  focus_index;
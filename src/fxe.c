@@ -0,0 +1,575 @@
+/*
+ * FRANK OS — Pre-linked App Images (.fxe)
+ * Copyright (c) 2026 Mikhail Matveev <xtreme@rh1.tech>
+ * https://rh1.tech
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "fxe.h"
+#include <string.h>
+
+/*==========================================================================
+ * Thumb relocation encoders
+ *
+ * All of them add to the addend already in the instruction, so applying
+ * a relocation twice with values a and b equals applying it once with
+ * a + b — which is what lets an image linked at 0 be rebased later.
+ *=========================================================================*/
+
+// Декодирование и обновление инструкции BL для ссылки типа R_ARM_THM_PC22
+// Функция для разрешения ссылки типа R_ARM_THM_PC22
+static void resolve_thm_pc22(uint16_t* addr, uint32_t addr_ref, uint32_t sym_val) {
+    uint16_t instr0 = *addr;
+    uint16_t instr = *(addr + 1);
+    // Декодирование текущего смещения
+    uint32_t S = (instr0 >> 10) & 1;
+    uint32_t J1 = (instr >> 13) & 1;
+    uint32_t J2 = (instr >> 11) & 1;
+    uint32_t imm10 = instr0 & 0x03FF;
+    uint32_t imm11 = instr & 0x07FF;
+
+    uint32_t I1 = (~(J1 ^ S) & 1);
+    uint32_t I2 = (~(J2 ^ S) & 1);
+    uint32_t offset = (I1 << 23) | (I2 << 22) | (imm10 << 12) | (imm11 << 1);
+    if (S) {
+        offset |= 0xFF800000; // знак расширение
+    }
+
+    // Вычисление нового смещения
+    uint32_t new_offset = (uint32_t)((int32_t)offset + (int32_t)sym_val - (int32_t)addr_ref);
+    S = new_offset >> 31;
+    I1 = (new_offset >> 23) & 1;
+    I2 = (new_offset >> 22) & 1;
+    imm10 = (new_offset >> 12) & 0x03FF;
+    imm11 = (new_offset >> 1) & 0x07FF;
+
+    J1 = (~(I1 ^ S) & 1);
+    J2 = (~(I2 ^ S) & 1);
+    //goutf("ov: %ph off: %ph noff: %ph -> %d:%d:%d:%x:%x", *addr, offset, new_offset, S, J1, J2, imm10, imm11);
+
+    // Обновление инструкции
+    *addr++ = 0xF000 | (S << 10) | imm10;
+    *addr = (0b11010 << 11) | (J1 << 13) | (J2 << 11) | imm11;
+    //goutf("%04X %04X -> %04X %04X [%p]\n" , instr0, instr, *(addr-1), *addr, addr - 1);
+}
+
+// Разрешение ссылки типа R_ARM_THM_JUMP24 (B.W в Thumb-2)
+// Mirrors resolve_thm_pc22 (BL) logic, but emits B.W encoding instead of BL.
+static void resolve_thm_jump24(uint16_t* addr, uint32_t addr_ref, uint32_t sym_val) {
+    uint16_t instr0 = addr[0];
+    uint16_t instr1 = addr[1];
+
+    // Декодирование текущего смещения (same as BL)
+    uint32_t S     = (instr0 >> 10) & 1;
+    uint32_t J1    = (instr1 >> 13) & 1;
+    uint32_t J2    = (instr1 >> 11) & 1;
+    uint32_t imm10 = instr0 & 0x03FF;
+    uint32_t imm11 = instr1 & 0x07FF;
+
+    uint32_t I1 = (~(J1 ^ S)) & 1;
+    uint32_t I2 = (~(J2 ^ S)) & 1;
+
+    uint32_t offset = (I1 << 23) | (I2 << 22) | (imm10 << 12) | (imm11 << 1);
+    if (S) {
+        offset |= 0xFF800000;
+    }
+
+    // Вычисление нового смещения (same formula as resolve_thm_pc22)
+    uint32_t new_offset = (uint32_t)((int32_t)offset + (int32_t)sym_val - (int32_t)addr_ref);
+
+    S     = new_offset >> 31;
+    I1    = (new_offset >> 23) & 1;
+    I2    = (new_offset >> 22) & 1;
+    imm10 = (new_offset >> 12) & 0x03FF;
+    imm11 = (new_offset >> 1)  & 0x07FF;
+
+    J1 = (~(I1 ^ S)) & 1;
+    J2 = (~(I2 ^ S)) & 1;
+
+    // B.W encoding: upper = 11110 S imm10, lower = 10 J1 1 J2 imm11
+    addr[0] = (uint16_t)(0xF000 | (S << 10) | imm10);
+    addr[1] = (uint16_t)(0x9000 | (J1 << 13) | (J2 << 11) | imm11);
+}
+
+// Разрешение ссылки типа R_ARM_THM_JUMP19 (B<cond>.W в Thumb-2)
+// Conditional branch with 21-bit signed offset (±1 MB range).
+// Encoding differs from B.W: J1/J2 are NOT XOR-inverted with S;
+// upper = 11110 S cond imm6, lower = 10 J1 0 J2 imm11.
+static void resolve_thm_jump19(uint16_t* addr, uint32_t addr_ref, uint32_t sym_val) {
+    uint16_t instr0 = addr[0];
+    uint16_t instr1 = addr[1];
+
+    // Decode current offset from B<cond>.W
+    uint32_t S     = (instr0 >> 10) & 1;
+    uint32_t cond4 = (instr0 >> 6) & 0xF;  // condition code (preserved)
+    uint32_t imm6  = instr0 & 0x3F;
+    uint32_t J1    = (instr1 >> 13) & 1;
+    uint32_t J2    = (instr1 >> 11) & 1;
+    uint32_t imm11 = instr1 & 0x7FF;
+
+    // offset = SignExtend(S:J2:J1:imm6:imm11:0, 21)
+    uint32_t offset = (S << 20) | (J2 << 19) | (J1 << 18) | (imm6 << 12) | (imm11 << 1);
+    if (S) {
+        offset |= 0xFFE00000; // sign extend from bit 20
+    }
+
+    // Calculate new offset
+    uint32_t new_offset = (uint32_t)((int32_t)offset + (int32_t)sym_val - (int32_t)addr_ref);
+
+    // Re-encode
+    S     = (new_offset >> 20) & 1;
+    J2    = (new_offset >> 19) & 1;
+    J1    = (new_offset >> 18) & 1;
+    imm6  = (new_offset >> 12) & 0x3F;
+    imm11 = (new_offset >> 1)  & 0x7FF;
+
+    // B<cond>.W: upper = 11110 S cond imm6, lower = 10 J1 0 J2 imm11
+    addr[0] = (uint16_t)(0xF000 | (S << 10) | (cond4 << 6) | imm6);
+    addr[1] = (uint16_t)(0x8000 | (J1 << 13) | (J2 << 11) | imm11);
+}
+
+// вставить где-то рядом с resolve_thm_pc22/resolve_thm_jump24
+// value -- (A + S) — итоговое 32-битное значение, которое нужно вставить (MOVW/MOVT берут 16 бит)
+static void resolve_thm_alu_abs_g0_nc(uint16_t* addr, uint32_t base_value)
+{
+    // addr указывает на пару halfword'ов MOVW (32-bit Thumb)
+    uint16_t instr0 = addr[0];
+    uint16_t instr1 = addr[1];
+
+    // -------------------------------
+    // 1. ДЕКОДИРУЕМ addend (imm16)
+    // -------------------------------
+    uint32_t imm4  = instr0 & 0x000F;
+    uint32_t i_bit = (instr0 >> 10) & 0x1;
+    uint32_t imm3  = (instr1 >> 12) & 0x7;
+    uint32_t imm8  = instr1 & 0x00FF;
+
+    uint32_t addend = (imm4 << 12) | (i_bit << 11) | (imm3 << 8) | imm8;
+
+    // -------------------------------
+    // 2. full = (адрес символа) + addend
+    // base_value = sec_addr_ref + st_value
+    // -------------------------------
+    uint32_t full = base_value + addend;
+
+    uint32_t new_imm16 = full & 0xFFFF;  // G0_NC – lower 16 bits
+
+    // -------------------------------
+    // 3. Разбираем new_imm16 обратно по полям
+    // -------------------------------
+    uint32_t new_imm4  = (new_imm16 >> 12) & 0xF;
+    uint32_t new_i     = (new_imm16 >> 11) & 1;
+    uint32_t new_imm3  = (new_imm16 >> 8)  & 0x7;
+    uint32_t new_imm8  =  new_imm16        & 0xFF;
+
+    // -------------------------------
+    // 4. Собираем новый MOVW
+    // -------------------------------
+    uint16_t new_instr0 = instr0;
+    uint16_t new_instr1 = instr1;
+
+    // imm4 (bits 3..0)
+    new_instr0 &= ~0x000F;
+    new_instr0 |= new_imm4;
+
+    // i bit (bit 10)
+    new_instr0 &= ~(1u << 10);
+    new_instr0 |= (new_i << 10);
+
+    // imm3 (bits 14..12)
+    new_instr1 &= ~0x7000;
+    new_instr1 |= (new_imm3 << 12);
+
+    // imm8 (bits 7..0)
+    new_instr1 &= ~0x00FF;
+    new_instr1 |= new_imm8;
+
+    // -------------------------------
+    // 5. Записываем обратно
+    // -------------------------------
+    addr[0] = new_instr0;
+    addr[1] = new_instr1;
+}
+
+
+int fxe_rel_apply(uint8_t *loc, uint32_t p, uint8_t type, uint32_t value) {
+    switch (type) {
+        case 2:  // R_ARM_ABS32
+        case 38: // R_ARM_TARGET1 (resolved as ABS32)
+            *(uint32_t*)loc += value;
+            return FXE_REL_OK;
+        case 3:  // R_ARM_REL32
+            *(uint32_t*)loc += value - p;
+            return FXE_REL_OK;
+        case 10: // R_ARM_THM_PC22
+            resolve_thm_pc22((uint16_t*)loc, p, value);
+            return FXE_REL_OK;
+        case 30: // R_ARM_THM_JUMP24
+            resolve_thm_jump24((uint16_t*)loc, p, value);
+            return FXE_REL_OK;
+        case 51: // R_ARM_THM_JUMP19 (B<cond>.W)
+            resolve_thm_jump19((uint16_t*)loc, p, value);
+            return FXE_REL_OK;
+        case 102: // R_ARM_THM_ALU_ABS_G0_NC
+            if ((uintptr_t)loc & 0x3)
+                return FXE_REL_SKIPPED;
+            resolve_thm_alu_abs_g0_nc((uint16_t*)loc, value);
+            return FXE_REL_OK;
+        default:
+            return FXE_REL_UNSUPPORTED;
+    }
+}
+
+bool fxe_rel_pc_relative(uint8_t type) {
+    return type == 3 || type == 10 || type == 30 || type == 51;
+}
+
+static bool rel_supported(uint8_t type) {
+    return type == 2 || type == 38 || type == 102 || fxe_rel_pc_relative(type);
+}
+
+bool fxe_header_ok(const fxe_header_t *h, uint32_t file_size) {
+    if (h->magic != FXE_MAGIC || h->version != FXE_VERSION)
+        return false;
+    if (h->image_size != file_size || h->sec_count == 0)
+        return false;
+    uint32_t tables = sizeof(fxe_header_t) + h->sec_count * sizeof(fxe_sec_t);
+    if (tables > file_size || h->rel_offset < tables ||
+        h->rel_offset > file_size ||
+        h->rel_count > (file_size - h->rel_offset) / sizeof(fxe_rel_t))
+        return false;
+    return h->entries[FXE_ENTRY_MAIN].sec < h->sec_count;
+}
+
+const char *fxe_strerror(int err) {
+    switch (err) {
+        case FXE_OK:       return "ok";
+        case FXE_E_IO:     return "I/O error";
+        case FXE_E_NOMEM:  return "out of memory";
+        case FXE_E_FORMAT: return "malformed ELF";
+        case FXE_E_NOMAIN: return "no main()";
+        case FXE_E_LINK:   return "unsupported symbol or relocation";
+        default:           return "unknown error";
+    }
+}
+
+/*==========================================================================
+ * Image builder
+ *
+ * Mirrors the ELF loader: the same entry symbols, the same sections
+ * (those reachable from the entries through relocations) and the same
+ * relocation rules, so an image loads to the very bytes the ELF would.
+ *=========================================================================*/
+
+static const char *const entry_names[FXE_NENTRIES] = {
+    "__required_m_api_verion", "_init", "main", "_fini", "signal", "__app_flags"
+};
+
+typedef struct {
+    const fxe_io_t *io;
+    elf32_header eh;
+    elf32_shdr  *sh;
+    elf32_sym   *sym;
+    uint32_t     nsym;
+    char        *str;
+    uint32_t     nstr;
+    uint16_t    *map;      /* ELF section -> image index, FXE_NONE */
+    uint16_t    *order;    /* image index -> ELF section */
+    uint16_t     nsec;
+    elf32_rel   *rbuf;     /* relocations of the section being scanned */
+    uint32_t     rbuf_cap;
+    fxe_rel_t   *rel;
+    uint32_t     nrel, rel_cap;
+} fxe_builder_t;
+
+static void *read_alloc(fxe_builder_t *b, uint32_t off, uint32_t len) {
+    void *p = b->io->alloc(len ? len : 1);
+    if (p && len && !b->io->read(b->io->ctx, off, p, len)) {
+        b->io->free(p);
+        return NULL;
+    }
+    return p;
+}
+
+static void mark(fxe_builder_t *b, uint16_t s) {
+    if (b->map[s] != FXE_NONE) return;
+    b->map[s] = b->nsec;
+    b->order[b->nsec++] = s;
+}
+
+/* Read REL section r into b->rbuf; returns the entry count or < 0 */
+static int32_t read_rels(fxe_builder_t *b, uint16_t r) {
+    const elf32_shdr *rs = &b->sh[r];
+    uint32_t n = rs->sh_size / sizeof(elf32_rel);
+    if (n > b->rbuf_cap) {
+        if (b->rbuf) b->io->free(b->rbuf);
+        b->rbuf = (elf32_rel *)b->io->alloc(n * sizeof(elf32_rel));
+        b->rbuf_cap = b->rbuf ? n : 0;
+        if (!b->rbuf) return FXE_E_NOMEM;
+    }
+    if (n && !b->io->read(b->io->ctx, rs->sh_offset, b->rbuf, n * sizeof(elf32_rel)))
+        return FXE_E_IO;
+    return (int32_t)n;
+}
+
+/* Symbol of a relocation, with the loader's checks */
+static int rel_symbol(fxe_builder_t *b, const elf32_rel *rel, uint32_t sec_size,
+                      const elf32_sym **ps) {
+    uint32_t si = rel->rel_info >> 8;
+    if (si >= b->nsym || b->sym[si].st_name >= b->nstr ||
+        rel->rel_offset + sizeof(uint32_t) > sec_size)
+        return FXE_E_FORMAT;
+    const elf32_sym *s = &b->sym[si];
+    if (s->st_shndx == 0 || s->st_shndx >= b->eh.sh_num ||
+        !rel_supported(rel->rel_info & 0xFF))
+        return FXE_E_LINK;
+    *ps = s;
+    return FXE_OK;
+}
+
+static int push_rel(fxe_builder_t *b, uint32_t offset, uint16_t target, uint8_t type) {
+    if (b->nrel == b->rel_cap) {
+        uint32_t cap = b->rel_cap ? b->rel_cap * 2 : 256;
+        fxe_rel_t *n = (fxe_rel_t *)b->io->alloc(cap * sizeof(fxe_rel_t));
+        if (!n) return FXE_E_NOMEM;
+        if (b->rel) {
+            memcpy(n, b->rel, b->nrel * sizeof(fxe_rel_t));
+            b->io->free(b->rel);
+        }
+        b->rel = n;
+        b->rel_cap = cap;
+    }
+    fxe_rel_t *r = &b->rel[b->nrel++];
+    r->offset   = offset;
+    r->target   = target;
+    r->type     = type;
+    r->reserved = 0;
+    return FXE_OK;
+}
+
+/* Load the symbol tables and resolve the entry points */
+static int load_tables(fxe_builder_t *b, fxe_header_t *h) {
+    const fxe_io_t *io = b->io;
+    elf32_header *eh = &b->eh;
+    if (!io->read(io->ctx, 0, eh, sizeof(*eh)))
+        return FXE_E_IO;
+    if (eh->common.magic != ELF_MAGIC || eh->common.arch_class != 1 ||
+        eh->common.endianness != 1 || eh->common.machine != EM_ARM ||
+        eh->sh_num > 512 || eh->sh_str_index >= eh->sh_num)
+        return FXE_E_FORMAT;
+
+    b->sh = (elf32_shdr *)read_alloc(b, eh->sh_offset, eh->sh_num * sizeof(elf32_shdr));
+    b->map = (uint16_t *)io->alloc(eh->sh_num * sizeof(uint16_t));
+    b->order = (uint16_t *)io->alloc(eh->sh_num * sizeof(uint16_t));
+    if (!b->sh || !b->map || !b->order)
+        return FXE_E_NOMEM;
+    memset(b->map, 0xFF, eh->sh_num * sizeof(uint16_t));
+
+    const elf32_shdr *ss = &b->sh[eh->sh_str_index];
+    char *shstr = (char *)read_alloc(b, ss->sh_offset, ss->sh_size);
+    if (!shstr)
+        return FXE_E_NOMEM;
+    const elf32_shdr *symsh = NULL, *strsh = NULL;
+    for (uint16_t i = 0; i < eh->sh_num && (!symsh || !strsh); i++) {
+        const elf32_shdr *s = &b->sh[i];
+        if (s->sh_name >= ss->sh_size) continue;
+        if (!symsh && s->sh_type == SHT_SYMTAB && !strcmp(shstr + s->sh_name, ".symtab"))
+            symsh = s;
+        if (!strsh && s->sh_type == SHT_STRTAB && !strcmp(shstr + s->sh_name, ".strtab"))
+            strsh = s;
+    }
+    io->free(shstr);
+    if (!symsh || !strsh)
+        return FXE_E_FORMAT;
+
+    b->nsym = symsh->sh_size / sizeof(elf32_sym);
+    b->nstr = strsh->sh_size;
+    b->sym = (elf32_sym *)read_alloc(b, symsh->sh_offset, b->nsym * sizeof(elf32_sym));
+    b->str = (char *)read_alloc(b, strsh->sh_offset, b->nstr);
+    if (!b->sym || !b->str)
+        return FXE_E_NOMEM;
+    if (b->nstr) b->str[b->nstr - 1] = 0;
+
+    uint32_t idx[FXE_NENTRIES], weak_init = 0xFFFFFFFF, weak_fini = 0xFFFFFFFF;
+    for (int k = 0; k < FXE_NENTRIES; k++) idx[k] = 0xFFFFFFFF;
+    for (uint32_t i = 0; i < b->nsym; i++) {
+        const elf32_sym *s = &b->sym[i];
+        if (s->st_name >= b->nstr) continue;
+        const char *name = b->str + s->st_name;
+        if (s->st_info == STR_TAB_GLOBAL_FUNC) {
+            for (int k = 0; k < FXE_NENTRIES; k++)
+                if (!strcmp(name, entry_names[k])) idx[k] = i;
+        } else if (s->st_info == STR_TAB_WEAK_FUNC) {
+            if (!strcmp(name, "_init")) weak_init = i;
+            else if (!strcmp(name, "_fini")) weak_fini = i;
+        }
+    }
+    if (idx[FXE_ENTRY_INIT] == 0xFFFFFFFF) idx[FXE_ENTRY_INIT] = weak_init;
+    if (idx[FXE_ENTRY_FINI] == 0xFFFFFFFF) idx[FXE_ENTRY_FINI] = weak_fini;
+    if (idx[FXE_ENTRY_MAIN] == 0xFFFFFFFF)
+        return FXE_E_NOMAIN;
+
+    /* Entry sections come first, in the loader's order */
+    for (int k = 0; k < FXE_NENTRIES; k++) {
+        h->entries[k].sec = FXE_NONE;
+        if (idx[k] == 0xFFFFFFFF) continue;
+        const elf32_sym *s = &b->sym[idx[k]];
+        if (s->st_shndx == 0 || s->st_shndx >= eh->sh_num)
+            return FXE_E_LINK;
+        mark(b, s->st_shndx);
+        h->entries[k].sec   = b->map[s->st_shndx];
+        h->entries[k].value = s->st_value;
+    }
+    return FXE_OK;
+}
+
+/* Breadth-first closure over relocation targets */
+static int reach(fxe_builder_t *b) {
+    for (uint16_t q = 0; q < b->nsec; q++) {
+        uint16_t s = b->order[q];
+        for (uint16_t r = 0; r < b->eh.sh_num; r++) {
+            if (b->sh[r].sh_type != SHT_REL || b->sh[r].sh_info != s) continue;
+            int32_t n = read_rels(b, r);
+            if (n < 0) return (int)n;
+            for (int32_t j = 0; j < n; j++) {
+                const elf32_sym *sym;
+                int rc = rel_symbol(b, &b->rbuf[j], b->sh[s].sh_size, &sym);
+                if (rc != FXE_OK) return rc;
+                mark(b, sym->st_shndx);
+            }
+        }
+    }
+    return FXE_OK;
+}
+
+/* Link image section i at address 0 into buf, recording base deltas */
+static int link_section(fxe_builder_t *b, uint16_t i, uint8_t *buf, fxe_sec_t *fs) {
+    uint16_t s = b->order[i];
+    fs->rel_first = b->nrel;
+    for (uint16_t r = 0; r < b->eh.sh_num; r++) {
+        if (b->sh[r].sh_type != SHT_REL || b->sh[r].sh_info != s) continue;
+        if (!buf) return FXE_E_FORMAT;      /* relocations into NOBITS */
+        int32_t n = read_rels(b, r);
+        if (n < 0) return (int)n;
+        for (int32_t j = 0; j < n; j++) {
+            const elf32_rel *rel = &b->rbuf[j];
+            const elf32_sym *sym;
+            int rc = rel_symbol(b, rel, fs->size, &sym);
+            if (rc != FXE_OK) return rc;
+            uint8_t type = rel->rel_info & 0xFF;
+            rc = fxe_rel_apply(buf + rel->rel_offset, rel->rel_offset, type, sym->st_value);
+            if (rc == FXE_REL_SKIPPED) continue;
+            if (sym->st_shndx == s && fxe_rel_pc_relative(type)) continue;
+            rc = push_rel(b, rel->rel_offset, b->map[sym->st_shndx], type);
+            if (rc != FXE_OK) return rc;
+        }
+    }
+    fs->rel_count = b->nrel - fs->rel_first;
+    return FXE_OK;
+}
+
+static int build(fxe_builder_t *b, const fxe_elf_id_t *id, uint32_t *image_size) {
+    const fxe_io_t *io = b->io;
+    fxe_header_t h;
+    memset(&h, 0, sizeof(h));
+    int rc = load_tables(b, &h);
+    if (rc == FXE_OK) rc = reach(b);
+    if (rc != FXE_OK) return rc;
+
+    uint32_t tbl_len = sizeof(fxe_header_t) + b->nsec * sizeof(fxe_sec_t);
+    fxe_sec_t *secs = (fxe_sec_t *)io->alloc(tbl_len);
+    if (!secs) return FXE_E_NOMEM;
+    /* Zeros first: a header only appears once everything else is written */
+    memset(secs, 0, tbl_len);
+    if (!io->write(io->ctx, 0, secs, tbl_len)) {
+        io->free(secs);
+        return FXE_E_IO;
+    }
+
+    uint32_t off = tbl_len;
+    for (uint16_t i = 0; i < b->nsec && rc == FXE_OK; i++) {
+        const elf32_shdr *sh = &b->sh[b->order[i]];
+        fxe_sec_t *fs = &secs[i];
+        fs->size      = sh->sh_size;
+        fs->align     = sh->sh_addralign;
+        fs->elf_index = b->order[i];
+        if (sh->sh_flags & SHF_EXECINSTR) fs->flags |= FXE_SEC_EXEC;
+        if (sh->sh_flags & SHF_WRITE)     fs->flags |= FXE_SEC_WRITE;
+        if (sh->sh_type == SHT_NOBITS) {
+            fs->flags |= FXE_SEC_NOBITS;
+            rc = link_section(b, i, NULL, fs);
+            continue;
+        }
+        uint8_t *buf = (uint8_t *)read_alloc(b, sh->sh_offset, sh->sh_size);
+        if (!buf) { rc = FXE_E_NOMEM; break; }
+        rc = link_section(b, i, buf, fs);
+        fs->offset = off;
+        if (rc == FXE_OK && sh->sh_size && !io->write(io->ctx, off, buf, sh->sh_size))
+            rc = FXE_E_IO;
+        io->free(buf);
+        off += sh->sh_size;
+    }
+
+    if (rc == FXE_OK) {
+        /* Greatest fixpoint: read-only sections whose relocations all
+         * reach other PURE sections */
+        for (uint16_t i = 0; i < b->nsec; i++)
+            if (!(secs[i].flags & (FXE_SEC_WRITE | FXE_SEC_NOBITS)) &&
+                (b->sh[b->order[i]].sh_flags & SHF_ALLOC))
+                secs[i].flags |= FXE_SEC_PURE;
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (uint16_t i = 0; i < b->nsec; i++) {
+                if (!(secs[i].flags & FXE_SEC_PURE)) continue;
+                for (uint32_t j = 0; j < secs[i].rel_count; j++) {
+                    uint16_t t = b->rel[secs[i].rel_first + j].target;
+                    if (t != i && !(secs[t].flags & FXE_SEC_PURE)) {
+                        secs[i].flags &= ~FXE_SEC_PURE;
+                        changed = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        for (uint16_t i = 0; i < b->eh.sh_num; i++)
+            if ((b->sh[i].sh_flags & SHF_ALLOC) && (b->sh[i].sh_flags & SHF_EXECINSTR))
+                h.code_bytes += b->sh[i].sh_size + b->sh[i].sh_addralign;
+
+        h.magic      = FXE_MAGIC;
+        h.version    = FXE_VERSION;
+        h.sec_count  = b->nsec;
+        h.elf_size   = id->size;
+        h.elf_fdate  = id->fdate;
+        h.elf_ftime  = id->ftime;
+        h.elf_sh_num = b->eh.sh_num;
+        h.rel_offset = off;
+        h.rel_count  = b->nrel;
+        h.image_size = off + b->nrel * sizeof(fxe_rel_t);
+        if ((b->nrel && !io->write(io->ctx, off, b->rel, b->nrel * sizeof(fxe_rel_t))) ||
+            !io->write(io->ctx, sizeof(h), secs, b->nsec * sizeof(fxe_sec_t)) ||
+            !io->write(io->ctx, 0, &h, sizeof(h)))
+            rc = FXE_E_IO;
+        else if (image_size)
+            *image_size = h.image_size;
+    }
+    io->free(secs);
+    return rc;
+}
+
+int fxe_build(const fxe_io_t *io, const fxe_elf_id_t *id, uint32_t *image_size) {
+    fxe_builder_t b;
+    memset(&b, 0, sizeof(b));
+    b.io = io;
+    int rc = build(&b, id, image_size);
+    if (b.sh)    io->free(b.sh);
+    if (b.sym)   io->free(b.sym);
+    if (b.str)   io->free(b.str);
+    if (b.map)   io->free(b.map);
+    if (b.order) io->free(b.order);
+    if (b.rbuf)  io->free(b.rbuf);
+    if (b.rel)   io->free(b.rel);
+    return rc;
+}
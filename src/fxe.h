@@ -0,0 +1,152 @@
+/*
+ * FRANK OS — Pre-linked App Images (.fxe)
+ * Copyright (c) 2026 Mikhail Matveev <xtreme@rh1.tech>
+ * https://rh1.tech
+ *
+ * An .fxe is the part of an app ELF that the loader actually uses,
+ * linked once against load address 0 so a launch needs neither
+ * .shstrtab/.symtab/.strtab nor symbol lookups:
+ *
+ *   fxe_header_t                      entry points, source ELF identity
+ *   fxe_sec_t[sec_count]              one per section reachable from them
+ *   section blobs                     in table order, back to back
+ *   fxe_rel_t[rel_count]              base deltas, grouped by section
+ *
+ * Loading is one front-to-back read: allocate each section, read its
+ * blob, then for every relocation add the real base of the target
+ * section (and subtract the own base for PC-relative types) with
+ * fxe_rel_apply().  PC-relative relocations inside one section are
+ * already final and not stored.
+ *
+ * The firmware writes <app>.fxe after the first successful ELF load; the
+ * host tool tools/hostbench/fxetool builds the same bytes.  An image is
+ * used only while the ELF's size and FAT date/time match the header; a
+ * bare header with sec_count 0 marks an ELF the format can't represent,
+ * so the firmware doesn't retry it on every launch.
+ *
+ * Plain C, no OS dependencies — shared by the firmware and host tools.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef FXE_H
+#define FXE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "elf32.h"
+
+#define FXE_MAGIC    0x31455846u   /* "FXE1" */
+#define FXE_VERSION  1
+#define FXE_EXT      ".fxe"
+#define FXE_NONE     0xFFFF
+
+/* Entry points, in the order the loader resolves them */
+enum {
+    FXE_ENTRY_REQ_VER,     /* __required_m_api_verion */
+    FXE_ENTRY_INIT,        /* _init (global, else weak) */
+    FXE_ENTRY_MAIN,        /* main */
+    FXE_ENTRY_FINI,        /* _fini (global, else weak) */
+    FXE_ENTRY_SIGNAL,      /* signal */
+    FXE_ENTRY_FLAGS,       /* __app_flags */
+    FXE_NENTRIES
+};
+
+/* fxe_sec_t.flags */
+#define FXE_SEC_EXEC    0x01   /* SHF_EXECINSTR: SRAM candidate */
+#define FXE_SEC_WRITE   0x02   /* SHF_WRITE */
+#define FXE_SEC_NOBITS  0x04   /* no blob, zero-filled */
+#define FXE_SEC_PURE    0x08   /* read-only, relocations only to PURE
+                                  sections: may live in the code cache */
+
+typedef struct {
+    uint16_t sec;          /* image section index, FXE_NONE if absent */
+    uint16_t reserved;
+    uint32_t value;        /* offset in that section */
+} fxe_entry_t;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t sec_count;
+    uint32_t image_size;   /* whole file — catches truncated writes */
+    uint32_t elf_size;     /* source ELF identity: size, FAT mtime */
+    uint16_t elf_fdate;
+    uint16_t elf_ftime;
+    uint16_t elf_sh_num;   /* keys the app code cache like the ELF path */
+    uint16_t reserved;
+    uint32_t code_bytes;   /* executable bytes in the ELF (sh_size +
+                              sh_addralign), for the SRAM placement test */
+    uint32_t rel_offset;
+    uint32_t rel_count;
+    fxe_entry_t entries[FXE_NENTRIES];
+} fxe_header_t;
+
+typedef struct {
+    uint32_t offset;       /* file offset of the blob, 0 for NOBITS */
+    uint32_t size;
+    uint32_t align;        /* sh_addralign */
+    uint32_t rel_first;    /* first fxe_rel_t of this section */
+    uint32_t rel_count;
+    uint16_t elf_index;    /* section number in the source ELF */
+    uint8_t  flags;        /* FXE_SEC_* */
+    uint8_t  reserved;
+} fxe_sec_t;
+
+typedef struct {
+    uint32_t offset;       /* in the owning section */
+    uint16_t target;       /* image section index */
+    uint8_t  type;         /* R_ARM_* */
+    uint8_t  reserved;
+} fxe_rel_t;
+
+_Static_assert(sizeof(fxe_header_t) == 84, "fxe_header_t layout");
+_Static_assert(sizeof(fxe_sec_t) == 24, "fxe_sec_t layout");
+_Static_assert(sizeof(fxe_rel_t) == 8, "fxe_rel_t layout");
+
+/* Identity of the source ELF stored in the header */
+typedef struct {
+    uint32_t size;
+    uint16_t fdate, ftime;  /* FAT-encoded modification time */
+} fxe_elf_id_t;
+
+/* fxe_rel_apply() results */
+#define FXE_REL_OK           0
+#define FXE_REL_SKIPPED      1   /* misaligned MOVW, left untouched */
+#define FXE_REL_UNSUPPORTED  (-1)
+
+/* Apply one ARM relocation (REL, addend in place): loc is where the word
+ * is written, p its run-time address, value the symbol address S + A. */
+int fxe_rel_apply(uint8_t *loc, uint32_t p, uint8_t type, uint32_t value);
+
+/* True for PC-relative types, whose in-section uses need no rebase */
+bool fxe_rel_pc_relative(uint8_t type);
+
+/* Sanity-check a header read from an image of file_size bytes */
+bool fxe_header_ok(const fxe_header_t *h, uint32_t file_size);
+
+/* Byte access for fxe_build().  read/write address the source ELF and
+ * the image by absolute offset and return false on any error. */
+typedef struct {
+    void *ctx;
+    bool  (*read)(void *ctx, uint32_t off, void *buf, uint32_t len);
+    bool  (*write)(void *ctx, uint32_t off, const void *buf, uint32_t len);
+    void *(*alloc)(size_t sz);
+    void  (*free)(void *p);
+} fxe_io_t;
+
+/* fxe_build() results */
+#define FXE_OK          0
+#define FXE_E_IO        (-1)
+#define FXE_E_NOMEM     (-2)
+#define FXE_E_FORMAT    (-3)   /* not an ARM32 LE ELF, bad tables */
+#define FXE_E_NOMAIN    (-4)   /* no main() */
+#define FXE_E_LINK      (-5)   /* unsupported symbol or relocation */
+
+/* Build the image of an ELF.  *image_size gets the bytes written. */
+int fxe_build(const fxe_io_t *io, const fxe_elf_id_t *id, uint32_t *image_size);
+
+const char *fxe_strerror(int err);
+
+#endif /* FXE_H */
@@ -8,44 +8,61 @@
 
 #include "gfx.h"
 #include "display.h"
+#include "raster4.h"
 #include "font.h"
+#include "FreeRTOS.h"
+#include "task.h"
 
 void gfx_hline(int x, int y, int w, uint8_t color) {
     display_hline_safe(x, y, w, color);
 }
 
 void gfx_vline(int x, int y, int h, uint8_t color) {
-    for (int i = 0; i < h; i++)
-        display_set_pixel(x, y + i, color);
+    if (x < display_clip.x0 || x >= display_clip.x1) return;
+    int y1 = y + h;
+    if (y < display_clip.y0) y = display_clip.y0;
+    if (y1 > display_clip.y1) y1 = display_clip.y1;
+    if (y >= y1) return;
+    if (display_bpp == 4) {
+        r4_vline(display_draw_buffer_ptr, x, y, y1, color);
+        return;
+    }
+    for (int row = y; row < y1; row++)
+        display_set_pixel_8bpp_fast(x, row, color);
 }
 
 void gfx_fill_rect(int x, int y, int w, int h, uint8_t color) {
-    /* Clip to screen */
+    /* Clip to the display clip rect (always within the screen) */
     int x1 = x + w;
     int y1 = y + h;
-    if (x < 0) x = 0;
-    if (y < 0) y = 0;
-    if (x1 > display_width) x1 = display_width;
-    if (y1 > display_height) y1 = display_height;
+    if (x < display_clip.x0) x = display_clip.x0;
+    if (y < display_clip.y0) y = display_clip.y0;
+    if (x1 > display_clip.x1) x1 = display_clip.x1;
+    if (y1 > display_clip.y1) y1 = display_clip.y1;
     if (x >= x1 || y >= y1) return;
-    int cw = x1 - x;
-    if (display_bpp == 4) color &= 0x0F;
+    if (display_bpp == 4) {
+        r4_fill(display_draw_buffer_ptr, x, y, x1, y1, color);
+        return;
+    }
     for (int row = y; row < y1; row++)
-        display_hline_fast(x, row, cw, color);
+        display_hline_fast(x, row, x1 - x, color);
 }
 
 void gfx_fill_rect_dithered(int x, int y, int w, int h, uint8_t color) {
     int x1 = x + w;
     int y1 = y + h;
-    if (x < 0) x = 0;
-    if (y < 0) y = 0;
-    if (x1 > display_width) x1 = display_width;
-    if (y1 > display_height) y1 = display_height;
+    if (x < display_clip.x0) x = display_clip.x0;
+    if (y < display_clip.y0) y = display_clip.y0;
+    if (x1 > display_clip.x1) x1 = display_clip.x1;
+    if (y1 > display_clip.y1) y1 = display_clip.y1;
     if (x >= x1 || y >= y1) return;
+    if (display_bpp == 4) {
+        r4_fill_dither(display_draw_buffer_ptr, x, y, x1, y1, color);
+        return;
+    }
     for (int row = y; row < y1; row++)
-        for (int col = x; col < x1; col++)
-            if ((row + col) & 1)
-                display_set_pixel(col, row, color);
+        for (int col = x + ((row + x + 1) & 1); col < x1; col += 2)
+            display_set_pixel_8bpp_fast(col, row, color);
 }
 
 void gfx_rect(int x, int y, int w, int h, uint8_t color) {
@@ -56,10 +73,8 @@ void gfx_rect(int x, int y, int w, int h, uint8_t color) {
 }
 
 void gfx_char(int x, int y, char c, uint8_t fg, uint8_t bg) {
-    /* Fast path: even x and fully on-screen */
-    if (!(x & 1) &&
-        x >= 0 && (x + FONT_WIDTH) <= display_width &&
-        y >= 0 && (y + FONT_HEIGHT) <= display_height) {
+    /* Fast path: even x and fully inside the display clip */
+    if (!(x & 1) && display_clip_contains(x, y, FONT_WIDTH, FONT_HEIGHT)) {
         display_blit_glyph_8wide(x, y, font_get_glyph(c),
                                   FONT_HEIGHT, fg & 0x0F, bg & 0x0F);
         return;
@@ -93,27 +108,28 @@ void gfx_fill_rect_clipped(int x, int y, int w, int h, uint8_t color,
 
     if (x0 >= x1 || y0 >= y1) return;
 
-    /* Also clip to screen */
-    if (x0 < 0) x0 = 0;
-    if (y0 < 0) y0 = 0;
-    if (x1 > display_width) x1 = display_width;
-    if (y1 > display_height) y1 = display_height;
+    /* Also clip to the display clip rect */
+    if (x0 < display_clip.x0) x0 = display_clip.x0;
+    if (y0 < display_clip.y0) y0 = display_clip.y0;
+    if (x1 > display_clip.x1) x1 = display_clip.x1;
+    if (y1 > display_clip.y1) y1 = display_clip.y1;
     if (x0 >= x1 || y0 >= y1) return;
 
-    int span = x1 - x0;
-    if (display_bpp == 4) color &= 0x0F;
+    if (display_bpp == 4) {
+        r4_fill(display_draw_buffer_ptr, x0, y0, x1, y1, color);
+        return;
+    }
     for (int row = y0; row < y1; row++)
-        display_hline_fast(x0, row, span, color);
+        display_hline_fast(x0, row, x1 - x0, color);
 }
 
 void gfx_char_clipped(int x, int y, char c, uint8_t fg, uint8_t bg,
                        int cx, int cy, int cw, int ch) {
-    /* Fast path: even x and fully inside clip rect and on-screen */
+    /* Fast path: even x and fully inside clip rect and display clip */
     if (!(x & 1) &&
         x >= cx && (x + FONT_WIDTH) <= (cx + cw) &&
         y >= cy && (y + FONT_HEIGHT) <= (cy + ch) &&
-        x >= 0 && (x + FONT_WIDTH) <= display_width &&
-        y >= 0 && (y + FONT_HEIGHT) <= display_height) {
+        display_clip_contains(x, y, FONT_WIDTH, FONT_HEIGHT)) {
         display_blit_glyph_8wide(x, y, font_get_glyph(c),
                                   FONT_HEIGHT, fg & 0x0F, bg & 0x0F);
         return;
@@ -149,12 +165,53 @@ void gfx_text_clipped(int x, int y, const char *str, uint8_t fg, uint8_t bg,
 /*==========================================================================
  * UI font (8x12) — regular weight
  *
- * The UI font uses MSB=leftmost bit ordering (natural for authoring),
- * while display_blit_glyph_8wide expects LSB=leftmost.  Since the UI
- * font only renders small amounts of chrome text (not a 70x20 grid),
- * we always use per-pixel rendering — the cost is negligible.
+ * The UI font uses MSB=leftmost bit ordering (natural for authoring).
+ * Glyph cells that lie fully inside the clip take the 4bpp fast path:
+ * each row is expanded through r4_glyph_msb and stored as part of one
+ * word.  Everything else falls back to per-pixel rendering.
  *=========================================================================*/
 
+static bool ui_glyph_fast(int x, int y, const uint8_t *glyph,
+                          uint8_t fg, uint8_t bg) {
+    if (display_bpp != 4 ||
+        !display_clip_contains(x, y, FONT_UI_WIDTH, FONT_UI_HEIGHT))
+        return false;
+    uint32_t fgw = r4_fill_word(fg);
+    uint32_t bgw = r4_fill_word(bg);
+    uint8_t *dst = &display_draw_buffer_ptr[y * FB_STRIDE + (x >> 1)];
+
+    if (!(x & 1)) {
+        for (int row = 0; row < FONT_UI_HEIGHT; row++, dst += FB_STRIDE) {
+            uint32_t w = r4_glyph_word(r4_glyph_msb[glyph[row]], fgw, bgw);
+            memcpy(dst, &w, FONT_UI_WIDTH / 2);
+        }
+        return true;
+    }
+
+    /* Odd x (bold text advances 7px): render the glyph one pixel into
+     * the word that starts at x - 1 and keep the neighbouring nibbles.
+     * The word must not run past the end of the row. */
+    if (x + FONT_UI_WIDTH >= display_width) return false;
+    uint32_t keep = r4_glyph_msb[0x80 | (0xFF >> (FONT_UI_WIDTH + 1))];
+    for (int row = 0; row < FONT_UI_HEIGHT; row++, dst += FB_STRIDE) {
+        uint32_t w = r4_glyph_word(r4_glyph_msb[glyph[row] >> 1], fgw, bgw);
+        uint32_t old;
+        memcpy(&old, dst, 4);
+        r4_store32(dst, (old & keep) | (w & ~keep));
+    }
+    return true;
+}
+
+/* ui_glyph_fast() additionally limited to the caller's clip rect */
+static bool ui_glyph_fast_clipped(int x, int y, const uint8_t *glyph,
+                                  uint8_t fg, uint8_t bg,
+                                  int cx, int cy, int cw, int ch) {
+    if (x < cx || x + FONT_UI_WIDTH > cx + cw ||
+        y < cy || y + FONT_UI_HEIGHT > cy + ch)
+        return false;
+    return ui_glyph_fast(x, y, glyph, fg, bg);
+}
+
 /* Decode one UTF-8 character from *p, advance *p, return Win1251 glyph index.
  * ASCII passes through. Cyrillic U+0400-U+04FF maps to Win1251. */
 static uint8_t utf8_next_win1251(const char **p) {
@@ -211,6 +268,7 @@ void gfx_char_ui_clipped(int x, int y, char c, uint8_t fg, uint8_t bg,
     int cx1 = cx + cw, cy1 = cy + ch;
     if (x + FONT_UI_WIDTH <= cx || x >= cx1) return;
     const uint8_t *glyph = font_ui_get_glyph((uint8_t)c);
+    if (ui_glyph_fast_clipped(x, y, glyph, fg, bg, cx, cy, cw, ch)) return;
     for (int row = 0; row < FONT_UI_HEIGHT; row++) {
         int py = y + row;
         if (py < cy || py >= cy1) continue;
@@ -225,6 +283,7 @@ void gfx_char_ui_clipped(int x, int y, char c, uint8_t fg, uint8_t bg,
 
 void gfx_char_ui(int x, int y, char c, uint8_t fg, uint8_t bg) {
     const uint8_t *glyph = font_ui_get_glyph((uint8_t)c);
+    if (ui_glyph_fast(x, y, glyph, fg, bg)) return;
     for (int row = 0; row < FONT_UI_HEIGHT; row++) {
         uint8_t bits = glyph[row];
         for (int col = 0; col < FONT_UI_WIDTH; col++) {
@@ -250,6 +309,10 @@ void gfx_text_ui_clipped(int x, int y, const char *str, uint8_t fg, uint8_t bg,
         uint8_t glyph_ch = utf8_next_win1251(&str);
         if (x + FONT_UI_WIDTH > cx && x < cx1) {
             const uint8_t *glyph = font_ui_get_glyph(glyph_ch);
+            if (ui_glyph_fast_clipped(x, y, glyph, fg, bg, cx, cy, cw, ch)) {
+                x += FONT_UI_WIDTH;
+                continue;
+            }
             for (int row = 0; row < FONT_UI_HEIGHT; row++) {
                 int py = y + row;
                 if (py < cy || py >= cy1) continue;
@@ -275,6 +338,7 @@ void gfx_text_ui_clipped(int x, int y, const char *str, uint8_t fg, uint8_t bg,
 
 void gfx_char_ui_bold(int x, int y, char c, uint8_t fg, uint8_t bg) {
     const uint8_t *glyph = font_ui_bold_get_glyph((uint8_t)c);
+    if (ui_glyph_fast(x, y, glyph, fg, bg)) return;
     for (int row = 0; row < FONT_UI_HEIGHT; row++) {
         uint8_t bits = glyph[row];
         for (int col = 0; col < FONT_UI_WIDTH; col++) {
@@ -301,6 +365,10 @@ void gfx_text_ui_bold_clipped(int x, int y, const char *str,
         uint8_t glyph_ch = utf8_next_win1251(&str);
         if (x + FONT_UI_WIDTH > cx && x < cx1) {
             const uint8_t *glyph = font_ui_bold_get_glyph(glyph_ch);
+            if (ui_glyph_fast_clipped(x, y, glyph, fg, bg, cx, cy, cw, ch)) {
+                x += FONT_UI_WIDTH + 1;
+                continue;
+            }
             for (int row = 0; row < FONT_UI_HEIGHT; row++) {
                 int py = y + row;
                 if (py < cy || py >= cy1) continue;
@@ -318,71 +386,179 @@ void gfx_text_ui_bold_clipped(int x, int y, const char *str,
 }
 
 /*==========================================================================
- * 16x16 icon blitter
+ * Icon blitters
+ *
+ * Raw icons are packed a row at a time and go through the same masked
+ * word blit as packed ones.  Rows cut by the clip horizontally, and 8bpp
+ * mode, fall back to single pixels.
  *=========================================================================*/
 
-void gfx_draw_icon_16(int sx, int sy, const uint8_t *icon_data) {
-    for (int row = 0; row < 16; row++) {
-        int py = sy + row;
-        if (py < 0 || py >= display_height) continue;
-        for (int col = 0; col < 16; col++) {
-            int px = sx + col;
-            if (px < 0 || px >= display_width) continue;
-            uint8_t c = icon_data[row * 16 + col];
-            if (c != 0xFF)
-                display_set_pixel(px, py, c);
+/* Pack n raw pixels (a multiple of 8) into 4bpp pixels and a mask */
+static void icon_pack(const uint8_t *raw, int n, uint8_t *pix, uint8_t *mask) {
+    for (int i = 0; i < n; i += 8) {
+        uint8_t m = 0;
+        for (int k = 0; k < 8; k += 2) {
+            uint8_t a = raw[i + k], b = raw[i + k + 1];
+            m = (uint8_t)((m << 2) | ((a != 0xFF) << 1) | (b != 0xFF));
+            *pix++ = (uint8_t)((a != 0xFF ? (a & 0x0F) << 4 : 0) |
+                               (b != 0xFF ? (b & 0x0F) : 0));
         }
+        *mask++ = m;
     }
 }
 
-void gfx_draw_icon_16_clipped(int sx, int sy, const uint8_t *icon_data,
-                               int cx, int cy, int cw, int ch) {
-    int cx1 = cx + cw;
-    int cy1 = cy + ch;
-    for (int row = 0; row < 16; row++) {
-        int py = sy + row;
-        if (py < cy || py >= cy1 || py < 0 || py >= display_height) continue;
-        for (int col = 0; col < 16; col++) {
-            int px = sx + col;
-            if (px < cx || px >= cx1 || px < 0 || px >= display_width) continue;
-            uint8_t c = icon_data[row * 16 + col];
-            if (c != 0xFF)
-                display_set_pixel(px, py, c);
+/* Draw a size x size icon, raw or packed, clipped to the display clip
+ * and (cx, cy, cw, ch) */
+static void icon_draw(int sx, int sy, int size, const uint8_t *raw,
+                      const uint8_t *pix, const uint8_t *mask,
+                      int cx, int cy, int cw, int ch) {
+    int x0 = sx, y0 = sy, x1 = sx + size, y1 = sy + size;
+    if (x0 < cx) x0 = cx;
+    if (y0 < cy) y0 = cy;
+    if (x1 > cx + cw) x1 = cx + cw;
+    if (y1 > cy + ch) y1 = cy + ch;
+    if (x0 < display_clip.x0) x0 = display_clip.x0;
+    if (y0 < display_clip.y0) y0 = display_clip.y0;
+    if (x1 > display_clip.x1) x1 = display_clip.x1;
+    if (y1 > display_clip.y1) y1 = display_clip.y1;
+    if (x0 >= x1 || y0 >= y1) return;
+
+    bool whole = display_bpp == 4 && x0 == sx && x1 == sx + size;
+    uint8_t rpix[16], rmask[4];     /* one packed 32-pixel row */
+    for (int y = y0; y < y1; y++) {
+        int r = y - sy;
+        if (!whole) {
+            for (int x = x0; x < x1; x++) {
+                int c = x - sx;
+                if (raw) {
+                    uint8_t v = raw[r * size + c];
+                    if (v != 0xFF)
+                        display_set_pixel(x, y, v);
+                } else if (mask[r * (size / 8) + (c >> 3)] & (0x80 >> (c & 7))) {
+                    uint8_t v = pix[r * (size / 2) + (c >> 1)];
+                    display_set_pixel(x, y, (c & 1) ? v & 0x0F : v >> 4);
+                }
+            }
+            continue;
+        }
+        if (raw) {
+            icon_pack(raw + r * size, size, rpix, rmask);
+            r4_blit_masked(display_draw_buffer_ptr + y * FB_STRIDE, sx,
+                           rpix, rmask, size);
+        } else {
+            r4_blit_masked(display_draw_buffer_ptr + y * FB_STRIDE, sx,
+                           pix + r * (size / 2), mask + r * (size / 8), size);
         }
     }
 }
 
-/*==========================================================================
- * 32x32 icon blitter
- *=========================================================================*/
+void gfx_draw_icon_16(int sx, int sy, const uint8_t *icon_data) {
+    icon_draw(sx, sy, 16, icon_data, NULL, NULL,
+              0, 0, display_width, display_height);
+}
+
+void gfx_draw_icon_16_clipped(int sx, int sy, const uint8_t *icon_data,
+                               int cx, int cy, int cw, int ch) {
+    icon_draw(sx, sy, 16, icon_data, NULL, NULL, cx, cy, cw, ch);
+}
 
 void gfx_draw_icon_32(int sx, int sy, const uint8_t *icon_data) {
-    for (int row = 0; row < 32; row++) {
-        int py = sy + row;
-        if (py < 0 || py >= display_height) continue;
-        for (int col = 0; col < 32; col++) {
-            int px = sx + col;
-            if (px < 0 || px >= display_width) continue;
-            uint8_t c = icon_data[row * 32 + col];
-            if (c != 0xFF)
-                display_set_pixel(px, py, c);
-        }
-    }
+    icon_draw(sx, sy, 32, icon_data, NULL, NULL,
+              0, 0, display_width, display_height);
 }
 
 void gfx_draw_icon_32_clipped(int sx, int sy, const uint8_t *icon_data,
                                int cx, int cy, int cw, int ch) {
-    int cx1 = cx + cw;
-    int cy1 = cy + ch;
-    for (int row = 0; row < 32; row++) {
-        int py = sy + row;
-        if (py < cy || py >= cy1 || py < 0 || py >= display_height) continue;
-        for (int col = 0; col < 32; col++) {
-            int px = sx + col;
-            if (px < cx || px >= cx1 || px < 0 || px >= display_width) continue;
-            uint8_t c = icon_data[row * 32 + col];
-            if (c != 0xFF)
-                display_set_pixel(px, py, c);
+    icon_draw(sx, sy, 32, icon_data, NULL, NULL, cx, cy, cw, ch);
+}
+
+void gfx_draw_icon(int sx, int sy, const gfx_icon_t *icon) {
+    icon_draw(sx, sy, icon->size, NULL, icon->pix, icon->mask,
+              0, 0, display_width, display_height);
+}
+
+/*==========================================================================
+ * Icon atlas
+ *
+ * Windows and the Alt+Tab list hold references; the pixels are packed
+ * into a heap block when an icon first arrives and freed with its last
+ * reference.  The table is short, so lookups run with the scheduler
+ * suspended — any task may create a window.
+ *=========================================================================*/
+
+static gfx_icon_t icon_atlas[GFX_ICON_SLOTS];
+
+static uint32_t icon_hash(const uint8_t *raw, int n) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < n; i++)
+        h = (h ^ (raw[i] == 0xFF ? 0xFF : (raw[i] & 0x0F))) * 16777619u;
+    return h;
+}
+
+static bool icon_matches(const gfx_icon_t *ic, const uint8_t *raw) {
+    int n = ic->size * ic->size;
+    for (int i = 0; i < n; i++) {
+        bool opaque = ic->mask[i >> 3] & (0x80 >> (i & 7));
+        if (opaque != (raw[i] != 0xFF)) return false;
+        uint8_t c = (i & 1) ? ic->pix[i >> 1] & 0x0F : ic->pix[i >> 1] >> 4;
+        if (opaque && c != (raw[i] & 0x0F)) return false;
+    }
+    return true;
+}
+
+const gfx_icon_t *gfx_icon_get(const uint8_t *icon_data, int size) {
+    if (!icon_data || (size != 16 && size != 32)) return NULL;
+    int n = size * size;
+    uint32_t h = icon_hash(icon_data, n);
+    gfx_icon_t *ic = NULL, *free_slot = NULL;
+
+    vTaskSuspendAll();
+    for (int i = 0; i < GFX_ICON_SLOTS; i++) {
+        gfx_icon_t *s = &icon_atlas[i];
+        if (!s->size) {
+            if (!free_slot) free_slot = s;
+        } else if (s->size == size && s->hash == h && s->refs < 255 &&
+                   icon_matches(s, icon_data)) {
+            ic = s;
+            break;
+        }
+    }
+    if (ic) {
+        ic->refs++;
+    } else if (free_slot) {
+        uint8_t *data = (uint8_t *)pvPortMalloc(n / 2 + n / 8);
+        if (data) {
+            ic = free_slot;
+            ic->pix  = data;
+            ic->mask = data + n / 2;
+            icon_pack(icon_data, n, ic->pix, ic->mask);
+            ic->hash = h;
+            ic->size = (uint8_t)size;
+            ic->refs = 1;
         }
     }
+    xTaskResumeAll();
+    return ic;
+}
+
+const gfx_icon_t *gfx_icon_ref(const gfx_icon_t *icon) {
+    if (!icon) return NULL;
+    gfx_icon_t *ic = &icon_atlas[icon - icon_atlas];
+    vTaskSuspendAll();
+    if (ic->size && ic->refs < 255) ic->refs++;
+    else ic = NULL;
+    xTaskResumeAll();
+    return ic;
+}
+
+void gfx_icon_put(const gfx_icon_t *icon) {
+    if (!icon) return;
+    gfx_icon_t *ic = &icon_atlas[icon - icon_atlas];
+    vTaskSuspendAll();
+    if (ic->refs && --ic->refs == 0) {
+        vPortFree(ic->pix);
+        ic->pix = ic->mask = NULL;
+        ic->size = 0;
+    }
+    xTaskResumeAll();
 }
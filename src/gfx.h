@@ -91,4 +91,33 @@ void gfx_draw_icon_32(int sx, int sy, const uint8_t *icon_data);
 void gfx_draw_icon_32_clipped(int sx, int sy, const uint8_t *icon_data,
                                int cx, int cy, int cw, int ch);
 
+/* Packed icons — the same images as 4bpp pixels in framebuffer order
+ * (left pixel in the high nibble) plus a 1bpp mask (bit 7 = leftmost,
+ * 1 = opaque): 160 bytes for 16x16, 640 for 32x32, drawn 8 pixels per
+ * word.  They live in a shared atlas: gfx_icon_get() packs an icon once
+ * and hands out another reference when an identical one is there. */
+
+#define GFX_ICON_SLOTS  40
+
+typedef struct gfx_icon {
+    uint32_t hash;      /* of the raw image */
+    uint8_t  size;      /* 16 or 32; 0 = free slot */
+    uint8_t  refs;
+    uint8_t *pix;       /* size * size / 2 bytes */
+    uint8_t *mask;      /* size * size / 8 bytes */
+} gfx_icon_t;
+
+/* Pack a raw 16x16 or 32x32 icon into the atlas, or take a reference on
+ * an identical one.  Returns NULL if the atlas or the heap is full. */
+const gfx_icon_t *gfx_icon_get(const uint8_t *icon_data, int size);
+
+/* Take another reference on an atlas icon.  Returns NULL (and takes
+ * nothing) for NULL or when the icon already has 255 references. */
+const gfx_icon_t *gfx_icon_ref(const gfx_icon_t *icon);
+
+/* Drop a reference taken by gfx_icon_get or gfx_icon_ref (NULL is ignored) */
+void gfx_icon_put(const gfx_icon_t *icon);
+
+void gfx_draw_icon(int sx, int sy, const gfx_icon_t *icon);
+
 #endif /* GFX_H */
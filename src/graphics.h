@@ -47,6 +47,7 @@ void goutf(const char *__restrict str, ...) _ATTRIBUTE ((__format__ (__printf__,
 void fgoutf(FIL *f, const char *__restrict str, ...) _ATTRIBUTE ((__format__ (__printf__, 2, 3)));
 void __putc(char);
 void gouta(char* buf);
+void goutn(const char* buf, size_t len);
 void gbackspace();
 void graphics_set_con_pos(int x, int y);
 void graphics_set_con_color(uint8_t color, uint8_t bgcolor);
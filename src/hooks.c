@@ -64,6 +64,7 @@
 
 #include "hooks.h"
 #include "../drivers/psram/psram.h"
+#include "swap.h"
 
 /* Deferred PSRAM cleanup queue — filled by task_mem_defer_free() in app.c,
  * drained here in the idle hook after the self-deleting task has switched out. */
@@ -134,6 +135,9 @@ void vApplicationIdleHook( void )
     /* Remove compiler warning about xFreeHeapSpace being set but never used. */
     ( void ) xFreeHeapSpace;
 
+    /* Stack slots of app tasks that released them while exiting */
+    swap_trim_deferred();
+
     /* Drain deferred PSRAM cleanup queue (static task stacks/TCBs) */
     for (int i = 0; i < TASK_MEM_CLEANUP_SLOTS; i++) {
         taskENTER_CRITICAL();
@@ -35,7 +35,7 @@
 #include "taskbar.h"
 #include "startmenu.h"
 #include "run_dialog.h"
-#include "file_assoc.h"
+#include "app_registry.h"
 #include "desktop.h"
 #include "sysmenu.h"
 #include "filemanager.h"
@@ -197,6 +197,13 @@ void vApplicationGetTimerTaskMemory(StaticTask_t **ppxTimerTaskTCBBuffer,
 /* Dirty flag — set by input_task, read by compositor_task (both on Core 0) */
 static volatile bool g_video_dirty = true;
 
+/* Both tasks sleep on their notification (see window_event.h).  These
+ * bound the sleep for what nothing signals: the taskbar clock and network
+ * icon for the compositor, keyboard bytes left over a poll's limit or
+ * arriving while mouse commands mask the PS/2 IRQ for input_task. */
+#define COMPOSITOR_IDLE_MS  100
+#define INPUT_IDLE_MS       50
+
 /* Deferred spawn/open flags — set by input_task, consumed by compositor_task.
  * Avoids calling heavy WM/allocation functions from the small input_task stack
  * and prevents races with the compositor. */
@@ -206,11 +213,6 @@ static volatile bool g_open_run_dialog_pending      = false;
 static volatile bool g_spawn_control_panel_pending  = false;
 static volatile bool g_spawn_network_settings_pending = false;
 
-/* Boot cursor state: cursor is hidden after the hourglass timeout until
- * the user first moves the mouse.  Non-static so wm_composite can skip
- * stamping the cursor while hidden. */
-volatile bool boot_cursor_hidden = false;
-
 /* Deferred fullscreen: set before launching an ELF app so the compositor
  * can toggle the app's window fullscreen once it appears. */
 static volatile bool g_pending_fullscreen = false;
@@ -391,6 +393,7 @@ static void usb_service_task(void *params) {
  *=========================================================================*/
 static void compositor_task(void *params) {
     (void)params;
+    wm_set_compositor_task(xTaskGetCurrentTaskHandle());
 
     /* Show hourglass for 1 second, then hide cursor until first mouse move */
     TickType_t boot_deadline = xTaskGetTickCount() + pdMS_TO_TICKS(1000);
@@ -399,16 +402,14 @@ static void compositor_task(void *params) {
     for (;;) {
         /* In fullscreen 8bpp mode, the app owns the display.
          * Skip compositor (no windows, no cursor, no recomposite).
-         * Short sleep so we resume quickly when mode is restored.
+         * The mode hook wakes us when the mode is restored.
          * Force full repaint on the first frame back in desktop mode. */
         if (display_video_mode == VIDEO_MODE_320x240x256) {
             display_compositor_idle = 1;
-            do { vTaskDelay(pdMS_TO_TICKS(10)); }
+            do { wm_wait_compositor(pdMS_TO_TICKS(COMPOSITOR_IDLE_MS)); }
             while (display_video_mode == VIDEO_MODE_320x240x256);
             display_compositor_idle = 0;
-            boot_cursor_hidden = false;
             cursor_set_visible(true);
-            cursor_overlay_reset();
             wm_force_full_repaint();
             g_video_dirty = true;
             continue;
@@ -418,13 +419,12 @@ static void compositor_task(void *params) {
         if (boot_cursor_active && xTaskGetTickCount() >= boot_deadline) {
             boot_cursor_active = false;
             swap_init();
+            app_registry_load();
             startmenu_init();
-            file_assoc_scan();
             desktop_init();
             taskbar_init();
             cursor_set_type(CURSOR_ARROW);
-            cursor_overlay_erase();
-            boot_cursor_hidden = true;
+            cursor_hide_until_move();
             wm_force_full_repaint();
             /* Focus desktop if shortcuts exist and no windows are open */
             if (desktop_has_shortcuts()) desktop_focus();
@@ -495,18 +495,34 @@ static void compositor_task(void *params) {
 
         /* Recomposite when input arrives OR when windows are
          * invalidated (e.g. terminal output, cursor blink).
-         * Always drain both flags to avoid a stale-flag repeat. */
+         * Always drain both flags to avoid a stale-flag repeat.
+         * Events go first: a passive mouse move only wakes us with a
+         * queued WM_MOUSEMOVE, and repaints only if its handler
+         * invalidated something.  Otherwise a moved mouse cursor is
+         * just presented at vblank. */
         {
+            wm_dispatch_events();
+
             bool input   = g_video_dirty;
             bool content = wm_needs_composite();
             if (input || content) {
                 g_video_dirty = false;
-
-                wm_dispatch_events();
                 wm_composite();
+            } else if (display_sprites_pending()) {
+                display_wait_vsync();
+                display_sprites_present();
             }
         }
-        vTaskDelay(1);
+
+        /* Sleep until something is marked dirty or deferred work is
+         * posted.  wm_composite() already paced us to vblank. */
+        TickType_t wait = pdMS_TO_TICKS(COMPOSITOR_IDLE_MS);
+        if (boot_cursor_active) {
+            TickType_t left = boot_deadline - xTaskGetTickCount();
+            if ((int32_t)left <= 0) left = 0;
+            if (left < wait) wait = left;
+        }
+        wm_wait_compositor(wait);
     }
 }
 
@@ -613,15 +629,25 @@ static void startup_app_launch(void) {
 void spawn_control_panel(void) {
     g_spawn_control_panel_pending = true;
     g_video_dirty = true;
+    wm_wake_compositor();
 }
 
 void spawn_network_settings(void) {
     g_spawn_network_settings_pending = true;
     g_video_dirty = true;
+    wm_wake_compositor();
+}
+
+/* Display mode hook: both tasks park while a fullscreen app owns the
+ * display and look again when the mode changes */
+static void video_mode_changed(void) {
+    wm_wake_input();
+    wm_wake_compositor();
 }
 
 static void input_task(void *params) {
     (void)params;
+    wm_set_input_task(xTaskGetCurrentTaskHandle());
 
     /* Absolute cursor position — start at screen center */
     int16_t cur_x = display_width / 2;
@@ -633,7 +659,7 @@ static void input_task(void *params) {
          * Skip all input processing so keyboard_poll/get_event are available
          * exclusively to the fullscreen app, and mouse cursor is suppressed. */
         if (display_video_mode == VIDEO_MODE_320x240x256) {
-            do { vTaskDelay(pdMS_TO_TICKS(10)); }
+            do { wm_wait_input(pdMS_TO_TICKS(INPUT_IDLE_MS)); }
             while (display_video_mode == VIDEO_MODE_320x240x256);
             continue;
         }
@@ -883,7 +909,7 @@ static void input_task(void *params) {
             if (usb_mouse.has_motion) {
                 dx += usb_mouse.dx;
                 dy -= usb_mouse.dy; /* USB HID dy is positive=down; PS/2 convention is positive=up */
-                wheel += usb_mouse.wheel;
+                wheel -= usb_mouse.wheel; /* USB HID wheel is positive=up; PS/2 Z is positive=down */
                 buttons |= usb_mouse.buttons;
                 mouse_activity = true;
             }
@@ -891,11 +917,6 @@ static void input_task(void *params) {
 #endif
 
         if (mouse_activity) {
-            /* First mouse movement after boot: show the arrow cursor */
-            if (boot_cursor_hidden) {
-                boot_cursor_hidden = false;
-            }
-
             /* Convert deltas to absolute — PS/2 Y is inverted */
             cur_x += dx;
             cur_y -= dy;
@@ -909,6 +930,9 @@ static void input_task(void *params) {
             wm_set_cursor_pos(cur_x, cur_y);
             wm_set_mouse_buttons(buttons);
 
+            /* Also shows the arrow on the first move after boot */
+            cursor_move(cur_x, cur_y);
+
             /* Route all mouse events through the WM handler for
              * hit-testing, focus management, and title-bar dragging */
             wm_handle_mouse_input(WM_MOUSEMOVE, cur_x, cur_y, buttons);
@@ -941,24 +965,31 @@ static void input_task(void *params) {
             }
             prev_buttons = buttons;
 
+            /* Wheel goes to the focused window (PS/2 Z counts toward
+             * the user; the event uses positive = away) */
+            if (wheel != 0) {
+                window_event_t we;
+                memset(&we, 0, sizeof(we));
+                we.type = WM_MOUSEWHEEL;
+                we.wheel.x = cur_x;
+                we.wheel.y = cur_y;
+                we.wheel.delta = (int8_t)-wheel;
+                we.wheel.modifiers = wm_get_modifiers();
+                wm_post_event_focused(&we);
+            }
+
             /* Button changes or held buttons need full composite.
-             * Passive moves only need composite if an app requested it
-             * (via wm_mark_dirty from the MOUSEMOVE event handler). */
-            if (changed || buttons) {
+             * A passive move is left to cursor_move(): its wakeup has
+             * the compositor dispatch the queued WM_MOUSEMOVE and
+             * repaint only if an app's handler invalidated a window. */
+            if (changed || buttons)
                 g_video_dirty = true;
-            } else {
-                /* Passive move: dispatch the queued event by poking
-                 * compositor_dirty (wm_post_event skips it for MOUSEMOVE).
-                 * The compositor will run, dispatch the event, and only
-                 * repaint if the app's handler invalidated a window. */
-                extern void wm_mark_dirty(void);
-                wm_mark_dirty();
-                if (!boot_cursor_hidden)
-                    cursor_overlay_move(cur_x, cur_y);
-            }
         }
 
-        vTaskDelay(pdMS_TO_TICKS(8));
+        /* Hand anything marked above to the compositor, then sleep until
+         * the PS/2 IRQ or a USB HID report brings more */
+        if (g_video_dirty) wm_wake_compositor();
+        wm_wait_input(pdMS_TO_TICKS(INPUT_IDLE_MS));
     }
 }
 
@@ -1093,6 +1124,8 @@ int main(void) {
         } else {
             printf("PS/2 mouse device init failed after 5 attempts\n");
         }
+        /* Keyboard bytes and mouse packets wake input_task */
+        ps2_set_wake_handler(wm_wake_input_from_isr);
     } else {
         printf("PS/2 PIO init failed\n");
     }
@@ -1147,8 +1180,11 @@ int main(void) {
 #ifdef USB_HID_ENABLED
     printf("Initializing USB HID Host...\n"); stdio_flush();
     usbhid_init();
+    usbhid_set_wake_handler(wm_wake_input);
 #endif
 
+    display_set_mode_hook(video_mode_changed);
+
 #ifdef USB_HID_ENABLED
     xTaskCreate(usb_service_task, "usb", 512, NULL, configMAX_PRIORITIES - 1, NULL);
 #else
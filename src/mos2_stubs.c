@@ -91,6 +91,13 @@ void gouta(char *buf) {
     if (t) terminal_puts(t, buf);
 }
 
+/* Length-delimited console output (stdout/stderr write path) — one
+ * terminal burst, no NUL terminator or copy needed */
+void goutn(const char *buf, size_t len) {
+    terminal_t *t = terminal_get_active();
+    if (t) terminal_write(t, buf, len);
+}
+
 void gbackspace(void) {
     terminal_t *t = terminal_get_active();
     if (t) terminal_putc(t, '\b');
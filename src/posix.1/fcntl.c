@@ -7,6 +7,7 @@
 
 #include <FreeRTOS.h>
 #include <task.h>
+#include <semphr.h>
 
 #include "sys/fcntl.h"
 #include "sys/stat.h"
@@ -101,9 +102,104 @@ static time_t __in_hfa() fatfs_to_time_t(WORD fdate, WORD ftime) {
     return simple_mktime(&t); // mktime(&t);
 }
 
-static posix_link_t* posix_links = 0;
+/* POSIX metadata FAT can't hold (modes, symlinks, hard links) lives in
+ * /.extfs, one record per path:
+ *
+ *   type(1) hash(4) len(2) name  word(4)  ['H': len(2) orig-name]
+ *
+ * word is the mode, or for 'H' the hash of the original.  The file is a
+ * journal: every change appends records, a later record for a path wins
+ * and a 'D' record drops it.  Once the journal holds more than twice the
+ * live entries it is compacted — written out to /.extfs.new, which then
+ * replaces it.
+ *
+ * In memory the entries sit in an open-addressing hash table keyed by
+ * get_hash(), with linear probing and a power-of-two size that doubles
+ * at 3/4 load.  Entries are allocated one by one, so a posix_link_t*
+ * stays valid while the table grows. */
+#define EXTFS_PATH      "/.extfs"
+#define EXTFS_NEW_PATH  "/.extfs.new"
+#define EXTFS_DELETED   'D'
+#define LINKS_MIN_CAP   32
+#define JOURNAL_SLACK   64
+
+static posix_link_t** links = 0;
+static size_t links_cap = 0;        // power of two, or 0
 static size_t posix_links_cnt = 0;
+static size_t links_hcnt = 0;       // 'H' entries: lookup_by_orig() scans only if any
+static size_t journal_cnt = 0;      // records in /.extfs
+
+/* The link table and /.extfs change together under this lock.  It is held
+ * across the file I/O, so it's a mutex rather than a scheduler lock: other
+ * tasks keep running while /.extfs is written.  Recursive, since
+ * extfs_add_hlink() adds its links through extfs_add_link(). */
+static SemaphoreHandle_t extfs_mutex;
+
+static void extfs_lock(void) {
+    if (!extfs_mutex) {
+        static StaticSemaphore_t extfs_mutex_buf;
+        taskENTER_CRITICAL();
+        if (!extfs_mutex) extfs_mutex = xSemaphoreCreateRecursiveMutexStatic(&extfs_mutex_buf);
+        taskEXIT_CRITICAL();
+    }
+    xSemaphoreTakeRecursive(extfs_mutex, portMAX_DELAY);
+}
+
+static void extfs_unlock(void) {
+    xSemaphoreGiveRecursive(extfs_mutex);
+}
+
+/* Slot holding path, or the empty slot where it would go; needs links_cap */
+static posix_link_t** __in_hfa() links_slot(uint32_t hash, const char* path) {
+    size_t mask = links_cap - 1;
+    for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+        posix_link_t* lnk = links[i];
+        if (!lnk || (lnk->hash == hash && strcmp(path, lnk->fname) == 0)) {
+            return &links[i];
+        }
+    }
+}
 
+static bool __in_hfa() links_grow(void) {
+    size_t cap = links_cap ? links_cap * 2 : LINKS_MIN_CAP;
+    posix_link_t** t = (posix_link_t**)pvPortCalloc(cap, sizeof(posix_link_t*));
+    if (!t) return false;
+    posix_link_t** old = links;
+    size_t old_cap = links_cap;
+    links = t;
+    links_cap = cap;
+    for (size_t i = 0; i < old_cap; ++i) {
+        if (old[i]) *links_slot(old[i]->hash, old[i]->fname) = old[i];
+    }
+    if (old) vPortFree(old);
+    return true;
+}
+
+/* Take the entry out of its slot, shifting later members of its probe run
+ * back so that no tombstones are needed */
+static void __in_hfa() links_remove(posix_link_t** slot) {
+    size_t mask = links_cap - 1;
+    size_t i = (size_t)(slot - links);
+    if (links[i]->type == 'H') --links_hcnt;
+    --posix_links_cnt;
+    for (size_t j = (i + 1) & mask; links[j]; j = (j + 1) & mask) {
+        size_t home = links[j]->hash & mask;
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            links[i] = links[j];
+            i = j;
+        }
+    }
+    links[i] = 0;
+}
+
+static void __in_hfa() link_free(posix_link_t* lnk) {
+    vPortFree(lnk->fname);
+    if (lnk->type == 'H' && lnk->hlink.ofname) vPortFree(lnk->hlink.ofname);
+    vPortFree(lnk);
+}
+
+/* Add or replace the entry for path.  allocated: path and opath are
+ * pvPortMalloc'ed and handed over, else they are copied. */
 static posix_link_t* __in_hfa() posix_add_link(
     uint32_t hash,
     const char* path, 
@@ -113,182 +209,242 @@ static posix_link_t* __in_hfa() posix_add_link(
     bool allocated
 ) {
     // goutf("[posix_add_link] %c %s [%o]\n", type, path, ohash);
-    posix_link_t* lnk = (posix_link_t*)pvPortMalloc((posix_links_cnt + 1) * sizeof(posix_link_t));
-    if (!lnk) return lnk;
-    if (posix_links) {
-        memcpy(lnk, posix_links, posix_links_cnt * sizeof(posix_link_t));
-        vPortFree(posix_links);
-        posix_links = lnk;
-        lnk += posix_links_cnt;
-    } else {
-        posix_links = lnk;
-    }
-    ++posix_links_cnt;
+    posix_link_t* lnk = (posix_link_t*)pvPortMalloc(sizeof(posix_link_t));
+    if (!lnk) goto err;
     lnk->type = type;
     lnk->hash = hash;
-    lnk->fname = allocated ? path : copy_str(path);
+    lnk->fname = allocated ? (char*)path : copy_str(path);
     if (type == 'H') {
         lnk->hlink.ohash = ohash;
-        lnk->hlink.ofname = allocated ? opath : copy_str(opath);
+        lnk->hlink.ofname = allocated ? (char*)opath : copy_str(opath);
     } else {
         lnk->desc.mode = type == 'S' ? (S_IFLNK | 0777) : ohash;
         lnk->desc.owner = 0; // no group/owner support for now
     }
+    if ((posix_links_cnt + 1) * 4 > links_cap * 3 && !links_grow()) {
+        link_free(lnk);
+        return 0;
+    }
+    posix_link_t** slot = links_slot(hash, path);
+    if (*slot) {
+        if ((*slot)->type == 'H') --links_hcnt;
+        --posix_links_cnt;
+        link_free(*slot);
+    }
+    *slot = lnk;
+    ++posix_links_cnt;
+    if (type == 'H') ++links_hcnt;
     return lnk;
+err:
+    if (allocated) {
+        vPortFree((char*)path);
+        if (opath) vPortFree((char*)opath);
+    }
+    return 0;
 }
 
+static FRESULT __in_hfa() extfs_put(FIL* pf, char type, uint32_t hash, const char* name, uint32_t word, const char* oname) {
+    UINT bw;
+    uint16_t sz = (uint16_t)strlen(name);
+    FRESULT r = f_write(pf, &type, 1, &bw);
+    if (r == FR_OK) r = f_write(pf, &hash, sizeof(hash), &bw);
+    if (r == FR_OK) r = f_write(pf, &sz, sizeof(sz), &bw);
+    if (r == FR_OK) r = f_write(pf, name, sz, &bw);
+    if (r == FR_OK) r = f_write(pf, &word, sizeof(word), &bw);
+    if (r == FR_OK && type == 'H') {
+        sz = (uint16_t)strlen(oname);
+        r = f_write(pf, &sz, sizeof(sz), &bw);
+        if (r == FR_OK) r = f_write(pf, oname, sz, &bw);
+    }
+    return r;
+}
+
+static FRESULT __in_hfa() extfs_put_link(FIL* pf, const posix_link_t* lnk) {
+    if (lnk->type == 'H') {
+        if (!lnk->hlink.ofname) return FR_OK; // lost to a failed allocation
+        return extfs_put(pf, 'H', lnk->hash, lnk->fname, lnk->hlink.ohash, lnk->hlink.ofname);
+    }
+    return extfs_put(pf, lnk->type, lnk->hash, lnk->fname, lnk->desc.mode, 0);
+}
+
+/* Compaction: write the live entries to a new file and swap it in.  Until
+ * the rename /.extfs stays complete; init_pfiles() picks up /.extfs.new if
+ * power fails between the unlink and the rename. */
 static FRESULT __in_hfa() extfs_flush() {
     FIL* pf = (FIL*)pvPortMalloc(sizeof(FIL));
-    if (!pf) { errno = ENOMEM; return -1; }
-    FRESULT r = FR_OK;
-    vTaskSuspendAll();
-    posix_link_t* lnk = posix_links;
-    if (!lnk) {
-        goto ok;
-    }
-    r = f_open(pf, "/.extfs", FA_CREATE_ALWAYS | FA_WRITE);
-    if (r != FR_OK) goto ex;
-    for (uint32_t i = 0; i < posix_links_cnt; ++i, ++lnk) {
-        UINT bw;
-        r = f_write(pf, &lnk->type, 1, &bw);
-        if (r != FR_OK) goto ex;
-        r = f_write(pf, &lnk->hash, sizeof(lnk->hash), &bw);
-        if (r != FR_OK) goto ex;
-        uint16_t sz = (uint16_t)strlen(lnk->fname);
-        r = f_write(pf, &sz, sizeof(sz), &bw);
-        if (r != FR_OK) goto ex;
-        r = f_write(pf, lnk->fname, sz, &bw);
-        if (r != FR_OK) goto ex;
-        if (lnk->type == 'H') {
-            r = f_write(pf, &lnk->hlink.ohash, sizeof(lnk->hlink.ohash), &bw);
-            if (r != FR_OK) goto ex;
-            sz = (uint16_t)strlen(lnk->hlink.ofname);
-            r = f_write(pf, &sz, sizeof(sz), &bw);
-            if (r != FR_OK) goto ex;
-            r = f_write(pf, lnk->hlink.ofname, sz, &bw);
-            if (r != FR_OK) goto ex;
-        } else {
-            r = f_write(pf, &lnk->desc.mode, sizeof(lnk->desc.mode), &bw);
-            if (r != FR_OK) goto ex;
+    if (!pf) return FR_NOT_ENOUGH_CORE;
+    extfs_lock();
+    FRESULT r = f_open(pf, EXTFS_NEW_PATH, FA_CREATE_ALWAYS | FA_WRITE);
+    if (r == FR_OK) {
+        for (size_t i = 0; i < links_cap && r == FR_OK; ++i) {
+            if (links[i]) r = extfs_put_link(pf, links[i]);
         }
+        FRESULT rc = f_close(pf);
+        if (r == FR_OK) r = rc;
     }
-ex:
-    f_close(pf);
-ok:
+    if (r == FR_OK) {
+        r = f_unlink(EXTFS_PATH);
+        if (r == FR_OK || r == FR_NO_FILE) r = f_rename(EXTFS_NEW_PATH, EXTFS_PATH);
+    }
+    if (r == FR_OK) journal_cnt = posix_links_cnt;
+    else f_unlink(EXTFS_NEW_PATH);
+    extfs_unlock();
     vPortFree(pf);
-	xTaskResumeAll();
     return r;
 }
 
-posix_link_t* __in_hfa() lookup_exact(uint32_t hash, const char* path) {
-    posix_link_t* lnk = posix_links;
-    if (!lnk) return 0;
-    for (uint32_t i = 0; i < posix_links_cnt; ++i, ++lnk) {
-        if (lnk->hash == hash && strcmp(path, lnk->fname) == 0) {
-            return lnk;
+/* Append the current record of lnk (or, with lnk 0, a 'D' record for
+ * hash/path) to the journal; compact once it has grown stale enough */
+static FRESULT __in_hfa() extfs_journal(const posix_link_t* lnk, uint32_t hash, const char* path) {
+    FIL* pf = (FIL*)pvPortMalloc(sizeof(FIL));
+    if (!pf) return FR_NOT_ENOUGH_CORE;
+    FRESULT r = f_open(pf, EXTFS_PATH, FA_OPEN_APPEND | FA_WRITE);
+    if (r == FR_OK) {
+        r = lnk ? extfs_put_link(pf, lnk) : extfs_put(pf, EXTFS_DELETED, hash, path, 0, 0);
+        FRESULT rc = f_close(pf);
+        if (r == FR_OK) r = rc;
+    }
+    vPortFree(pf);
+    if (r != FR_OK) return r;
+    ++journal_cnt;
+    if (journal_cnt > JOURNAL_SLACK && journal_cnt > posix_links_cnt * 2) {
+        return extfs_flush();
+    }
+    return FR_OK;
+}
+
+static FRESULT __in_hfa() append_to_extfs(posix_link_t* lnk) {
+    // goutf("[append_to_extfs] %c %s [%o]\n", lnk->type, lnk->fname, lnk->desc.mode);
+    return extfs_journal(lnk, 0, 0);
+}
+
+/* Replay the journal into the table */
+static void __in_hfa() extfs_load(void) {
+    FIL* pf = (FIL*)pvPortMalloc(sizeof(FIL));
+    if (!pf) { errno = ENOMEM; return; }
+    FRESULT r = f_open(pf, EXTFS_PATH, FA_READ);
+    if (r == FR_NO_FILE && f_rename(EXTFS_NEW_PATH, EXTFS_PATH) == FR_OK) { // compaction cut short
+        r = f_open(pf, EXTFS_PATH, FA_READ);
+    }
+    if (r != FR_OK) {
+        vPortFree(pf);
+        return;
+    }
+    UINT br;
+    char type;
+    uint32_t hash;
+    uint16_t strsize;
+    while(!f_eof(pf)) {
+        if (f_read(pf, &type, 1, &br) != FR_OK || br != 1) break;
+        if (f_read(pf, &hash, sizeof(hash), &br) != FR_OK || br != sizeof(hash)) break;
+        if (f_read(pf, &strsize, sizeof(strsize), &br) != FR_OK || br != sizeof(strsize) || strsize < 2) break;
+        char* buf = pvPortMalloc(strsize + 1);
+        if (!buf) break;
+        buf[strsize] = 0;
+        if (f_read(pf, buf, strsize, &br) != FR_OK || strsize != br) {
+            vPortFree(buf);
+            break;
+        }
+        uint32_t ohash = 0; // mode for 'O' case
+        if (f_read(pf, &ohash, sizeof(ohash), &br) != FR_OK || br != sizeof(ohash)) goto brk2;
+        char* obuf = 0;
+        if (type == 'H') {
+            if (f_read(pf, &strsize, sizeof(strsize), &br) != FR_OK || br != sizeof(strsize) || strsize < 2) goto brk2;
+            obuf = (char*)pvPortMalloc(strsize + 1);
+            if (obuf) {
+                obuf[strsize] = 0;
+                if (f_read(pf, obuf, strsize, &br) != FR_OK || strsize != br) {
+                    vPortFree(obuf);
+                    brk2: vPortFree(buf);
+                    break;
+                }
+            } else if (f_tell(pf) + strsize > f_size(pf) || f_lseek(pf, f_tell(pf) + strsize) != FR_OK) {
+                goto brk2; // skip the string anyway, so the next record stays aligned
+            }
+        }
+        ++journal_cnt;
+        if (type == EXTFS_DELETED) {
+            if (links_cap) {
+                posix_link_t** slot = links_slot(hash, buf);
+                if (*slot) {
+                    posix_link_t* lnk = *slot;
+                    links_remove(slot);
+                    link_free(lnk);
+                }
+            }
+            vPortFree(buf);
+            continue;
         }
+        posix_add_link(hash, buf, type, ohash, obuf, true);
     }
-    return 0;
+    // a torn tail (power lost mid-append) would hide later appends: rewrite
+    bool torn = !f_eof(pf);
+    f_close(pf);
+    vPortFree(pf);
+    if (torn) extfs_flush();
+}
+
+/* Guarded by the lock: the table may be resized under an unlocked reader */
+posix_link_t* __in_hfa() lookup_exact(uint32_t hash, const char* path) {
+    if (!posix_links_cnt) return 0;
+    extfs_lock();
+    posix_link_t* lnk = posix_links_cnt ? *links_slot(hash, path) : 0;
+    extfs_unlock();
+    return lnk;
 }
 
 static posix_link_t* __in_hfa() lookup_by_orig(uint32_t ohash, const char* opath) {
-    posix_link_t* lnk = posix_links;
-    if (!lnk) return 0;
-    for (uint32_t i = 0; i < posix_links_cnt; ++i, ++lnk) {
-        if (lnk->type == 'H' && lnk->hlink.ofname && lnk->hlink.ohash == ohash && strcmp(opath, lnk->hlink.ofname) == 0) {
+    if (!links_hcnt) return 0;
+    for (size_t i = 0; i < links_cap; ++i) {
+        posix_link_t* lnk = links[i];
+        if (lnk && lnk->type == 'H' && lnk->hlink.ofname && lnk->hlink.ohash == ohash && strcmp(opath, lnk->hlink.ofname) == 0) {
             return lnk;
         }
     }
     return 0;
 }
 
-static void __in_hfa() replace_orig(const char* opath, uint32_t ohash, posix_link_t* rename_to) {
-    posix_link_t* lnk = posix_links;
-    if (!lnk) return;
-    for (uint32_t i = 0; i < posix_links_cnt; ++i, ++lnk) {
-        if (lnk->type == 'H' && lnk->hlink.ofname && lnk->hlink.ohash == ohash && strcmp(opath, lnk->hlink.ofname) == 0) {
+/* Point the hard links of opath to rename_to; returns how many changed */
+static size_t __in_hfa() replace_orig(const char* opath, uint32_t ohash, posix_link_t* rename_to) {
+    size_t n = 0;
+    if (!links_hcnt) return n;
+    for (size_t i = 0; i < links_cap; ++i) {
+        posix_link_t* lnk = links[i];
+        if (lnk && lnk != rename_to && lnk->type == 'H' && lnk->hlink.ofname && lnk->hlink.ohash == ohash && strcmp(opath, lnk->hlink.ofname) == 0) {
             lnk->hlink.ohash = rename_to->hash;
             vPortFree(lnk->hlink.ofname);
             lnk->hlink.ofname = copy_str(rename_to->fname);
+            ++n;
         }
     }
-    return;
+    return n;
 }
 
+/* Drop the entry for path.  When path is an original with hard links, the
+ * first of them becomes the new original (*rename_to, still typed 'H'
+ * with its ofname — the caller converts it once the file is moved).
+ * Returns the original mode, or 0 if path had no entry. */
 static uint32_t __in_hfa() posix_unlink(const char* path, uint32_t hash, posix_link_t** rename_to) {
-    posix_link_t* lnk = posix_links;
+    if (!posix_links_cnt) return 0; // nothing
+    posix_link_t** slot = links_slot(hash, path);
+    posix_link_t* lnk = *slot;
     if (!lnk) return 0; // nothing
-    for (uint32_t i = 0; i < posix_links_cnt; ++i, ++lnk) {
-        if (lnk->hash == hash && strcmp(path, lnk->fname) == 0) {
-            uint32_t omode = S_IFREG | 0777;
-            if (lnk->type == 'O' && rename_to) { // original removement (additional handling is required)
-                omode = lnk->desc.mode;
-                *rename_to = lookup_by_orig(hash, path);
-                if (*rename_to) {
-                    (*rename_to)->type = 'O';
-                    replace_orig(hash, path, *rename_to);
-                }
-            }
-            vPortFree(lnk->fname);
-            if (lnk->hlink.ofname) vPortFree(lnk->hlink.ofname);
-            if (posix_links_cnt - i > 1) {
-                memmove(lnk, lnk + 1, sizeof(posix_link_t) * (posix_links_cnt - i - 1));
-            }
-            --posix_links_cnt;
-            return omode; // flush is required
+    uint32_t omode = S_IFREG | 0777;
+    if (lnk->type == 'O' && rename_to) { // original removement (additional handling is required)
+        omode = lnk->desc.mode;
+        *rename_to = lookup_by_orig(hash, path);
+        if (*rename_to) {
+            replace_orig(path, hash, *rename_to);
         }
     }
-    return 0; // nothing
+    links_remove(slot);
+    link_free(lnk);
+    return omode; // journal record is required
 }
 
 static bool __in_hfa() is_symlink(const char* path, uint32_t hash) {
-    vTaskSuspendAll();
-    posix_link_t* lnk = posix_links;
-    if (!lnk) goto err; // nothing
-    for (uint32_t i = 0; i < posix_links_cnt; ++i, ++lnk) {
-        if (lnk->hash == hash && strcmp(path, lnk->fname) == 0) {
-            char type = lnk->type;
-        	xTaskResumeAll();
-            return type == 'S';
-        }
-    }
-err:
-	xTaskResumeAll();
-    return false; // nothing
-}
-
-static FRESULT __in_hfa() append_to_extfs(posix_link_t* lnk) {
-    // goutf("[append_to_extfs] %c %s [%o]\n", lnk->type, lnk->fname, lnk->desc.mode);
-    FIL* pf = (FIL*)pvPortMalloc(sizeof(FIL));
-    if (!pf) { return FR_DISK_ERR; } // ??
-    FRESULT r = f_open(pf, "/.extfs", FA_OPEN_ALWAYS | FA_WRITE);
-    if (r != FR_OK) goto ex;
-    r = f_lseek(pf, f_size(pf));
-    if (r != FR_OK) goto err;
-    UINT bw;
-    r = f_write(pf, &lnk->type, 1, &bw);
-    if (r != FR_OK) goto err;
-    r = f_write(pf, &lnk->hash, sizeof(lnk->hash), &bw);
-    if (r != FR_OK) goto err;
-    uint16_t sz = (uint16_t)strlen(lnk->fname);
-    r = f_write(pf, &sz, sizeof(sz), &bw);
-    if (r != FR_OK) goto err;
-    r = f_write(pf, lnk->fname, sz, &bw);
-    if (r != FR_OK) goto err;
-    r = f_write(pf, &lnk->desc.mode, sizeof(lnk->desc.mode), &bw);
-    if (r != FR_OK) goto err;
-    if (lnk->type == 'H') {
-        sz = (uint16_t)strlen(lnk->hlink.ofname);
-        r = f_write(pf, &sz, sizeof(sz), &bw);
-        if (r != FR_OK) goto err;
-        r = f_write(pf, lnk->hlink.ofname, sz, &bw);
-        if (r != FR_OK) goto err;
-    }
-err:
-    f_close(pf);
-ex:
-    vPortFree(pf);
-    return r;
+    posix_link_t* lnk = lookup_exact(hash, path);
+    return lnk && lnk->type == 'S';
 }
 
 static FRESULT __in_hfa() extfs_add_link(
@@ -298,13 +454,13 @@ static FRESULT __in_hfa() extfs_add_link(
     uint32_t ohash, // means mode for 'O' type
     const char *opath
 ) {
-    vTaskSuspendAll();
+    extfs_lock();
     FRESULT r;
     posix_link_t* lnk = posix_add_link(hash, path, type, ohash, opath, false);
-    if (!lnk) { r = FR_DISK_ERR; goto ex; }
+    if (!lnk) { r = FR_NOT_ENOUGH_CORE; goto ex; }
     r = append_to_extfs(lnk);
 ex:
-    xTaskResumeAll();
+    extfs_unlock();
     return r;
 }
 
@@ -316,20 +472,13 @@ static FRESULT __in_hfa() extfs_add_hlink(
     uint32_t omode
 ) {
     FRESULT r;
-    vTaskSuspendAll();
-    bool found_orig = false;
-    posix_link_t* lnk = posix_links;
-    for (uint32_t i = 0; i < posix_links_cnt; ++i, ++lnk) {
-        if (lnk->hash == ohash && strcmp(opath, lnk->fname) == 0) {
-            if (lnk->type != 'O') {
-                r = FR_EXIST;
-                goto ex;
-            }
-            found_orig = true;
-            break;
-        }
+    extfs_lock();
+    posix_link_t* lnk = lookup_exact(ohash, opath);
+    if (lnk && lnk->type != 'O') {
+        r = FR_EXIST;
+        goto ex;
     }
-    if (!found_orig) {
+    if (!lnk) {
         r = extfs_add_link(opath, ohash, 'O', omode, 0);
         if (FR_OK != r) {
             goto ex;
@@ -337,7 +486,7 @@ static FRESULT __in_hfa() extfs_add_hlink(
     }
     r = extfs_add_link(path, hash, 'H', ohash, opath);
 ex:
-	xTaskResumeAll();
+    extfs_unlock();
     return r;
 }
 
@@ -384,48 +533,10 @@ void __in_hfa() dealloc_dir(void* p) {
 void __in_hfa() init_pfiles(cmd_ctx_t* ctx) {
     static volatile bool posix_links_initialized = 0;
     if (!posix_links_initialized) {
-        FIL* pf = (FIL*)pvPortMalloc(sizeof(FIL));
-        if (!pf) { errno = ENOMEM; return; }
+        extfs_lock();
+        if (!posix_links_initialized) extfs_load();
         posix_links_initialized = 1;
-        vTaskSuspendAll();
-        FRESULT r = f_open(pf, "/.extfs", FA_READ);
-        if (r == FR_OK) {
-            UINT br;
-            char type;
-            uint32_t hash;
-            uint16_t strsize;
-            while(!f_eof(pf)) {
-                if (f_read(pf, &type, 1, &br) != FR_OK || br != 1) break;
-                if (f_read(pf, &hash, sizeof(hash), &br) != FR_OK || br != sizeof(hash)) break;
-                if (f_read(pf, &strsize, sizeof(strsize), &br) != FR_OK || br != sizeof(strsize) || strsize < 2) break;
-                char* buf = pvPortMalloc(strsize + 1);
-                if (!buf) break;
-                buf[strsize] = 0;
-                if (f_read(pf, buf, strsize, &br) != FR_OK || strsize != br) {
-                    vPortFree(buf);
-                    break;
-                }
-                uint32_t ohash = 0; // mode for 'O' case
-                if (f_read(pf, &ohash, sizeof(ohash), &br) != FR_OK || br != sizeof(ohash)) goto brk2;
-                char* obuf = 0;
-                if (type == 'H') {
-                    if (f_read(pf, &strsize, sizeof(strsize), &br) != FR_OK || br != sizeof(strsize) || strsize < 2) goto brk1;
-                    obuf = (char*)pvPortMalloc(strsize + 1);
-                    if (obuf) {
-                        obuf[strsize] = 0;
-                        if (f_read(pf, obuf, strsize, &br) != FR_OK || strsize != br) {
-                            brk1: vPortFree(obuf);
-                            brk2: vPortFree(buf);
-                            break;
-                        }
-                    }
-                }
-                posix_add_link(hash, buf, type, ohash, obuf, true);
-            }
-            f_close(pf);
-        }
-        vPortFree(pf);
-    	xTaskResumeAll();
+        extfs_unlock();
     }
     if (!ctx || ctx->pfiles) return;
     ctx->pfiles = new_array_v(alloc_file, dealloc_file, NULL);
@@ -667,20 +778,20 @@ int __in_hfa() __openat(int dfd, const char* _path, int flags, mode_t mode) {
     fd->path = path;
     pf->ctime = fatfs_to_time_t(fno.fdate, fno.ftime);
     uint32_t hash = get_hash(path);
+    extfs_lock();
     posix_link_t* lnk = lookup_exact(hash, path);
     pf->mode = lnk && lnk->type != 'H' ? lnk->desc.mode : (flags & O_CREAT ? (mode | S_IFREG) : fatfs_mode_to_posix(fno.fattrib));
     if (!lnk) {
-        vTaskSuspendAll();
         lnk = posix_add_link(hash, path, 'O', pf->mode, 0, false);
         if (!lnk) {
-            xTaskResumeAll();
+            extfs_unlock();
             f_close(pf);
             errno = ENOMEM;
             return -1;
         }
         FRESULT fr = append_to_extfs(lnk); // TODO:
-        xTaskResumeAll();
     }
+    extfs_unlock();
     errno = 0;
     return (int)n;
 }
@@ -935,6 +1046,43 @@ ex:
     return 0;
 }
 
+/* stdio descriptor of a pipeline stage: the pipe end from cmd_enter_helper() */
+static int std_pipe_read(FIL* pp, const FDESC* fd, void* buf, size_t count) {
+    if (fd->flags & O_NONBLOCK) {
+        int n = f_pipe_avail(pp);
+        if (n < 0) {
+            errno = 0;
+            return 0;
+        }
+        if (n == 0 && count) {
+            errno = EAGAIN;
+            return -1;
+        }
+    }
+    UINT br;
+    f_read(pp, buf, count, &br); // blocks for data; nothing read means the writer is gone
+    errno = 0;
+    return br;
+}
+
+static int std_pipe_write(FIL* pp, const FDESC* fd, const void* buf, size_t count) {
+    if (fd->flags & O_NONBLOCK) {
+        int n = f_pipe_avail(pp);
+        if (n == 0 && count) {
+            errno = EAGAIN;
+            return -1;
+        }
+        if (n > 0 && count > (size_t)n) count = n;
+    }
+    UINT bw;
+    if (f_write(pp, buf, count, &bw) != FR_OK && bw == 0) {
+        errno = EPIPE;
+        return -1;
+    }
+    errno = 0;
+    return bw;
+}
+
 int __in_hfa() __read(int fildes, void *buf, size_t count) {
     if (!buf) {
         errno = EFAULT;
@@ -953,6 +1101,8 @@ int __in_hfa() __read(int fildes, void *buf, size_t count) {
     }
     FIL* fp = fd->fp;
     if ((intptr_t)fp == STDIN_FILENO) {
+        FIL* pp = get_std_pipe(ctx, STDIN_FILENO);
+        if (pp) return std_pipe_read(pp, fd, buf, count);
         char *p = (char*)buf;
         size_t n = 0;
         while (n < count) {
@@ -1026,15 +1176,14 @@ e:
         goto nperm;
     }
     if ((intptr_t)fp <= STDERR_FILENO) {
-		// TODO: tune up tty
-		char* b = pvPortMalloc(count + 1);
-		if (!b) { errno = ENOMEM; return -1; }
-		memcpy(b, buf, count);
-		b[count] = 0;
-		gouta(b);
-		vPortFree(b);
+        FIL* pp = get_std_pipe(ctx, (intptr_t)fp);
+        if (pp) return std_pipe_write(pp, fd, buf, count);
+        /* Console: the whole buffer is one terminal burst (musl's
+         * __stdout_write -> __stdio_write -> __writev lands here) */
+        extern void goutn(const char* buf, size_t len);
+        goutn((const char*)buf, count);
         errno = 0;
-		return count;
+        return count;
     }
     if (!S_ISREG(fp->mode)) {
         errno = S_ISDIR(fp->mode) ? EISDIR : EINVAL;
@@ -1323,7 +1472,7 @@ inval:
             }
         }
     }
-    vTaskSuspendAll();
+    extfs_lock();
     uint32_t hash = get_hash(pathname);
     posix_link_t* rename_to = 0;
     uint32_t omode = posix_unlink(pathname, hash, &rename_to);
@@ -1333,22 +1482,25 @@ inval:
             fr = f_rename(pathname, rename_to->fname); if (fr != FR_OK) { goto err; }
             // new original, so cleanup 'H' related fields
             vPortFree(rename_to->hlink.ofname);
+            rename_to->type = 'O';
+            --links_hcnt;
             rename_to->desc.mode = omode;
             rename_to->desc.owner = 0;
+            extfs_flush(); // several entries changed
             goto ok;
         }
+        extfs_journal(0, hash, pathname);
     }
     fr = f_unlink(pathname);
     if (fr != FR_OK) {
 err:
-    	xTaskResumeAll();
+        extfs_unlock();
         __free(pathname);
         errno = map_ff_fresult_to_errno(fr);
         return -1;
     }
 ok:
-    extfs_flush();
-	xTaskResumeAll();
+    extfs_unlock();
     __free(pathname);
     errno = 0;
     return 0;
@@ -1361,34 +1513,50 @@ int __in_hfa() __renameat(int dfd1, const char * f1, int dfd2, const char * f2)
     }
     cmd_ctx_t* ctx = get_cmd_ctx();
     init_pfiles(ctx);
-    vTaskSuspendAll();
     char* path = __realpathat(dfd1, f1, 0, AT_SYMLINK_NOFOLLOW);
 	if (!path) { return -1; }
-    uint32_t hash = get_hash(path);
-    posix_link_t* lnk = lookup_exact(hash, path);
     char* path2 = __realpathat(dfd2, f2, 0, AT_SYMLINK_NOFOLLOW);
 	if (!path2) { __free(path); return -1; }
+    extfs_lock();
+    uint32_t hash = get_hash(path);
+    posix_link_t* lnk = lookup_exact(hash, path);
     /// TODO: POSIX rename() допускает переименование каталогов (если f2 указывает на существующий каталог, то поведение зависит от того, пуст ли он).
     FRESULT fr = f_rename(path, path2);
     if (fr != FR_OK) {
+        extfs_unlock();
         __free(path);
         __free(path2);
         errno = map_ff_fresult_to_errno(fr);
-    	xTaskResumeAll();
         return -1;
     }
     if (lnk) {
+        // re-key: out of the table under the old name, back in under the new
+        posix_link_t** slot = links_slot(hash, path);
+        links_remove(slot);
+        uint32_t hash2 = get_hash(path2);
+        slot = links_slot(hash2, path2);
+        if (*slot) {
+            posix_link_t* old = *slot;
+            links_remove(slot);
+            link_free(old);
+            slot = links_slot(hash2, path2);
+        }
+        char* fname = copy_str(path2);
         vPortFree(lnk->fname);
-        lnk->fname = path2;
-        lnk->hash = get_hash(path2);
-        if (lnk->type == 'O')
-            replace_orig(path, hash, lnk);
-        extfs_flush();
-    } else {
-        __free(path2);
+        lnk->fname = fname;
+        lnk->hash = hash2;
+        *slot = lnk;
+        ++posix_links_cnt;
+        if (lnk->type == 'H') ++links_hcnt;
+        if (lnk->type == 'O' && replace_orig(path, hash, lnk)) {
+            extfs_flush();
+        } else if (extfs_journal(0, hash, path) == FR_OK) {
+            extfs_journal(lnk, 0, 0);
+        }
     }
+    extfs_unlock();
+    __free(path2);
     __free(path);
-	xTaskResumeAll();
     errno = 0;
     return 0;
 }
@@ -1508,7 +1676,7 @@ long __in_hfa() __readlinkat(int fd, const char *restrict _path, char *restrict
     init_pfiles(ctx);
 	char* path = __realpathat(fd, _path, 0, AT_SYMLINK_FOLLOW);
 	if (!path) { return -1; }
-    if (!is_symlink(get_hash(path), path)) {
+    if (!is_symlink(path, get_hash(path))) {
         __free(path);
         errno = EINVAL;
         return -1;
@@ -1557,16 +1725,17 @@ int __in_hfa() __mkdirat(int dirfd, const char *pathname, mode_t mode) {
         return -1;
     }
     uint32_t hash = get_hash(path);
-    vTaskSuspendAll();
+    extfs_lock();
     mode &= ~ctx->umask;
-    posix_link_t* lnk = posix_add_link(hash, path, 'O', (mode | S_IFDIR), 0, true);
+    posix_link_t* lnk = posix_add_link(hash, path, 'O', (mode | S_IFDIR), 0, false);
+    __free(path);
     if (!lnk) {
-        xTaskResumeAll();
+        extfs_unlock();
         errno = ENOMEM;
         return -1;
     }
     fr = append_to_extfs(lnk); // todo
-    xTaskResumeAll();
+    extfs_unlock();
     errno = 0;
     return 0;
 }
@@ -1749,10 +1918,18 @@ int __fchmodat(int fd, const char* n, mode_t m, int fl)
         return -1; // errno already set
     }
     uint32_t h = get_hash(path);
+    extfs_lock();
     posix_link_t* lnk = lookup_exact(h, path);
     if (lnk) {
-        lnk->desc.mode = m;
-        FRESULT fr = extfs_flush();
+        if (lnk->type == 'H') { // the mode belongs to the original
+            lnk = lookup_exact(lnk->hlink.ohash, lnk->hlink.ofname);
+        }
+        FRESULT fr = FR_OK;
+        if (lnk) {
+            lnk->desc.mode = m;
+            fr = append_to_extfs(lnk);
+        }
+        extfs_unlock();
         __free(path);
         if (fr != FR_OK) {
             errno = EIO;
@@ -1761,16 +1938,15 @@ int __fchmodat(int fd, const char* n, mode_t m, int fl)
         errno = 0;
         return 0;
     }
-    vTaskSuspendAll();
-    lnk = posix_add_link(h, path, 'O', m, 0, true);
+    lnk = posix_add_link(h, path, 'O', m, 0, false);
+    __free(path);
     if (!lnk) {
-        xTaskResumeAll();
-        __free(path);
+        extfs_unlock();
         errno = ENOMEM;
         return -1;
     }
     FRESULT fr = append_to_extfs(lnk);
-    xTaskResumeAll();
+    extfs_unlock();
     if (fr != FR_OK) {
         errno = EIO;
         return -1;
@@ -17,8 +17,24 @@ void kbd_remove_stdin_waiter(TaskHandle_t th);
 void deliver_signals(cmd_ctx_t *ctx);
 extern volatile int __c; // keyboard.c
 
-static short poll_fd_events(int fd, short events)
+// stdio of a pipeline stage connected to a pipe
+static FIL* poll_fd_pipe(cmd_ctx_t *ctx, int fd)
 {
+    return fd >= 0 && fd <= 2 ? get_std_pipe(ctx, fd) : NULL;
+}
+
+static short poll_fd_events(cmd_ctx_t *ctx, int fd, short events)
+{
+    FIL *pp = poll_fd_pipe(ctx, fd);
+    if (pp) {
+        int n = f_pipe_avail(pp);
+        if (n < 0)
+            return fd == 0 ? POLLHUP : POLLERR;
+        if (n > 0 && (events & (fd == 0 ? POLLIN : POLLOUT)))
+            return events & (fd == 0 ? POLLIN : POLLOUT);
+        return 0;
+    }
+
     // stdin
     if (fd == 0) {
         short re = 0;
@@ -66,7 +82,7 @@ again:
             continue;
         }
 
-        short re = poll_fd_events(fds[i].fd, fds[i].events);
+        short re = poll_fd_events(ctx, fds[i].fd, fds[i].events);
         if (re) {
             fds[i].revents = re;
             ready++;
@@ -84,21 +100,29 @@ again:
     // 5. Перед блокировкой — сигналы
     deliver_signals(ctx);
 
+    TaskHandle_t me = xTaskGetCurrentTaskHandle();
     int wants_stdin = 0;
+    int pipe_ready = 0;
     for (nfds_t i = 0; i < nfds; ++i) {
-        if (fds[i].fd == 0 && (fds[i].events & POLLIN)) {
+        FIL *pp = poll_fd_pipe(ctx, fds[i].fd);
+        if (pp) {
+            // register first, then re-check: a change in between still wakes us
+            f_pipe_set_waiter(pp, me);
+            if (poll_fd_events(ctx, fds[i].fd, fds[i].events))
+                pipe_ready = 1;
+        } else if (fds[i].fd == 0 && (fds[i].events & POLLIN)) {
             wants_stdin = 1;
-            break;
         }
     }
 
-    TaskHandle_t me = xTaskGetCurrentTaskHandle();
     if (wants_stdin && !__c) {
         kbd_add_stdin_waiter(me);
     }
 
     // 6. Ожидание
-    if (timeout < 0) {
+    if (pipe_ready) {
+        // became ready while registering
+    } else if (timeout < 0) {
         ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
     } else {
         TickType_t ticks = pdMS_TO_TICKS(timeout);
@@ -110,6 +134,10 @@ again:
     if (wants_stdin) {
         kbd_remove_stdin_waiter(me);
     }
+    for (nfds_t i = 0; i < nfds; ++i) {
+        FIL *pp = poll_fd_pipe(ctx, fds[i].fd);
+        if (pp) f_pipe_set_waiter(pp, NULL);
+    }
 
     /* ЛОЖНОЕ ПРОБУЖДЕНИЕ:
        poll имеет право проснуться, но не имеет права
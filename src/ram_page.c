@@ -8,6 +8,8 @@
 #include "ram_page.h"
 #include "f_util.h"
 #include "ff.h"
+#include "diskio.h"
+#include "psram.h"
 #include <pico.h>
 #include <pico/stdlib.h>
 #include "graphics.h"
@@ -29,70 +31,269 @@ static char* _swap_pages_base = 0;
 static uint8_t* RAM = 0;
 static uint16_t* RAM_PAGES = 0;
 
+/* Dirty pages evicted before a batch write, and pages read after a
+ * sequential fault */
+#ifndef RAM_PAGE_WB_PAGES
+#define RAM_PAGE_WB_PAGES 8
+#endif
+#ifndef RAM_PAGE_READ_AHEAD
+#define RAM_PAGE_READ_AHEAD 4
+#endif
+
+/* First sector of the pagefile when f_expand() made it contiguous, so
+ * pages are read and written by raw LBA; 0 = through FatFs */
+static LBA_t vram_lba = 0;
+static BYTE vram_pdrv = 0;
+
 uint32_t swap_base_size() { return _swap_base_size; }
 uint32_t swap_page_size() { return _swap_page_size; }
 uint8_t* swap_base() { return RAM; }
 uint32_t swap_pages() { return _swap_pages; }
 uint16_t* swap_pages_base() { return RAM_PAGES; }
 
-static uint32_t get_ram_page_for(const uint32_t addr32);
+/* LBA page -> frame index: bucket heads plus a chain link per frame
+ * (0 ends a chain — frame 0 is never used), and the CLOCK referenced
+ * bits.  One allocation, sized in init_vram(). */
+static uint16_t* page_hash = 0;
+static uint16_t* page_next = 0;
+static uint8_t* page_ref = 0;
+static uint32_t page_hash_mask = 0;
+
+static uint16_t clock_hand = 1;
+static uint16_t last_ram_page = 0;
+static uint32_t last_lba_page = 0;
+static uint32_t last_seq_lba = 0;
+
+/* Write-back queue: evicted dirty pages are copied here (PSRAM) in
+ * eviction order and written out together when it fills, sorted by LBA
+ * page, with runs adjacent both on disk and here merged into one
+ * multi-sector write.  A hole (LBA 0) is a page faulted back in.  No
+ * PSRAM - pages are written on eviction as before. */
+static uint8_t* wb_buf = 0;
+static uint16_t wb_lba[RAM_PAGE_WB_PAGES];
+static uint8_t wb_count = 0;
+
+static uint16_t hash_find(uint32_t lba_page) {
+    register uint16_t ram_page = page_hash[lba_page & page_hash_mask];
+    while (ram_page && (RAM_PAGES[ram_page] & 0x7FFF) != lba_page) {
+        ram_page = page_next[ram_page];
+    }
+    return ram_page;
+}
+
+static void hash_insert(uint16_t ram_page, uint32_t lba_page) {
+    uint16_t* head = &page_hash[lba_page & page_hash_mask];
+    page_next[ram_page] = *head;
+    *head = ram_page;
+}
+
+static void hash_remove(uint16_t ram_page, uint32_t lba_page) {
+    uint16_t* link = &page_hash[lba_page & page_hash_mask];
+    while (*link && *link != ram_page) {
+        link = &page_next[*link];
+    }
+    if (*link) *link = page_next[ram_page];
+}
+
+// second chance: skip (and clear) frames used since the hand last passed
+static uint16_t clock_victim(void) {
+    for (;;) {
+        uint16_t ram_page = clock_hand;
+        if (++clock_hand >= _swap_pages) clock_hand = 1; // do not use first page (id == 0)
+        if (!page_ref[ram_page]) return ram_page;
+        page_ref[ram_page] = 0;
+    }
+}
+
+static int wb_find(uint32_t lba_page) {
+    for (int i = 0; i < wb_count; ++i) {
+        if (wb_lba[i] == lba_page) return i;
+    }
+    return -1;
+}
+
+static void wb_flush(void) {
+    uint8_t order[RAM_PAGE_WB_PAGES];
+    int n = 0;
+    for (int i = 0; i < wb_count; ++i) {
+        if (!wb_lba[i]) continue;
+        int j = n++;
+        for (; j > 0 && wb_lba[order[j - 1]] > wb_lba[i]; --j) {
+            order[j] = order[j - 1];
+        }
+        order[j] = (uint8_t)i;
+    }
+    for (int k = 0; k < n; ) {
+        int first = order[k], run = 1;
+        while (k + run < n && order[k + run] == first + run &&
+               wb_lba[order[k + run]] == wb_lba[first] + run) {
+            ++run;
+        }
+        flush_vram_block((const char*)wb_buf + (first << _swap_page_div),
+                         (uint32_t)wb_lba[first] << _swap_page_div, run << _swap_page_div);
+        k += run;
+    }
+    wb_count = 0;
+}
+
+/* Drop what frame ram_page holds; a dirty page is queued or written */
+static void evict_frame(uint16_t ram_page) {
+    uint16_t ram_page_desc = RAM_PAGES[ram_page];
+    // higest (15) bit is set, it means - the page has changes (RW page)
+    uint32_t old_lba_page = ram_page_desc & 0x7FFF; // 14-0 - max 32k keys for 4K LBA bloks
+    if (!old_lba_page) return;
+    hash_remove(ram_page, old_lba_page);
+    RAM_PAGES[ram_page] = 0;
+    if (!(ram_page_desc & 0x8000)) return; // RO page is just replaced
+    const uint8_t* frame = RAM + ((uint32_t)ram_page << _swap_page_div);
+#ifdef BOOT_DEBUG_ACC
+    goutf("2 RAM page 0x%X / VRAM page: 0x%X\n", ram_page, old_lba_page);
+#endif
+    if (!wb_buf) {
+        flush_vram_block((const char*)frame, old_lba_page << _swap_page_div, _swap_page_size);
+        return;
+    }
+    if (wb_count == RAM_PAGE_WB_PAGES) wb_flush();
+    memcpy(wb_buf + ((uint32_t)wb_count << _swap_page_div), frame, _swap_page_size);
+    wb_lba[wb_count++] = (uint16_t)old_lba_page;
+}
+
+/* Fetch up to RAM_PAGE_READ_AHEAD pages after lba_page into cold frames
+ * (referenced bit clear, so unused ones go first), one read per run of
+ * frames that are adjacent both in RAM and on disk */
+static void read_ahead(uint32_t lba_page) {
+    const uint32_t max_lba = _swap_size >> _swap_page_div;
+    uint32_t n = RAM_PAGE_READ_AHEAD;
+    if (n > _swap_pages - 2) n = _swap_pages - 2; // keep the faulting frame
+    uint16_t run_frame = 0;
+    uint32_t run_lba = 0, run = 0;
+    for (uint32_t k = 0; k < n; ++k, ++lba_page) {
+        if (lba_page > max_lba || hash_find(lba_page) || wb_find(lba_page) >= 0) break;
+        uint16_t ram_page = clock_victim();
+        if (ram_page == last_ram_page) break;
+        evict_frame(ram_page);
+        RAM_PAGES[ram_page] = lba_page;
+        hash_insert(ram_page, lba_page);
+        if (run && ram_page == run_frame + run && lba_page == run_lba + run) {
+            ++run;
+            continue;
+        }
+        if (run) {
+            read_vram_block((char*)RAM + ((uint32_t)run_frame << _swap_page_div),
+                            run_lba << _swap_page_div, run << _swap_page_div);
+        }
+        run_frame = ram_page;
+        run_lba = lba_page;
+        run = 1;
+    }
+    if (run) {
+        read_vram_block((char*)RAM + ((uint32_t)run_frame << _swap_page_div),
+                        run_lba << _swap_page_div, run << _swap_page_div);
+    }
+}
+
+static uint32_t get_ram_page_for(const uint32_t addr32) {
+    const register uint32_t lba_page = (addr32 >> _swap_page_div) + 1; // page idx
+    if (last_lba_page == lba_page) {
+        return last_ram_page;
+    }
+    // hits on the cached page above don't touch its bit; do it on leaving
+    page_ref[last_ram_page] = 1;
+    last_lba_page = lba_page;
+    // a scan through read-ahead pages keeps its place, so the fault just
+    // past them counts as sequential and prefetches the next window
+    const bool sequential = (lba_page == last_seq_lba + 1);
+    last_seq_lba = lba_page;
+    uint16_t ram_page = hash_find(lba_page);
+    if (ram_page) {
+        page_ref[ram_page] = 1;
+        last_ram_page = ram_page;
+#ifdef BOOT_DEBUG_ACC
+    goutf("VRAM page: 0x%X (ram_page: %X)\n", lba_page, ram_page);
+#endif
+        return ram_page;
+    }
+#ifdef BOOT_DEBUG_ACC
+    goutf("VRAM page: 0x%X\n", lba_page);
+#endif
+    ram_page = clock_victim();
+    evict_frame(ram_page);
+    uint8_t* frame = RAM + ((uint32_t)ram_page << _swap_page_div);
+    RAM_PAGES[ram_page] = lba_page;
+    hash_insert(ram_page, lba_page);
+    page_ref[ram_page] = 1;
+    last_ram_page = ram_page;
+    int wb = wb_find(lba_page);
+    if (wb >= 0) {
+        // still waiting to be written: take it back, it stays dirty
+        memcpy(frame, wb_buf + ((uint32_t)wb << _swap_page_div), _swap_page_size);
+        wb_lba[wb] = 0;
+        RAM_PAGES[ram_page] |= 0x8000;
+    } else {
+        read_vram_block((char*)frame, lba_page << _swap_page_div, _swap_page_size);
+    }
+    if (sequential) read_ahead(lba_page + 1);
+    return ram_page;
+}
+
+/* Frame address of addr32; the page is paged in if needed */
+inline static uint8_t* ram_page_ptr(uint32_t addr32) {
+    return RAM + (get_ram_page_for(addr32) << _swap_page_div) + (addr32 & _swap_page_mask);
+}
+
+/* Mark the page of the last ram_page_ptr() as changed - bit 15 */
+inline static void ram_page_dirty(void) {
+    RAM_PAGES[last_ram_page] |= 0x8000;
+}
+
+/* Frames are 4-byte aligned and at least 1K, so an aligned access never
+ * leaves its page; unaligned ones crossing a page go byte by byte. */
+#define CROSSES_PAGE(addr32, n) (((addr32) & _swap_page_mask) > _swap_page_mask - ((n) - 1))
 
 uint8_t ram_page_read(uint32_t addr32) {
-    const register uint32_t ram_page = get_ram_page_for(addr32);
-    const register uint32_t addr_in_page = addr32 & _swap_page_mask;
+    uint8_t res = *ram_page_ptr(addr32);
 #ifdef BOOT_DEBUG_ACC
-    uint8_t res = RAM[(ram_page * _swap_page_size) + addr_in_page];
     if (addr32 >= BOOT_DEBUG_ACC) {
         goutf("R %08X ->   %02X\n", addr32, res);
     }
-    return res;
-#else
-    return RAM[(ram_page * _swap_page_size) + addr_in_page];
 #endif
-}
-
-inline static uint16_t read16arr(uint8_t* arr, uint32_t base_addr, uint32_t addr32) {
-    register uint8_t* ptr = arr + addr32 - base_addr;
-    register uint16_t b1 = *ptr++;
-    register uint16_t b0 = *ptr;
-    return b1 | (b0 << 8);
+    return res;
 }
 
 uint16_t ram_page_read16(uint32_t addr32) {
-    const register uint32_t ram_page = get_ram_page_for(addr32);
-    const register uint32_t addr_in_page = addr32 & _swap_page_mask;
+    uint16_t res;
+    if (!(addr32 & 1)) {
+        res = *(const uint16_t*)ram_page_ptr(addr32);
+    } else if (!CROSSES_PAGE(addr32, 2)) {
+        const uint8_t* ptr = ram_page_ptr(addr32);
+        res = ptr[0] | (ptr[1] << 8);
+    } else {
+        res = ram_page_read(addr32) | (ram_page_read(addr32 + 1) << 8);
+    }
 #ifdef BOOT_DEBUG_ACC
-    uint16_t res = read16arr(RAM, 0, (ram_page * _swap_page_size) + addr_in_page);
     if (addr32 >= BOOT_DEBUG_ACC) {
         goutf("R %08X -> %04X\n", addr32, res);
     }
-    return res;
-#else
-    return read16arr(RAM, 0, (ram_page * _swap_page_size) + addr_in_page);
 #endif
-}
-
-inline static uint32_t read32arr(uint8_t* arr, uint32_t base_addr, uint32_t addr32) {
-    register uint8_t* ptr = arr + addr32 - base_addr;
-    register uint32_t b3 = *ptr++;
-    register uint32_t b2 = *ptr++;
-    register uint32_t b1 = *ptr++;
-    register uint32_t b0 = *ptr;
-    return b3 | (b2 << 8) | (b1 << 16) | (b0 << 24);
+    return res;
 }
 
 uint32_t ram_page_read32(uint32_t addr32) {
-    const register uint32_t ram_page = get_ram_page_for(addr32);
-    const register uint32_t addr_in_page = addr32 & _swap_page_mask;
+    uint32_t res;
+    if (!(addr32 & 3)) {
+        res = *(const uint32_t*)ram_page_ptr(addr32);
+    } else if (!CROSSES_PAGE(addr32, 4)) {
+        const uint8_t* ptr = ram_page_ptr(addr32);
+        res = ptr[0] | (ptr[1] << 8) | (ptr[2] << 16) | ((uint32_t)ptr[3] << 24);
+    } else {
+        res = ram_page_read16(addr32) | ((uint32_t)ram_page_read16(addr32 + 2) << 16);
+    }
 #ifdef BOOT_DEBUG_ACC
-    uint16_t res = read32arr(RAM, 0, (ram_page * _swap_page_size) + addr_in_page);
     if (addr32 >= BOOT_DEBUG_ACC) {
         goutf("R %08X -> %08X\n", addr32, res);
     }
-    return res;
-#else
-    return read32arr(RAM, 0, (ram_page * _swap_page_size) + addr_in_page);
 #endif
+    return res;
 }
 
 void ram_page_write(uint32_t addr32, uint8_t value) {
@@ -101,14 +302,8 @@ void ram_page_write(uint32_t addr32, uint8_t value) {
         goutf("W %08X <-   %02X\n", addr32, value);
     }
 #endif
-    register uint32_t ram_page = get_ram_page_for(addr32);
-    register uint32_t addr_in_page = addr32 & _swap_page_mask;
-    RAM[(ram_page * _swap_page_size) + addr_in_page] = value;
-    register uint16_t ram_page_desc = RAM_PAGES[ram_page];
-    if (!(ram_page_desc & 0x8000)) {
-        // if higest (15) bit is set, it means - the page has changes
-        RAM_PAGES[ram_page] = ram_page_desc | 0x8000; // mark it as changed - bit 15
-    }
+    *ram_page_ptr(addr32) = value;
+    ram_page_dirty();
 }
 
 void ram_page_write16(uint32_t addr32, uint16_t value) {
@@ -117,15 +312,17 @@ void ram_page_write16(uint32_t addr32, uint16_t value) {
         goutf("W %08X <- %04X\n", addr32, value);
     }
 #endif
-    register uint32_t ram_page = get_ram_page_for(addr32);
-    register uint32_t addr_in_page = addr32 & _swap_page_mask;
-    register uint8_t* addr_in_ram = RAM + ram_page * _swap_page_size + addr_in_page;
-    *addr_in_ram++     = (uint8_t) value;
-    *addr_in_ram       = (uint8_t)(value >> 8);
-    register uint16_t ram_page_desc = RAM_PAGES[ram_page];
-    if (!(ram_page_desc & 0x8000)) {
-        // if higest (15) bit is set, it means - the page has changes
-        RAM_PAGES[ram_page] = ram_page_desc | 0x8000; // mark it as changed - bit 15
+    if (!(addr32 & 1)) {
+        *(uint16_t*)ram_page_ptr(addr32) = value;
+        ram_page_dirty();
+    } else if (!CROSSES_PAGE(addr32, 2)) {
+        uint8_t* ptr = ram_page_ptr(addr32);
+        ptr[0] = (uint8_t) value;
+        ptr[1] = (uint8_t)(value >> 8);
+        ram_page_dirty();
+    } else {
+        ram_page_write(addr32, (uint8_t)value);
+        ram_page_write(addr32 + 1, (uint8_t)(value >> 8));
     }
 }
 
@@ -135,78 +332,20 @@ void ram_page_write32(uint32_t addr32, uint32_t value) {
         goutf("Q %08X <- %08X\n", addr32, value);
     }
 #endif
-    register uint32_t ram_page = get_ram_page_for(addr32);
-    register uint32_t addr_in_page = addr32 & _swap_page_mask;
-    register uint8_t* addr_in_ram = RAM + ram_page * _swap_page_size + addr_in_page;
-    *addr_in_ram++     = (uint8_t) value;
-    *addr_in_ram++     = (uint8_t)(value >> 8);
-    *addr_in_ram++     = (uint8_t)(value >> 16);
-    *addr_in_ram       = (uint8_t)(value >> 24);
-    register uint16_t ram_page_desc = RAM_PAGES[ram_page];
-    if (!(ram_page_desc & 0x8000)) {
-        // if higest (15) bit is set, it means - the page has changes
-        RAM_PAGES[ram_page] = ram_page_desc | 0x8000; // mark it as changed - bit 15
-    }
-}
-
-static uint16_t oldest_ram_page = 1;
-static uint16_t last_ram_page = 0;
-static uint32_t last_lba_page = 0;
-
-static uint32_t get_ram_page_for(const uint32_t addr32) {
-    const register uint32_t lba_page = (addr32 >> _swap_page_div) + 1; // page idx
-    if (last_lba_page == lba_page) {
-        return last_ram_page;
-    }
-    last_lba_page = lba_page;
-    for (register uint32_t ram_page = 1; ram_page < _swap_pages; ++ram_page) {
-        register uint16_t ram_page_desc = RAM_PAGES[ram_page];
-        register uint16_t lba_page_in_ram = ram_page_desc & 0x7FFF; // 14-0 - max 32k keys for 4K LBA bloks
-        if (lba_page_in_ram == lba_page) {
-            last_ram_page = ram_page;
-#ifdef BOOT_DEBUG_ACC
-    goutf("VRAM page: 0x%X (ram_page: %X)\n", lba_page, ram_page);
-#endif
-            return ram_page;
-        }
-    }
-#ifdef BOOT_DEBUG_ACC
-    goutf("VRAM page: 0x%X\n", lba_page);
-#endif
-    // rolling page usage
-    uint16_t ram_page = oldest_ram_page++;
-    if (oldest_ram_page >= _swap_pages - 1) oldest_ram_page = 1; // do not use first page (id == 0)
-    uint16_t ram_page_desc = RAM_PAGES[ram_page];
-    bool ro_page_was_found = !(ram_page_desc & 0x8000);
-    // higest (15) bit is set, it means - the page has changes (RW page)
-    uint32_t old_lba_page = ram_page_desc & 0x7FFF; // 14-0 - max 32k keys for 4K LBA bloks
-    RAM_PAGES[ram_page] = lba_page;
-    if (ro_page_was_found) {
-        // just replace RO page (faster than RW flush to sdcard)
-#ifdef BOOT_DEBUG_ACC
-        goutf("1 RAM page 0x%X / VRAM page: 0x%X\n", ram_page, lba_page);
-#endif
-        uint32_t ram_page_offset = ((uint32_t)ram_page) * _swap_page_size;
-        uint32_t lba_page_offset = lba_page * _swap_page_size;
-        read_vram_block(RAM + ram_page_offset, lba_page_offset, _swap_page_size);
-        last_ram_page = ram_page;
-        return ram_page;
+    if (!(addr32 & 3)) {
+        *(uint32_t*)ram_page_ptr(addr32) = value;
+        ram_page_dirty();
+    } else if (!CROSSES_PAGE(addr32, 4)) {
+        uint8_t* ptr = ram_page_ptr(addr32);
+        ptr[0] = (uint8_t) value;
+        ptr[1] = (uint8_t)(value >> 8);
+        ptr[2] = (uint8_t)(value >> 16);
+        ptr[3] = (uint8_t)(value >> 24);
+        ram_page_dirty();
+    } else {
+        ram_page_write16(addr32, (uint16_t)value);
+        ram_page_write16(addr32 + 2, (uint16_t)(value >> 16));
     }
-    // Lets flush found RW page to sdcard
-#ifdef BOOT_DEBUG_ACC
-    goutf("2 RAM page 0x%X / VRAM page: 0x%X\n", ram_page, lba_page);
-#endif
-    uint32_t ram_page_offset = ram_page * _swap_page_size;
-    uint32_t lba_page_offset = old_lba_page * _swap_page_size;
-#ifdef BOOT_DEBUG_ACC
-    goutf("2 RAM offs 0x%X / VRAM offs: 0x%X\n", ram_page_offset, lba_page_offset);
-#endif
-    flush_vram_block(RAM + ram_page_offset, lba_page_offset, _swap_page_size);
-    // use new page:
-    lba_page_offset = lba_page * _swap_page_size;
-    read_vram_block(RAM + ram_page_offset, lba_page_offset, _swap_page_size);
-    last_ram_page = ram_page;
-    return ram_page;
 }
 
 uint32_t swap_size() {
@@ -279,21 +418,62 @@ uint32_t __in_hfa() init_vram(char* cfg_in) { // "/mos2/pagefile.sys 8M 128K 4K"
             _swap_page_div = 11;
             break;
     }
-    if (!_swap_base_size || !_swap_size || _swap_size < _swap_base_size) {
-        return 0;
+    if (!_swap_base_size || !_swap_size || _swap_size < _swap_base_size ||
+        _swap_base_size < 2 * _swap_page_size) { // frame 0 is not used
+        _swap_size = 0;
+        goto e;
     }
     _swap_pages = _swap_base_size / _swap_page_size;
+    if (page_hash) vPortFree(page_hash);
+    uint32_t buckets = 16;
+    while (buckets < _swap_pages) buckets <<= 1;
+    size_t index_sz = (buckets + _swap_pages) * sizeof(uint16_t) + _swap_pages;
     _swap_pages_base = (uint16_t*)pvPortMalloc((_swap_pages << 1) + 3);
     _swap_base = (uint8_t*)pvPortMalloc(_swap_base_size + 3);
+    page_hash = (uint16_t*)pvPortMalloc(index_sz);
+    if (!_swap_pages_base || !_swap_base || !page_hash) {
+        goutf("Not enough memory for %d KB of swap frames\n", _swap_base_size >> 10);
+        if (_swap_pages_base) vPortFree(_swap_pages_base);
+        if (_swap_base) vPortFree(_swap_base);
+        if (page_hash) vPortFree(page_hash);
+        _swap_pages_base = 0;
+        _swap_base = 0;
+        page_hash = 0;
+        RAM = 0;
+        RAM_PAGES = 0;
+        _swap_size = 0;
+        goto e;
+    }
     RAM = (uint8_t*)((uint32_t)(_swap_base + 3) & 0xFFFFFFFC);
     RAM_PAGES = (uint16_t*)((uint32_t)(_swap_pages_base + 3) & 0xFFFFFFFC);
     memset(RAM, 0, _swap_base_size);
     memset(RAM_PAGES, 0, _swap_pages << 1);
 
+    memset(page_hash, 0, index_sz);
+    page_next = page_hash + buckets;
+    page_ref = (uint8_t*)(page_next + _swap_pages);
+    page_hash_mask = buckets - 1;
+    clock_hand = 1;
+    last_ram_page = 0;
+    last_lba_page = 0;
+    last_seq_lba = 0;
+
+    if (wb_buf) psram_free(wb_buf);
+    wb_buf = (uint8_t*)psram_alloc(RAM_PAGE_WB_PAGES * _swap_page_size);
+    wb_count = 0;
+
     f_unlink(path); // ensure it is new file
+    // LBA page 0 is never used, page N is at offset N * page size
+    FSIZE_t file_size = (FSIZE_t)_swap_size + _swap_page_size;
+    vram_lba = 0;
     FRESULT result = f_open(&file, path, FA_WRITE | FA_CREATE_ALWAYS);
-    if (result == FR_OK) {
-        result = f_lseek(&file, _swap_size - 1);
+    if (result == FR_OK && f_expand(&file, file_size, 1) == FR_OK) {
+        // contiguous: address it by sector, no FAT chain walks
+        FATFS* fs = file.obj.fs;
+        vram_pdrv = fs->pdrv;
+        vram_lba = fs->database + (LBA_t)fs->csize * (file.obj.sclust - 2);
+    } else if (result == FR_OK) {
+        result = f_lseek(&file, file_size - 1);
         if (result != FR_OK) {
             goutf("Unable to init %s\n", path);
             _swap_size = 0;
@@ -343,6 +523,14 @@ void read_vram_block(char* dst, uint32_t file_offset, uint32_t sz) {
 #ifdef BOOT_DEBUG_ACC
     goutf("Read  pagefile 0x%X<-0x%X\n", dst, file_offset);
 #endif
+    if (vram_lba) {
+        DRESULT dr = disk_read(vram_pdrv, (BYTE*)dst, vram_lba + file_offset / FF_MIN_SS, sz / FF_MIN_SS);
+        if (dr != RES_OK) {
+            goutf("Failed to read pagefile sectors (%d)\n", dr);
+        }
+        gpio_put(PICO_DEFAULT_LED_PIN, false);
+        return;
+    }
     FRESULT result = vram_seek(&file, file_offset);
     if (result != FR_OK) {
         return;
@@ -361,6 +549,14 @@ void flush_vram_block(const char* src, uint32_t file_offset, uint32_t sz) {
    //     sprintf(tmp, "Flush pagefile 0x%X->0x%X", src, file_offset);
    //     logMsg(tmp);
    // }
+    if (vram_lba) {
+        DRESULT dr = disk_write(vram_pdrv, (const BYTE*)src, vram_lba + file_offset / FF_MIN_SS, sz / FF_MIN_SS);
+        if (dr != RES_OK) {
+            goutf("Failed to write pagefile sectors (%d)\n", dr);
+        }
+        gpio_put(PICO_DEFAULT_LED_PIN, false);
+        return;
+    }
     FRESULT result = vram_seek(&file, file_offset);
     if (result != FR_OK) {
         return;
@@ -0,0 +1,203 @@
+/*
+ * FRANK OS
+ * Copyright (c) 2026 Mikhail Matveev <xtreme@rh1.tech>
+ * https://rh1.tech
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "raster4.h"
+#include "display.h"
+
+/*==========================================================================
+ * Glyph expansion tables
+ *
+ * Each entry is the nibble mask for 8 pixels as stored in one
+ * little-endian word: pixel 2k is the high nibble of byte k, pixel 2k+1
+ * the low nibble.  Built at compile time so the tables live in flash.
+ *=========================================================================*/
+
+#define R4_PX(b, bit, m)  (((b) & (bit)) ? (m) : 0u)
+
+#define R4_LSB(b) (R4_PX(b, 0x01, 0x000000F0u) | R4_PX(b, 0x02, 0x0000000Fu) | \
+                   R4_PX(b, 0x04, 0x0000F000u) | R4_PX(b, 0x08, 0x00000F00u) | \
+                   R4_PX(b, 0x10, 0x00F00000u) | R4_PX(b, 0x20, 0x000F0000u) | \
+                   R4_PX(b, 0x40, 0xF0000000u) | R4_PX(b, 0x80, 0x0F000000u))
+
+#define R4_MSB(b) (R4_PX(b, 0x80, 0x000000F0u) | R4_PX(b, 0x40, 0x0000000Fu) | \
+                   R4_PX(b, 0x20, 0x0000F000u) | R4_PX(b, 0x10, 0x00000F00u) | \
+                   R4_PX(b, 0x08, 0x00F00000u) | R4_PX(b, 0x04, 0x000F0000u) | \
+                   R4_PX(b, 0x02, 0xF0000000u) | R4_PX(b, 0x01, 0x0F000000u))
+
+#define R4_X4(M, b)   M(b), M((b) + 1), M((b) + 2), M((b) + 3)
+#define R4_X16(M, b)  R4_X4(M, b), R4_X4(M, (b) + 4), \
+                      R4_X4(M, (b) + 8), R4_X4(M, (b) + 12)
+#define R4_X64(M, b)  R4_X16(M, b), R4_X16(M, (b) + 16), \
+                      R4_X16(M, (b) + 32), R4_X16(M, (b) + 48)
+#define R4_X256(M)    R4_X64(M, 0), R4_X64(M, 64), \
+                      R4_X64(M, 128), R4_X64(M, 192)
+
+const uint32_t r4_glyph_lsb[256] = { R4_X256(R4_LSB) };
+const uint32_t r4_glyph_msb[256] = { R4_X256(R4_MSB) };
+
+/*==========================================================================
+ * Spans
+ *=========================================================================*/
+
+void r4_span(uint8_t *row, int x0, int x1, uint8_t color) {
+    if (x0 >= x1) return;
+    color &= 0x0F;
+
+    /* Odd edges: a single nibble each */
+    if (x0 & 1) {
+        uint8_t *p = &row[x0 >> 1];
+        *p = (*p & 0xF0) | color;
+        x0++;
+    }
+    if (x1 & 1) {
+        x1--;
+        uint8_t *p = &row[x1 >> 1];
+        *p = (*p & 0x0F) | (uint8_t)(color << 4);
+    }
+
+    uint8_t *p = row + (x0 >> 1);
+    uint8_t *e = row + (x1 >> 1);
+    uint8_t  f8 = (uint8_t)(color * 0x11);
+    uint32_t fw = r4_fill_word(color);
+
+    if (e - p < 4) {
+        while (p < e)
+            *p++ = f8;
+        return;
+    }
+
+    /* Unaligned words cover the ragged ends (overlapping the aligned
+     * body is harmless — same value), so short spans need no byte loop */
+    r4_store32(p, fw);
+    r4_store32(e - 4, fw);
+    p = (uint8_t *)(((uintptr_t)p + 4) & ~(uintptr_t)3);
+    e -= 4;
+    while (e - p >= 16) {
+        r4_store32(p,      fw);
+        r4_store32(p + 4,  fw);
+        r4_store32(p + 8,  fw);
+        r4_store32(p + 12, fw);
+        p += 16;
+    }
+    while (p < e) {
+        r4_store32(p, fw);
+        p += 4;
+    }
+}
+
+void r4_fill(uint8_t *fb, int x0, int y0, int x1, int y1, uint8_t color) {
+    uint8_t *row = fb + y0 * FB_STRIDE;
+    for (int y = y0; y < y1; y++, row += FB_STRIDE)
+        r4_span(row, x0, x1, color);
+}
+
+/*==========================================================================
+ * Dithered fill — checkerboard, one nibble of every byte per row
+ *=========================================================================*/
+
+static inline void merge8(uint8_t *p, uint8_t m, uint8_t f) {
+    *p = (uint8_t)((*p & ~m) | (f & m));
+}
+
+void r4_fill_dither(uint8_t *fb, int x0, int y0, int x1, int y1,
+                    uint8_t color) {
+    if (x0 >= x1) return;
+    uint8_t  f8 = (uint8_t)((color & 0x0F) * 0x11);
+    uint32_t fw = r4_fill_word(color);
+    uint8_t *row = fb + y0 * FB_STRIDE;
+
+    for (int y = y0; y < y1; y++, row += FB_STRIDE) {
+        /* (x + y) odd: odd x (low nibbles) on even rows, even x (high
+         * nibbles) on odd rows */
+        uint8_t  m  = (y & 1) ? 0xF0 : 0x0F;
+        uint32_t mw = (uint32_t)m * 0x01010101u;
+        int a = x0, b = x1;
+
+        if (a & 1) {
+            merge8(&row[a >> 1], m & 0x0F, f8);
+            a++;
+        }
+        if (b & 1) {
+            b--;
+            merge8(&row[b >> 1], m & 0xF0, f8);
+        }
+
+        uint8_t *p = row + (a >> 1);
+        uint8_t *e = row + (b >> 1);
+        while (p < e && ((uintptr_t)p & 3))
+            merge8(p++, m, f8);
+        while (e - p >= 4) {
+            uint32_t w;
+            memcpy(&w, p, 4);
+            r4_store32(p, (w & ~mw) | (fw & mw));
+            p += 4;
+        }
+        while (p < e)
+            merge8(p++, m, f8);
+    }
+}
+
+/*==========================================================================
+ * Vertical line — one nibble per row, mask and colour hoisted
+ *=========================================================================*/
+
+void r4_vline(uint8_t *fb, int x, int y0, int y1, uint8_t color) {
+    color &= 0x0F;
+    uint8_t *p    = fb + y0 * FB_STRIDE + (x >> 1);
+    uint8_t  keep = (x & 1) ? 0xF0 : 0x0F;
+    uint8_t  set  = (x & 1) ? color : (uint8_t)(color << 4);
+    for (int y = y0; y < y1; y++, p += FB_STRIDE)
+        *p = (*p & keep) | set;
+}
+
+/*==========================================================================
+ * Masked blit — packed 4bpp pixels through a 1bpp mask (icons)
+ *=========================================================================*/
+
+void r4_blit_masked(uint8_t *row, int x, const uint8_t *pix,
+                    const uint8_t *mask, int w) {
+    uint8_t *p = row + (x >> 1);
+    int groups = w >> 3;
+
+    if (!(x & 1)) {
+        for (int g = 0; g < groups; g++, p += 4, pix += 4) {
+            uint8_t m = mask[g];
+            if (!m) continue;
+            uint32_t s;
+            memcpy(&s, pix, 4);
+            if (m == 0xFF) {
+                r4_store32(p, s);
+                continue;
+            }
+            uint32_t d;
+            memcpy(&d, p, 4);
+            r4_store32(p, r4_glyph_word(r4_glyph_msb[m], s, d));
+        }
+        return;
+    }
+
+    /* Odd x: every pixel moves one nibble right.  Within a word the low
+     * nibble of byte k becomes the high nibble of byte k+1 and the high
+     * nibble becomes the low one; byte 3's low nibble carries into the
+     * next word and the last pixel of the row lands in a byte of its own. */
+    uint32_t cs = 0, cm = 0;
+    for (int g = 0; g < groups; g++, p += 4, pix += 4) {
+        uint32_t s, mw = r4_glyph_msb[mask[g]];
+        memcpy(&s, pix, 4);
+        uint32_t ss = ((s  & 0x0F0F0F0Fu) << 12) | ((s  >> 4) & 0x0F0F0F0Fu) | cs;
+        uint32_t sm = ((mw & 0x0F0F0F0Fu) << 12) | ((mw >> 4) & 0x0F0F0F0Fu) | cm;
+        cs = (s  >> 20) & 0xF0;
+        cm = (mw >> 20) & 0xF0;
+        if (!sm) continue;
+        uint32_t d;
+        memcpy(&d, p, 4);
+        r4_store32(p, r4_glyph_word(sm, ss, d));
+    }
+    if (cm)
+        merge8(p, (uint8_t)cm, (uint8_t)cs);
+}
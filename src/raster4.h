@@ -0,0 +1,67 @@
+/*
+ * FRANK OS
+ * Copyright (c) 2026 Mikhail Matveev <xtreme@rh1.tech>
+ * https://rh1.tech
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef RASTER4_H
+#define RASTER4_H
+
+#include <stdint.h>
+#include <string.h>
+
+/* ======================================================================
+ * 4bpp raster kernels (640x480x16 pair-encoded framebuffer)
+ *
+ * Work on 32-bit words wherever possible: a word holds 8 pixels, with
+ * pixel 0 in the high nibble of the lowest-addressed byte (little-endian
+ * word bits 4..7).  No clipping or mode checks — callers clip to
+ * display_clip and only use these when display_bpp == 4.
+ * Pixel ranges are half-open [x0, x1).
+ * ====================================================================== */
+
+/* Replicate a 4-bit colour into every nibble of a word */
+static inline uint32_t r4_fill_word(uint8_t color) {
+    return (uint32_t)(color & 0x0F) * 0x11111111u;
+}
+
+/* Single 32-bit store, alignment not required (one STR on Cortex-M33) */
+static inline void r4_store32(uint8_t *p, uint32_t w) {
+    memcpy(p, &w, 4);
+}
+
+/* Glyph row expansion: 8 font bits -> nibble mask for 8 pixels.
+ * lsb: bit 0 = leftmost pixel (8x8 / 8x16 fonts)
+ * msb: bit 7 = leftmost pixel (UI fonts) */
+extern const uint32_t r4_glyph_lsb[256];
+extern const uint32_t r4_glyph_msb[256];
+
+/* Merge fg/bg words through a glyph mask */
+static inline uint32_t r4_glyph_word(uint32_t mask, uint32_t fgw,
+                                     uint32_t bgw) {
+    return bgw ^ ((fgw ^ bgw) & mask);
+}
+
+/* Solid span on one framebuffer row (row = start of the row) */
+void r4_span(uint8_t *row, int x0, int x1, uint8_t color);
+
+/* Solid rectangle [x0,x1) x [y0,y1) */
+void r4_fill(uint8_t *fb, int x0, int y0, int x1, int y1, uint8_t color);
+
+/* 50% checkerboard: sets pixels where (x + y) is odd, leaves the rest */
+void r4_fill_dither(uint8_t *fb, int x0, int y0, int x1, int y1,
+                    uint8_t color);
+
+/* Vertical line at x over [y0, y1) */
+void r4_vline(uint8_t *fb, int x, int y0, int y1, uint8_t color);
+
+/* Masked blit of w pixels (a multiple of 8) at x on one row, any x.
+ * pix holds packed pixels in framebuffer order, mask one bit per pixel
+ * (bit 7 = leftmost, 1 = draw).  8 pixels per word; fully opaque words
+ * are plain stores and fully transparent ones are skipped. */
+void r4_blit_masked(uint8_t *row, int x, const uint8_t *pix,
+                    const uint8_t *mask, int w);
+
+#endif
@@ -11,10 +11,14 @@
 #include "app.h"
 #include "cmd.h"
 #include "elf32.h"
+#include "fxe.h"
 #include "FreeRTOS.h"
 #include "task.h"
 #include "sdcard_init.h"
 #include "ff.h"
+#include "psram.h"
+#include "swap.h"
+#include "window_event.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -58,7 +62,8 @@ static void cmd_help(int argc, char **argv) {
     terminal_puts(t, "  cd <dir>   - change directory\n");
     terminal_puts(t, "  pwd        - print working directory\n");
     terminal_puts(t, "  clear      - clear screen\n");
-    terminal_puts(t, "  free       - show heap info\n");
+    terminal_puts(t, "  free [-v]  - show heap info (-v: PSRAM size classes)\n");
+    terminal_puts(t, "  ps         - list tasks, app stack slots, UI wakeups\n");
     terminal_puts(t, "  mount      - retry SD card mount\n");
     terminal_puts(t, "  help       - this message\n");
     terminal_puts(t, "  reboot     - reboot system\n");
@@ -71,13 +76,72 @@ static void cmd_clear(int argc, char **argv) {
 }
 
 static void cmd_free_cmd(int argc, char **argv) {
-    (void)argc; (void)argv;
     terminal_t *t = my_term();
     size_t free_sz = xPortGetFreeHeapSize();
     size_t total = configTOTAL_HEAP_SIZE;
     terminal_printf(t, "Heap: %u / %u bytes free (%u%% used)\n",
                     (unsigned)free_sz, (unsigned)total,
                     (unsigned)((total - free_sz) * 100 / total));
+
+    psram_stats_t ps;
+    psram_get_stats(&ps);
+    if (!ps.total_bytes) return;
+    terminal_printf(t, "PSRAM: %u / %u bytes free, largest block %u\n",
+                    (unsigned)ps.free_bytes, (unsigned)ps.total_bytes,
+                    (unsigned)ps.largest_free);
+    if (argc < 2 || strcmp(argv[1], "-v") != 0) return;
+    terminal_puts(t, "  class      allocs     frees  fail  used  free\n");
+    for (int k = 0; k < PSRAM_NCLASSES; k++) {
+        const psram_class_stats_t *c = &ps.classes[k];
+        if (!c->allocs && !c->free_blocks && !c->failures) continue;
+        terminal_printf(t, "  %8lu %9u %9u %5u %5u %5u\n",
+                        1ul << k, (unsigned)c->allocs, (unsigned)c->frees,
+                        (unsigned)c->failures, (unsigned)c->in_use,
+                        (unsigned)c->free_blocks);
+    }
+}
+
+/* App stack slot and UI task wakeup counters, printed after the task
+ * list of /mos2/ps */
+static void cmd_ps_slots(void) {
+    terminal_t *t = my_term();
+    swap_stats_t st;
+    swap_get_stats(&st);
+    terminal_printf(t, "Stack slots: %u/%u in use, %u allocated, "
+                    "%u tasks outside\n",
+                    (unsigned)st.in_use, (unsigned)st.slots,
+                    (unsigned)st.allocated, (unsigned)st.no_slot);
+    terminal_printf(t, "Switches: %u suspends, %u resumes (%u in place), "
+                    "%u spills, %u restores, %u KB copied\n",
+                    (unsigned)st.suspends, (unsigned)st.resumes,
+                    (unsigned)st.resident, (unsigned)st.spills,
+                    (unsigned)st.restores,
+                    (unsigned)((st.bytes_copied + 1023) / 1024));
+
+    wm_wake_stats_t ws;
+    wm_get_wake_stats(&ws);
+    unsigned secs = (unsigned)(ws.ticks / configTICK_RATE_HZ);
+    if (!secs) secs = 1;
+    terminal_printf(t, "Wakeups: compositor %u (%u timeouts), "
+                    "input %u (%u timeouts), %u/s over %u s\n",
+                    (unsigned)ws.comp_wakeups, (unsigned)ws.comp_timeouts,
+                    (unsigned)ws.input_wakeups, (unsigned)ws.input_timeouts,
+                    (unsigned)((ws.comp_wakeups + ws.comp_timeouts +
+                                ws.input_wakeups + ws.input_timeouts) / secs),
+                    secs);
+}
+
+/* True for <app>.fxe next to its <app> — the pre-linked image the
+ * loader keeps, not something the user put there */
+static bool is_fxe_companion(const char *dir, const char *name) {
+    const char *dot = strrchr(name, '.');
+    if (!dot || dot == name || strcmp(dot, FXE_EXT) != 0) return false;
+    char base[256];
+    FILINFO fno;
+    snprintf(base, sizeof(base), "%s%s%.*s", dir,
+             dir[0] && dir[strlen(dir) - 1] == '/' ? "" : "/",
+             (int)(dot - name), name);
+    return f_stat(base, &fno) == FR_OK;
 }
 
 static void cmd_ls(int argc, char **argv) {
@@ -109,6 +173,7 @@ static void cmd_ls(int argc, char **argv) {
             break;
         }
         if (fno.fname[0] == 0) break;
+        if (is_fxe_companion(path, fno.fname)) continue;
         if (fno.fattrib & AM_DIR) {
             terminal_printf(t, "  [%s]\n", fno.fname);
         } else {
@@ -450,6 +515,9 @@ static void shell_task(void *pv) {
             cmd_mount(argc, argv);
         } else if (strcmp(argv[0], "reboot") == 0) {
             cmd_reboot(argc, argv);
+        } else if (strcmp(argv[0], "ps") == 0) {
+            shell_run_elf(t, argc, argv);
+            cmd_ps_slots();
         } else {
             /* Try to run as ELF from SD card */
             shell_run_elf(t, argc, argv);
@@ -3,10 +3,11 @@
  * Copyright (c) 2026 Mikhail Matveev <xtreme@rh1.tech>
  * https://rh1.tech
  *
- * Multi-channel ring-buffer mixer with nearest-neighbour resampling.
+ * Multi-channel ring-buffer mixer with linear-interpolation resampling.
  * The DMA IRQ handler reads all active channels, resamples to 44100 Hz,
- * mixes (sum + clamp), and fills the DMA ping-pong buffer.  Playback is
- * completely decoupled from task scheduling.
+ * applies per-channel gain and pan, mixes (sum + saturate), and fills the
+ * DMA ping-pong buffer.  Playback is completely decoupled from task
+ * scheduling.
  *
  * SPDX-License-Identifier: GPL-3.0-or-later
  */
@@ -22,21 +23,30 @@
 #include "hardware/sync.h"
 #include "FreeRTOS.h"
 #include "task.h"
+#include "psram.h"
 
 /* DMA chunk size in stereo frames — IRQ fires every ~23 ms at 44100 Hz */
 #define SND_DMA_FRAMES   1024
 
-/* Per-channel ring buffer size (must be power of 2) */
+/* Default per-channel ring buffer size (must be power of 2) */
 #define SND_CHAN_FRAMES   2048
-#define SND_CHAN_MASK     (SND_CHAN_FRAMES - 1)
+
+/* Re-check period of a writer waiting for ring space */
+#define SND_WAIT          pdMS_TO_TICKS(50)
 
 typedef struct {
-    int16_t  buf[SND_CHAN_FRAMES * 2];  /* stereo L/R interleaved, 8 KB */
+    int16_t *buf;                       /* stereo L/R interleaved, size + span frames */
+    uint32_t size;                      /* ring frames (power of 2) */
+    uint32_t mask;
+    uint32_t span;                      /* frames past the end snd_acquire() may hand out */
+    bool     own_buf;                   /* buf allocated by snd_open_ring() */
     volatile uint32_t rd;               /* read position  (IRQ increments) */
     volatile uint32_t wr;               /* write position (task increments) */
+    TaskHandle_t volatile writer;       /* task waiting for space */
     uint32_t rate;                      /* source sample rate */
     uint32_t phase;                     /* fixed-point resampling accumulator */
     uint32_t phase_inc;                 /* (source_rate << 16) / 44100 */
+    volatile uint32_t gain;             /* L gain | R gain << 16, SND_GAIN_UNITY = 1 */
     int16_t  hold_l;                    /* last output sample (sample-and-hold) */
     int16_t  hold_r;
     bool     active;
@@ -44,6 +54,9 @@ typedef struct {
 
 static snd_channel_t channels[SND_MAX_CHANNELS];
 
+/* Rings of channels opened with snd_open(), 8 KB each */
+static int16_t chan_bufs[SND_MAX_CHANNELS][SND_CHAN_FRAMES * 2];
+
 /* Global volume as right-shift (0 = max, 4 = mute).
  * Volatile because snd_fill_dma reads it from DMA IRQ context
  * while snd_set_volume writes it from task context. */
@@ -51,6 +64,111 @@ static volatile uint8_t snd_volume = 0;
 
 static i2s_config_t snd_i2s_config;
 
+/*==========================================================================
+ * Mixer
+ *
+ * A DMA buffer is mixed in blocks of SND_MIX_FRAMES: every active channel
+ * is resampled and scaled by its gain into a 32-bit accumulator in one
+ * pass, then the block is shifted by the global volume, saturated and
+ * packed into the buffer.  A channel at 44100 Hz on a whole-frame phase
+ * takes its frames straight off the ring.
+ *==========================================================================*/
+#define SND_MIX_FRAMES  256
+
+#if defined(__ARM_FEATURE_SAT)
+#include <arm_acle.h>
+#define SAT16(x)  __ssat((x), 16)     /* SSAT */
+#else
+static inline int32_t SAT16(int32_t x) {
+    return x > 32767 ? 32767 : x < -32768 ? -32768 : x;
+}
+#endif
+
+static int32_t mix_acc[SND_MIX_FRAMES * 2];
+static snd_stats_t snd_stats;
+
+/* Add n output frames of c to acc.  avail: source frames in the ring at
+ * the start of this fill.  Returns the frames it had to hold. */
+static uint32_t __not_in_flash_func(mix_channel)(snd_channel_t *c,
+                                                  uint32_t avail,
+                                                  int32_t *acc,
+                                                  uint32_t n) {
+    /* A stereo frame is one word: L in the low half, R in the high one */
+    typedef uint32_t __attribute__((may_alias)) frame_t;
+    const frame_t *ring = (const frame_t *)c->buf;
+    uint32_t mask  = c->mask;
+    uint32_t rd    = c->rd;
+    uint32_t phase = c->phase;
+    uint32_t inc   = c->phase_inc;
+    uint32_t gain  = c->gain;
+    int32_t  gl    = (int32_t)(gain & 0xFFFF);
+    int32_t  gr    = (int32_t)(gain >> 16);
+    uint32_t i     = 0;
+
+    if (inc == 1u << 16 && !(phase & 0xFFFF)) {
+        uint32_t idx = phase >> 16;
+        uint32_t run = idx < avail ? avail - idx : 0;
+        if (run > n) run = n;
+        for (; i < run; i++) {
+            uint32_t w = ring[(rd + idx + i) & mask];
+            acc[i * 2]     += (int16_t)w * gl;
+            acc[i * 2 + 1] += (int16_t)(w >> 16) * gr;
+        }
+        if (run) {
+            uint32_t w = ring[(rd + idx + run - 1) & mask];
+            c->hold_l = (int16_t)w;
+            c->hold_r = (int16_t)(w >> 16);
+            phase += run << 16;
+        }
+    } else {
+        /* Linear interpolation while the next source frame is there too */
+        int16_t sl = c->hold_l, sr = c->hold_r;
+        for (; i < n; i++) {
+            uint32_t idx = phase >> 16;
+            if (idx + 1 >= avail) break;
+            uint32_t w0 = ring[(rd + idx) & mask];
+            uint32_t w1 = ring[(rd + idx + 1) & mask];
+            int32_t frac = (int32_t)((phase & 0xFFFF) >> 1);
+            int32_t l0 = (int16_t)w0, r0 = (int16_t)(w0 >> 16);
+            sl = l0 + ((((int16_t)w1 - l0) * frac) >> 15);
+            sr = r0 + ((((int16_t)(w1 >> 16) - r0) * frac) >> 15);
+            acc[i * 2]     += sl * gl;
+            acc[i * 2 + 1] += sr * gr;
+            phase += inc;
+        }
+        c->hold_l = sl;
+        c->hold_r = sr;
+    }
+
+    /* The last source frame as is, then hold it to avoid a DC-offset click */
+    uint32_t held = 0;
+    for (; i < n; i++) {
+        uint32_t idx = phase >> 16;
+        if (idx < avail) {
+            uint32_t w = ring[(rd + idx) & mask];
+            c->hold_l = (int16_t)w;
+            c->hold_r = (int16_t)(w >> 16);
+            phase += inc;
+        } else {
+            held++;
+        }
+        acc[i * 2]     += c->hold_l * gl;
+        acc[i * 2 + 1] += c->hold_r * gr;
+    }
+    c->phase = phase;
+    return held;
+}
+
+/* Scale, saturate and pack n accumulated frames */
+static void __not_in_flash_func(mix_store)(uint32_t *out, const int32_t *acc,
+                                           uint32_t n, int shift) {
+    for (uint32_t i = 0; i < n; i++) {
+        int32_t l = SAT16(acc[i * 2] >> shift);
+        int32_t r = SAT16(acc[i * 2 + 1] >> shift);
+        out[i] = (uint16_t)l | ((uint32_t)r << 16);
+    }
+}
+
 /*==========================================================================
  * snd_fill_dma — called from DMA IRQ to mix all channels into one buffer
  *
@@ -61,88 +179,51 @@ static void __not_in_flash_func(snd_fill_dma)(int buf_index,
                                                uint32_t *buf,
                                                uint32_t frames) {
     (void)buf_index;
-    int16_t *out = (int16_t *)buf;
+    uint32_t t0 = time_us_32();
 
     /* Snapshot available frames per channel (wr only changes from task
      * context, rd only from here — both are stable for this fill). */
     uint32_t ch_avail[SND_MAX_CHANNELS];
+    bool any = false;
     for (int ch = 0; ch < SND_MAX_CHANNELS; ch++) {
-        if (channels[ch].active)
+        if (channels[ch].active) {
             ch_avail[ch] = channels[ch].wr - channels[ch].rd;
-        else
+            any = true;
+        } else {
             ch_avail[ch] = 0;
+        }
     }
 
-    for (uint32_t i = 0; i < frames; i++) {
-        int32_t left = 0, right = 0;
-
-        for (int ch = 0; ch < SND_MAX_CHANNELS; ch++) {
-            snd_channel_t *c = &channels[ch];
-            if (!c->active) continue;
-
-            if (ch_avail[ch] == 0) {
-                /* Buffer empty — hold last sample to avoid DC-offset click */
-                left  += c->hold_l;
-                right += c->hold_r;
-                continue;
-            }
-
-            uint32_t src_idx = c->phase >> 16;
-            if (src_idx >= ch_avail[ch]) {
-                /* Exhausted available data — hold last sample */
-                left  += c->hold_l;
-                right += c->hold_r;
-                continue;
+    /* Halve the mix so several channels rarely clip, then apply the
+     * volume; gains are in 1/SND_GAIN_UNITY steps (8 bits).  Muted
+     * (vol >= 4) still mixes, so channels keep consuming and writers
+     * waiting for space are not left blocked — only the output is
+     * silenced. */
+    uint8_t vol = snd_volume;
+    if (!any) {
+        memset(buf, 0, frames * sizeof(uint32_t));
+    } else {
+        int shift = 8 + 1 + vol;
+        uint32_t starved = 0;
+        for (uint32_t pos = 0; pos < frames; pos += SND_MIX_FRAMES) {
+            uint32_t n = frames - pos;
+            if (n > SND_MIX_FRAMES) n = SND_MIX_FRAMES;
+            memset(mix_acc, 0, n * 2 * sizeof(int32_t));
+            for (int ch = 0; ch < SND_MAX_CHANNELS; ch++) {
+                if (channels[ch].active)
+                    starved += mix_channel(&channels[ch], ch_avail[ch], mix_acc, n);
             }
-
-            uint32_t idx0 = (c->rd + src_idx) & SND_CHAN_MASK;
-            int16_t l0 = c->buf[idx0 * 2];
-            int16_t r0 = c->buf[idx0 * 2 + 1];
-
-            int16_t sl, sr;
-            if (src_idx + 1 < ch_avail[ch]) {
-                /* Linear interpolation between current and next sample */
-                uint32_t idx1 = (c->rd + src_idx + 1) & SND_CHAN_MASK;
-                int32_t frac = (int32_t)((c->phase & 0xFFFF) >> 1);
-                sl = l0 + (((int32_t)(c->buf[idx1 * 2]     - l0) * frac) >> 15);
-                sr = r0 + (((int32_t)(c->buf[idx1 * 2 + 1] - r0) * frac) >> 15);
-            } else {
-                sl = l0;
-                sr = r0;
-            }
-
-            c->hold_l = sl;
-            c->hold_r = sr;
-            left  += sl;
-            right += sr;
-
-            c->phase += c->phase_inc;
+            if (vol >= 4)
+                memset(buf + pos, 0, n * sizeof(uint32_t));
+            else
+                mix_store(buf + pos, mix_acc, n, shift);
         }
-
-        /* Attenuate mix to prevent clipping when multiple channels
-         * are active, then apply volume control. */
-        left  >>= 1;
-        right >>= 1;
-
-        if (snd_volume >= 4) {
-            left  = 0;
-            right = 0;
-        } else if (snd_volume) {
-            left  >>= snd_volume;
-            right >>= snd_volume;
-        }
-
-        /* Clamp to int16_t range */
-        if (left  >  32767) left  =  32767;
-        if (left  < -32768) left  = -32768;
-        if (right >  32767) right =  32767;
-        if (right < -32768) right = -32768;
-
-        out[i * 2]     = (int16_t)left;
-        out[i * 2 + 1] = (int16_t)right;
+        snd_stats.starved += starved;
     }
 
-    /* Advance read pointers by the number of source frames consumed */
+    /* Advance read pointers by the number of source frames consumed,
+     * and wake writers waiting for the space */
+    BaseType_t woken = pdFALSE;
     for (int ch = 0; ch < SND_MAX_CHANNELS; ch++) {
         snd_channel_t *c = &channels[ch];
         if (ch_avail[ch] == 0) continue;
@@ -150,7 +231,16 @@ static void __not_in_flash_func(snd_fill_dma)(int buf_index,
         uint32_t consumed = c->phase >> 16;
         c->rd    += consumed;
         c->phase &= 0xFFFF;  /* keep fractional part */
+        TaskHandle_t writer = c->writer;
+        if (consumed && writer) vTaskNotifyGiveFromISR(writer, &woken);
     }
+
+    uint32_t us = time_us_32() - t0;
+    snd_stats.fills++;
+    snd_stats.last_us = us;
+    snd_stats.total_us += us;
+    if (us > snd_stats.max_us) snd_stats.max_us = us;
+    portYIELD_FROM_ISR(woken);
 }
 
 /*==========================================================================
@@ -175,19 +265,38 @@ void snd_init(void) {
 
 /*==========================================================================
  * snd_open — allocate a mixing channel
+ *
+ * snd_open() uses the channel's static 2048-frame SRAM ring;
+ * snd_open_ring() allocates one of the given size plus span frames past
+ * its end, from PSRAM when there is PSRAM.  The IRQ may read PSRAM: it
+ * doesn't run while flash is written (interrupts are off then).
  *==========================================================================*/
-int snd_open(uint32_t sample_rate) {
+static inline bool in_psram(const void *p) {
+    return (uintptr_t)p >= PSRAM_BASE && (uintptr_t)p < PSRAM_END;
+}
+
+static int chan_open(uint32_t sample_rate, int16_t *buf, uint32_t size,
+                     uint32_t span, bool own_buf) {
     for (int ch = 0; ch < SND_MAX_CHANNELS; ch++) {
         if (!channels[ch].active) {
             snd_channel_t *c = &channels[ch];
-            memset(c->buf, 0, sizeof(c->buf));
+            if (!buf) buf = chan_bufs[ch];
+            memset(buf, 0, (size + span) * 4);
+            c->buf       = buf;
+            c->size      = size;
+            c->mask      = size - 1;
+            c->span      = span;
+            c->own_buf   = own_buf;
             c->rd        = 0;
             c->wr        = 0;
+            c->writer    = NULL;
             c->rate      = sample_rate;
             c->phase     = 0;
             c->phase_inc = (sample_rate << 16) / SND_SYSTEM_RATE;
+            c->gain      = SND_GAIN_UNITY | (SND_GAIN_UNITY << 16);
             c->hold_l    = 0;
             c->hold_r    = 0;
+            __dmb();     /* ring set up before the IRQ sees the channel */
             c->active    = true;
             return ch;
         }
@@ -195,38 +304,104 @@ int snd_open(uint32_t sample_rate) {
     return -1;  /* all channels in use */
 }
 
+int snd_open(uint32_t sample_rate) {
+    return chan_open(sample_rate, NULL, SND_CHAN_FRAMES, 0, false);
+}
+
+int snd_open_ring(uint32_t sample_rate, uint32_t frames, uint32_t span) {
+    uint32_t size = 256;
+    while (size < frames && size < (1u << 20)) size <<= 1;
+    if (span > size) span = size;
+    size_t bytes = (size + span) * 4;
+    int16_t *buf = NULL;
+    if (psram_is_available()) buf = (int16_t *)psram_alloc(bytes);
+    if (!buf) buf = (int16_t *)pvPortMalloc(bytes);
+    if (!buf) return -1;
+    int ch = chan_open(sample_rate, buf, size, span, true);
+    if (ch < 0) {
+        if (in_psram(buf)) psram_free(buf);
+        else vPortFree(buf);
+    }
+    return ch;
+}
+
+/* Free frames at the write position */
+static inline uint32_t chan_space(const snd_channel_t *c) {
+    return c->size - (c->wr - c->rd);
+}
+
+/* Park the task until the IRQ has freed space or SND_WAIT passes */
+static void chan_sleep(snd_channel_t *c, uint32_t need) {
+    c->writer = xTaskGetCurrentTaskHandle();
+    __dmb();     /* publish the waiter before looking at rd */
+    if (c->active && chan_space(c) < need) ulTaskNotifyTake(pdTRUE, SND_WAIT);
+    c->writer = NULL;
+}
+
+/*==========================================================================
+ * snd_acquire / snd_commit — write in place
+ *
+ * Only the task owning a channel writes to it, and only the IRQ moves
+ * rd, so no lock is needed.  A span that runs past the end of the ring
+ * lands in the span frames behind it and snd_commit() moves that part
+ * to the start, where the IRQ reads it.
+ *==========================================================================*/
+int snd_acquire(int ch, int16_t **ptr, int max_frames) {
+    if (ch < 0 || ch >= SND_MAX_CHANNELS || max_frames <= 0) return 0;
+    snd_channel_t *c = &channels[ch];
+    if (!c->active) return 0;
+
+    uint32_t want = (uint32_t)max_frames;
+    if (want > c->size) want = c->size;
+    uint32_t wr_idx = c->wr & c->mask;
+    uint32_t contig = c->size - wr_idx + c->span;
+    if (want > contig) want = contig;
+    while (chan_space(c) < want) {
+        if (!c->active) return 0;
+        chan_sleep(c, want);
+    }
+    *ptr = &c->buf[wr_idx * 2];
+    return (int)want;
+}
+
+void snd_commit(int ch, int frames) {
+    if (ch < 0 || ch >= SND_MAX_CHANNELS || frames <= 0) return;
+    snd_channel_t *c = &channels[ch];
+    uint32_t n = (uint32_t)frames;
+    if (n > chan_space(c)) n = chan_space(c);
+
+    uint32_t wr_idx = c->wr & c->mask;
+    if (wr_idx + n > c->size) {
+        /* Each stereo frame = 2 x int16_t = 4 bytes */
+        memcpy(&c->buf[0], &c->buf[c->size * 2], (wr_idx + n - c->size) * 4);
+    }
+    __dmb();     /* ensure sample data visible before wr update */
+    c->wr += n;
+}
+
 /*==========================================================================
  * snd_write — copy stereo frames into a channel's ring buffer
  *
- * Blocks (vTaskDelay) if the ring buffer is full.  Handles wrap-around
- * with up to two memcpy calls per iteration.
+ * Copies whatever fits, up to the end of the ring at a time, and sleeps
+ * until the IRQ frees space while the ring is full.
  *==========================================================================*/
 void snd_write(int ch, const int16_t *samples, int frames) {
     if (ch < 0 || ch >= SND_MAX_CHANNELS) return;
     snd_channel_t *c = &channels[ch];
 
-    while (frames > 0) {
-        uint32_t used  = c->wr - c->rd;
-        uint32_t space = SND_CHAN_FRAMES - used;
-
+    while (frames > 0 && c->active) {
+        uint32_t space = chan_space(c);
         if (space == 0) {
-            vTaskDelay(1);
+            chan_sleep(c, 1);
             continue;
         }
 
         uint32_t n = (uint32_t)frames;
         if (n > space) n = space;
+        uint32_t wr_idx = c->wr & c->mask;
+        if (n > c->size - wr_idx) n = c->size - wr_idx;
 
-        uint32_t wr_idx = c->wr & SND_CHAN_MASK;
-        uint32_t first  = SND_CHAN_FRAMES - wr_idx;
-        if (first > n) first = n;
-
-        /* Each stereo frame = 2 x int16_t = 4 bytes */
-        memcpy(&c->buf[wr_idx * 2], samples, first * 4);
-        if (n > first) {
-            memcpy(&c->buf[0], samples + first * 2, (n - first) * 4);
-        }
-
+        memcpy(&c->buf[wr_idx * 2], samples, n * 4);
         __dmb();     /* ensure sample data visible before wr update */
         c->wr += n;
 
@@ -238,12 +413,25 @@ void snd_write(int ch, const int16_t *samples, int frames) {
 /*==========================================================================
  * snd_close — release a mixing channel
  *==========================================================================*/
+static void chan_release(snd_channel_t *c) {
+    /* The IRQ runs on this core: once it's off, it sees the channel gone */
+    uint32_t irq = save_and_disable_interrupts();
+    c->active = false;
+    restore_interrupts(irq);
+    c->rd     = 0;
+    c->wr     = 0;
+    c->phase  = 0;
+    if (c->own_buf) {
+        if (in_psram(c->buf)) psram_free(c->buf);
+        else vPortFree(c->buf);
+        c->own_buf = false;
+    }
+    c->buf = NULL;
+}
+
 void snd_close(int ch) {
     if (ch < 0 || ch >= SND_MAX_CHANNELS) return;
-    channels[ch].active = false;
-    channels[ch].rd     = 0;
-    channels[ch].wr     = 0;
-    channels[ch].phase  = 0;
+    if (channels[ch].active) chan_release(&channels[ch]);
 }
 
 /*==========================================================================
@@ -251,7 +439,7 @@ void snd_close(int ch) {
  *==========================================================================*/
 void snd_deinit(void) {
     for (int ch = 0; ch < SND_MAX_CHANNELS; ch++)
-        channels[ch].active = false;
+        if (channels[ch].active) chan_release(&channels[ch]);
     i2s_deinit(&snd_i2s_config);
 }
 
@@ -263,3 +451,24 @@ void snd_set_volume(uint8_t vol) {
     if (vol > 4) vol = 4;
     snd_volume = vol;
 }
+
+/*==========================================================================
+ * snd_set_gain — per-channel gain and pan
+ *
+ * Both sides go into one word, so the IRQ never sees half an update.
+ *==========================================================================*/
+void snd_set_gain(int ch, uint16_t gain, int8_t pan) {
+    if (ch < 0 || ch >= SND_MAX_CHANNELS) return;
+    if (gain > 2 * SND_GAIN_UNITY) gain = 2 * SND_GAIN_UNITY;
+    if (pan < -127) pan = -127;
+    uint32_t gl = pan > 0 ? gain * (uint32_t)(127 - pan) / 127 : gain;
+    uint32_t gr = pan < 0 ? gain * (uint32_t)(127 + pan) / 127 : gain;
+    channels[ch].gain = gl | (gr << 16);
+}
+
+void snd_get_stats(snd_stats_t *st) {
+    uint32_t irq = save_and_disable_interrupts();
+    *st = snd_stats;
+    restore_interrupts(irq);
+    st->budget_us = (uint32_t)((uint64_t)SND_DMA_FRAMES * 1000000 / SND_SYSTEM_RATE);
+}
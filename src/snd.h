@@ -23,12 +23,47 @@ void snd_init(void);
  * sample_rate: source sample rate (e.g. 15625, 22050, 44100) */
 int  snd_open(uint32_t sample_rate);
 
+/* Open a channel with its own ring of frames (rounded up to a power of
+ * 2) plus span frames behind it, in PSRAM when there is PSRAM.  A bigger
+ * ring rides out longer stalls of the writer; span lets snd_acquire()
+ * hand out up to span frames in one piece anywhere in the ring.  Closed
+ * by snd_close() from the writing task.  Returns -1 if full or no memory. */
+int  snd_open_ring(uint32_t sample_rate, uint32_t frames, uint32_t span);
+
 /* Write stereo interleaved frames to a channel.  Blocks if ring buffer full. */
 void snd_write(int ch, const int16_t *samples, int frames);
 
+/* Write in place: snd_acquire() waits until max_frames (at most the ring
+ * size) are free and points *ptr at them in the ring; the caller fills
+ * them with stereo interleaved frames and publishes them with
+ * snd_commit().  Returns the frames handed out — fewer than asked only
+ * where the ring ends and the channel has no span to run into — or 0 if
+ * the channel is closed.  The IRQ wakes a waiting writer as it plays. */
+int  snd_acquire(int ch, int16_t **ptr, int max_frames);
+void snd_commit(int ch, int frames);
+
 /* Close a channel, freeing it for reuse. */
 void snd_close(int ch);
 
+/* Per-channel gain and pan.  gain: 0 .. 2 * SND_GAIN_UNITY, where
+ * SND_GAIN_UNITY plays the channel unchanged.  pan: -127 (left only)
+ * .. 0 (centre) .. 127 (right only); off centre the far side is
+ * attenuated.  snd_open() resets both. */
+#define SND_GAIN_UNITY  256
+void snd_set_gain(int ch, uint16_t gain, int8_t pan);
+
+/* Mixer load, measured in the DMA IRQ */
+typedef struct {
+    uint32_t fills;       /* DMA buffers mixed */
+    uint32_t last_us;     /* time spent on the last one */
+    uint32_t max_us;      /* ... the worst one */
+    uint32_t total_us;    /* ... all of them */
+    uint32_t budget_us;   /* play time of one buffer */
+    uint32_t starved;     /* frames an open channel had no data for */
+} snd_stats_t;
+
+void snd_get_stats(snd_stats_t *st);
+
 /* Shut down the entire sound system (stops I2S DMA + PIO). */
 void snd_deinit(void);
 
@@ -22,8 +22,7 @@
 #include "sdcard_init.h"
 #include "desktop.h"
 #include "snd.h"
-#include "file_assoc.h"
-#include "ico.h"
+#include "app_registry.h"
 #include "ff.h"
 #include "run_dialog.h"
 #include "control_panel.h"
@@ -77,132 +76,6 @@ static sm_item_t sm_items[] = {
 #define SM_IDX_SETTINGS  1
 #define SM_IDX_FIRMWARE  2
 
-/*==========================================================================
- * Dynamic /fos/ app scanning
- *=========================================================================*/
-
-#define FOS_MAX_APPS 16
-#define FOS_NAME_LEN 32   /* UTF-8: up to ~15 Cyrillic chars */
-#define FOS_PATH_LEN 32
-#define ICON16_SIZE  256
-
-static struct {
-    char    name[FOS_NAME_LEN];  /* display name from .inf */
-    char    path[FOS_PATH_LEN];  /* e.g. "/fos/minesweeper" */
-    uint8_t icon[ICON16_SIZE];   /* 16x16 icon data from .inf */
-    bool    has_icon;             /* true if icon was loaded */
-} fos_apps[FOS_MAX_APPS];
-static int fos_app_count = 0;
-
-static void fos_scan(void) {
-    fos_app_count = 0;
-    if (!sdcard_is_mounted()) return;
-
-    DIR dir;
-    FILINFO fno;
-    if (f_opendir(&dir, "/fos") != FR_OK) return;
-
-    while (fos_app_count < FOS_MAX_APPS) {
-        if (f_readdir(&dir, &fno) != FR_OK || fno.fname[0] == 0)
-            break;
-        /* Skip directories */
-        if (fno.fattrib & AM_DIR) continue;
-        /* Skip .inf metadata files */
-        const char *dot = strrchr(fno.fname, '.');
-        if (dot && strcmp(dot, ".inf") == 0) continue;
-
-        /* Build path */
-        snprintf(fos_apps[fos_app_count].path,
-                 FOS_PATH_LEN, "/fos/%s", fno.fname);
-
-        /* Try to read display name and icon from companion .inf file */
-        char inf_path[FOS_PATH_LEN + 4];
-        snprintf(inf_path, sizeof(inf_path), "/fos/%s.inf", fno.fname);
-        FIL f;
-        bool got_name = false;
-        fos_apps[fos_app_count].has_icon = false;
-        if (f_open(&f, inf_path, FA_READ) == FR_OK) {
-            UINT br;
-            static char buf[96]; /* static to avoid stack overflow */
-            if (f_read(&f, buf, sizeof(buf) - 1, &br) == FR_OK && br > 0) {
-                buf[br] = '\0';
-                /* Line 1 = default (English) name.
-                 * Subsequent lines: name.XX=Localized Name
-                 * where XX is the language code (ru, de, fr, etc.) */
-                char *line1 = buf;
-                char *nl = strchr(buf, '\n');
-                if (nl) {
-                    *nl = '\0';
-                    if (nl > buf && *(nl - 1) == '\r') *(nl - 1) = '\0';
-                }
-                /* Look for name.XX= matching current language */
-                const char *lang_codes[] = { "en", "ru" };
-                uint8_t lang = lang_get();
-                const char *chosen = line1;
-                if (lang < sizeof(lang_codes)/sizeof(lang_codes[0]) && lang > 0 && nl) {
-                    char prefix[12];
-                    snprintf(prefix, sizeof(prefix), "name.%s=", lang_codes[lang]);
-                    int plen = strlen(prefix);
-                    char *p = nl + 1;
-                    while (*p) {
-                        char *eol = strchr(p, '\n');
-                        if (eol) *eol = '\0';
-                        /* Trim CR */
-                        char *cr = strchr(p, '\r');
-                        if (cr) *cr = '\0';
-                        if (strncmp(p, prefix, plen) == 0 && p[plen]) {
-                            chosen = p + plen;
-                            break;
-                        }
-                        if (!eol) break;
-                        p = eol + 1;
-                    }
-                }
-                if (chosen[0]) {
-                    strncpy(fos_apps[fos_app_count].name, chosen, FOS_NAME_LEN - 1);
-                    fos_apps[fos_app_count].name[FOS_NAME_LEN - 1] = '\0';
-                    got_name = true;
-                }
-            }
-            /* Load 16x16 icon from .ico file */
-            {
-                char ico_path[FOS_PATH_LEN + 4];
-                snprintf(ico_path, sizeof(ico_path), "%s.ico",
-                         fos_apps[fos_app_count].path);
-                FIL ico;
-                if (f_open(&ico, ico_path, FA_READ) == FR_OK) {
-                    FSIZE_t fsize = f_size(&ico);
-                    if (fsize >= 22 && fsize <= 4096) {
-                        uint8_t ibuf[4096];
-                        UINT ibr;
-                        if (f_read(&ico, ibuf, (UINT)fsize, &ibr) == FR_OK
-                            && ibr == (UINT)fsize) {
-                            if (ico_parse_16(ibuf, ibr,
-                                    fos_apps[fos_app_count].icon))
-                                fos_apps[fos_app_count].has_icon = true;
-                        }
-                    }
-                    f_close(&ico);
-                }
-            }
-            /* No .ico → use terminal icon as default */
-            if (!fos_apps[fos_app_count].has_icon) {
-                extern const uint8_t *fn_icon16_terminal_get(void);
-                memcpy(fos_apps[fos_app_count].icon,
-                       fn_icon16_terminal_get(), ICON16_SIZE);
-                fos_apps[fos_app_count].has_icon = true;
-            }
-            f_close(&f);
-        }
-
-        /* Skip files without a companion .inf */
-        if (!got_name) continue;
-
-        fos_app_count++;
-    }
-    f_closedir(&dir);
-}
-
 /*==========================================================================
  * Dynamic /uf2/ firmware scanning
  *=========================================================================*/
@@ -345,7 +218,7 @@ static void compute_menu_rect(void) {
 
 static void compute_sub_rect(void) {
     sub_w = 148;
-    sub_h = 4 + (fos_app_count + 2) * SM_ITEM_HEIGHT; /* apps + Navigator + Terminal */
+    sub_h = 4 + (app_registry_count() + 2) * SM_ITEM_HEIGHT; /* apps + Navigator + Terminal */
     sub_x = sm_x + sm_w;
     /* Align with the Programs item, but move up if it won't fit */
     sub_y = sm_y + 1;
@@ -406,7 +279,6 @@ static void sm_refresh_text(void) {
 
 void startmenu_init(void) {
     sm_refresh_text();
-    fos_scan();
     uf2_scan();
 }
 
@@ -475,23 +347,13 @@ static void execute_sub_item(int index) {
     cursor_set_type(CURSOR_WAIT);
     wm_composite();  /* flush frame so hourglass is visible during load */
     extern const uint8_t default_icon_16x16[256];
-    if (index < fos_app_count) {
-        wm_set_pending_icon(fos_apps[index].has_icon
-                            ? fos_apps[index].icon : default_icon_16x16);
-        /* Look up 32x32 icon from file_assoc registry */
-        {
-            int fa_cnt;
-            const fa_app_t *fa_list = file_assoc_get_apps(&fa_cnt);
-            for (int i = 0; i < fa_cnt; i++) {
-                if (strcmp(fa_list[i].path, fos_apps[index].path) == 0) {
-                    if (fa_list[i].has_icon32)
-                        wm_set_pending_icon32(fa_list[i].icon32);
-                    break;
-                }
-            }
-        }
-        launch_elf_app(fos_apps[index].path);
-    } else if (index == fos_app_count) {
+    if (index < app_registry_count()) {
+        const fa_app_t *app = app_registry_get(index);
+        wm_set_pending_icon(app->has_icon ? app->icon : default_icon_16x16);
+        if (app->has_icon32)
+            wm_set_pending_icon32(app->icon32);
+        launch_elf_app(app->path);
+    } else if (index == app_registry_count()) {
         /* FRANK Navigator */
         spawn_filemanager_window();
     } else {
@@ -776,7 +638,7 @@ void startmenu_draw(void) {
 
     /* Draw Programs submenu if open */
     if (sub_open) {
-        int sub_count = fos_app_count + 2; /* apps + Terminal */
+        int sub_count = app_registry_count() + 2; /* apps + Terminal */
         gfx_fill_rect(sub_x, sub_y, sub_w, sub_h, THEME_BUTTON_FACE);
         gfx_hline(sub_x, sub_y, sub_w, COLOR_WHITE);
         gfx_vline(sub_x, sub_y, sub_h, COLOR_WHITE);
@@ -794,10 +656,11 @@ void startmenu_draw(void) {
             /* Draw 16x16 icon */
             const uint8_t *icon = default_icon_16x16;
             const char *label;
-            if (i < fos_app_count) {
-                if (fos_apps[i].has_icon) icon = fos_apps[i].icon;
-                label = fos_apps[i].name;
-            } else if (i == fos_app_count) {
+            if (i < app_registry_count()) {
+                const fa_app_t *app = app_registry_get(i);
+                if (app->has_icon) icon = app->icon;
+                label = app_registry_title(i);
+            } else if (i == app_registry_count()) {
                 icon = fn_icon16_open_folder;
                 label = L(STR_NAVIGATOR);
             } else {
@@ -975,11 +838,11 @@ bool startmenu_mouse(uint8_t type, int16_t x, int16_t y) {
             }
             if (type == WM_LBUTTONUP && sm_ctx_hover >= 0) {
                 /* "Send to Desktop" action */
-                if (sm_ctx_app_idx >= 0 && sm_ctx_app_idx < fos_app_count)
-                    desktop_add_shortcut(fos_apps[sm_ctx_app_idx].path);
-                else if (sm_ctx_app_idx == fos_app_count)
+                if (sm_ctx_app_idx >= 0 && sm_ctx_app_idx < app_registry_count())
+                    desktop_add_shortcut(app_registry_get(sm_ctx_app_idx)->path);
+                else if (sm_ctx_app_idx == app_registry_count())
                     desktop_add_shortcut(DESKTOP_BUILTIN_NAVIGATOR);
-                else if (sm_ctx_app_idx == fos_app_count + 1)
+                else if (sm_ctx_app_idx == app_registry_count() + 1)
                     desktop_add_shortcut(DESKTOP_BUILTIN_TERMINAL);
                 sm_ctx_open = false;
                 sm_ctx_hover = -1;
@@ -1008,7 +871,7 @@ bool startmenu_mouse(uint8_t type, int16_t x, int16_t y) {
     /* Check Programs submenu */
     if (sub_open && x >= sub_x && x < sub_x + sub_w &&
         y >= sub_y && y < sub_y + sub_h) {
-        int sub_count = fos_app_count + 2;
+        int sub_count = app_registry_count() + 2;
         if (type == WM_MOUSEMOVE || type == WM_LBUTTONDOWN ||
             type == WM_RBUTTONDOWN) {
             int iy = sub_y + 2;
@@ -1030,7 +893,7 @@ bool startmenu_mouse(uint8_t type, int16_t x, int16_t y) {
         }
         /* Right-click on any app in Programs → open inline context popup */
         if (type == WM_RBUTTONUP && sub_hover >= 0 &&
-            sub_hover < fos_app_count + 2) {
+            sub_hover < app_registry_count() + 2) {
             sm_ctx_app_idx = sub_hover;
             /* Position context popup at cursor, clamped to screen */
             sm_ctx_w = 18 * FONT_UI_WIDTH + 12; /* "Send to Desktop" width */
@@ -1183,7 +1046,7 @@ bool startmenu_handle_key(uint8_t hid_code, uint8_t modifiers) {
 
     /* Programs submenu keyboard handling */
     if (sub_open) {
-        int sub_count = fos_app_count + 2;
+        int sub_count = app_registry_count() + 2;
         switch (hid_code) {
         case 0x52: /* UP */
             sub_hover--;
@@ -12,7 +12,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-/* Pre-scan /fos/ apps at boot (call once from compositor task) */
+/* Pre-scan /uf2/ firmware at boot (call once from compositor task,
+ * after app_registry_load() — the Programs list reads the registry) */
 void startmenu_init(void);
 
 /* Toggle start menu visibility */
@@ -15,29 +15,6 @@
 #include <string.h>
 #include <stdio.h>
 
-/*==========================================================================
- * Shared SRAM stack — all foreground app tasks use this single block.
- * Only one runs at a time; on switch, the 8KB is saved to PSRAM.
- *=========================================================================*/
-
-static StackType_t shared_stack[SWAP_STACK_WORDS] __attribute__((aligned(8)));
-
-/* True when the shared stack is actively in use by a running task.
- * Prevents a second foreground task from corrupting the first. */
-static volatile bool shared_stack_busy;
-
-bool swap_is_stack_busy(void) {
-    return shared_stack_busy;
-}
-
-void swap_stack_acquire(void) {
-    shared_stack_busy = true;
-}
-
-void swap_stack_release(void) {
-    shared_stack_busy = false;
-}
-
 /*==========================================================================
  * Swap table — one entry per registered app window
  *=========================================================================*/
@@ -45,7 +22,9 @@ void swap_stack_release(void) {
 typedef struct {
     hwnd_t        hwnd;
     TaskHandle_t  task;
-    StackType_t  *psram_save;   /* 8KB PSRAM buffer for saved stack */
+    StackType_t  *spill;        /* PSRAM copy of the live stack, or NULL */
+    uint16_t      spill_words;
+    int8_t        slot;         /* home stack slot, -1 if outside the pool */
     bool          suspended;
     bool          background;   /* never suspend (e.g. FrankAmp) */
 } swap_entry_t;
@@ -64,11 +43,229 @@ static uint8_t fg_history_count = 0;
 static TaskHandle_t pending_bg_task = NULL;
 
 /* Deferred resume — set by swap_resume_previous() (called from the
- * exiting app task which is still on the shared stack).  The actual
- * memcpy + vTaskResume is done by swap_process_deferred() in the
- * compositor task, which runs on its own stack. */
+ * exiting app task, which may still be on the slot being resumed into).
+ * The actual restore + vTaskResume is done by swap_process_deferred()
+ * in the compositor task, which runs on its own stack. */
 static volatile hwnd_t deferred_resume_hwnd = HWND_NULL;
 
+/*==========================================================================
+ * SRAM stack slots
+ *
+ * A task's stack can't move once created — saved frames hold absolute
+ * pointers — so every pool task has a home slot and always runs there.
+ * Several suspended tasks may share a home; the one whose frames are in
+ * the slot is its resident, the others are spilled to PSRAM.  Only the
+ * live part (saved SP up to the top) is copied either way.
+ *
+ * busy means the resident is running, or the slot is claimed by a task
+ * being created or resumed; such a slot is never spilled.  Decisions are
+ * made with the scheduler suspended, the copies outside.
+ *=========================================================================*/
+
+typedef struct {
+    StackType_t  *stack;      /* SWAP_STACK_WORDS, NULL until needed */
+    TaskHandle_t  resident;
+    bool          busy;
+    TickType_t    last_use;   /* when the resident last stopped */
+} stack_slot_t;
+
+static StackType_t  slot0_stack[SWAP_STACK_WORDS] __attribute__((aligned(8)));
+static stack_slot_t slots[SWAP_STACK_SLOTS] = { [0] = { .stack = slot0_stack } };
+static swap_stats_t stats;
+
+static swap_entry_t *find_entry_by_task(TaskHandle_t task);
+
+/* Saved SP of a task that isn't running.  pxTopOfStack is the first
+ * member of every TCB — the port's context switch relies on that. */
+static inline StackType_t *saved_sp(TaskHandle_t task) {
+    return *(StackType_t *const *)task;
+}
+
+static uint32_t live_words(const stack_slot_t *s, TaskHandle_t task) {
+    StackType_t *sp = saved_sp(task);
+    if (sp < s->stack || sp > s->stack + SWAP_STACK_WORDS)
+        return SWAP_STACK_WORDS;
+    return (uint32_t)(s->stack + SWAP_STACK_WORDS - sp);
+}
+
+/* True if a spilled task still calls slot i home */
+static bool slot_homed(int i) {
+    for (int k = 0; k < SWAP_MAX_APPS; k++)
+        if (swap_table[k].task && swap_table[k].slot == i &&
+            swap_table[k].spill)
+            return true;
+    return false;
+}
+
+/* Claim a slot for a new task: a free one, else a fresh one while the
+ * heap can spare it, else the least recently used one with a suspended
+ * resident (which the caller must spill).  Returns -1 if all are busy. */
+static int slot_claim(void) {
+    int pick = -1;
+    vTaskSuspendAll();
+    for (int i = 0; i < SWAP_STACK_SLOTS && pick < 0; i++)
+        if (slots[i].stack && !slots[i].busy && !slots[i].resident)
+            pick = i;
+    for (int i = 1; i < SWAP_STACK_SLOTS && pick < 0; i++) {
+        if (slots[i].stack) continue;
+        if (xPortGetFreeHeapSize() < SWAP_STACK_BYTES + SWAP_SLOT_HEAP_RESERVE)
+            break;
+        slots[i].stack = (StackType_t *)pvPortMalloc(SWAP_STACK_BYTES);
+        if (slots[i].stack) pick = i;
+    }
+    for (int i = 0; i < SWAP_STACK_SLOTS && pick < 0; i++) {
+        stack_slot_t *s = &slots[i];
+        if (!s->stack || s->busy) continue;
+        if (pick < 0 || (int32_t)(s->last_use - slots[pick].last_use) < 0)
+            pick = i;
+    }
+    if (pick >= 0) slots[pick].busy = true;
+    (void)xTaskResumeAll();
+    return pick;
+}
+
+/* Set when a slot could not be freed because the caller was still
+ * running on it; swap_trim_deferred() retries once it has gone */
+static volatile bool trim_pending;
+
+/* Give a heap slot back once nothing runs there and no spilled task
+ * calls it home.  Call with the scheduler suspended. */
+static void slot_trim(int i) {
+    stack_slot_t *s = &slots[i];
+    if (i > 0 && s->stack && !s->busy && !s->resident && !slot_homed(i)) {
+        /* An exiting task releases its own slot before vTaskDelete */
+        StackType_t here;
+        if (&here >= s->stack && &here < s->stack + SWAP_STACK_WORDS) {
+            trim_pending = true;
+            return;
+        }
+        vPortFree(s->stack);
+        s->stack = NULL;
+    }
+}
+
+static void slot_unclaim(int i) {
+    vTaskSuspendAll();
+    slots[i].busy = false;
+    (void)xTaskResumeAll();
+}
+
+/* Move the suspended resident of a claimed slot out to PSRAM */
+static bool slot_spill(int i) {
+    stack_slot_t *s = &slots[i];
+    swap_entry_t *e = find_entry_by_task(s->resident);
+    if (!e || !e->suspended || e->slot != i) return false;
+
+    uint32_t words = live_words(s, e->task);
+    StackType_t *buf = (StackType_t *)psram_alloc(words * sizeof(StackType_t));
+    if (!buf) return false;
+    memcpy(buf, s->stack + SWAP_STACK_WORDS - words, words * sizeof(StackType_t));
+    e->spill = buf;
+    e->spill_words = (uint16_t)words;
+    s->resident = NULL;
+    stats.spills++;
+    stats.bytes_copied += words * sizeof(StackType_t);
+    return true;
+}
+
+/* Get a suspended task's stack back into its home slot and claim the
+ * slot for it.  Fails while another task runs there. */
+static bool slot_reclaim(swap_entry_t *e) {
+    if (e->slot < 0) return true;
+    stack_slot_t *s = &slots[e->slot];
+
+    vTaskSuspendAll();
+    bool ok = !s->busy;
+    if (ok) s->busy = true;
+    (void)xTaskResumeAll();
+    if (!ok) return false;
+
+    if (s->resident == e->task) {
+        stats.resident++;
+        return true;
+    }
+    if (!e->spill || (s->resident && !slot_spill(e->slot))) {
+        slot_unclaim(e->slot);
+        return false;
+    }
+    uint32_t words = e->spill_words;
+    memcpy(s->stack + SWAP_STACK_WORDS - words, e->spill,
+           words * sizeof(StackType_t));
+    psram_free(e->spill);
+    e->spill = NULL;
+    s->resident = e->task;
+    stats.restores++;
+    stats.bytes_copied += words * sizeof(StackType_t);
+    return true;
+}
+
+TaskHandle_t swap_create_task(TaskFunction_t fn, const char *name,
+                              void *param, UBaseType_t priority,
+                              StaticTask_t *tcb) {
+    int i = slot_claim();
+    if (i >= 0 && slots[i].resident && !slot_spill(i)) {
+        slot_unclaim(i);
+        i = -1;
+    }
+    if (i < 0) {
+        stats.no_slot++;
+        return NULL;
+    }
+    stack_slot_t *s = &slots[i];
+    /* Re-fill with the watermark pattern before each new task */
+    for (uint32_t k = 0; k < SWAP_STACK_WORDS; k++)
+        s->stack[k] = 0xa5a5a5a5;
+    /* A static task's handle is its TCB: mark the slot before the task
+     * can run and register its window */
+    s->resident = (TaskHandle_t)tcb;
+    TaskHandle_t h = xTaskCreateStatic(fn, name, SWAP_STACK_WORDS, param,
+                                       priority, s->stack, tcb);
+    if (!h) {
+        vTaskSuspendAll();
+        s->resident = NULL;
+        s->busy = false;
+        (void)xTaskResumeAll();
+    }
+    return h;
+}
+
+void swap_stack_release(TaskHandle_t task) {
+    if (!task) return;
+    vTaskSuspendAll();
+    for (int i = 0; i < SWAP_STACK_SLOTS; i++) {
+        stack_slot_t *s = &slots[i];
+        if (s->resident != task) continue;
+        s->resident = NULL;
+        s->busy = false;
+        s->last_use = xTaskGetTickCount();
+        /* Heap slots go back unless a spilled task must return there */
+        slot_trim(i);
+        break;
+    }
+    (void)xTaskResumeAll();
+}
+
+void swap_trim_deferred(void) {
+    if (!trim_pending) return;
+    vTaskSuspendAll();
+    trim_pending = false;
+    for (int i = 1; i < SWAP_STACK_SLOTS; i++)
+        slot_trim(i);
+    (void)xTaskResumeAll();
+}
+
+void swap_get_stats(swap_stats_t *st) {
+    vTaskSuspendAll();
+    *st = stats;
+    st->slots = SWAP_STACK_SLOTS;
+    st->allocated = st->in_use = 0;
+    for (int i = 0; i < SWAP_STACK_SLOTS; i++) {
+        if (slots[i].stack)    st->allocated++;
+        if (slots[i].resident) st->in_use++;
+    }
+    (void)xTaskResumeAll();
+}
+
 /*==========================================================================
  * Internal helpers
  *=========================================================================*/
@@ -129,9 +326,6 @@ static void history_remove(hwnd_t hwnd) {
 
 void swap_init(void) {
     memset(swap_table, 0, sizeof(swap_table));
-    /* Fill shared stack with FreeRTOS watermark pattern */
-    for (int i = 0; i < SWAP_STACK_WORDS; i++)
-        shared_stack[i] = 0xa5a5a5a5;
     active_fg = HWND_NULL;
     fg_history_count = 0;
 }
@@ -149,10 +343,11 @@ void swap_register(hwnd_t hwnd, TaskHandle_t task) {
             swap_table[i].task = task;
             swap_table[i].suspended = false;
             swap_table[i].background = false;
-            /* Allocate 8KB PSRAM save buffer */
-            swap_table[i].psram_save = (StackType_t *)psram_alloc(SWAP_STACK_BYTES);
-            if (swap_table[i].psram_save)
-                memset(swap_table[i].psram_save, 0xa5, SWAP_STACK_BYTES);
+            swap_table[i].spill = NULL;
+            /* The task is running, so its slot (if any) holds it */
+            swap_table[i].slot = -1;
+            for (int k = 0; k < SWAP_STACK_SLOTS; k++)
+                if (slots[k].resident == task) swap_table[i].slot = (int8_t)k;
             /* Auto-mark background if this task was pre-flagged */
             if (pending_bg_task == task) {
                 swap_table[i].background = true;
@@ -163,17 +358,27 @@ void swap_register(hwnd_t hwnd, TaskHandle_t task) {
     }
 }
 
+/* Forget an entry.  A spilled task's home slot is left empty — free it
+ * if that was the last reason to keep it. */
+static void entry_drop(swap_entry_t *e) {
+    int home = e->spill ? e->slot : -1;
+    if (e->spill)
+        psram_free(e->spill);
+    memset(e, 0, sizeof(*e));
+    if (home >= 0) {
+        vTaskSuspendAll();
+        slot_trim(home);
+        (void)xTaskResumeAll();
+    }
+}
+
 void swap_unregister(hwnd_t hwnd) {
     swap_entry_t *e = find_entry(hwnd);
     if (!e) return;
     history_remove(hwnd);
     if (active_fg == hwnd)
         active_fg = HWND_NULL;
-    if (e->psram_save) {
-        psram_free(e->psram_save);
-        e->psram_save = NULL;
-    }
-    memset(e, 0, sizeof(*e));
+    entry_drop(e);
 }
 
 void swap_unregister_by_task(TaskHandle_t task) {
@@ -182,27 +387,27 @@ void swap_unregister_by_task(TaskHandle_t task) {
     history_remove(e->hwnd);
     if (active_fg == e->hwnd)
         active_fg = HWND_NULL;
-    if (e->psram_save) {
-        psram_free(e->psram_save);
-        e->psram_save = NULL;
-    }
-    memset(e, 0, sizeof(*e));
+    entry_drop(e);
 }
 
 void swap_suspend(hwnd_t hwnd) {
     swap_entry_t *e = find_entry(hwnd);
     if (!e || e->suspended || e->background) return;
-    if (!e->psram_save) return;  /* no save buffer — can't suspend */
 
-    /* 1. Suspend task FIRST (stack must be stable before copy) */
+    /* 1. Suspend task FIRST (its saved SP must be final) */
     vTaskSuspend(e->task);
-
-    /* 2. Save the shared stack to PSRAM */
-    memcpy(e->psram_save, shared_stack, SWAP_STACK_BYTES);
+    e->suspended = true;
+    stats.suspends++;
+
+    /* 2. Leave the stack where it is; the slot may now be spilled */
+    if (e->slot >= 0) {
+        vTaskSuspendAll();
+        slots[e->slot].busy = false;
+        slots[e->slot].last_use = xTaskGetTickCount();
+        (void)xTaskResumeAll();
+    }
 
     /* 3. Set suspended flag on the window */
-    e->suspended = true;
-    shared_stack_busy = false;  /* stack saved to PSRAM — available now */
     window_t *win = wm_get_window(hwnd);
     if (win)
         win->flags |= WF_SUSPENDED;
@@ -211,11 +416,10 @@ void swap_suspend(hwnd_t hwnd) {
 void swap_resume(hwnd_t hwnd) {
     swap_entry_t *e = find_entry(hwnd);
     if (!e || !e->suspended) return;
-    if (!e->psram_save) return;
 
-    shared_stack_busy = true;  /* about to restore and run on it */
-    /* 1. Restore stack from PSRAM BEFORE resuming */
-    memcpy(shared_stack, e->psram_save, SWAP_STACK_BYTES);
+    /* 1. Get the stack back into its slot BEFORE resuming */
+    if (!slot_reclaim(e)) return;
+    stats.resumes++;
 
     /* 2. Clear suspended flag */
     e->suspended = false;
@@ -239,8 +443,8 @@ void swap_switch_to(hwnd_t hwnd) {
     /* Cancel any pending deferred resume.  If an app just exited and
      * set deferred_resume_hwnd, but we're now explicitly switching to a
      * new foreground (e.g. launching a new app), the deferred resume
-     * must NOT fire — it would memcpy over the shared stack while the
-     * new app task is already running on it, corrupting its state. */
+     * must NOT fire — it would wake the previous app behind the new
+     * one, or spill it just as the new task wants its slot. */
     deferred_resume_hwnd = HWND_NULL;
 
     /* Suspend current foreground (if registered and not background) */
@@ -300,8 +504,8 @@ hwnd_t swap_get_previous(void) {
 void swap_resume_previous(void) {
     /* Find the most recent suspended app in the back-stack.
      * We can NOT call swap_resume() here because the caller (the exiting
-     * app task) is still running on the shared stack — memcpy would
-     * overwrite our own stack frame and hardfault.
+     * app task) may still be running in the slot the previous app lives
+     * in — restoring it would overwrite our own stack frame and hardfault.
      * Instead, set a deferred flag for the compositor to process. */
     while (fg_history_count > 0) {
         hwnd_t prev = fg_history[fg_history_count - 1];
@@ -323,7 +527,7 @@ bool swap_process_deferred(void) {
 
     swap_entry_t *e = find_entry(hwnd);
     if (e && e->suspended) {
-        /* Now safe: compositor runs on its own stack, not shared_stack */
+        /* Now safe: compositor runs on its own stack, not a slot */
         swap_resume(hwnd);
         active_fg = hwnd;
         wm_set_focus(hwnd);
@@ -341,8 +545,9 @@ void swap_force_close(hwnd_t hwnd) {
     /* 1. Get cmd_ctx_t BEFORE deleting the task */
     cmd_ctx_t *ctx = (cmd_ctx_t *)pvTaskGetThreadLocalStoragePointer(task, 0);
 
-    /* 2. Delete the task */
+    /* 2. Delete the task and free its slot */
     vTaskDelete(task);
+    swap_stack_release(task);
 
     /* 3. Destroy the window */
     wm_destroy_window(hwnd);
@@ -383,11 +588,3 @@ TaskHandle_t swap_get_task(hwnd_t hwnd) {
     swap_entry_t *e = find_entry(hwnd);
     return e ? e->task : NULL;
 }
-
-StackType_t *swap_get_shared_stack(void) {
-    return shared_stack;
-}
-
-uint32_t swap_get_stack_words(void) {
-    return SWAP_STACK_WORDS;
-}
@@ -15,27 +15,56 @@
 #include "FreeRTOS.h"
 #include "task.h"
 
-/* Shared SRAM stack size for app tasks */
+/* SRAM stack size for foreground app tasks */
 #define SWAP_STACK_WORDS 2048
 #define SWAP_STACK_BYTES (SWAP_STACK_WORDS * sizeof(StackType_t))  /* 8192 */
 
+/* Foreground apps get their stack from a pool of SRAM slots.  Slot 0 is
+ * static; the others come from the FreeRTOS heap on first use, only
+ * while at least SWAP_SLOT_HEAP_RESERVE bytes stay free, and go back
+ * once no task lives in them.  A suspended app keeps its slot, so
+ * switching back to it copies nothing; only when every slot is taken
+ * is the least recently used suspended app's stack spilled to PSRAM. */
+#ifndef SWAP_STACK_SLOTS
+#define SWAP_STACK_SLOTS 3
+#endif
+#ifndef SWAP_SLOT_HEAP_RESERVE
+#define SWAP_SLOT_HEAP_RESERVE (32 * 1024)
+#endif
+
+typedef struct {
+    uint8_t  slots;          /* SWAP_STACK_SLOTS */
+    uint8_t  allocated;      /* slots with memory */
+    uint8_t  in_use;         /* slots holding a task's stack */
+    uint32_t suspends;
+    uint32_t resumes;
+    uint32_t resident;       /* resumes that found their stack in place */
+    uint32_t spills;         /* stacks moved out to PSRAM */
+    uint32_t restores;       /* stacks brought back from PSRAM */
+    uint32_t bytes_copied;   /* by spills and restores */
+    uint32_t no_slot;        /* tasks created outside the pool */
+} swap_stats_t;
+
 /* Initialize the swap manager — call once at boot before taskbar_init() */
 void swap_init(void);
 
-/* Register an app window + task for swap management.
- * Allocates an 8KB PSRAM save buffer for stack swapping. */
+/* Register an app window + task for swap management */
 void swap_register(hwnd_t hwnd, TaskHandle_t task);
 
-/* Unregister by hwnd — frees PSRAM save buffer */
+/* Unregister by hwnd — frees a spilled stack */
 void swap_unregister(hwnd_t hwnd);
 
 /* Unregister by task handle (for cleanup when task exits) */
 void swap_unregister_by_task(TaskHandle_t task);
 
-/* Suspend an app: vTaskSuspend → memcpy stack→PSRAM → set WF_SUSPENDED */
+/* Suspend an app: vTaskSuspend → set WF_SUSPENDED.  The stack stays in
+ * its slot until another task needs the slot. */
 void swap_suspend(hwnd_t hwnd);
 
-/* Resume an app: memcpy PSRAM→stack → clear WF_SUSPENDED → vTaskResume */
+/* Resume an app: bring its stack back if it was spilled (spilling the
+ * slot's current suspended owner in turn) → clear WF_SUSPENDED →
+ * vTaskResume.  The app stays suspended if its slot is held by a
+ * running task. */
 void swap_resume(hwnd_t hwnd);
 
 /* Suspend old foreground + resume target (single call for focus switch) */
@@ -88,18 +117,25 @@ bool swap_find_by_task(TaskHandle_t task);
 /* Return the task handle registered for a swap entry (NULL if none) */
 TaskHandle_t swap_get_task(hwnd_t hwnd);
 
-/* Return pointer to the shared SRAM stack (for task creation) */
-StackType_t *swap_get_shared_stack(void);
-
-/* Return the stack size in words */
-uint32_t swap_get_stack_words(void);
-
-/* Shared stack usage tracking — prevents two concurrent foreground tasks
- * from using the same stack buffer (e.g. two terminal shells each running
- * an app).  When the stack is busy, callers should allocate a separate
- * stack (e.g. via PSRAM or heap). */
-bool swap_is_stack_busy(void);
-void swap_stack_acquire(void);
-void swap_stack_release(void);
+/* Create a foreground app task on a pool slot (SWAP_STACK_WORDS) with
+ * the caller's TCB.  Returns NULL when no slot can be had — every slot
+ * runs a task, or spilling would need PSRAM that isn't there — and the
+ * caller should give the task a stack of its own. */
+TaskHandle_t swap_create_task(TaskFunction_t fn, const char *name,
+                              void *param, UBaseType_t priority,
+                              StaticTask_t *tcb);
+
+/* Give back the slot of a finished task (no-op for tasks outside the
+ * pool).  An exiting task may release its own slot if it raises its
+ * priority first, so nothing can reuse the slot before vTaskDelete;
+ * a heap slot is then only freed by swap_trim_deferred(). */
+void swap_stack_release(TaskHandle_t task);
+
+/* Free heap slots left behind by tasks that released their own slot.
+ * Call from the idle hook, after those tasks have deleted themselves. */
+void swap_trim_deferred(void);
+
+/* Slot pool counters, for `ps` */
+void swap_get_stats(swap_stats_t *st);
 
 #endif /* SWAP_H */
@@ -746,5 +746,12 @@ unsigned long __in_systable() __aligned(4096) sys_table_ptrs[] = {
     L,                            // 552
     lang_set,                     // 553
     wd_radio,                     // 554
+    wm_invalidate_rect,           // 555
+    psram_get_stats,              // 556
+    snd_set_gain,                 // 557
+    snd_get_stats,                // 558
+    snd_open_ring,                // 559
+    snd_acquire,                  // 560
+    snd_commit,                   // 561
     0
 };
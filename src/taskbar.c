@@ -231,8 +231,11 @@ void taskbar_draw(void) {
 
         /* Draw 16x16 icon in button */
         int offset = is_focused ? 1 : 0;
-        const uint8_t *icon = win->icon ? win->icon : default_icon_16x16;
-        gfx_draw_icon_16(btn_x + 4 + offset, BUTTON_Y + 3 + offset, icon);
+        if (win->icon)
+            gfx_draw_icon(btn_x + 4 + offset, BUTTON_Y + 3 + offset, win->icon);
+        else
+            gfx_draw_icon_16(btn_x + 4 + offset, BUTTON_Y + 3 + offset,
+                             default_icon_16x16);
 
         /* Truncated title text (shifted right for icon).
          * Suspended apps show title in dark gray to indicate they're inactive. */
@@ -49,27 +49,242 @@
 #define TB_FG(attr)        ((attr) & 0x0F)
 #define TB_BG(attr)        ((attr) >> 4)
 
+#define TERM_ROW_BIT(r)    (1u << (r))
+#define TERM_ALL_ROWS(t)   ((t)->rows >= 32 ? 0xFFFFFFFFu : \
+                            TERM_ROW_BIT((t)->rows) - 1u)
+
+/* Client-coordinate rect of one character cell */
+static inline rect_t terminal_cell_rect(int col, int row) {
+    return (rect_t){ col * TERM_FONT_W, row * TERM_FONT_H,
+                     TERM_FONT_W, TERM_FONT_H };
+}
+
+/*==========================================================================
+ * Scrollback ring
+ *
+ * Rows scrolled off the top are appended to a ring of
+ * TERM_SCROLLBACK_LINES rows in PSRAM, TERM_SB_ROW_BYTES each (narrower
+ * grids are padded with blanks, so the history survives a resize).
+ * The ring is only touched with byte loops from SRAM functions — see
+ * terminal_scroll_up for why PSRAM must not be fed to memcpy.
+ *=========================================================================*/
+
+/* Ring size for index arithmetic (never 0, so it also compiles when
+ * scrollback is disabled) */
+#define TERM_SB_DEPTH  (TERM_SCROLLBACK_LINES > 0 ? TERM_SCROLLBACK_LINES : 1)
+
+/* Ring row holding the line k rows above the top of the grid (k >= 1),
+ * or NULL if it is not stored */
+static inline volatile uint8_t *sb_line(const terminal_t *t, int k) {
+    if (!t->sb_ring || k < 1 || k > t->sb_count) return NULL;
+    int slot = t->sb_head - k;
+    if (slot < 0) slot += TERM_SB_DEPTH;
+    return t->sb_ring + slot * TERM_SB_ROW_BYTES;
+}
+
+/* Store one row n slots past the head without publishing it (see
+ * terminal_scroll_up): cols cells from src, or a blank row if src is NULL */
+static void __not_in_flash_func(sb_store)(terminal_t *t, int n,
+                                          const volatile uint8_t *src,
+                                          int cols, uint8_t attr) {
+    int slot = (t->sb_head + n) % TERM_SB_DEPTH;
+    volatile uint8_t *dst = t->sb_ring + slot * TERM_SB_ROW_BYTES;
+    int len = src ? cols * 2 : 0;
+    for (int i = 0; i < len; i++) dst[i] = src[i];
+    for (int i = len; i < TERM_SB_ROW_BYTES; i += 2) {
+        dst[i]     = ' ';
+        dst[i + 1] = attr;
+    }
+}
+
+/* The ring, allocated on first use; NULL when disabled or out of PSRAM */
+static uint8_t *sb_ring(terminal_t *t) {
+    if (TERM_SCROLLBACK_LINES == 0 || t->sb_ring || t->sb_no_psram)
+        return t->sb_ring;
+    t->sb_ring = (uint8_t *)psram_alloc(TERM_SCROLLBACK_LINES *
+                                        TERM_SB_ROW_BYTES);
+    if (!t->sb_ring) t->sb_no_psram = true;
+    return t->sb_ring;
+}
+
+/* Fill shadow rows [r0, r1) with the grid as it looked sb_view lines
+ * back: ring rows above the live top, textbuf rows below it */
+static void __not_in_flash_func(terminal_compose)(terminal_t *t,
+                                                  int r0, int r1) {
+    int cols = t->cols;
+    uint8_t attr = TB_PACK(t->fg_color, t->bg_color);
+    for (int r = r0; r < r1; r++) {
+        int line = r - t->sb_view;
+        volatile uint8_t *src = line >= 0 ? t->textbuf + line * cols * 2
+                                          : sb_line(t, -line);
+        uint8_t *dst = t->shadow + r * cols * 2;
+        for (int i = 0; i < cols * 2; i += 2) {
+            dst[i]     = src ? src[i]     : ' ';
+            dst[i + 1] = src ? src[i + 1] : attr;
+        }
+    }
+}
+
+/* Move the drawn grid by dy pixels.  The compositor shifts the whole
+ * client area, which only matches the grid when the grid fills it;
+ * otherwise the leftover strip would smear into the text — repaint. */
+static void terminal_scroll_client(terminal_t *t, int dy) {
+    if (wm_get_client_rect(t->hwnd).h == t->rows * TERM_FONT_H)
+        wm_scroll_client(t->hwnd, (int16_t)dy);
+    else
+        wm_invalidate(t->hwnd);
+}
+
 /*==========================================================================
  * Helpers
  *=========================================================================*/
 
-static void __not_in_flash_func(terminal_scroll_up)(terminal_t *t) {
-    /* Move rows 1..rows-1 up to rows 0..rows-2.
+static void __not_in_flash_func(terminal_scroll_up)(terminal_t *t, int lines) {
+    int cols = t->cols;
+    int rows = t->rows;
+    if (lines <= 0) return;
+
+    /* The rows leaving the grid go to scrollback, followed by blanks
+     * for any lines a long burst scrolls straight through (terminal_write
+     * fills those in).  Rows the ring would overwrite again are not
+     * stored.  The slots past the head hold the oldest lines, which a
+     * scrollback paint may be reading: they are dropped from the history
+     * and rewritten under the scheduler lock.  The new rows are published
+     * below, under the same lock as the view. */
+    uint8_t attr = TB_PACK(t->fg_color, t->bg_color);
+    int pushed = 0;
+    if (sb_ring(t)) {
+        int gone = lines < rows ? lines : rows;
+        int k = lines > TERM_SCROLLBACK_LINES ? lines - TERM_SCROLLBACK_LINES : 0;
+        int keep_old = TERM_SB_DEPTH - (lines - k);
+        vTaskSuspendAll();
+        if (t->sb_count > keep_old) t->sb_count = keep_old;
+        if (t->sb_view > t->sb_count) {
+            t->sb_view = t->sb_count;
+            t->sb_stale = true;
+        }
+        for (; k < lines; k++, pushed++)
+            sb_store(t, pushed, k < gone ? t->textbuf + k * cols * 2 : NULL,
+                     cols, attr);
+        xTaskResumeAll();
+    }
+    int total = lines;
+    if (lines > rows) lines = rows;
+
+    /* Move rows lines..rows-1 up to rows 0..rows-lines-1.
      * Manual loop instead of memmove() because memmove is in flash and
      * calling it on a PSRAM buffer causes CS0 (flash instruction fetch) +
      * CS1 (PSRAM data) QMI bus contention that hangs the system. */
-    int cols = t->cols;
-    int rows = t->rows;
+    int row_bytes = cols * 2;
+    int keep = rows - lines;
     volatile uint8_t *dst = t->textbuf;
-    volatile uint8_t *src = t->textbuf + cols * 2;
-    int n = cols * 2 * (rows - 1);
+    volatile uint8_t *src = t->textbuf + row_bytes * lines;
+    int n = row_bytes * keep;
     for (int i = 0; i < n; i++) dst[i] = src[i];
-    /* Clear last row */
-    uint8_t attr = TB_PACK(t->fg_color, t->bg_color);
-    uint8_t *last = t->textbuf + cols * 2 * (rows - 1);
-    for (int i = 0; i < cols; i++) {
-        last[i * 2]     = ' ';
-        last[i * 2 + 1] = attr;
+    /* Clear the rows scrolled in */
+    uint8_t *fresh = t->textbuf + row_bytes * keep;
+    for (int i = 0; i < cols * lines; i++) {
+        fresh[i * 2]     = ' ';
+        fresh[i * 2 + 1] = attr;
+    }
+
+    /* Scroll the shadow and the screen the same way: the compositor
+     * moves the client pixels up and paints only the new bottom rows.
+     * The shadow, the pending move and the drawn-cursor row must change
+     * together, before the compositor can paint from any of them —
+     * hence the scheduler lock (the copy is SRAM-only).  While the user
+     * is looking at scrollback the shadow holds the view instead: keep
+     * it still by moving the view back with the text. */
+    vTaskSuspendAll();
+    if (pushed) {
+        t->sb_head = (t->sb_head + pushed) % TERM_SB_DEPTH;
+        t->sb_count += pushed;
+        if (t->sb_count > TERM_SCROLLBACK_LINES)
+            t->sb_count = TERM_SCROLLBACK_LINES;
+    }
+    if (t->sb_view > 0) {
+        t->sb_view += total;
+        if (t->sb_view > t->sb_count) t->sb_view = t->sb_count;
+        t->sb_stale = true;
+    } else {
+        memmove(t->shadow, t->shadow + row_bytes * lines, row_bytes * keep);
+        memcpy(t->shadow + row_bytes * keep, fresh, row_bytes * lines);
+        t->dirty_rows = lines >= 32 ? 0 : t->dirty_rows >> lines;
+        if (t->cursor_drawn_col >= 0) {
+            t->cursor_drawn_row -= lines;
+            if (t->cursor_drawn_row < 0) t->cursor_drawn_col = -1;
+        }
+        terminal_scroll_client(t, -lines * TERM_FONT_H);
+    }
+    xTaskResumeAll();
+}
+
+/* Commit the dirty rows of textbuf to the shadow and invalidate just the
+ * cells that differ.  Changed spans on consecutive rows are merged into
+ * one rect.  Also invalidates the old and new cursor cells when the
+ * cursor moved, so it follows the text without waiting for a blink. */
+static void __not_in_flash_func(terminal_flush)(terminal_t *t) {
+    /* While scrollback is shown the shadow holds the view, not textbuf:
+     * just note that the live grid moved on.  The lock keeps the
+     * compositor from switching views halfway through the diff. */
+    vTaskSuspendAll();
+    if (t->sb_view > 0) {
+        t->sb_stale = true;
+        xTaskResumeAll();
+        return;
+    }
+
+    uint32_t dirty = t->textbuf_shared ? TERM_ALL_ROWS(t) : t->dirty_rows;
+    t->dirty_rows = 0;
+
+    int cols = t->cols;
+    int run_row = -1, run_c0 = 0, run_c1 = 0;
+
+    for (int row = 0; row <= t->rows; row++) {
+        int c0 = cols, c1 = 0;
+
+        if (row < t->rows && (dirty & TERM_ROW_BIT(row))) {
+            /* volatile: see terminal_scroll_up — no flash memcmp */
+            volatile uint8_t *src = t->textbuf + row * cols * 2;
+            uint8_t *dst = t->shadow + row * cols * 2;
+            for (int c = 0; c < cols; c++) {
+                uint8_t ch = src[c * 2], attr = src[c * 2 + 1];
+                if (ch != dst[c * 2] || attr != dst[c * 2 + 1]) {
+                    dst[c * 2]     = ch;
+                    dst[c * 2 + 1] = attr;
+                    if (c < c0) c0 = c;
+                    c1 = c + 1;
+                }
+            }
+        }
+
+        if (c0 < c1) {
+            if (run_row < 0) {
+                run_row = row;
+                run_c0 = c0;
+                run_c1 = c1;
+            } else {
+                if (c0 < run_c0) run_c0 = c0;
+                if (c1 > run_c1) run_c1 = c1;
+            }
+        } else if (run_row >= 0) {
+            wm_invalidate_rect(t->hwnd,
+                (rect_t){ run_c0 * TERM_FONT_W, run_row * TERM_FONT_H,
+                          (run_c1 - run_c0) * TERM_FONT_W,
+                          (row - run_row) * TERM_FONT_H });
+            run_row = -1;
+        }
+    }
+    xTaskResumeAll();
+
+    if (t->cursor_drawn_col != t->cursor_col ||
+        t->cursor_drawn_row != t->cursor_row) {
+        if (t->cursor_drawn_col >= 0)
+            wm_invalidate_rect(t->hwnd,
+                terminal_cell_rect(t->cursor_drawn_col, t->cursor_drawn_row));
+        if (t->cursor_visible)
+            wm_invalidate_rect(t->hwnd,
+                terminal_cell_rect(t->cursor_col, t->cursor_row));
     }
 }
 
@@ -116,35 +331,25 @@ terminal_t *terminal_get_task_terminal(void) {
 /*==========================================================================
  * Paint handler — draws the character grid using 8x16 font
  *
- * When the textbuf lives in PSRAM, thousands of individual byte reads
- * from the uncached XIP window (0x15000000) interleave with flash
- * instruction fetches through the shared QMI bus, which can cause
- * bus hangs.  We snapshot the textbuf into a SRAM shadow buffer once
- * via memcpy, then render entirely from SRAM.
+ * Renders from the per-terminal SRAM shadow, never from textbuf: when
+ * the textbuf lives in PSRAM, thousands of individual byte reads from
+ * the uncached XIP window (0x15000000) interleave with flash instruction
+ * fetches through the shared QMI bus, which can cause bus hangs.  The
+ * shadow is also exactly what terminal_flush() has invalidated, so a
+ * damage rect always repaints the content it was queued for.
+ *
+ * Only cells intersecting the display clip are drawn: when the
+ * compositor repaints a damage rect (a changed span, the new bottom row
+ * after a scroll, the cursor cell on a blink) the handler touches just
+ * those cells instead of the whole grid.
  *=========================================================================*/
 
-static uint8_t paint_shadow[TERM_MAX_TEXTBUF_SIZE];
-
 static void __not_in_flash_func(terminal_paint)(hwnd_t hwnd) {
     terminal_t *t = terminal_from_hwnd(hwnd);
-    if (!t || !t->textbuf) return;
+    if (!t || !t->shadow) return;
 
     int term_cols = t->cols;
     int term_rows = t->rows;
-    int bufsize = term_cols * term_rows * 2;
-
-    /* Snapshot textbuf into SRAM — one bulk copy instead of thousands
-     * of individual PSRAM reads during the rendering loop.
-     * Manual loop instead of memcpy() because memcpy is in flash and
-     * calling it on a PSRAM source causes QMI bus contention (CS0
-     * instruction fetch + CS1 data read simultaneously → bus hang).
-     * volatile source prevents the compiler from converting this back
-     * into a memcpy call. */
-    {
-        volatile uint8_t *src = t->textbuf;
-        for (int i = 0; i < bufsize; i++)
-            paint_shadow[i] = src[i];
-    }
 
     /* Compute client-area origin in screen coordinates directly,
      * bypassing wd_begin/wd_end to avoid per-pixel clipping overhead. */
@@ -160,54 +365,127 @@ static void __not_in_flash_func(terminal_paint)(hwnd_t hwnd) {
         oy = win->frame.y;
     }
 
+    /* Row/column range that intersects the display clip */
+    int row0 = (display_clip.y0 - oy) / TERM_FONT_H;
+    int row1 = (display_clip.y1 - oy + TERM_FONT_H - 1) / TERM_FONT_H;
+    int col0 = (display_clip.x0 - ox) / TERM_FONT_W;
+    int col1 = (display_clip.x1 - ox + TERM_FONT_W - 1) / TERM_FONT_W;
+    if (row0 < 0) row0 = 0;
+    if (col0 < 0) col0 = 0;
+    if (row1 > term_rows) row1 = term_rows;
+    if (col1 > term_cols) col1 = term_cols;
+    if (row0 >= row1 || col0 >= col1) return;
+
+    const uint8_t *shadow = t->shadow;
+
     /* Draw character grid using fast glyph blitter */
-    for (int row = 0; row < term_rows; row++) {
+    for (int row = row0; row < row1; row++) {
         int sy = oy + row * TERM_FONT_H;
-        if (sy + TERM_FONT_H <= 0 || sy >= display_height) continue;
 
-        for (int col = 0; col < term_cols; col++) {
+        for (int col = col0; col < col1; col++) {
             int sx = ox + col * TERM_FONT_W;
-            if (sx + TERM_FONT_W <= 0 || sx >= display_width) continue;
 
             int off = (row * term_cols + col) * 2;
-            uint8_t ch   = paint_shadow[off];
-            uint8_t attr = paint_shadow[off + 1];
+            uint8_t ch   = shadow[off];
+            uint8_t attr = shadow[off + 1];
             uint8_t fg   = TB_FG(attr);
             uint8_t bg   = TB_BG(attr);
 
             const uint8_t *glyph = font8x16_get_glyph(ch);
 
-            /* Fast path: even x and fully on-screen */
+            /* Fast path: even x and fully inside the display clip */
             if (!(sx & 1) &&
-                sx >= 0 && (sx + TERM_FONT_W) <= display_width &&
-                sy >= 0 && (sy + TERM_FONT_H) <= display_height) {
+                display_clip_contains(sx, sy, TERM_FONT_W, TERM_FONT_H)) {
                 display_blit_glyph_8wide(sx, sy, glyph, TERM_FONT_H, fg, bg);
             } else {
                 /* Fallback: per-pixel for partially clipped chars */
                 for (int gr = 0; gr < TERM_FONT_H; gr++) {
-                    int py = sy + gr;
-                    if ((unsigned)py >= (unsigned)display_height) continue;
                     uint8_t bits = glyph[gr];
-                    for (int gc = 0; gc < TERM_FONT_W; gc++) {
-                        int px = sx + gc;
-                        if ((unsigned)px >= (unsigned)display_width) continue;
-                        display_set_pixel_fast(px, py,
-                                               (bits & (1 << gc)) ? fg : bg);
-                    }
+                    for (int gc = 0; gc < TERM_FONT_W; gc++)
+                        display_set_pixel(sx + gc, sy + gr,
+                                          (bits & (1 << gc)) ? fg : bg);
                 }
             }
         }
     }
 
-    /* Draw blinking DOS-style underline cursor (bottom 2 scanlines) */
-    if (t->cursor_visible &&
-        t->cursor_col >= 0 && t->cursor_col < term_cols &&
-        t->cursor_row >= 0 && t->cursor_row < term_rows) {
+    /* Cells repainted above no longer carry an underline */
+    if (t->cursor_drawn_col >= col0 && t->cursor_drawn_col < col1 &&
+        t->cursor_drawn_row >= row0 && t->cursor_drawn_row < row1)
+        t->cursor_drawn_col = -1;
+
+    /* Draw blinking DOS-style underline cursor (bottom 2 scanlines);
+     * not while scrollback is shown — the cursor belongs to the live grid */
+    if (t->cursor_visible && t->sb_view == 0 &&
+        t->cursor_col >= col0 && t->cursor_col < col1 &&
+        t->cursor_row >= row0 && t->cursor_row < row1) {
         int cx = ox + t->cursor_col * TERM_FONT_W;
         int cy = oy + t->cursor_row * TERM_FONT_H;
         display_hline_safe(cx, cy + TERM_FONT_H - 2, TERM_FONT_W, t->fg_color);
         display_hline_safe(cx, cy + TERM_FONT_H - 1, TERM_FONT_W, t->fg_color);
+        t->cursor_drawn_col = t->cursor_col;
+        t->cursor_drawn_row = t->cursor_row;
+    }
+}
+
+/*==========================================================================
+ * Scrollback view
+ *
+ * Runs in the compositor task (from terminal_event).  The writer
+ * changes the shadow, the ring and the view under the scheduler lock,
+ * so the compositor never sees them halfway through an update.
+ * Small steps move the shadow and the drawn pixels and compose only the
+ * rows scrolled in; output that arrived meanwhile (sb_stale) or a jump
+ * of a full page recomposes the whole grid.
+ *=========================================================================*/
+
+#define TERM_WHEEL_LINES  3
+
+static void terminal_set_view(terminal_t *t, int v) {
+    if (v > t->sb_count) v = t->sb_count;
+    if (v < 0) v = 0;
+    int d = v - t->sb_view;
+    if (d == 0 && !t->sb_stale) return;
+
+    int rows = t->rows;
+    int row_bytes = t->cols * 2;
+    int shift = d < 0 ? -d : d;
+    t->sb_view = v;
+
+    if (t->sb_stale || shift >= rows) {
+        terminal_compose(t, 0, rows);
+        t->sb_stale = false;
+        if (v == 0) t->dirty_rows = 0;   /* shadow matches textbuf again */
+        t->cursor_drawn_col = -1;
+        wm_invalidate(t->hwnd);
+    } else {
+        if (d > 0) {
+            /* Back in time: text moves down, older lines come in on top */
+            memmove(t->shadow + row_bytes * d, t->shadow,
+                    row_bytes * (rows - d));
+            terminal_compose(t, 0, d);
+        } else {
+            memmove(t->shadow, t->shadow + row_bytes * shift,
+                    row_bytes * (rows - shift));
+            terminal_compose(t, rows - shift, rows);
+        }
+        terminal_scroll_client(t, d * TERM_FONT_H);
+
+        /* The underline moved with the pixels — repaint its cell */
+        if (t->cursor_drawn_col >= 0) {
+            t->cursor_drawn_row += d;
+            if (t->cursor_drawn_row >= 0 && t->cursor_drawn_row < rows)
+                wm_invalidate_rect(t->hwnd,
+                    terminal_cell_rect(t->cursor_drawn_col,
+                                       t->cursor_drawn_row));
+            else
+                t->cursor_drawn_col = -1;
+        }
     }
+
+    if (v == 0 && t->cursor_visible)
+        wm_invalidate_rect(t->hwnd,
+                           terminal_cell_rect(t->cursor_col, t->cursor_row));
 }
 
 /*==========================================================================
@@ -249,14 +527,30 @@ static bool terminal_event(hwnd_t hwnd, const window_event_t *event) {
 
     switch (event->type) {
     case WM_CHAR:
+        terminal_set_view(t, 0);
         terminal_input_push(t, (uint8_t)event->charev.ch);
         return true;
 
+    case WM_MOUSEWHEEL:
+        terminal_set_view(t, t->sb_view + event->wheel.delta * TERM_WHEEL_LINES);
+        return true;
+
     case WM_SIZE:
         terminal_resize(t, event->size.w, event->size.h);
         return true;
 
     case WM_KEYDOWN:
+        /* Shift+PgUp / Shift+PgDn: page through scrollback */
+        if ((event->key.scancode == 0x4B || event->key.scancode == 0x4E) &&
+            (event->key.modifiers & KMOD_SHIFT)) {
+            int page = t->rows - 1;
+            terminal_set_view(t, t->sb_view +
+                              (event->key.scancode == 0x4B ? page : -page));
+            return true;
+        }
+        /* Any other key (not a lone modifier) returns to live output */
+        if (event->key.scancode < 0xE0)
+            terminal_set_view(t, 0);
         /* Alt+Enter: toggle fullscreen (before Enter→'\n' mapping) */
         if (event->key.scancode == 0x28 && (event->key.modifiers & KMOD_ALT)) {
             wm_toggle_fullscreen(hwnd);
@@ -340,7 +634,15 @@ static void blink_callback(TimerHandle_t xTimer) {
     terminal_t *t = (terminal_t *)pvTimerGetTimerID(xTimer);
     if (!t) return;
     t->cursor_visible = !t->cursor_visible;
-    wm_invalidate(t->hwnd);
+    /* Repaint only the cursor cell (and the cell it was last drawn in,
+     * in case terminal_set_cursor moved it without an invalidate) */
+    if (t->cursor_drawn_col >= 0 &&
+        (t->cursor_drawn_col != t->cursor_col ||
+         t->cursor_drawn_row != t->cursor_row))
+        wm_invalidate_rect(t->hwnd, terminal_cell_rect(t->cursor_drawn_col,
+                                                       t->cursor_drawn_row));
+    wm_invalidate_rect(t->hwnd, terminal_cell_rect(t->cursor_col,
+                                                   t->cursor_row));
 }
 
 /*==========================================================================
@@ -368,6 +670,7 @@ hwnd_t terminal_create(void) {
     t->fg_color = COLOR_WHITE;
     t->bg_color = COLOR_BLACK;
     t->cursor_visible = true;
+    t->cursor_drawn_col = -1;
     t->cols = TERM_COLS;
     t->rows = TERM_ROWS;
 
@@ -393,6 +696,15 @@ hwnd_t terminal_create(void) {
         t->textbuf[i * 2 + 1] = attr;
     }
 
+    /* Paint shadow always lives in SRAM */
+    t->shadow = (uint8_t *)pvPortMalloc(t->textbuf_size);
+    if (!t->shadow) {
+        psram_free(t->textbuf);
+        vPortFree(t);
+        return HWND_NULL;
+    }
+    memcpy(t->shadow, t->textbuf, t->textbuf_size);
+
     /* Create input semaphore */
     t->input_sem = xSemaphoreCreateCounting(64, 0);
 
@@ -418,6 +730,7 @@ hwnd_t terminal_create(void) {
 
     if (t->hwnd == HWND_NULL) {
         vSemaphoreDelete(t->input_sem);
+        vPortFree(t->shadow);
         vPortFree(t->textbuf);
         vPortFree(t);
         return HWND_NULL;
@@ -472,65 +785,179 @@ void terminal_destroy(terminal_t *t) {
         psram_free(t->textbuf);
         t->textbuf = NULL;
     }
+    if (t->shadow) {
+        vPortFree(t->shadow);
+        t->shadow = NULL;
+    }
+    if (t->sb_ring) {
+        psram_free(t->sb_ring);
+        t->sb_ring = NULL;
+    }
 
     /* Free the terminal struct itself */
     vPortFree(t);
 }
 
-void __not_in_flash_func(terminal_putc)(terminal_t *t, char c) {
-    if (!t || !t->textbuf) return;
+/*==========================================================================
+ * Output — all console text goes through terminal_write
+ *
+ * A burst is processed in two passes.  The first only replays the
+ * cursor movement to count how many rows the burst scrolls; the grid is
+ * then scrolled once by that amount and the second pass writes the text
+ * at its final position (rows that scroll off again go straight into
+ * the scrollback ring).
+ * Runs of printable characters are copied into textbuf a row segment at
+ * a time, and the window is invalidated once, by terminal_flush, at the
+ * end of the burst.
+ *=========================================================================*/
 
-    switch (c) {
-    case '\n':
-        t->cursor_col = 0;
-        t->cursor_row++;
-        break;
-    case '\r':
-        t->cursor_col = 0;
-        break;
-    case '\b':
-        if (t->cursor_col > 0) {
-            t->cursor_col--;
-            TB_CHAR(t, t->cursor_row, t->cursor_col) = ' ';
-            TB_ATTR(t, t->cursor_row, t->cursor_col) =
-                TB_PACK(t->fg_color, t->bg_color);
+static inline bool terminal_is_ctrl(char c) {
+    return c == '\n' || c == '\r' || c == '\b' || c == '\t';
+}
+
+/* Cells of a row during a burst: the grid for row >= 0, else the
+ * scrollback line the row has already scrolled into (NULL if not kept) */
+static inline volatile uint8_t *terminal_row_cells(terminal_t *t, int row) {
+    return row >= 0 ? t->textbuf + row * t->cols * 2 : sb_line(t, -row);
+}
+
+/* Rows the cursor would run off the bottom while writing buf */
+static int __not_in_flash_func(terminal_count_scroll)(const terminal_t *t,
+                                                      const char *buf,
+                                                      size_t len) {
+    int cols = t->cols, rows = t->rows;
+    int col = t->cursor_col, row = t->cursor_row;
+    int lines = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        switch (buf[i]) {
+        case '\n':
+            col = 0;
+            row++;
+            break;
+        case '\r':
+            col = 0;
+            break;
+        case '\b':
+            if (col > 0) col--;
+            break;
+        case '\t':
+            col = (col + 8) & ~7;
+            if (col >= cols) {
+                col = 0;
+                row++;
+            }
+            break;
+        default:
+            if (col >= cols) {
+                col = 0;
+                row++;
+            }
+            if (row >= rows) {
+                lines++;
+                row = rows - 1;
+            }
+            col++;
+            break;
         }
-        break;
-    case '\t':
-        t->cursor_col = (t->cursor_col + 8) & ~7;
-        if (t->cursor_col >= t->cols) {
-            t->cursor_col = 0;
-            t->cursor_row++;
+        if (row >= rows) {
+            lines++;
+            row = rows - 1;
         }
-        break;
-    default:
-        if (t->cursor_col >= t->cols) {
-            t->cursor_col = 0;
-            t->cursor_row++;
+    }
+    return lines;
+}
+
+void __not_in_flash_func(terminal_write)(terminal_t *t, const char *buf,
+                                         size_t len) {
+    if (!t || !t->textbuf || !buf || !len) return;
+
+    int lines = terminal_count_scroll(t, buf, len);
+    if (lines > 0) {
+        terminal_scroll_up(t, lines);
+        t->cursor_row -= lines;   /* may go negative: those rows scroll off */
+    }
+
+    int     cols = t->cols;
+    int     col  = t->cursor_col, row = t->cursor_row;
+    uint8_t attr = TB_PACK(t->fg_color, t->bg_color);
+    size_t  i = 0;
+
+    while (i < len) {
+        char c = buf[i];
+
+        if (!terminal_is_ctrl(c)) {
+            if (col >= cols) {
+                col = 0;
+                row++;
+            }
+            /* Printable run up to the end of this row */
+            size_t n = 0;
+            while (i + n < len && n < (size_t)(cols - col) &&
+                   !terminal_is_ctrl(buf[i + n]))
+                n++;
+            volatile uint8_t *cell = terminal_row_cells(t, row);
+            if (cell) {
+                /* Rows above the grid are published ring rows: fill
+                 * them under the lock, like terminal_scroll_up */
+                if (row < 0) vTaskSuspendAll();
+                cell += col * 2;
+                for (size_t k = 0; k < n; k++) {
+                    cell[k * 2]     = (uint8_t)buf[i + k];
+                    cell[k * 2 + 1] = attr;
+                }
+                if (row >= 0) t->dirty_rows |= TERM_ROW_BIT(row);
+                else xTaskResumeAll();
+            }
+            col += (int)n;
+            i += n;
+            continue;
         }
-        if (t->cursor_row >= t->rows) {
-            terminal_scroll_up(t);
-            t->cursor_row = t->rows - 1;
+
+        switch (c) {
+        case '\n':
+            col = 0;
+            row++;
+            break;
+        case '\r':
+            col = 0;
+            break;
+        case '\b':
+            if (col > 0) {
+                col--;
+                volatile uint8_t *cell = terminal_row_cells(t, row);
+                if (cell) {
+                    if (row < 0) vTaskSuspendAll();   /* ring row */
+                    cell[col * 2]     = ' ';
+                    cell[col * 2 + 1] = attr;
+                    if (row >= 0) t->dirty_rows |= TERM_ROW_BIT(row);
+                    else xTaskResumeAll();
+                }
+            }
+            break;
+        case '\t':
+            col = (col + 8) & ~7;
+            if (col >= cols) {
+                col = 0;
+                row++;
+            }
+            break;
         }
-        TB_CHAR(t, t->cursor_row, t->cursor_col) = (uint8_t)c;
-        TB_ATTR(t, t->cursor_row, t->cursor_col) =
-            TB_PACK(t->fg_color, t->bg_color);
-        t->cursor_col++;
-        break;
+        i++;
     }
 
-    /* Handle scroll after newline/tab */
-    if (t->cursor_row >= t->rows) {
-        terminal_scroll_up(t);
-        t->cursor_row = t->rows - 1;
-    }
+    t->cursor_col = col;
+    t->cursor_row = row;
+    terminal_flush(t);
+}
 
-    wm_invalidate(t->hwnd);
+void __not_in_flash_func(terminal_putc)(terminal_t *t, char c) {
+    terminal_write(t, &c, 1);
 }
 
 void terminal_puts(terminal_t *t, const char *s) {
-    if (!t || !s) return;
-    while (*s) terminal_putc(t, *s++);
+    if (!s) return;
+    terminal_write(t, s, strlen(s));
 }
 
 void terminal_printf(terminal_t *t, const char *fmt, ...) {
@@ -553,7 +980,8 @@ void __not_in_flash_func(terminal_clear)(terminal_t *t, uint8_t color) {
     }
     t->cursor_col = 0;
     t->cursor_row = 0;
-    wm_invalidate(t->hwnd);
+    t->dirty_rows = TERM_ALL_ROWS(t);
+    terminal_flush(t);
 }
 
 void terminal_set_cursor(terminal_t *t, int col, int row) {
@@ -582,7 +1010,8 @@ void __not_in_flash_func(terminal_draw_text)(terminal_t *t, const char *str,
         TB_CHAR(t, row, c) = (uint8_t)str[i];
         TB_ATTR(t, row, c) = attr;
     }
-    wm_invalidate(t->hwnd);
+    t->dirty_rows |= TERM_ROW_BIT(row);
+    terminal_flush(t);
 }
 
 int terminal_get_cursor_col(terminal_t *t) {
@@ -655,14 +1084,30 @@ void terminal_resize(terminal_t *t, int client_w, int client_h) {
             dst[i] = src[i];
     }
 
-    /* Swap: update textbuf pointer first (atomic on ARM), then dims */
+    uint8_t *new_shadow = (uint8_t *)pvPortMalloc(new_size);
+    if (!new_shadow) {
+        vPortFree(new_buf);
+        return;
+    }
+    memcpy(new_shadow, new_buf, new_size);
+
+    /* Swap buffers and dims together so the paint handler never sees
+     * a buffer paired with the other size */
+    uint8_t *old_shadow = t->shadow;
+    vTaskSuspendAll();
     t->textbuf = new_buf;
+    t->shadow = new_shadow;
     t->cols = new_cols;
     t->rows = new_rows;
     t->textbuf_size = new_size;
+    t->dirty_rows = 0;
+    t->sb_view = 0;            /* the new shadow is the live grid */
+    t->sb_stale = false;
+    xTaskResumeAll();
 
-    /* Free old buffer */
+    /* Free old buffers */
     psram_free(old_buf);
+    vPortFree(old_shadow);
 
     /* Clamp cursor */
     if (t->cursor_col >= new_cols) t->cursor_col = new_cols - 1;
@@ -710,7 +1155,10 @@ terminal_t *terminal_get_active(void) {
 }
 
 uint8_t *terminal_get_textbuf(terminal_t *t) {
-    return t ? t->textbuf : NULL;
+    if (!t) return NULL;
+    /* The caller may write cells behind our back from now on */
+    t->textbuf_shared = true;
+    return t->textbuf;
 }
 
 size_t terminal_get_textbuf_size(terminal_t *t) {
@@ -719,5 +1167,7 @@ size_t terminal_get_textbuf_size(terminal_t *t) {
 
 void terminal_invalidate_active(void) {
     terminal_t *t = terminal_get_active();
-    if (t) wm_invalidate(t->hwnd);
+    if (!t || !t->textbuf) return;
+    t->dirty_rows = TERM_ALL_ROWS(t);
+    terminal_flush(t);
 }
@@ -29,6 +29,16 @@
 #define TERM_MAX_COLS  80
 #define TERM_MAX_ROWS  30
 #define TERM_MAX_TEXTBUF_SIZE  (TERM_MAX_COLS * TERM_MAX_ROWS * 2)  /* 4800 bytes */
+/* dirty_rows is a 32-bit row mask */
+_Static_assert(TERM_MAX_ROWS <= 32, "terminal dirty_rows mask too small");
+
+/* Scrollback depth in lines (rows scrolled off the top, kept in PSRAM,
+ * TERM_MAX_COLS cells each — 160 bytes/line).  Override with
+ * -DTERM_SCROLLBACK_LINES=n; 0 disables scrollback. */
+#ifndef TERM_SCROLLBACK_LINES
+#define TERM_SCROLLBACK_LINES  2000
+#endif
+#define TERM_SB_ROW_BYTES      (TERM_MAX_COLS * 2)
 
 /*
  * Text-mode buffer layout (MOS2-compatible):
@@ -54,6 +64,24 @@ struct terminal {
     uint8_t *textbuf;
     size_t   textbuf_size;
 
+    /* SRAM copy of textbuf as last handed to the compositor (same
+     * layout).  The paint handler renders from it; terminal_flush()
+     * diffs dirty rows against it and invalidates only changed cells. */
+    uint8_t *shadow;
+    uint32_t dirty_rows;       /* bit n = row n written since last flush */
+    bool     textbuf_shared;   /* get_buffer() handed out — diff all rows */
+
+    /* Scrollback ring in PSRAM, allocated on the first row scrolled off.
+     * sb_view > 0 shows the grid that many lines back: the view is
+     * composed into the shadow (textbuf is untouched) and stays frozen
+     * while output continues underneath. */
+    uint8_t *sb_ring;          /* TERM_SCROLLBACK_LINES rows, or NULL */
+    int      sb_head;          /* slot the next row goes to */
+    int      sb_count;         /* rows stored */
+    int      sb_view;          /* lines scrolled back, 0 = live */
+    bool     sb_stale;         /* output arrived while viewing */
+    bool     sb_no_psram;      /* allocation failed — don't retry */
+
     /* Current grid dimensions (dynamic — changes on resize) */
     int      cols, rows;
 
@@ -61,6 +89,10 @@ struct terminal {
     uint8_t  fg_color, bg_color;
     bool     cursor_visible;
 
+    /* Cell where the blinking cursor was last painted (-1 = none) —
+     * the blink timer invalidates just this cell and the current one */
+    int      cursor_drawn_col, cursor_drawn_row;
+
     /* Keyboard input ring buffer (for terminal_getch) */
     uint8_t  input_buf[64];
     uint8_t  in_head, in_tail;
@@ -106,6 +138,9 @@ terminal_t *terminal_get_task_terminal(void);
 /* Console output */
 void terminal_putc(terminal_t *t, char c);
 void terminal_puts(terminal_t *t, const char *s);
+/* Write len bytes (no NUL needed) as one burst: a single scroll and a
+ * single repaint request however many lines it contains */
+void terminal_write(terminal_t *t, const char *buf, size_t len);
 void terminal_printf(terminal_t *t, const char *fmt, ...)
     __attribute__((format(printf, 2, 3)));
 void terminal_clear(terminal_t *t, uint8_t color);
@@ -142,7 +177,8 @@ void terminal_resize(terminal_t *t, int client_w, int client_h);
 int terminal_get_cols(terminal_t *t);
 int terminal_get_rows(terminal_t *t);
 
-/* Force repaint of the active terminal (call after direct textbuf writes) */
+/* Repaint whatever changed in the active terminal's textbuf
+ * (call after direct textbuf writes) */
 void terminal_invalidate_active(void);
 
 /* Notify per-terminal stdin waiters (called from keyboard.c) */
@@ -24,6 +24,7 @@
 #include "FreeRTOS.h"
 #include "task.h"
 #include <string.h>
+#include <stdint.h>
 
 
 /*==========================================================================
@@ -59,11 +60,26 @@ static rect_t  expose_rects[EXPOSE_MAX];
 static uint8_t expose_count = 0;
 
 
-/* Per-window icon storage — copied here so icons survive fos_apps[] rescan */
-#define ICON16_SIZE 256
-#define ICON32_SIZE 1024
-static uint8_t   icon_pool[WM_MAX_WINDOWS][ICON16_SIZE];
-static uint8_t   icon32_pool[WM_MAX_WINDOWS][ICON32_SIZE];
+/* Per-window damage lists (screen coordinates).
+ * wm_invalidate_rect() queues client-area damage; the compositor adds
+ * frame damage where an expose rect or a lower window's repaint touches
+ * a window.  Kept outside window_t to avoid struct bloat.  Overlapping
+ * or touching rects are merged on insert; when the list is full the new
+ * rect is merged into the entry whose bounding box grows the least.
+ * scroll_dy accumulates wm_scroll_client() requests; it is taken
+ * together with the rects so the move and the damage stay in step. */
+#define WM_DAMAGE_MAX 4
+
+typedef struct {
+    rect_t r;
+    bool   frame;   /* decorations must be redrawn inside r as well */
+} damage_rect_t;
+
+static struct {
+    damage_rect_t rects[WM_DAMAGE_MAX];
+    uint8_t       count;
+    int16_t       scroll_dy;   /* pending client scroll, pixels */
+} damage[WM_MAX_WINDOWS];
 
 /* Pending icon — set before wm_create_window(), consumed by it */
 static const uint8_t *pending_icon = NULL;
@@ -114,6 +130,98 @@ static inline rect_t rect_union(const rect_t *a, const rect_t *b) {
     return (rect_t){ x0, y0, x1 - x0, y1 - y0 };
 }
 
+/* Rectangle intersection — returns false (and leaves *out untouched)
+ * when the rects do not overlap */
+static inline bool rect_intersect(const rect_t *a, const rect_t *b,
+                                  rect_t *out) {
+    int16_t x0 = a->x > b->x ? a->x : b->x;
+    int16_t y0 = a->y > b->y ? a->y : b->y;
+    int16_t x1 = (a->x + a->w) < (b->x + b->w) ? (a->x + a->w) : (b->x + b->w);
+    int16_t y1 = (a->y + a->h) < (b->y + b->h) ? (a->y + a->h) : (b->y + b->h);
+    if (x0 >= x1 || y0 >= y1) return false;
+    *out = (rect_t){ x0, y0, x1 - x0, y1 - y0 };
+    return true;
+}
+
+/* Overlap-or-adjacent test: merging touching rects keeps a run of
+ * invalidated text cells as one span instead of one rect per cell */
+static inline bool rect_touches(const rect_t *a, const rect_t *b) {
+    return a->x <= b->x + b->w && a->x + a->w >= b->x &&
+           a->y <= b->y + b->h && a->y + a->h >= b->y;
+}
+
+static inline int32_t rect_area(const rect_t *r) {
+    return (int32_t)r->w * r->h;
+}
+
+/* Client area of a window in screen coordinates */
+static rect_t client_screen_rect(const window_t *win) {
+    if (!(win->flags & WF_BORDER))
+        return win->frame;
+    point_t co = theme_client_origin(&win->frame, win->flags);
+    rect_t  cr = theme_client_rect(&win->frame, win->flags);
+    return (rect_t){ co.x, co.y, cr.w, cr.h };
+}
+
+/* Add a screen-space rect to a window's damage list.  The rect is
+ * clipped to the window frame and the screen, then coalesced. */
+static void damage_add(uint8_t idx, rect_t r, bool frame) {
+    rect_t screen = { 0, 0, display_width, display_height };
+    if (!rect_intersect(&r, &windows[idx].frame, &r)) return;
+    if (!rect_intersect(&r, &screen, &r)) return;
+
+    taskENTER_CRITICAL();
+    damage_rect_t *dl = damage[idx].rects;
+    uint8_t n = damage[idx].count;
+
+    /* Absorb every entry the new rect overlaps or touches */
+    for (uint8_t k = 0; k < n; ) {
+        if (rect_touches(&r, &dl[k].r)) {
+            r = rect_union(&r, &dl[k].r);
+            frame |= dl[k].frame;
+            dl[k] = dl[--n];
+            k = 0;  /* grown rect may now touch an earlier entry */
+        } else {
+            k++;
+        }
+    }
+
+    if (n < WM_DAMAGE_MAX) {
+        dl[n].r = r;
+        dl[n].frame = frame;
+        n++;
+    } else {
+        /* Full — merge into the entry whose bounding box grows least */
+        uint8_t best = 0;
+        int32_t best_cost = INT32_MAX;
+        for (uint8_t k = 0; k < n; k++) {
+            rect_t u = rect_union(&r, &dl[k].r);
+            int32_t cost = rect_area(&u) - rect_area(&dl[k].r);
+            if (cost < best_cost) { best_cost = cost; best = k; }
+        }
+        dl[best].r = rect_union(&r, &dl[best].r);
+        dl[best].frame |= frame;
+    }
+    damage[idx].count = n;
+    taskEXIT_CRITICAL();
+}
+
+/* Move a window's damage list into out[] and its pending scroll into
+ * *scroll, and clear both.  Damage added by other tasks while the window
+ * is being painted lands in the fresh list and is picked up by the next
+ * composite. */
+static uint8_t damage_take(uint8_t idx, damage_rect_t *out,
+                           int16_t *scroll) {
+    taskENTER_CRITICAL();
+    uint8_t n = damage[idx].count;
+    memcpy(out, damage[idx].rects, n * sizeof(damage_rect_t));
+    damage[idx].count = 0;
+    *scroll = damage[idx].scroll_dy;
+    damage[idx].scroll_dy = 0;
+    taskEXIT_CRITICAL();
+    return n;
+}
+
 /*==========================================================================
  * Window Manager API — stub implementations
  *=========================================================================*/
@@ -121,6 +229,7 @@ static inline rect_t rect_union(const rect_t *a, const rect_t *b) {
 void wm_init(void) {
     wm_event_init();
     memset(windows, 0, sizeof(windows));
+    memset(damage, 0, sizeof(damage));
     memset(z_stack, 0, sizeof(z_stack));
     z_count = 0;
     focus_hwnd = HWND_NULL;
@@ -135,6 +244,8 @@ hwnd_t wm_create_window(int16_t x, int16_t y, int16_t w, int16_t h,
         if (!(windows[i].flags & WF_ALIVE)) {
             window_t *win = &windows[i];
             memset(win, 0, sizeof(*win));
+            damage[i].count = 0;
+            damage[i].scroll_dy = 0;
             win->flags = WF_ALIVE | WF_VISIBLE | WF_DIRTY | WF_FRAME_DIRTY | (style & 0x1978);
             win->state = WS_NORMAL;
             win->frame = (rect_t){ x, y, w, h };
@@ -148,21 +259,12 @@ hwnd_t wm_create_window(int16_t x, int16_t y, int16_t w, int16_t h,
                 win->title[sizeof(win->title) - 1] = '\0';
             }
 
-            /* Assign pending icon (if any) */
-            if (pending_icon) {
-                memcpy(icon_pool[i], pending_icon, ICON16_SIZE);
-                win->icon = icon_pool[i];
-                pending_icon = NULL;
-            } else {
-                win->icon = NULL;
-            }
-            if (pending_icon32) {
-                memcpy(icon32_pool[i], pending_icon32, ICON32_SIZE);
-                win->icon32 = icon32_pool[i];
-                pending_icon32 = NULL;
-            } else {
-                win->icon32 = NULL;
-            }
+            /* Assign pending icons (if any) — packed into the icon
+             * atlas, so they survive the source being rewritten */
+            win->icon   = gfx_icon_get(pending_icon, 16);
+            win->icon32 = gfx_icon_get(pending_icon32, 32);
+            pending_icon   = NULL;
+            pending_icon32 = NULL;
 
             /* Smart cascade: find a position where no existing window's
              * top-left corner is nearby.  Try slots starting from 0,
@@ -305,6 +407,8 @@ void wm_destroy_window(hwnd_t hwnd) {
         }
     }
 
+    gfx_icon_put(win->icon);
+    gfx_icon_put(win->icon32);
     memset(win, 0, sizeof(*win));
     fs_state[hwnd - 1].active = false;
     taskbar_invalidate();
@@ -615,6 +719,78 @@ void wm_invalidate(hwnd_t hwnd) {
     wm_mark_dirty();
 }
 
+void wm_invalidate_rect(hwnd_t hwnd, rect_t r) {
+    if (!valid_hwnd(hwnd)) return;
+    window_t *win = &windows[hwnd - 1];
+
+    /* Same gating as wm_invalidate() */
+    if (win->flags & WF_SUSPENDED) return;
+    if (hwnd != focus_hwnd) return;
+
+    /* A pending full repaint already covers any sub-rect */
+    if (!(win->flags & WF_DIRTY)) {
+        rect_t cs = client_screen_rect(win);
+        rect_t sr = { cs.x + r.x, cs.y + r.y, r.w, r.h };
+        if (!rect_intersect(&sr, &cs, &sr)) return;
+        damage_add(hwnd - 1, sr, false);
+    }
+    wm_mark_dirty();
+}
+
+void wm_scroll_client(hwnd_t hwnd, int16_t dy) {
+    if (!valid_hwnd(hwnd) || dy == 0) return;
+    window_t *win = &windows[hwnd - 1];
+    uint8_t idx = hwnd - 1;
+
+    /* Same gating as wm_invalidate() */
+    if (win->flags & WF_SUSPENDED) return;
+    if (hwnd != focus_hwnd) return;
+
+    /* A pending full repaint already shows the scrolled content */
+    if (win->flags & WF_DIRTY) {
+        wm_mark_dirty();
+        return;
+    }
+
+    rect_t cs = client_screen_rect(win);
+    bool full = false;
+
+    taskENTER_CRITICAL();
+    int16_t total = damage[idx].scroll_dy + dy;
+    if (total <= -cs.h || total >= cs.h) {
+        full = true;
+    } else {
+        /* Frame damage means the client pixels are not ours to move */
+        for (uint8_t k = 0; k < damage[idx].count; k++)
+            if (damage[idx].rects[k].frame) full = true;
+    }
+    if (!full) {
+        /* Pending damage moves with the content it refers to */
+        damage_rect_t *dl = damage[idx].rects;
+        uint8_t n = damage[idx].count;
+        for (uint8_t k = 0; k < n; ) {
+            dl[k].r.y += dy;
+            if (rect_intersect(&dl[k].r, &cs, &dl[k].r))
+                k++;
+            else
+                dl[k] = dl[--n];
+        }
+        damage[idx].count = n;
+        damage[idx].scroll_dy = total;
+    }
+    taskEXIT_CRITICAL();
+
+    if (full) {
+        win->flags |= WF_DIRTY;
+    } else {
+        /* Band uncovered by the move */
+        rect_t band = { cs.x, dy < 0 ? cs.y + cs.h + dy : cs.y,
+                        cs.w, dy < 0 ? -dy : dy };
+        damage_add(idx, band, false);
+    }
+    wm_mark_dirty();
+}
+
 void wm_force_full_repaint(void) {
     needs_full_repaint = true;
     wm_mark_dirty();
@@ -638,7 +814,6 @@ void wm_toggle_fullscreen(hwnd_t hwnd) {
         wm_set_window_rect(hwnd, 0, 0, display_width, display_height);
         fs->active = true;
         cursor_set_visible(false);
-        cursor_overlay_erase();
         wm_force_full_repaint();
     } else {
         /* Exit fullscreen: restore decorations and rect */
@@ -903,8 +1078,10 @@ static void draw_window_decorations(hwnd_t hwnd, window_t *win) {
 
     /* Title bar icon — draw 16x16 icon if available, use default otherwise */
     extern const uint8_t default_icon_16x16[256];
-    const uint8_t *icon = win->icon ? win->icon : default_icon_16x16;
-    gfx_draw_icon_16(tb_x + 2, tb_y + 2, icon);
+    if (win->icon)
+        gfx_draw_icon(tb_x + 2, tb_y + 2, win->icon);
+    else
+        gfx_draw_icon_16(tb_x + 2, tb_y + 2, default_icon_16x16);
 
     /* Title text — bold UI font, vertically centered in title bar */
     int text_y = tb_y + (THEME_TITLE_HEIGHT - FONT_UI_HEIGHT) / 2;
@@ -987,43 +1164,196 @@ static void draw_window_decorations(hwnd_t hwnd, window_t *win) {
  * Compositor
  *=========================================================================*/
 
-/* Check if a point lies inside a region that WILL be repainted this frame.
- * For windows with WF_FRAME_DIRTY the full frame is repainted.
- * For content-only updates (WF_DIRTY alone) only the client area is
- * repainted — the title bar / border area is NOT touched, so the
- * cursor save-under must be preserved there. */
-static bool point_in_dirty_window(int16_t px, int16_t py) {
-    if (taskbar_needs_redraw() && py >= taskbar_work_area_height())
-        return true;
-    for (uint8_t i = 0; i < z_count; i++) {
-        window_t *w = &windows[z_stack[i] - 1];
-        if (!(w->flags & WF_VISIBLE) || !(w->flags & WF_DIRTY)) continue;
-
-        if (w->flags & WF_FRAME_DIRTY) {
-            /* Full frame repaint — check entire frame */
-            if (px >= w->frame.x && px < w->frame.x + w->frame.w &&
-                py >= w->frame.y && py < w->frame.y + w->frame.h)
-                return true;
-        } else if (w->flags & WF_BORDER) {
-            /* Content-only — only client area will be repainted */
-            point_t co = theme_client_origin(&w->frame, w->flags);
-            rect_t  cr = theme_client_rect(&w->frame, w->flags);
-            if (px >= co.x && px < co.x + cr.w &&
-                py >= co.y && py < co.y + cr.h)
-                return true;
-        } else {
-            /* No border — frame IS client area */
-            if (px >= w->frame.x && px < w->frame.x + w->frame.w &&
-                py >= w->frame.y && py < w->frame.y + w->frame.h)
-                return true;
+/* Run a window's paint handler inside a wd_begin/wd_end pair.
+ * Returns true if the handler wrote through wd_fb_ptr(), i.e. its
+ * output may extend past the current display clip. */
+static bool paint_client(hwnd_t hwnd, window_t *win) {
+    if (!win->paint_handler) return false;
+    /* wd_begin() clips draw_ctx.cw/ch to the visible portion of the
+     * framebuffer and sets active=false when the client is fully
+     * off-screen.  No guard needed — partial off-screen windows
+     * paint fine. */
+    wd_begin(hwnd);
+    win->paint_handler(hwnd);
+    bool raw = wd_raw_access();
+    wd_end();
+    return raw;
+}
+
+/*--------------------------------------------------------------------------
+ * Occlusion culling — visible region of a window
+ *
+ * The visible region is the window frame (clipped to the screen) minus
+ * the frames of all higher visible windows, kept as a list of disjoint
+ * rects.  Each subtraction splits an overlapped rect into up to four
+ * bands (top, bottom, left, right).  If the list would exceed
+ * WM_VIS_MAX the region falls back to the whole frame and the window
+ * is painted with overdraw; the paint loop then propagates its painted
+ * rects to the higher windows as before.
+ *------------------------------------------------------------------------*/
+
+#define WM_VIS_MAX 16
+
+typedef struct {
+    rect_t  r[WM_VIS_MAX];
+    uint8_t n;
+    bool    overflow;   /* culling abandoned — region is the full frame */
+} vis_region_t;
+
+static void vis_subtract(vis_region_t *vr, const rect_t *b) {
+    rect_t  out[WM_VIS_MAX];
+    uint8_t n = 0;
+
+#define VIS_PUSH(X, Y, W, H) do {                           \
+        if (n == WM_VIS_MAX) { vr->overflow = true; return; } \
+        out[n++] = (rect_t){ (X), (Y), (W), (H) };           \
+    } while (0)
+
+    for (uint8_t k = 0; k < vr->n; k++) {
+        rect_t a = vr->r[k];
+        if (!rect_overlaps(&a, b)) {
+            VIS_PUSH(a.x, a.y, a.w, a.h);
+            continue;
+        }
+        int16_t ax1 = a.x + a.w,  ay1 = a.y + a.h;
+        int16_t bx1 = b->x + b->w, by1 = b->y + b->h;
+        int16_t my0 = a.y > b->y ? a.y : b->y;
+        int16_t my1 = ay1 < by1 ? ay1 : by1;
+
+        if (b->y > a.y) VIS_PUSH(a.x, a.y, a.w, b->y - a.y);     /* top */
+        if (by1 < ay1)  VIS_PUSH(a.x, by1, a.w, ay1 - by1);      /* bottom */
+        if (b->x > a.x) VIS_PUSH(a.x, my0, b->x - a.x, my1 - my0); /* left */
+        if (bx1 < ax1)  VIS_PUSH(bx1, my0, ax1 - bx1, my1 - my0);  /* right */
+    }
+#undef VIS_PUSH
+
+    memcpy(vr->r, out, n * sizeof(rect_t));
+    vr->n = n;
+}
+
+/* Compute the visible region of the window at z-stack index zi */
+static void vis_compute(uint8_t zi, vis_region_t *vr) {
+    window_t *win = &windows[z_stack[zi] - 1];
+    rect_t screen = { 0, 0, display_width, display_height };
+    rect_t full;
+
+    vr->n = 0;
+    vr->overflow = false;
+    if (!rect_intersect(&win->frame, &screen, &full)) return;
+    vr->r[0] = full;
+    vr->n = 1;
+
+    for (uint8_t j = zi + 1; j < z_count && vr->n > 0; j++) {
+        window_t *w = &windows[z_stack[j] - 1];
+        if (!(w->flags & WF_VISIBLE)) continue;
+        vis_subtract(vr, &w->frame);
+        if (vr->overflow) {
+            vr->r[0] = full;
+            vr->n = 1;
+            return;
         }
     }
+}
+
+/* True if r lies entirely inside one rect of the visible region */
+static bool vis_contains(const vis_region_t *vr, const rect_t *r) {
+    if (vr->overflow) return false;
+    for (uint8_t v = 0; v < vr->n; v++) {
+        const rect_t *a = &vr->r[v];
+        if (r->x >= a->x && r->y >= a->y &&
+            r->x + r->w <= a->x + a->w && r->y + r->h <= a->y + a->h)
+            return true;
+    }
     return false;
 }
 
-void wm_composite(void) {
-    cursor_overlay_lock();
+/* Draw decorations and/or the client of a window restricted to
+ * target ∩ visible region — one clipped pass per visible rect, so
+ * covered pixels are never written.  Returns true if the paint handler
+ * wrote through wd_fb_ptr() (output not bound by the clip). */
+static bool paint_clipped(hwnd_t hwnd, window_t *win, const rect_t *target,
+                          const vis_region_t *vis, bool deco, bool client) {
+    bool raw = false;
+    /* Sprites come off first; a handler writing through wd_fb_ptr()
+     * may reach anywhere in its client */
+    display_sprites_lift(target->x, target->y, target->w, target->h);
+    if (client) {
+        rect_t cs = client_screen_rect(win);
+        display_sprites_lift(cs.x, cs.y, cs.w, cs.h);
+    }
+    for (uint8_t v = 0; v < vis->n; v++) {
+        rect_t c;
+        if (!rect_intersect(target, &vis->r[v], &c)) continue;
+        display_set_clip(c.x, c.y, c.w, c.h);
+        if (deco)
+            draw_window_decorations(hwnd, win);
+        if (client)
+            raw |= paint_client(hwnd, win);
+    }
+    display_reset_clip();
+    return raw;
+}
 
+/* Repaint one window within its visible region and collect the screen
+ * rects it wrote into painted[] (at most WM_DAMAGE_MAX + 1 entries).
+ * *raw is set if the paint handler wrote through wd_fb_ptr().
+ *
+ *  - WF_FRAME_DIRTY: decorations + full client.
+ *  - WF_DIRTY:       frame-damage rects get decorations, then the
+ *                    whole client is painted.
+ *  - damage only:    each rect is painted on its own; frame rects
+ *                    redraw decorations first.
+ *
+ * While painting frame damage WF_FRAME_DIRTY is presented to the paint
+ * handler, so handlers that normally repaint incrementally redraw
+ * everything (the client background was refilled under the clip). */
+static uint8_t paint_window(hwnd_t hwnd, window_t *win,
+                            const damage_rect_t *dl, uint8_t dn,
+                            const vis_region_t *vis, rect_t *painted,
+                            bool *raw) {
+    uint8_t pn = 0;
+
+    if (win->flags & WF_FRAME_DIRTY) {
+        *raw = paint_clipped(hwnd, win, &win->frame, vis, true, true);
+        painted[pn++] = win->frame;
+        return pn;
+    }
+
+    bool any_frame = false;
+    for (uint8_t k = 0; k < dn; k++) {
+        if (!dl[k].frame) continue;
+        paint_clipped(hwnd, win, &dl[k].r, vis, true, false);
+        painted[pn++] = dl[k].r;
+        any_frame = true;
+    }
+
+    rect_t cs = client_screen_rect(win);
+    if (win->flags & WF_DIRTY) {
+        /* Whole client is dirty — covers every client damage rect */
+        if (any_frame) win->flags |= WF_FRAME_DIRTY;
+        *raw = paint_clipped(hwnd, win, &cs, vis, false, true);
+        painted[pn++] = cs;
+        return pn;
+    }
+
+    *raw = false;
+    for (uint8_t k = 0; k < dn; k++) {
+        if (dl[k].frame)
+            win->flags |= WF_FRAME_DIRTY;
+        else
+            win->flags &= ~WF_FRAME_DIRTY;
+        *raw |= paint_clipped(hwnd, win, &dl[k].r, vis, false, true);
+        if (!dl[k].frame) painted[pn++] = dl[k].r;
+    }
+
+    /* Direct framebuffer writes ignore the clip — assume the whole
+     * client area changed so higher windows repaint over it */
+    if (*raw)
+        painted[pn++] = cs;
+    return pn;
+}
+
+void wm_composite(void) {
     /* Erase drag outline (fast XOR) before vsync wait */
     drag_overlay_erase();
 
@@ -1041,17 +1371,17 @@ void wm_composite(void) {
         prev_had_popup = has_popup;
     }
 
-    /* Wait for vblank — cursor stays visible during this wait,
-     * which may block up to one frame period. */
+    /* Wait for vblank — sprites stay up during this wait, which may
+     * block up to one frame period.  From here on each region is
+     * lifted clear of sprites just before it is painted, so the ones
+     * nothing paints under stay put. */
     display_wait_vsync();
 
-    enum { CUR_ERASE_STAMP, CUR_RESET_STAMP, CUR_SKIP } cursor_mode;
-
     bool did_full_repaint = false;
 
     if (needs_full_repaint) {
         /*--- Fallback path: full repaint ---*/
-        cursor_overlay_erase();
+        display_sprites_lift_all();
         display_clear(desktop_get_bg_color());
         desktop_paint();
         needs_full_repaint = false;
@@ -1065,30 +1395,29 @@ void wm_composite(void) {
                 w->flags |= WF_DIRTY | WF_FRAME_DIRTY;
         }
         taskbar_force_dirty();
-        cursor_mode = CUR_ERASE_STAMP;
     } else if (has_popup) {
         /*--- Popup-freeze path: overlays paint on top, so freeze
          * window painting to prevent dirty windows from overwriting
          * popup pixels mid-scanline on the single buffer.  When the
          * popup closes, needs_full_repaint refreshes everything. ---*/
         expose_count = 0;  /* deferred — full repaint on close */
-        cursor_overlay_erase();
-        cursor_mode = CUR_ERASE_STAMP;
+        display_sprites_lift_all();
     } else {
         /*--- Selective path ---*/
         uint8_t saved_expose_count = expose_count;
         expose_count = 0;
 
-        /* Phase 1: Mark overlapping windows dirty from expose rects
-         * (no framebuffer writes yet — cursor is still stamped) */
+        /* Phase 1: Queue frame damage on windows overlapping the expose
+         * rects — only the intersection is repainted, not the whole
+         * window (no framebuffer writes yet) */
         for (uint8_t e = 0; e < saved_expose_count; e++) {
             rect_t *er = &expose_rects[e];
 
             for (uint8_t i = 0; i < z_count; i++) {
-                window_t *w = &windows[z_stack[i] - 1];
-                if (!(w->flags & WF_VISIBLE)) continue;
-                if (rect_overlaps(er, &w->frame))
-                    w->flags |= WF_DIRTY | WF_FRAME_DIRTY;
+                hwnd_t h = z_stack[i];
+                if (!(windows[h - 1].flags & WF_VISIBLE)) continue;
+                if (rect_overlaps(er, &windows[h - 1].frame))
+                    damage_add(h - 1, *er, true);
             }
 
             /* Mark taskbar dirty if expose overlaps it */
@@ -1098,104 +1427,21 @@ void wm_composite(void) {
                 taskbar_force_dirty();
         }
 
-        /* Dirty propagation: if a dirty window (lower z) is painted,
-         * it overwrites pixels that a higher clean window should cover.
-         * A higher window that is already WF_DIRTY (content-only, from
-         * wm_invalidate) still needs WF_FRAME_DIRTY so that its
-         * background is re-filled over the lower window's pixels.
-         * Skip only if the window already has both flags set. */
-        for (uint8_t i = 1; i < z_count; i++) {
-            window_t *w = &windows[z_stack[i] - 1];
-            if (!(w->flags & WF_VISIBLE)) continue;
-            if ((w->flags & (WF_DIRTY | WF_FRAME_DIRTY)) ==
-                             (WF_DIRTY | WF_FRAME_DIRTY)) continue;
-
-            for (uint8_t j = 0; j < i; j++) {
-                window_t *d = &windows[z_stack[j] - 1];
-                if (!(d->flags & WF_VISIBLE) || !(d->flags & WF_DIRTY)) continue;
-                if (rect_overlaps(&w->frame, &d->frame)) {
-                    w->flags |= WF_DIRTY | WF_FRAME_DIRTY;
-                    break;
-                }
-            }
-        }
-
-        /* Cursor mode selection */
-        if (saved_expose_count > 0) {
-            /* Structural change — always erase cursor before filling
-             * expose rects (same ordering as old full-clear path) */
-            cursor_overlay_erase();
-            cursor_mode = CUR_ERASE_STAMP;
-        } else {
-            /* Content-only path — test cursor against dirty windows */
-            int16_t sx, sy;
-            bool stamped = cursor_overlay_get_stamp(&sx, &sy);
-            int16_t mx, my;
-            wm_get_cursor_pos(&mx, &my);
-            bool cursor_moved = !stamped || mx != sx || my != sy;
-
-            /* Treat a cursor-type change the same as a move: the old
-             * stamp must be erased and re-drawn with the new shape.
-             * Without this, cursor_get_bounds returns bounds for the
-             * current type, not the stamped type, which can cause the
-             * overlap check to skip the erase — leaving stale
-             * save-under pixels that cut into a newly painted window. */
-            if (cursor_overlay_type_changed())
-                cursor_moved = true;
-
-            bool any_dirty = false;
-            for (uint8_t i = 0; i < z_count && !any_dirty; i++) {
-                window_t *w = &windows[z_stack[i] - 1];
-                if ((w->flags & WF_VISIBLE) && (w->flags & WF_DIRTY))
-                    any_dirty = true;
-            }
-
-            if (!any_dirty && !taskbar_needs_redraw()) {
-                if (!cursor_moved) {
-                    cursor_mode = CUR_SKIP;
-                } else {
-                    cursor_overlay_erase();
-                    cursor_mode = CUR_ERASE_STAMP;
-                }
-            } else {
-                int16_t cx = stamped ? sx : mx;
-                int16_t cy = stamped ? sy : my;
-                int16_t bx0, by0, bx1, by1;
-                cursor_get_bounds(cx, cy, &bx0, &by0, &bx1, &by1);
-
-                bool tl = point_in_dirty_window(bx0, by0);
-                bool tr = point_in_dirty_window(bx1, by0);
-                bool bl = point_in_dirty_window(bx0, by1);
-                bool br = point_in_dirty_window(bx1, by1);
-
-                if (tl && tr && bl && br) {
-                    /* Cursor fully inside dirty area — erase it so the
-                     * window paint can write clean pixels underneath. */
-                    cursor_overlay_erase();
-                    cursor_mode = CUR_ERASE_STAMP;
-                } else if (!tl && !tr && !bl && !br && !cursor_moved) {
-                    cursor_mode = CUR_SKIP;
-                } else if (!cursor_moved) {
-                    /* Cursor partially overlaps dirty area — erase to
-                     * prevent ghost pixels from the old stamp. */
-                    cursor_overlay_erase();
-                    cursor_mode = CUR_ERASE_STAMP;
-                } else {
-                    cursor_overlay_erase();
-                    cursor_mode = CUR_ERASE_STAMP;
-                }
-            }
-        }
+        /* Dirty propagation to higher windows happens in the paint
+         * loop below, as each lower window's painted rects become
+         * known (see paint_window). */
 
-        /* Phase 2: Fill expose rects with desktop color
-         * (cursor is now safely erased) */
+        /* Phase 2: Fill expose rects with desktop color and repaint the
+         * desktop icons inside them.  Clipping keeps icon pixels off
+         * windows outside the rect. */
         for (uint8_t e = 0; e < saved_expose_count; e++) {
             rect_t *er = &expose_rects[e];
+            display_sprites_lift(er->x, er->y, er->w, er->h);
+            display_set_clip(er->x, er->y, er->w, er->h);
             gfx_fill_rect(er->x, er->y, er->w, er->h, desktop_get_bg_color());
-        }
-        /* Repaint desktop icons over the cleared expose rects */
-        if (saved_expose_count > 0)
             desktop_paint();
+        }
+        display_reset_clip();
     }
 
     /* Paint dirty visible windows back-to-front.
@@ -1210,42 +1456,62 @@ void wm_composite(void) {
             window_t *win = &windows[hwnd - 1];
             if (!(win->flags & WF_VISIBLE)) continue;
 
-            /* Late dirty propagation: a timer callback on another task
-             * may have marked a lower window dirty AFTER the propagation
-             * phase above.  Re-check here so higher overlapping windows
-             * are always repainted on top (with WF_FRAME_DIRTY to ensure
-             * background fill covers lower window pixels). */
-            if ((win->flags & (WF_DIRTY | WF_FRAME_DIRTY)) !=
-                               (WF_DIRTY | WF_FRAME_DIRTY)) {
-                for (uint8_t j = 0; j < i; j++) {
-                    window_t *d = &windows[z_stack[j] - 1];
-                    if ((d->flags & WF_VISIBLE) && (d->flags & WF_DIRTY) &&
-                        rect_overlaps(&win->frame, &d->frame)) {
-                        win->flags |= WF_DIRTY | WF_FRAME_DIRTY;
-                        break;
-                    }
+            damage_rect_t dl[WM_DAMAGE_MAX];
+            int16_t scroll;
+            uint8_t dn = damage_take(hwnd - 1, dl, &scroll);
+            if (!(win->flags & WF_DIRTY) && dn == 0 && scroll == 0)
+                continue;
+
+            /* Occlusion culling: paint only the part of the window not
+             * covered by higher windows.  Fully covered windows are
+             * skipped; their flags are consumed so a later expose
+             * (frame damage) brings them back. */
+            vis_region_t vis;
+            vis_compute(i, &vis);
+
+            /* Client scroll: move the pixels in place when the whole
+             * client is on screen and uncovered (its damage list was
+             * already shifted to match), else repaint the client */
+            if (scroll != 0 && !(win->flags & WF_DIRTY)) {
+                rect_t cs = client_screen_rect(win);
+                if (vis_contains(&vis, &cs)) {
+                    display_sprites_lift(cs.x, cs.y, cs.w, cs.h);
+                    display_move_rows(cs.x, cs.y, cs.w, cs.h, scroll);
+                } else {
+                    win->flags |= WF_DIRTY;
                 }
-                if (!(win->flags & WF_DIRTY)) continue;
             }
 
             /* Only repaint decorations (border, title bar, client bg)
-             * when the frame actually changed.  Content-only updates
-             * (wm_invalidate) skip this — avoids the full-frame fill
-             * that causes flicker on the single-buffer display. */
-            if (win->flags & WF_FRAME_DIRTY)
-                draw_window_decorations(hwnd, win);
-
-            if (win->paint_handler) {
-                /* wd_begin() clips draw_ctx.cw/ch to the visible
-                 * portion of the framebuffer and sets active=false
-                 * when the client is fully off-screen.  No guard
-                 * needed — partial off-screen windows paint fine. */
-                wd_begin(hwnd);
-                win->paint_handler(hwnd);
-                wd_end();
-            }
+             * where the frame actually changed.  Content-only updates
+             * (wm_invalidate / wm_invalidate_rect) skip this — avoids
+             * the fill that causes flicker on the single-buffer display. */
+            rect_t painted[WM_DAMAGE_MAX + 1];
+            uint8_t pn = 0;
+            bool raw = false;
+            if (vis.n > 0)
+                pn = paint_window(hwnd, win, dl, dn, &vis, painted, &raw);
 
             win->flags &= ~(WF_DIRTY | WF_FRAME_DIRTY);
+
+            /* Dirty propagation: with exact culling nothing lands under
+             * a higher window, except direct wd_fb_ptr() writes which
+             * may cover the whole client.  When culling overflowed,
+             * everything painted may cover parts of higher windows.
+             * Queue only the intersections as frame damage — they are
+             * painted later in this same pass. */
+            if (!vis.overflow) {
+                pn = 0;
+                if (raw) painted[pn++] = client_screen_rect(win);
+            }
+            for (uint8_t p = 0; p < pn; p++) {
+                for (uint8_t j = i + 1; j < z_count; j++) {
+                    hwnd_t h = z_stack[j];
+                    if (!(windows[h - 1].flags & WF_VISIBLE)) continue;
+                    if (rect_overlaps(&painted[p], &windows[h - 1].frame))
+                        damage_add(h - 1, painted[p], true);
+                }
+            }
         }
 
     }
@@ -1253,8 +1519,15 @@ void wm_composite(void) {
     /* Taskbar sits below all popups — always safe to draw.
      * Drawing it outside the popup guard fixes Start button
      * animation (sunken state when start menu is open). */
+    if (taskbar_needs_redraw())
+        display_sprites_lift(0, taskbar_work_area_height(),
+                             display_width, TASKBAR_HEIGHT);
     taskbar_draw();
 
+    /* Alt+Tab redraws its box on every pass */
+    if (alttab_is_active())
+        display_sprites_lift_all();
+
     /* Overlay menus — drawn after all windows and taskbar (always
      * when open — cheap and prevents overwrite by window paint) */
     startmenu_draw();
@@ -1284,23 +1557,17 @@ void wm_composite(void) {
     vol_popup_draw();
     alttab_draw();
 
-    /* Stamp drag outline on visible buffer (before cursor) */
+    /* Stamp drag outline on visible buffer, below the sprites: a
+     * sprite's save-under must hold the XOR'd pixels so lifting it
+     * leaves the outline intact for drag_overlay_erase() */
     {
         rect_t outline;
-        if (wm_get_drag_outline(&outline))
+        if (wm_get_drag_outline(&outline)) {
+            display_sprites_lift_all();
             drag_overlay_stamp(&outline);
+        }
     }
 
-    /* Stamp cursor — skip if already stamped above, untouched,
-     * hidden during boot, or hidden for fullscreen. */
-    extern volatile bool boot_cursor_hidden;
-    if (cursor_mode != CUR_SKIP && !boot_cursor_hidden && cursor_is_visible()) {
-        int16_t mx, my;
-        wm_get_cursor_pos(&mx, &my);
-        cursor_overlay_stamp(mx, my);
-    } else if (!cursor_is_visible()) {
-        cursor_overlay_erase();
-    }
-
-    cursor_overlay_unlock();
+    /* Put back the sprites lifted above and show any that moved */
+    display_sprites_present();
 }
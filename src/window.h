@@ -11,6 +11,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "gfx.h"
 
 /*==========================================================================
  * Geometry types
@@ -120,8 +121,8 @@ struct window {
     event_handler_t  event_handler;   /* event callback (may be NULL) */
     paint_handler_t  paint_handler;   /* paint callback (may be NULL) */
     void            *user_data;       /* opaque per-window data (e.g. terminal_t*) */
-    const uint8_t   *icon;            /* 16x16 icon data (256 bytes), NULL=default */
-    const uint8_t   *icon32;          /* 32x32 icon data (1024 bytes), NULL=default */
+    const gfx_icon_t *icon;           /* packed 16x16 icon (gfx_icon_get), NULL=default */
+    const gfx_icon_t *icon32;         /* packed 32x32 icon, NULL=default */
 };
 
 /* Size check — only meaningful on the 32-bit ARM target.
@@ -174,6 +175,20 @@ window_t *wm_get_window(hwnd_t hwnd); /* NULL if invalid */
 /* Invalidation — marks window for repaint */
 void wm_invalidate(hwnd_t hwnd);
 
+/* Partial invalidation — marks only rect r (client coordinates) for
+ * repaint.  Rects are coalesced into a small per-window damage list;
+ * the compositor clips the paint handler to each damaged rect and
+ * repaints overlapping higher windows only where they intersect it.
+ * A full wm_invalidate() pending on the same window takes precedence. */
+void wm_invalidate_rect(hwnd_t hwnd, rect_t r);
+
+/* Scroll the client area contents by dy pixels (negative = up).  The
+ * compositor moves the framebuffer rows in place when the client is
+ * fully visible, shifts pending damage along with the content and
+ * repaints only the uncovered band; otherwise the whole client is
+ * repainted.  Same focus/suspend gating as wm_invalidate(). */
+void wm_scroll_client(hwnd_t hwnd, int16_t dy);
+
 /* Set title string */
 void wm_set_title(hwnd_t hwnd, const char *title);
 
@@ -10,6 +10,7 @@
 #include "window_theme.h"
 #include "gfx.h"
 #include "display.h"
+#include "raster4.h"
 #include "font.h"
 #include <string.h>
 
@@ -21,6 +22,7 @@ static struct {
     int16_t ox, oy;     /* origin offset (screen coords of client 0,0) */
     int16_t cw, ch;     /* client area size */
     bool    active;      /* true between wd_begin/wd_end */
+    bool    raw;         /* wd_fb_ptr() handed out since wd_begin */
 } draw_ctx;
 
 /*==========================================================================
@@ -31,6 +33,8 @@ void wd_begin(hwnd_t hwnd) {
     window_t *win = wm_get_window(hwnd);
     if (!win) return;
 
+    draw_ctx.raw = false;
+
     if (win->flags & WF_BORDER) {
         point_t origin = theme_client_origin(&win->frame, win->flags);
         rect_t client = theme_client_rect(&win->frame, win->flags);
@@ -97,8 +101,8 @@ void wd_vline(int16_t x, int16_t y, int16_t h, uint8_t color) {
     if (x < 0 || x >= draw_ctx.cw) return;
     int16_t y0 = y < 0 ? 0 : y;
     int16_t y1 = (y + h) > draw_ctx.ch ? draw_ctx.ch : (y + h);
-    for (int16_t py = y0; py < y1; py++)
-        display_set_pixel(draw_ctx.ox + x, draw_ctx.oy + py, color);
+    if (y0 >= y1) return;
+    gfx_vline(draw_ctx.ox + x, draw_ctx.oy + y0, y1 - y0, color);
 }
 
 void wd_rect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t color) {
@@ -117,16 +121,19 @@ void wd_fill_rect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t color) {
     if (x0 >= x1 || y0 >= y1) return;
     int sx = draw_ctx.ox + x0;
     int sy = draw_ctx.oy + y0;
-    int span = x1 - x0;
-    int rows = y1 - y0;
-    if (sx < 0) { span += sx; sx = 0; }
-    if (sx + span > display_width) span = display_width - sx;
-    if (sy < 0) { rows += sy; sy = 0; }
-    if (sy + rows > display_height) rows = display_height - sy;
-    if (span <= 0 || rows <= 0) return;
-    if (display_bpp == 4) color &= 0x0F;
-    for (int py = 0; py < rows; py++)
-        display_hline_fast(sx, sy + py, span, color);
+    int sx1 = draw_ctx.ox + x1;
+    int sy1 = draw_ctx.oy + y1;
+    if (sx < display_clip.x0) sx = display_clip.x0;
+    if (sy < display_clip.y0) sy = display_clip.y0;
+    if (sx1 > display_clip.x1) sx1 = display_clip.x1;
+    if (sy1 > display_clip.y1) sy1 = display_clip.y1;
+    if (sx >= sx1 || sy >= sy1) return;
+    if (display_bpp == 4) {
+        r4_fill(display_draw_buffer_ptr, sx, sy, sx1, sy1, color);
+        return;
+    }
+    for (int py = sy; py < sy1; py++)
+        display_hline_fast(sx, py, sx1 - sx, color);
 }
 
 void wd_clear(uint8_t color) {
@@ -234,6 +241,7 @@ uint8_t *wd_fb_ptr(int16_t cx, int16_t cy, int16_t *stride) {
     if (sx < 0 || sy < 0 || sy >= display_height || sx >= display_width)
         return NULL;
     *stride = display_fb_stride;
+    draw_ctx.raw = true;
     if (display_bpp == 8)
         return &display_draw_buffer_ptr[sy * display_fb_stride + sx];
     else
@@ -245,6 +253,10 @@ void wd_get_clip_size(int16_t *w, int16_t *h) {
     if (h) *h = draw_ctx.ch;
 }
 
+bool wd_raw_access(void) {
+    return draw_ctx.raw;
+}
+
 void wd_button(int16_t x, int16_t y, int16_t w, int16_t h,
                const char *label, bool focused, bool pressed) {
     if (!draw_ctx.active) return;
@@ -100,6 +100,11 @@ uint8_t *wd_fb_ptr(int16_t cx, int16_t cy, int16_t *stride);
  * these bounds to prevent scanline overflow. */
 void wd_get_clip_size(int16_t *w, int16_t *h);
 
+/* True if wd_fb_ptr() was called since the last wd_begin().
+ * Direct framebuffer writes bypass the display clip rect, so the
+ * compositor treats such a paint as covering the whole client area. */
+bool wd_raw_access(void);
+
 /* Standard Win95-style push button (auto-clipped to client area).
  * label   - button text (centered)
  * focused - if true, draws dotted focus rectangle
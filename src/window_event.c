@@ -58,6 +58,11 @@ static volatile uint8_t mouse_buttons_live;
  * Starts dirty so the first frame is always drawn. */
 static volatile uint8_t compositor_dirty = 1;
 
+/* Tasks woken by wm_wake_compositor() / wm_wake_input*(), and how often */
+static TaskHandle_t    compositor_waiter;
+static TaskHandle_t    input_waiter;
+static wm_wake_stats_t wake_stats;
+
 /* Drag/resize state — managed by wm_handle_mouse_input() */
 #define DRAG_NONE    0
 #define DRAG_MOVE    1
@@ -126,7 +131,7 @@ bool wm_post_event(hwnd_t hwnd, const window_event_t *event) {
     eq_count++;
     spin_unlock(eq_spinlock, save);
     if (event->type != WM_MOUSEMOVE)
-        compositor_dirty = 1;
+        wm_mark_dirty();
     return true;
 }
 
@@ -228,6 +233,7 @@ uint8_t wm_get_mouse_buttons(void) {
 
 void wm_mark_dirty(void) {
     compositor_dirty = 1;
+    wm_wake_compositor();
 }
 
 bool wm_needs_composite(void) {
@@ -236,6 +242,58 @@ bool wm_needs_composite(void) {
     return true;
 }
 
+/*==========================================================================
+ * Task wakeups
+ *
+ * A notification given while the task is busy stays pending, so the next
+ * wait returns at once: nothing marked dirty mid-composite is lost.
+ *=========================================================================*/
+
+void wm_set_compositor_task(TaskHandle_t task) {
+    compositor_waiter = task;
+}
+
+void wm_set_input_task(TaskHandle_t task) {
+    input_waiter = task;
+}
+
+void wm_wake_compositor(void) {
+    TaskHandle_t t = compositor_waiter;
+    if (t) xTaskNotifyGive(t);
+}
+
+void wm_wake_input(void) {
+    TaskHandle_t t = input_waiter;
+    if (t) xTaskNotifyGive(t);
+}
+
+void wm_wake_input_from_isr(void) {
+    TaskHandle_t t = input_waiter;
+    if (!t) return;
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(t, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+bool wm_wait_compositor(TickType_t timeout) {
+    bool woken = ulTaskNotifyTake(pdTRUE, timeout) != 0;
+    if (woken) wake_stats.comp_wakeups++;
+    else       wake_stats.comp_timeouts++;
+    return woken;
+}
+
+bool wm_wait_input(TickType_t timeout) {
+    bool woken = ulTaskNotifyTake(pdTRUE, timeout) != 0;
+    if (woken) wake_stats.input_wakeups++;
+    else       wake_stats.input_timeouts++;
+    return woken;
+}
+
+void wm_get_wake_stats(wm_wake_stats_t *st) {
+    *st = wake_stats;
+    st->ticks = xTaskGetTickCount();
+}
+
 /*==========================================================================
  * Mouse input handler — move, resize, focus, hit-test
  *=========================================================================*/
@@ -422,11 +480,11 @@ void drag_overlay_stamp(const rect_t *r) {
 
 void drag_overlay_erase(void) {
     if (!drag_ol_active) return;
-    /* Erase cursor first — its save-under may contain XOR'd outline
-     * pixels.  Restoring the cursor cleans the buffer so the outline
-     * XOR-erase undoes correctly.  cursor_overlay_erase is a no-op
-     * when the cursor isn't stamped; re-stamp happens later. */
-    cursor_overlay_erase();
+    /* Lift the sprites first — their save-unders may contain XOR'd
+     * outline pixels.  Restoring them cleans the buffer so the outline
+     * XOR-erase undoes correctly; they are presented again at the end
+     * of the pass. */
+    display_sprites_lift_all();
     show_xor_outline(&drag_ol_rect);
     drag_ol_active = false;
 }
@@ -450,7 +508,7 @@ void wm_handle_mouse_input(uint8_t type, int16_t x, int16_t y, uint8_t buttons)
                 update_resize_rect(x, y);
             }
             drag_moved = true;
-            compositor_dirty = 1;
+            wm_mark_dirty();
             return;
         }
         if (type == WM_LBUTTONUP) {
@@ -469,10 +527,10 @@ void wm_handle_mouse_input(uint8_t type, int16_t x, int16_t y, uint8_t buttons)
             swap_resume(saved_hwnd);
             /* Don't manipulate overlays from the input task — the
              * compositor handles XOR outline erase in its synchronized
-             * cycle, avoiding the TOCTOU race on cursor_overlay_is_locked.
+             * cycle.
              * wm_set_window_rect() adds an expose rect for the old frame
              * and marks WF_DIRTY|WF_FRAME_DIRTY for the selective path. */
-            compositor_dirty = 1;
+            wm_mark_dirty();
             return;
         }
         return;
@@ -576,7 +634,7 @@ void wm_handle_mouse_input(uint8_t type, int16_t x, int16_t y, uint8_t buttons)
                             wm_restore_window(target);
                         else
                             wm_maximize_window(target);
-                        compositor_dirty = 1;
+                        wm_mark_dirty();
                     }
                     return;
                 }
@@ -666,7 +724,7 @@ void wm_handle_mouse_input(uint8_t type, int16_t x, int16_t y, uint8_t buttons)
             }
             if (bwin)
                 bwin->flags |= WF_DIRTY | WF_FRAME_DIRTY;
-            compositor_dirty = 1;
+            wm_mark_dirty();
             return;
         }
 
@@ -826,7 +884,7 @@ bool wm_keyboard_move_key(uint8_t hid_code) {
     default:
         return false;
     }
-    compositor_dirty = 1;
+    wm_mark_dirty();
     return true;
 }
 
@@ -12,6 +12,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "window.h"
+#include "FreeRTOS.h"
+#include "task.h"
 
 /*==========================================================================
  * Event types (WM_* message IDs)
@@ -56,6 +58,7 @@
 #define WM_TIMER        20
 #define WM_COMMAND      21
 #define WM_DROPFILES    22  /* file opened via association; file_path in event */
+#define WM_MOUSEWHEEL   23  /* wheel turned; posted to the focused window */
 
 /*==========================================================================
  * Keyboard modifier flags
@@ -179,6 +182,14 @@ struct window_event {
             uint8_t modifiers;
         } mouse;
 
+        /* WM_MOUSEWHEEL */
+        struct {
+            int16_t x;         /* cursor, screen coordinates */
+            int16_t y;
+            int8_t  delta;     /* notches, positive = away from the user */
+            uint8_t modifiers;
+        } wheel;
+
         /* WM_MOVE */
         struct {
             int16_t x;
@@ -284,6 +295,41 @@ uint8_t wm_get_modifiers(void);
 void wm_mark_dirty(void);
 bool wm_needs_composite(void);
 
+/*==========================================================================
+ * Compositor and input task wakeups
+ *
+ * Both tasks sleep on their task notification instead of polling.
+ * wm_mark_dirty() and wm_post_event() wake the compositor; the PS/2 IRQ
+ * and the USB HID report callback wake the input task.  The timeout is
+ * only a fallback for work nothing signals (the taskbar clock).
+ *=========================================================================*/
+
+typedef struct {
+    uint32_t comp_wakeups;    /* compositor woken by a notification */
+    uint32_t comp_timeouts;   /* ... by its fallback timeout */
+    uint32_t input_wakeups;   /* input task woken by an IRQ or report */
+    uint32_t input_timeouts;
+    uint32_t ticks;           /* xTaskGetTickCount() at the snapshot */
+} wm_wake_stats_t;
+
+/* Register the task that wm_wake_compositor() / wm_wake_input*() wake.
+ * Each task registers itself before its first wait. */
+void wm_set_compositor_task(TaskHandle_t task);
+void wm_set_input_task(TaskHandle_t task);
+
+/* Wake the compositor without marking anything dirty (deferred work) */
+void wm_wake_compositor(void);
+
+/* Wake the input task — from a task, and from an interrupt handler */
+void wm_wake_input(void);
+void wm_wake_input_from_isr(void);
+
+/* Sleep until woken or timeout ticks pass.  True if woken. */
+bool wm_wait_compositor(TickType_t timeout);
+bool wm_wait_input(TickType_t timeout);
+
+void wm_get_wake_stats(wm_wake_stats_t *st);
+
 /*==========================================================================
  * Title bar button press query
  *=========================================================================*/
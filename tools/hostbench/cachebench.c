@@ -0,0 +1,292 @@
+/*
+ * FRANK OS
+ * Copyright (c) 2026 Mikhail Matveev <xtreme@rh1.tech>
+ * https://rh1.tech
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/* cachebench — replay sector access traces through the FatFs sector
+ * cache (drivers/fatfs/ffcache.c, unmodified) on an in-memory disk.
+ *
+ *   cachebench                 built-in scenarios
+ *   cachebench trace...        recorded traces
+ *
+ * A trace is the serial log of a firmware built with FF_CACHE_TRACE 1:
+ * lines "ffc R <lba> <count> <class>", "ffc W <lba> <count>", "ffc S"
+ * and "ffc P <lba>" (f_read's lock-free look into the cache); anything
+ * else on a line before "ffc " or on other lines is ignored.  Reads go
+ * through ffc_read() when they came from the FatFs window (count 1 with
+ * a class), the rest through disk_read/disk_write.
+ *
+ * For each trace it prints the single-sector hit rate (all and FAT /
+ * directory), the share of lock-free reads served, the sectors read from and written to the device with and
+ * without the cache, and the write-back runs.  Every read is checked
+ * against the last data written to that sector; "same" must be "yes". */
+
+#include "ffcache.h"
+#include "task.h"
+#include "semphr.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*==========================================================================
+ * Device: sparse in-memory disk, sectors stamped with a version number
+ *=========================================================================*/
+
+#define DISK_SECTORS  (1u << 22)          /* 2 GB */
+
+static uint32_t *dev_ver;                 /* version stored on the device */
+static uint32_t *want_ver;                /* version last written by FatFs */
+static uint32_t  next_ver = 1;
+static unsigned  dev_rd, dev_wr;
+static bool      mismatch;
+
+static void stamp(BYTE *buf, LBA_t s, uint32_t ver) {
+    memcpy(buf, &s, sizeof s);
+    memcpy(buf + 8, &ver, sizeof ver);
+}
+
+static uint32_t stamp_ver(const BYTE *buf, LBA_t s) {
+    LBA_t got;
+    uint32_t ver;
+    memcpy(&got, buf, sizeof got);
+    memcpy(&ver, buf + 8, sizeof ver);
+    return got == s ? ver : 0xFFFFFFFFu;
+}
+
+DSTATUS sd_disk_initialize(BYTE pdrv) { (void)pdrv; return 0; }
+DSTATUS sd_disk_status(BYTE pdrv) { (void)pdrv; return 0; }
+
+DRESULT sd_disk_read(BYTE pdrv, BYTE *buff, LBA_t sector, UINT count) {
+    (void)pdrv;
+    for (UINT i = 0; i < count; i++)
+        stamp(buff + i * FF_MIN_SS, sector + i, dev_ver[sector + i]);
+    dev_rd += count;
+    return RES_OK;
+}
+
+DRESULT sd_disk_write(BYTE pdrv, const BYTE *buff, LBA_t sector, UINT count) {
+    (void)pdrv;
+    for (UINT i = 0; i < count; i++)
+        dev_ver[sector + i] = stamp_ver(buff + i * FF_MIN_SS, sector + i);
+    dev_wr += count;
+    return RES_OK;
+}
+
+DRESULT sd_disk_ioctl(BYTE pdrv, BYTE cmd, void *buff) {
+    (void)pdrv; (void)cmd; (void)buff;
+    return RES_OK;
+}
+
+/* Host stand-ins for the firmware services ffcache.c uses */
+void *psram_alloc(size_t size) { return malloc(size); }
+bool  psram_is_available(void) { return true; }
+BaseType_t xTaskGetSchedulerState(void) { return taskSCHEDULER_RUNNING; }
+
+/* Single-threaded: the cache's locks are never contended */
+static int host_sem;
+SemaphoreHandle_t xSemaphoreCreateMutex(void) { return (SemaphoreHandle_t)&host_sem; }
+BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t wait) { (void)s; (void)wait; return pdTRUE; }
+BaseType_t xSemaphoreGive(SemaphoreHandle_t s) { (void)s; return pdTRUE; }
+
+/*==========================================================================
+ * Replay
+ *=========================================================================*/
+
+typedef struct {
+    unsigned sect_rd, sect_wr;            /* what an uncached disk would see */
+} replay_t;
+
+static void op_read(replay_t *r, LBA_t s, UINT n, int cls) {
+    static BYTE buf[64 * FF_MIN_SS];
+    if (s + n > DISK_SECTORS || n > 64) return;
+    if (n == 1 && cls >= 0) ffc_read(0, buf, s, (BYTE)cls);
+    else disk_read(0, buf, s, n);
+    for (UINT i = 0; i < n; i++)
+        if (stamp_ver(buf + i * FF_MIN_SS, s + i) != want_ver[s + i]) mismatch = true;
+    r->sect_rd += n;
+}
+
+/* f_read without the volume lock: true if the cache had the sector */
+static bool op_peek(LBA_t s) {
+    BYTE buf[FF_MIN_SS];
+    if (s >= DISK_SECTORS || !ffc_peek(0, buf, s, 0, FF_MIN_SS)) return false;
+    if (stamp_ver(buf, s) != want_ver[s]) mismatch = true;
+    return true;
+}
+
+static void op_write(replay_t *r, LBA_t s, UINT n) {
+    static BYTE buf[64 * FF_MIN_SS];
+    if (s + n > DISK_SECTORS || n > 64) return;
+    for (UINT i = 0; i < n; i++) {
+        want_ver[s + i] = next_ver++;
+        stamp(buf + i * FF_MIN_SS, s + i, want_ver[s + i]);
+    }
+    disk_write(0, buf, s, n);
+    r->sect_wr += n;
+}
+
+static void op_sync(void) {
+    disk_ioctl(0, CTRL_SYNC, NULL);
+}
+
+static void start(replay_t *r) {
+    memset(dev_ver, 0, DISK_SECTORS * sizeof *dev_ver);
+    memset(want_ver, 0, DISK_SECTORS * sizeof *want_ver);
+    memset(r, 0, sizeof *r);
+    disk_initialize(0);
+    ffc_reset_stats();
+    dev_rd = dev_wr = 0;
+    mismatch = false;
+}
+
+static void report(const char *name, replay_t *r) {
+    op_sync();
+    for (LBA_t s = 0; s < DISK_SECTORS; s++)
+        if (dev_ver[s] != want_ver[s]) { mismatch = true; break; }
+    FFC_STATS st;
+    ffc_get_stats(&st);
+    printf("%-12s %8lu %6.1f%% %6.1f%% %6.1f%% %9u %9u %9u %9u %7lu  %s\n", name,
+           (unsigned long)st.reads,
+           st.reads ? 100.0 * st.read_hits / st.reads : 0.0,
+           st.meta_reads ? 100.0 * st.meta_hits / st.meta_reads : 0.0,
+           st.peeks ? 100.0 * st.peek_hits / st.peeks : 0.0,
+           r->sect_rd, dev_rd, r->sect_wr, dev_wr,
+           (unsigned long)st.wb_runs, mismatch ? "NO" : "yes");
+}
+
+static int replay_file(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) { perror(path); return 1; }
+    replay_t r;
+    start(&r);
+    char line[256];
+    while (fgets(line, sizeof line, f)) {
+        char *p = strstr(line, "ffc ");
+        if (!p) continue;
+        char op;
+        unsigned long s = 0;
+        unsigned n = 1;
+        int cls = -1;
+        int k = sscanf(p + 4, "%c %lu %u %d", &op, &s, &n, &cls);
+        if (k < 1) continue;
+        if (op == 'R' && k >= 3) op_read(&r, s, n, cls);
+        else if (op == 'W' && k >= 3) op_write(&r, s, n);
+        else if (op == 'S') op_sync();
+        else if (op == 'P' && k >= 2) op_peek(s);
+    }
+    fclose(f);
+    const char *base = strrchr(path, '/');
+    report(base ? base + 1 : path, &r);
+    return 0;
+}
+
+/*==========================================================================
+ * Built-in scenarios: the FatFs access pattern on a FAT32 volume
+ *=========================================================================*/
+
+#define FATBASE   32u
+#define FATSIZE   8192u
+#define DATABASE  (FATBASE + 2 * FATSIZE)
+#define CSIZE     8u                      /* sectors per cluster */
+
+static LBA_t clust_sect(uint32_t c) { return DATABASE + (c - 2) * CSIZE; }
+static LBA_t fat_sect(uint32_t c)   { return FATBASE + c / 128; }
+
+/* A file being read in 256-byte pieces, FAT looked up per cluster.  As in
+ * f_read, a piece inside the current cluster is first looked up without
+ * the volume lock, and only a miss goes through the window. */
+typedef struct {
+    uint32_t clust, first, len;           /* clusters are contiguous */
+    uint32_t pos;                         /* sector within the file */
+} file_t;
+
+static void file_read_step(replay_t *r, file_t *f) {
+    uint32_t c = f->first + f->pos / CSIZE;
+    LBA_t s = clust_sect(c) + f->pos % CSIZE;
+    if (f->pos % CSIZE == 0 && f->pos) op_read(r, fat_sect(c - 1), 1, FFC_META);
+    if (f->pos % CSIZE == 0 || !op_peek(s)) op_read(r, s, 1, FFC_DATA);
+    if (!op_peek(s)) op_read(r, s, 1, FFC_DATA);
+    if (++f->pos == f->len * CSIZE) f->pos = 0;
+}
+
+/* A directory listing: every entry sector, then a stat per few entries
+ * (finds the entry again from the top) */
+static void dir_walk(replay_t *r, uint32_t dclust, unsigned sects) {
+    for (unsigned i = 0; i < sects; i++) {
+        op_read(r, clust_sect(dclust) + i, 1, FFC_META);
+        for (unsigned k = 0; k <= i; k += 2)
+            op_read(r, clust_sect(dclust) + k, 1, FFC_META);
+    }
+}
+
+/* Appending 64-byte records to a log: the partial data sector is written
+ * per record, the FAT on each new cluster, the entry on f_sync every 16 */
+static void log_append(replay_t *r, file_t *f, uint32_t dclust) {
+    uint32_t sect = f->pos / 8;
+    uint32_t c = f->first + sect / CSIZE;
+    if (f->pos % (8 * CSIZE) == 0) {
+        op_read(r, fat_sect(c), 1, FFC_META);
+        op_write(r, fat_sect(c), 1);
+        op_write(r, fat_sect(c) + FATSIZE, 1);
+    }
+    if (f->pos % 8) op_read(r, clust_sect(c) + sect % CSIZE, 1, FFC_DATA);
+    op_write(r, clust_sect(c) + sect % CSIZE, 1);
+    if (++f->pos % 16 == 0) {
+        op_read(r, clust_sect(dclust), 1, FFC_META);
+        op_write(r, clust_sect(dclust), 1);
+        op_sync();
+    }
+}
+
+static void scenario(const char *name) {
+    replay_t r;
+    start(&r);
+    srand(1);
+    file_t song = { .first = 40000, .len = 600 };   /* ~2.4 MB MP3 */
+    file_t app  = { .first = 90000, .len = 40 };
+    file_t log  = { .first = 120000, .len = 1000 };
+    if (!strcmp(name, "stream")) {
+        for (int i = 0; i < 20000; i++) file_read_step(&r, &song);
+    } else if (!strcmp(name, "dirwalk")) {
+        for (int i = 0; i < 200; i++) dir_walk(&r, 10 + rand() % 6, 4 + rand() % 8);
+    } else if (!strcmp(name, "log")) {
+        for (int i = 0; i < 4000; i++) log_append(&r, &log, 12);
+    } else if (!strcmp(name, "mixed")) {
+        /* Music playing, file manager browsing, terminal app logging,
+         * an app launch now and then */
+        for (int i = 0; i < 20000; i++) {
+            file_read_step(&r, &song);
+            if (i % 50 == 0) dir_walk(&r, 10 + rand() % 6, 2 + rand() % 6);
+            if (i % 8 == 0) log_append(&r, &log, 12);
+            if (i % 2000 == 0) {
+                app.pos = 0;
+                for (unsigned k = 0; k < app.len * CSIZE; k += 8) op_read(&r, clust_sect(app.first) + k, 8, -1);
+            }
+        }
+    }
+    report(name, &r);
+}
+
+int main(int argc, char **argv) {
+    dev_ver  = calloc(DISK_SECTORS, sizeof *dev_ver);
+    want_ver = calloc(DISK_SECTORS, sizeof *want_ver);
+    if (!dev_ver || !want_ver) return 1;
+
+    printf("%d SRAM + %d x %d PSRAM sectors, write-back runs up to %d\n\n",
+           FF_CACHE_SRAM, FF_CACHE_SETS, FF_CACHE_WAYS, FF_CACHE_WB_MAX);
+    printf("%-12s %8s %7s %7s %7s %9s %9s %9s %9s %7s  %s\n", "trace", "reads",
+           "hit", "fat/dir", "nolock", "rd-nocache", "rd-dev", "wr-nocache", "wr-dev", "wbruns", "same");
+    int rc = 0;
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++) rc |= replay_file(argv[i]);
+    } else {
+        scenario("stream");
+        scenario("dirwalk");
+        scenario("log");
+        scenario("mixed");
+    }
+    return rc;
+}
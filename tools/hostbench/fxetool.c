@@ -0,0 +1,459 @@
+/*
+ * FRANK OS
+ * Copyright (c) 2026 Mikhail Matveev <xtreme@rh1.tech>
+ * https://rh1.tech
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/* fxetool — build pre-linked .fxe app images on the host (src/fxe.c, the
+ * same builder the firmware runs after a first launch) and compare
+ * launch costs of the two formats.
+ *
+ *   fxetool [-o out.fxe] app...      write <app>.fxe (or out.fxe)
+ *   fxetool -b [-r runs] app...      benchmark ELF vs .fxe launches
+ *
+ * The benchmark loads every app both ways from an in-memory copy of the
+ * file, at the same (fake, 32-bit) section addresses:
+ *
+ *   elf   what load_app() does: section headers, .shstrtab, .strtab and
+ *         .symtab, then each reachable section and its REL sections,
+ *         resolving every relocation through the symbol table
+ *   fxe   header and section table, blobs, delta table, rebase
+ *
+ * and reports the best time over the runs plus the read calls, seeks
+ * (reads not following the previous one — what costs most on an SD
+ * card), bytes read and relocations applied.  The loaded sections of
+ * both must be byte-identical; "same" says whether they are. */
+
+#include "fxe.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/* Fake load addresses: sections are laid out in ELF order from here */
+#define FAKE_BASE  0x15000000u
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/*==========================================================================
+ * In-memory files with read accounting
+ *=========================================================================*/
+
+typedef struct {
+    uint8_t  *data;
+    uint32_t  size, cap;
+    uint32_t  pos;
+    unsigned  reads, seeks, rels;
+    uint64_t  bytes;
+} mfile_t;
+
+static bool mread(mfile_t *m, uint32_t off, void *buf, uint32_t len) {
+    if (off > m->size || len > m->size - off) return false;
+    if (off != m->pos) m->seeks++;
+    m->reads++;
+    m->bytes += len;
+    memcpy(buf, m->data + off, len);
+    m->pos = off + len;
+    return true;
+}
+
+static bool mwrite(mfile_t *m, uint32_t off, const void *buf, uint32_t len) {
+    if (off + len > m->cap) {
+        uint32_t cap = m->cap ? m->cap : 65536;
+        while (cap < off + len) cap *= 2;
+        uint8_t *n = realloc(m->data, cap);
+        if (!n) return false;
+        memset(n + m->cap, 0, cap - m->cap);
+        m->data = n;
+        m->cap  = cap;
+    }
+    memcpy(m->data + off, buf, len);
+    if (off + len > m->size) m->size = off + len;
+    return true;
+}
+
+static void mreset(mfile_t *m) {
+    m->pos = 0;
+    m->reads = m->seeks = m->rels = 0;
+    m->bytes = 0;
+}
+
+static bool load_file(const char *path, mfile_t *m) {
+    memset(m, 0, sizeof(*m));
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    fseek(f, 0, SEEK_END);
+    long sz = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    m->data = malloc(sz > 0 ? sz : 1);
+    m->size = m->cap = (uint32_t)sz;
+    bool ok = m->data && fread(m->data, 1, sz, f) == (size_t)sz;
+    fclose(f);
+    return ok;
+}
+
+/* fxe_io_t over an ELF and an output mfile_t */
+typedef struct {
+    mfile_t *elf, *out;
+} io_files_t;
+
+static bool io_read(void *ctx, uint32_t off, void *buf, uint32_t len) {
+    return mread(((io_files_t *)ctx)->elf, off, buf, len);
+}
+
+static bool io_write(void *ctx, uint32_t off, const void *buf, uint32_t len) {
+    return mwrite(((io_files_t *)ctx)->out, off, buf, len);
+}
+
+static void elf_id(const char *path, fxe_elf_id_t *id) {
+    struct stat st;
+    memset(id, 0, sizeof(*id));
+    if (stat(path, &st) != 0) return;
+    struct tm *tm = localtime(&st.st_mtime);
+    id->size  = (uint32_t)st.st_size;
+    if (tm->tm_year >= 80) {
+        id->fdate = (uint16_t)(((tm->tm_year - 80) << 9) | ((tm->tm_mon + 1) << 5) | tm->tm_mday);
+        id->ftime = (uint16_t)((tm->tm_hour << 11) | (tm->tm_min << 5) | (tm->tm_sec / 2));
+    }
+}
+
+static int build_image(const char *path, mfile_t *elf, mfile_t *out) {
+    fxe_elf_id_t id;
+    elf_id(path, &id);
+    io_files_t files = { elf, out };
+    fxe_io_t io = { &files, io_read, io_write, malloc, free };
+    memset(out, 0, sizeof(*out));
+    mreset(elf);
+    return fxe_build(&io, &id, NULL);
+}
+
+/*==========================================================================
+ * Launch emulation
+ *=========================================================================*/
+
+typedef struct {
+    uint8_t **mem;      /* per ELF section, NULL = not loaded */
+    uint32_t *addr;     /* fake load address per ELF section */
+    uint32_t *size;
+    uint16_t  sh_num;
+} image_t;
+
+static void image_init(image_t *im, const mfile_t *elf) {
+    const elf32_header *eh = (const elf32_header *)elf->data;
+    const elf32_shdr *sh = (const elf32_shdr *)(elf->data + eh->sh_offset);
+    im->sh_num = eh->sh_num;
+    im->mem  = calloc(eh->sh_num, sizeof(uint8_t *));
+    im->addr = calloc(eh->sh_num, sizeof(uint32_t));
+    im->size = calloc(eh->sh_num, sizeof(uint32_t));
+    uint32_t a = FAKE_BASE;
+    for (uint16_t i = 0; i < eh->sh_num; i++) {
+        uint32_t al = sh[i].sh_addralign > 8 ? sh[i].sh_addralign : 8;
+        a = (a + al - 1) & ~(al - 1);
+        im->addr[i] = a;
+        a += sh[i].sh_size;
+    }
+}
+
+static void image_clear(image_t *im) {
+    for (uint16_t i = 0; i < im->sh_num; i++) {
+        free(im->mem[i]);
+        im->mem[i] = NULL;
+    }
+}
+
+static void image_free(image_t *im) {
+    image_clear(im);
+    free(im->mem);
+    free(im->addr);
+    free(im->size);
+}
+
+/* The ELF path, as load_app()/load_sec2mem() do it */
+typedef struct {
+    mfile_t    *f;
+    image_t    *im;
+    elf32_header eh;
+    elf32_shdr *sh;
+    elf32_sym  *sym;
+    uint32_t    nsym;
+} elf_load_t;
+
+static uint8_t *elf_load_sec(elf_load_t *c, uint16_t s) {
+    if (s == 0 || s >= c->eh.sh_num) return NULL;
+    if (c->im->mem[s]) return c->im->mem[s];
+    const elf32_shdr *sh = &c->sh[s];
+    uint8_t *p = calloc(1, sh->sh_size + 4);
+    c->im->mem[s]  = p;
+    c->im->size[s] = sh->sh_size;
+    if (sh->sh_type != SHT_NOBITS && sh->sh_size && !mread(c->f, sh->sh_offset, p, sh->sh_size))
+        return NULL;
+    for (uint16_t r = 0; r < c->eh.sh_num; r++) {
+        if (c->sh[r].sh_type != SHT_REL || c->sh[r].sh_info != s) continue;
+        uint32_t n = c->sh[r].sh_size / sizeof(elf32_rel);
+        elf32_rel *rel = malloc(n * sizeof(elf32_rel) + 1);
+        if (!mread(c->f, c->sh[r].sh_offset, rel, n * sizeof(elf32_rel))) {
+            free(rel);
+            return NULL;
+        }
+        for (uint32_t j = 0; j < n; j++) {
+            uint32_t si = rel[j].rel_info >> 8;
+            if (si >= c->nsym || rel[j].rel_offset + 4 > sh->sh_size) { free(rel); return NULL; }
+            const elf32_sym *sym = &c->sym[si];
+            uint16_t t = sym->st_shndx;
+            if (t != s && !elf_load_sec(c, t)) { free(rel); return NULL; }
+            uint32_t off = rel[j].rel_offset;
+            int rc = fxe_rel_apply(p + off, c->im->addr[s] + off, rel[j].rel_info & 0xFF,
+                                   c->im->addr[t] + sym->st_value);
+            if (rc == FXE_REL_UNSUPPORTED) { free(rel); return NULL; }
+            c->f->rels++;
+        }
+        free(rel);
+    }
+    return p;
+}
+
+static bool elf_launch(mfile_t *f, image_t *im) {
+    elf_load_t c;
+    memset(&c, 0, sizeof(c));
+    c.f = f;
+    c.im = im;
+    bool ok = false;
+    char *shstr = NULL, *str = NULL;
+    if (!mread(f, 0, &c.eh, sizeof(c.eh))) return false;
+    c.sh = malloc(c.eh.sh_num * sizeof(elf32_shdr));
+    if (!mread(f, c.eh.sh_offset, c.sh, c.eh.sh_num * sizeof(elf32_shdr))) goto out;
+    const elf32_shdr *ss = &c.sh[c.eh.sh_str_index];
+    shstr = malloc(ss->sh_size + 1);
+    if (!mread(f, ss->sh_offset, shstr, ss->sh_size)) goto out;
+    const elf32_shdr *symsh = NULL, *strsh = NULL;
+    for (uint16_t i = 0; i < c.eh.sh_num && (!symsh || !strsh); i++) {
+        if (!symsh && c.sh[i].sh_type == SHT_SYMTAB && !strcmp(shstr + c.sh[i].sh_name, ".symtab"))
+            symsh = &c.sh[i];
+        if (!strsh && c.sh[i].sh_type == SHT_STRTAB && !strcmp(shstr + c.sh[i].sh_name, ".strtab"))
+            strsh = &c.sh[i];
+    }
+    if (!symsh || !strsh) goto out;
+    str = malloc(strsh->sh_size + 1);
+    c.nsym = symsh->sh_size / sizeof(elf32_sym);
+    c.sym = malloc(symsh->sh_size + 1);
+    if (!mread(f, strsh->sh_offset, str, strsh->sh_size) ||
+        !mread(f, symsh->sh_offset, c.sym, symsh->sh_size))
+        goto out;
+
+    static const char *const names[] = {
+        "__required_m_api_verion", "_init", "main", "_fini", "signal", "__app_flags"
+    };
+    uint32_t idx[FXE_NENTRIES], winit = 0xFFFFFFFF, wfini = 0xFFFFFFFF;
+    for (int k = 0; k < FXE_NENTRIES; k++) idx[k] = 0xFFFFFFFF;
+    for (uint32_t i = 0; i < c.nsym; i++) {
+        const elf32_sym *s = &c.sym[i];
+        if (s->st_name >= strsh->sh_size) continue;
+        if (s->st_info == STR_TAB_GLOBAL_FUNC) {
+            for (int k = 0; k < FXE_NENTRIES; k++)
+                if (!strcmp(str + s->st_name, names[k])) idx[k] = i;
+        } else if (s->st_info == STR_TAB_WEAK_FUNC) {
+            if (!strcmp(str + s->st_name, "_init")) winit = i;
+            else if (!strcmp(str + s->st_name, "_fini")) wfini = i;
+        }
+    }
+    if (idx[FXE_ENTRY_INIT] == 0xFFFFFFFF) idx[FXE_ENTRY_INIT] = winit;
+    if (idx[FXE_ENTRY_FINI] == 0xFFFFFFFF) idx[FXE_ENTRY_FINI] = wfini;
+    ok = true;
+    for (int k = 0; k < FXE_NENTRIES && ok; k++)
+        if (idx[k] != 0xFFFFFFFF && !elf_load_sec(&c, c.sym[idx[k]].st_shndx))
+            ok = false;
+out:
+    free(shstr);
+    free(str);
+    free(c.sym);
+    free(c.sh);
+    return ok;
+}
+
+/* The .fxe path: one front-to-back pass, then rebase */
+static bool fxe_launch(mfile_t *f, image_t *im) {
+    fxe_header_t h;
+    if (!mread(f, 0, &h, sizeof(h)) || !fxe_header_ok(&h, f->size)) return false;
+    fxe_sec_t *secs = malloc(h.sec_count * sizeof(fxe_sec_t));
+    fxe_rel_t *rels = malloc(h.rel_count * sizeof(fxe_rel_t) + 1);
+    bool ok = mread(f, sizeof(h), secs, h.sec_count * sizeof(fxe_sec_t));
+    for (uint16_t i = 0; i < h.sec_count && ok; i++) {
+        const fxe_sec_t *s = &secs[i];
+        uint8_t *p = calloc(1, s->size + 4);
+        im->mem[s->elf_index]  = p;
+        im->size[s->elf_index] = s->size;
+        if (!(s->flags & FXE_SEC_NOBITS) && s->size)
+            ok = mread(f, s->offset, p, s->size);
+    }
+    ok = ok && mread(f, h.rel_offset, rels, h.rel_count * sizeof(fxe_rel_t));
+    for (uint16_t i = 0; i < h.sec_count && ok; i++) {
+        const fxe_sec_t *s = &secs[i];
+        uint32_t a = im->addr[s->elf_index];
+        for (uint32_t j = 0; j < s->rel_count && ok; j++) {
+            const fxe_rel_t *r = &rels[s->rel_first + j];
+            ok = fxe_rel_apply(im->mem[s->elf_index] + r->offset, a, r->type,
+                               im->addr[secs[r->target].elf_index]) == FXE_REL_OK;
+            f->rels++;
+        }
+    }
+    free(secs);
+    free(rels);
+    return ok;
+}
+
+static bool images_equal(const image_t *a, const image_t *b) {
+    for (uint16_t i = 0; i < a->sh_num; i++) {
+        if (!a->mem[i] != !b->mem[i]) return false;
+        if (a->mem[i] && (a->size[i] != b->size[i] ||
+                          memcmp(a->mem[i], b->mem[i], a->size[i]) != 0))
+            return false;
+    }
+    return true;
+}
+
+/*==========================================================================
+ * Commands
+ *=========================================================================*/
+
+static bool is_elf(const mfile_t *m) {
+    return m->size >= sizeof(elf32_header) && *(const uint32_t *)m->data == ELF_MAGIC;
+}
+
+static int cmd_build(const char *path, const char *out_path) {
+    mfile_t elf, out;
+    if (!load_file(path, &elf)) {
+        fprintf(stderr, "%s: cannot read\n", path);
+        return 1;
+    }
+    int rc = build_image(path, &elf, &out);
+    free(elf.data);
+    if (rc != FXE_OK) {
+        fprintf(stderr, "%s: %s\n", path, fxe_strerror(rc));
+        free(out.data);
+        return 1;
+    }
+    char def[4096];
+    if (!out_path) {
+        snprintf(def, sizeof(def), "%s%s", path, FXE_EXT);
+        out_path = def;
+    }
+    FILE *f = fopen(out_path, "wb");
+    bool ok = f && fwrite(out.data, 1, out.size, f) == out.size;
+    if (f) ok = (fclose(f) == 0) && ok;
+    if (!ok) fprintf(stderr, "%s: write failed\n", out_path);
+    else     printf("%s: %u bytes\n", out_path, out.size);
+    free(out.data);
+    return ok ? 0 : 1;
+}
+
+typedef struct {
+    uint64_t ns;
+    unsigned reads, seeks, rels;
+    uint64_t bytes;
+} launch_stats_t;
+
+static bool bench_one(bool (*launch)(mfile_t *, image_t *), mfile_t *f,
+                      image_t *im, int runs, launch_stats_t *st) {
+    st->ns = UINT64_MAX;
+    for (int r = 0; r < runs; r++) {
+        image_clear(im);
+        mreset(f);
+        uint64_t t0 = now_ns();
+        bool ok = launch(f, im);
+        uint64_t dt = now_ns() - t0;
+        if (!ok) return false;
+        if (dt < st->ns) st->ns = dt;
+    }
+    st->reads = f->reads;
+    st->seeks = f->seeks;
+    st->rels  = f->rels;
+    st->bytes = f->bytes;
+    return true;
+}
+
+static int cmd_bench(int n, char **paths, int runs) {
+    printf("%-14s %4s %9s %6s %6s %8s %7s %8s %5s\n",
+           "app", "fmt", "best us", "reads", "seeks", "KB read", "relocs", "size KB", "same");
+    int fails = 0;
+    for (int i = 0; i < n; i++) {
+        mfile_t elf, img;
+        if (!load_file(paths[i], &elf)) continue;
+        if (!is_elf(&elf)) { free(elf.data); continue; }
+        const char *name = strrchr(paths[i], '/');
+        name = name ? name + 1 : paths[i];
+
+        int rc = build_image(paths[i], &elf, &img);
+        if (rc != FXE_OK) {
+            printf("%-14s  no image: %s\n", name, fxe_strerror(rc));
+            free(elf.data);
+            free(img.data);
+            continue;
+        }
+        image_t a, b;
+        image_init(&a, &elf);
+        image_init(&b, &elf);
+        launch_stats_t se, sx;
+        bool ok = bench_one(elf_launch, &elf, &a, runs, &se) &&
+                  bench_one(fxe_launch, &img, &b, runs, &sx);
+        bool same = ok && images_equal(&a, &b);
+        if (!same) fails++;
+        printf("%-14s %4s %9.1f %6u %6u %8.1f %7u %8.1f\n", name, "elf",
+               se.ns / 1000.0, se.reads, se.seeks, se.bytes / 1024.0, se.rels, elf.size / 1024.0);
+        printf("%-14s %4s %9.1f %6u %6u %8.1f %7u %8.1f %5s\n", "", "fxe",
+               sx.ns / 1000.0, sx.reads, sx.seeks, sx.bytes / 1024.0, sx.rels, img.size / 1024.0,
+               !ok ? "ERR" : same ? "yes" : "NO");
+        image_free(&a);
+        image_free(&b);
+        free(elf.data);
+        free(img.data);
+    }
+    return fails ? 1 : 0;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+            "usage: %s [-o out.fxe] app...     build <app>.fxe images\n"
+            "       %s -b [-r runs] app...     benchmark ELF vs .fxe launches\n",
+            argv0, argv0);
+}
+
+int main(int argc, char **argv) {
+    int opt, runs = 20;
+    bool bench = false;
+    const char *out = NULL;
+    while ((opt = getopt(argc, argv, "o:br:h")) != -1) {
+        switch (opt) {
+        case 'o':
+            out = optarg;
+            break;
+        case 'b':
+            bench = true;
+            break;
+        case 'r':
+            runs = atoi(optarg);
+            if (runs < 1) runs = 1;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (optind >= argc || (out && argc - optind > 1)) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (bench)
+        return cmd_bench(argc - optind, argv + optind, runs);
+    int rc = 0;
+    for (int i = optind; i < argc; i++)
+        rc |= cmd_build(argv[i], out);
+    return rc;
+}
@@ -0,0 +1,28 @@
+/*
+ * FRANK OS
+ * Copyright (c) 2026 Mikhail Matveev <xtreme@rh1.tech>
+ * https://rh1.tech
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef HOST_H
+#define HOST_H
+
+#include <stdint.h>
+
+/* Host build glue shared between host_stubs.c and wmbench.c */
+
+/* FreeRTOS tick — advanced by vTaskDelay() and by the benchmark */
+extern volatile uint32_t host_tick;
+
+/* Number of DispHstxWaitVSync() calls so far */
+extern uint32_t host_vsync_count;
+
+/* Run the callback of every started software timer once */
+void host_timers_fire(void);
+
+/* Prepare the stand-in desktop shortcuts */
+void host_desktop_init(void);
+
+#endif
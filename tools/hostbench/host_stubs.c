@@ -0,0 +1,370 @@
+/*
+ * FRANK OS
+ * Copyright (c) 2026 Mikhail Matveev <xtreme@rh1.tech>
+ * https://rh1.tech
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/* Host build glue: FreeRTOS, DispHSTX and the OS subsystems the window
+ * manager calls into but which are not part of the benchmark (swap,
+ * start menu, desktop shortcuts, sound, network).  Everything runs on
+ * one host thread; the benchmark owns time (host_tick) and vsync. */
+
+#include "host.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "timers.h"
+#include "queue.h"
+#include "disphstx.h"
+#include "window.h"
+#include "window_theme.h"
+#include "desktop.h"
+#include "settings.h"
+#include "netcard.h"
+#include "gfx.h"
+#include "font.h"
+#include "display.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*==========================================================================
+ * Time and vsync
+ *=========================================================================*/
+
+volatile uint32_t host_tick;
+uint32_t          host_vsync_count;
+
+sDispHstxVModeState  DispHstxVMode;
+sDispHstxVModeState *pDispHstxVMode = &DispHstxVMode;
+const sDispHstxVModeTime DispHstxVModeTimeList[1];
+
+/* Scanout is not simulated: a vsync wait returns immediately with the
+ * beam parked past the last visible line, so display_wait_scanline()
+ * never spins. */
+void DispHstxWaitVSync(void) {
+    host_vsync_count++;
+    DispHstxVMode.line = DISPLAY_HEIGHT;
+}
+
+/*==========================================================================
+ * Heap
+ *=========================================================================*/
+
+void *pvPortMalloc(size_t size)          { return malloc(size); }
+void *pvPortCalloc(size_t n, size_t sz)  { return calloc(n, sz); }
+void  vPortFree(void *p)                 { free(p); }
+size_t xPortGetFreeHeapSize(void)            { return 256 * 1024; }
+size_t xPortGetMinimumEverFreeHeapSize(void) { return 256 * 1024; }
+
+void psram_free(void *p)        { free(p); }
+void *psram_alloc(size_t size)  { return malloc(size); }
+bool psram_is_available(void)   { return false; }
+
+/*==========================================================================
+ * Tasks — a single pseudo-task stands in for the compositor
+ *=========================================================================*/
+
+struct host_task {
+    void *tls[configNUM_THREAD_LOCAL_STORAGE_POINTERS];
+};
+
+static struct host_task host_main_task;
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name,
+                       uint32_t stack_depth, void *arg,
+                       UBaseType_t prio, TaskHandle_t *out) {
+    (void)fn; (void)name; (void)stack_depth; (void)arg; (void)prio;
+    if (out) *out = NULL;
+    return pdFAIL;
+}
+
+void vTaskDelete(TaskHandle_t t)        { (void)t; }
+void vTaskDelay(TickType_t ticks)       { host_tick += ticks; }
+TickType_t xTaskGetTickCount(void)      { return host_tick; }
+TaskHandle_t xTaskGetCurrentTaskHandle(void) { return &host_main_task; }
+BaseType_t xTaskGetSchedulerState(void) { return taskSCHEDULER_RUNNING; }
+void vTaskSuspendAll(void)              { }
+BaseType_t xTaskResumeAll(void)         { return pdFALSE; }
+void vTaskSuspend(TaskHandle_t t)       { (void)t; }
+void vTaskResume(TaskHandle_t t)        { (void)t; }
+UBaseType_t uxTaskPriorityGet(TaskHandle_t t) { (void)t; return 1; }
+void vTaskPrioritySet(TaskHandle_t t, UBaseType_t p) { (void)t; (void)p; }
+char *pcTaskGetName(TaskHandle_t t)     { (void)t; return "host"; }
+
+void vTaskSetThreadLocalStoragePointer(TaskHandle_t t, BaseType_t i,
+                                       void *v) {
+    if (!t) t = &host_main_task;
+    if (i >= 0 && i < configNUM_THREAD_LOCAL_STORAGE_POINTERS)
+        t->tls[i] = v;
+}
+
+void *pvTaskGetThreadLocalStoragePointer(TaskHandle_t t, BaseType_t i) {
+    if (!t) t = &host_main_task;
+    if (i >= 0 && i < configNUM_THREAD_LOCAL_STORAGE_POINTERS)
+        return t->tls[i];
+    return NULL;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t t) { (void)t; return pdPASS; }
+void vTaskNotifyGiveFromISR(TaskHandle_t t, BaseType_t *woken) {
+    (void)t;
+    if (woken) *woken = pdFALSE;
+}
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait) {
+    (void)clear; (void)wait;
+    return 0;
+}
+BaseType_t xTaskNotify(TaskHandle_t t, uint32_t v, eNotifyAction a) {
+    (void)t; (void)v; (void)a;
+    return pdPASS;
+}
+BaseType_t xTaskNotifyFromISR(TaskHandle_t t, uint32_t v, eNotifyAction a,
+                              BaseType_t *woken) {
+    (void)t; (void)v; (void)a;
+    if (woken) *woken = pdFALSE;
+    return pdPASS;
+}
+BaseType_t xTaskNotifyWait(uint32_t ce, uint32_t cx, uint32_t *v,
+                           TickType_t wait) {
+    (void)ce; (void)cx; (void)wait;
+    if (v) *v = 0;
+    return pdFALSE;
+}
+
+/*==========================================================================
+ * Semaphores and queues — counters only, never block
+ *=========================================================================*/
+
+struct host_sem {
+    UBaseType_t count;
+    UBaseType_t max;
+};
+
+static SemaphoreHandle_t sem_new(UBaseType_t max, UBaseType_t init) {
+    SemaphoreHandle_t s = calloc(1, sizeof(*s));
+    if (s) { s->max = max; s->count = init; }
+    return s;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)          { return sem_new(1, 1); }
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void) { return sem_new(1, 1); }
+SemaphoreHandle_t xSemaphoreCreateBinary(void)         { return sem_new(1, 0); }
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t init) {
+    return sem_new(max, init);
+}
+void vSemaphoreDelete(SemaphoreHandle_t s) { free(s); }
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t wait) {
+    (void)wait;
+    if (!s || s->count == 0) return pdFALSE;
+    s->count--;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t s) {
+    if (!s || s->count >= s->max) return pdFALSE;
+    s->count++;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t s, TickType_t wait) {
+    (void)s; (void)wait;
+    return pdTRUE;
+}
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t s) {
+    (void)s;
+    return pdTRUE;
+}
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t s, BaseType_t *woken) {
+    if (woken) *woken = pdFALSE;
+    return xSemaphoreGive(s);
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t len, UBaseType_t item_size) {
+    (void)len; (void)item_size;
+    return NULL;
+}
+void vQueueDelete(QueueHandle_t q) { (void)q; }
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t wait) {
+    (void)q; (void)item; (void)wait;
+    return pdFALSE;
+}
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void *item,
+                             BaseType_t *woken) {
+    (void)q; (void)item;
+    if (woken) *woken = pdFALSE;
+    return pdFALSE;
+}
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t wait) {
+    (void)q; (void)item; (void)wait;
+    return pdFALSE;
+}
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) { (void)q; return 0; }
+
+/*==========================================================================
+ * Software timers — fired explicitly by host_timers_fire()
+ *=========================================================================*/
+
+#define HOST_MAX_TIMERS 32
+
+struct host_timer {
+    bool                     used;
+    bool                     active;
+    void                    *id;
+    TimerCallbackFunction_t  cb;
+};
+
+static struct host_timer host_timers[HOST_MAX_TIMERS];
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period,
+                           UBaseType_t reload, void *id,
+                           TimerCallbackFunction_t cb) {
+    (void)name; (void)period; (void)reload;
+    for (int i = 0; i < HOST_MAX_TIMERS; i++) {
+        if (host_timers[i].used) continue;
+        host_timers[i] = (struct host_timer){ true, false, id, cb };
+        return &host_timers[i];
+    }
+    return NULL;
+}
+
+BaseType_t xTimerStart(TimerHandle_t t, TickType_t w) {
+    (void)w;
+    if (t) t->active = true;
+    return pdPASS;
+}
+BaseType_t xTimerStop(TimerHandle_t t, TickType_t w) {
+    (void)w;
+    if (t) t->active = false;
+    return pdPASS;
+}
+BaseType_t xTimerReset(TimerHandle_t t, TickType_t w) {
+    return xTimerStart(t, w);
+}
+BaseType_t xTimerDelete(TimerHandle_t t, TickType_t w) {
+    (void)w;
+    if (t) memset(t, 0, sizeof(*t));
+    return pdPASS;
+}
+BaseType_t xTimerChangePeriod(TimerHandle_t t, TickType_t p, TickType_t w) {
+    (void)p;
+    return xTimerStart(t, w);
+}
+void *pvTimerGetTimerID(TimerHandle_t t) { return t ? t->id : NULL; }
+
+void host_timers_fire(void) {
+    for (int i = 0; i < HOST_MAX_TIMERS; i++) {
+        struct host_timer *t = &host_timers[i];
+        if (t->used && t->active && t->cb)
+            t->cb(t);
+    }
+}
+
+/*==========================================================================
+ * OS globals referenced by the WM
+ *=========================================================================*/
+
+/* Process table (cmd.h) — no processes on the host */
+struct array;
+struct array *pids = NULL;
+
+static settings_t host_settings = {
+    .volume        = 0,
+    .desktop_color = COLOR_CYAN,
+    .dblclick_ms   = 400,
+    .theme_id      = 0,
+    .language      = 0,
+};
+
+settings_t *settings_get(void) { return &host_settings; }
+
+/*==========================================================================
+ * Swap — every window belongs to the (never suspended) host task
+ *=========================================================================*/
+
+void swap_register(hwnd_t hwnd, TaskHandle_t task) { (void)hwnd; (void)task; }
+void swap_unregister(hwnd_t hwnd)      { (void)hwnd; }
+void swap_suspend(hwnd_t hwnd)         { (void)hwnd; }
+void swap_resume(hwnd_t hwnd)          { (void)hwnd; }
+void swap_switch_to(hwnd_t hwnd)       { (void)hwnd; }
+bool swap_is_suspended(hwnd_t hwnd)    { (void)hwnd; return false; }
+hwnd_t swap_get_foreground(void)       { return HWND_NULL; }
+void swap_force_close(hwnd_t hwnd)     { (void)hwnd; }
+bool swap_find_by_task(TaskHandle_t t) { (void)t; return false; }
+TaskHandle_t swap_get_task(hwnd_t hwnd) { (void)hwnd; return NULL; }
+
+/*==========================================================================
+ * Start menu, dialogs, sound, keyboard layout, network
+ *=========================================================================*/
+
+bool startmenu_is_open(void)  { return false; }
+void startmenu_toggle(void)   { }
+void startmenu_close(void)    { }
+void startmenu_draw(void)     { }
+bool startmenu_mouse(uint8_t type, int16_t x, int16_t y) {
+    (void)type; (void)x; (void)y;
+    return false;
+}
+
+hwnd_t dialog_show(hwnd_t parent, const char *title, const char *text,
+                   uint8_t icon, uint8_t buttons) {
+    (void)parent; (void)title; (void)text; (void)icon; (void)buttons;
+    return HWND_NULL;
+}
+
+uint8_t snd_get_volume(void)       { return host_settings.volume; }
+void    snd_set_volume(uint8_t v)  { host_settings.volume = v; }
+bool    keyboard_is_russian(void)  { return false; }
+
+bool netcard_wifi_connected(void)              { return false; }
+net_icon_state_t netcard_get_icon_state(void)  { return NET_ICON_NOACT; }
+void netcard_request_quit(nc_cmd_done_cb_t cb) { (void)cb; }
+void spawn_network_settings(void)              { }
+
+/*==========================================================================
+ * Desktop — a fixed column of shortcuts drawn like desktop.c does
+ *=========================================================================*/
+
+#define HOST_DT_SHORTCUTS  6
+#define HOST_DT_CELL_W     76
+#define HOST_DT_CELL_H     64
+#define HOST_DT_ICON       32
+
+static uint8_t host_dt_icon[DESKTOP_ICON32_SIZE];
+
+void desktop_paint(void) {
+    static const char *names[HOST_DT_SHORTCUTS] = {
+        "Navigator", "Terminal", "Notepad", "Paint", "Solitaire", "Sound",
+    };
+    for (int i = 0; i < HOST_DT_SHORTCUTS; i++) {
+        int cx = 4;
+        int cy = 4 + i * HOST_DT_CELL_H;
+        gfx_draw_icon_32(cx + (HOST_DT_CELL_W - HOST_DT_ICON) / 2, cy + 2,
+                         host_dt_icon);
+        int tw = (int)strlen(names[i]) * FONT_UI_WIDTH;
+        gfx_text_ui(cx + (HOST_DT_CELL_W - tw) / 2, cy + HOST_DT_ICON + 4,
+                    names[i], COLOR_WHITE, COLOR_CYAN);
+    }
+}
+
+uint8_t desktop_get_bg_color(void)  { return COLOR_CYAN; }
+bool desktop_has_shortcuts(void)    { return true; }
+const uint8_t *desktop_get_icon32(void) { return host_dt_icon; }
+void desktop_focus(void)            { }
+bool desktop_handle_command(uint16_t cmd) { (void)cmd; return false; }
+bool desktop_mouse(uint8_t type, int16_t x, int16_t y) {
+    (void)type; (void)x; (void)y;
+    return false;
+}
+
+void host_desktop_init(void) {
+    /* Simple two-tone icon: dark frame, light body */
+    for (int y = 0; y < HOST_DT_ICON; y++)
+        for (int x = 0; x < HOST_DT_ICON; x++) {
+            bool edge = x < 2 || y < 2 || x >= 30 || y >= 30;
+            host_dt_icon[y * HOST_DT_ICON + x] =
+                edge ? COLOR_DARK_GRAY : COLOR_LIGHT_GRAY;
+        }
+}
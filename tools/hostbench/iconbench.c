@@ -0,0 +1,171 @@
+/*
+ * FRANK OS
+ * Copyright (c) 2026 Mikhail Matveev <xtreme@rh1.tech>
+ * https://rh1.tech
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/* iconbench — draw icons with the blitters in src/gfx.c (unmodified)
+ * and with the per-pixel loop they replaced, on the same framebuffer.
+ *
+ * Each scenario draws a run of random icons (about a third of the pixels
+ * transparent) at random positions over a noise background, partly off
+ * screen near the edges, once with each blitter from the same starting
+ * screen.  "raw" scenarios pass the 0xFF-keyed icon data, "packed" ones
+ * an atlas icon from gfx_icon_get(); "clipped" narrows the display clip
+ * the way the compositor does for a damaged rect.  It prints the time
+ * per icon for both and whether the screens matched ("same", must be
+ * "yes"), plus the atlas slots left in use ("slots", must be 0). */
+
+#include "host.h"
+#include "display.h"
+#include "gfx.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define ICONS   64
+#define DRAWS   20000
+
+/*==========================================================================
+ * Reference: the per-pixel blitter gfx_draw_icon_* used before
+ *=========================================================================*/
+
+static void ref_draw(int sx, int sy, int size, const uint8_t *icon_data,
+                     int cx, int cy, int cw, int ch) {
+    int cx1 = cx + cw;
+    int cy1 = cy + ch;
+    for (int row = 0; row < size; row++) {
+        int py = sy + row;
+        if (py < cy || py >= cy1 || py < 0 || py >= display_height) continue;
+        for (int col = 0; col < size; col++) {
+            int px = sx + col;
+            if (px < cx || px >= cx1 || px < 0 || px >= display_width) continue;
+            uint8_t c = icon_data[row * size + col];
+            if (c != 0xFF)
+                display_set_pixel(px, py, c);
+        }
+    }
+}
+
+/*==========================================================================
+ * Scenarios
+ *=========================================================================*/
+
+typedef struct {
+    const char *name;
+    int  size;
+    bool packed;
+    bool clipped;   /* draw through a window-sized clip rect */
+    bool own_clip;  /* pass a rect to the *_clipped variants */
+} scenario_t;
+
+static const scenario_t scenarios[] = {
+    { "raw16",     16, false, false, false },
+    { "raw32",     32, false, false, false },
+    { "packed16",  16, true,  false, false },
+    { "packed32",  32, true,  false, false },
+    { "clipped",   32, true,  true,  false },
+    { "rawclip16", 16, false, false, true  },
+};
+
+static uint32_t rng = 12345;
+
+static uint32_t rnd(void) {
+    rng = rng * 1103515245u + 12345u;
+    return rng >> 8;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static uint8_t icons[ICONS][32 * 32];
+
+typedef struct { int16_t x, y; uint8_t icon; } draw_t;
+static draw_t draws[DRAWS];
+
+static void run(const scenario_t *sc) {
+    static uint8_t bg[FB_STRIDE * FB_HEIGHT], out_ref[FB_STRIDE * FB_HEIGHT];
+    const gfx_icon_t *packed[ICONS];
+    int n = sc->size * sc->size;
+    int ccx = 100, ccy = 60, ccw = 301, cch = 203;   /* own_clip rect */
+
+    for (int i = 0; i < ICONS; i++)
+        for (int k = 0; k < n; k++)
+            icons[i][k] = rnd() % 3 == 0 ? 0xFF : rnd() & 0x0F;
+    /* Half the icons repeat — windows of one app share theirs */
+    for (int i = ICONS / 2; i < ICONS; i++)
+        memcpy(icons[i], icons[i - ICONS / 2], n);
+    for (int i = 0; i < DRAWS; i++) {
+        draws[i].x = (int16_t)(rnd() % (DISPLAY_WIDTH + 40) - 20);
+        draws[i].y = (int16_t)(rnd() % (DISPLAY_HEIGHT + 40) - 20);
+        draws[i].icon = (uint8_t)(rnd() % ICONS);
+    }
+    for (size_t i = 0; i < sizeof bg; i++) bg[i] = (uint8_t)rnd();
+
+    int cx = 0, cy = 0, cw = display_width, ch = display_height;
+    if (sc->own_clip) { cx = ccx; cy = ccy; cw = ccw; ch = cch; }
+
+    memcpy(display_draw_buffer_ptr, bg, sizeof bg);
+    if (sc->clipped) display_set_clip(137, 91, 250, 170);
+    uint64_t t0 = now_ns();
+    for (int i = 0; i < DRAWS; i++)
+        ref_draw(draws[i].x, draws[i].y, sc->size, icons[draws[i].icon],
+                 cx, cy, cw, ch);
+    uint64_t t1 = now_ns();
+    memcpy(out_ref, display_draw_buffer_ptr, sizeof out_ref);
+
+    for (int i = 0; i < ICONS; i++)
+        packed[i] = sc->packed ? gfx_icon_get(icons[i], sc->size) : NULL;
+
+    memcpy(display_draw_buffer_ptr, bg, sizeof bg);
+    uint64_t t2 = now_ns();
+    for (int i = 0; i < DRAWS; i++) {
+        const draw_t *d = &draws[i];
+        if (sc->packed)
+            gfx_draw_icon(d->x, d->y, packed[d->icon]);
+        else if (sc->size == 16)
+            gfx_draw_icon_16_clipped(d->x, d->y, icons[d->icon], cx, cy, cw, ch);
+        else
+            gfx_draw_icon_32_clipped(d->x, d->y, icons[d->icon], cx, cy, cw, ch);
+    }
+    uint64_t t3 = now_ns();
+    display_reset_clip();
+
+    bool same = memcmp(out_ref, display_draw_buffer_ptr, sizeof out_ref) == 0;
+    int distinct = 0;
+    for (int i = 0; i < ICONS; i++) {
+        bool seen = false;
+        for (int k = 0; k < i; k++) seen |= packed[k] == packed[i];
+        distinct += packed[i] && !seen;
+    }
+    for (int i = 0; i < ICONS; i++) gfx_icon_put(packed[i]);
+    int slots = 0;
+    for (int i = 0; i < ICONS; i++) {
+        const gfx_icon_t *ic = gfx_icon_get(icons[i], sc->size);
+        /* Every slot was freed, so a fresh get must find refs == 1 */
+        if (ic && ic->refs != 1) slots++;
+        gfx_icon_put(ic);
+    }
+
+    printf("%-9s %5d %6d %8d %9.1f %9.1f %8.2fx %5d %5s\n",
+           sc->name, sc->size, DRAWS, sc->packed ? distinct : 0,
+           (double)(t1 - t0) / DRAWS, (double)(t3 - t2) / DRAWS,
+           t3 > t2 ? (double)(t1 - t0) / (double)(t3 - t2) : 0.0,
+           slots, same ? "yes" : "NO");
+}
+
+int main(void) {
+    display_init();
+    printf("%-9s %5s %6s %8s %9s %9s %9s %5s %5s\n",
+           "scenario", "size", "draws", "distinct", "ref ns", "new ns",
+           "speedup", "slots", "same");
+    for (size_t i = 0; i < sizeof scenarios / sizeof scenarios[0]; i++)
+        run(&scenarios[i]);
+    return 0;
+}
@@ -0,0 +1,64 @@
+/*
+ * FRANK OS
+ * Copyright (c) 2026 Mikhail Matveev <xtreme@rh1.tech>
+ * https://rh1.tech
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/* Host build: minimal FreeRTOS surface used by the window manager.
+ * Single-threaded — critical sections and scheduler locks are no-ops. */
+
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef uint32_t      TickType_t;
+typedef uint32_t      StackType_t;
+typedef long          BaseType_t;
+typedef unsigned long UBaseType_t;
+
+typedef struct host_task  *TaskHandle_t;
+typedef struct host_sem   *SemaphoreHandle_t;
+typedef struct host_timer *TimerHandle_t;
+typedef struct host_queue *QueueHandle_t;
+
+typedef struct { void *pxDummy1; } StaticTask_t;   /* layout unused */
+
+#define pdTRUE              ((BaseType_t)1)
+#define pdFALSE             ((BaseType_t)0)
+#define pdPASS              pdTRUE
+#define pdFAIL              pdFALSE
+#define portMAX_DELAY       ((TickType_t)0xFFFFFFFFu)
+#define configTICK_RATE_HZ  ((TickType_t)1000)
+#define portTICK_PERIOD_MS  ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(ms))
+
+#define configASSERT(x)                 ((void)0)
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS 3
+
+#define taskENTER_CRITICAL()            do { } while (0)
+#define taskEXIT_CRITICAL()             do { } while (0)
+#define taskENTER_CRITICAL_FROM_ISR()   0
+#define taskEXIT_CRITICAL_FROM_ISR(x)   ((void)(x))
+#define portYIELD_FROM_ISR(x)           ((void)(x))
+
+void  *pvPortMalloc(size_t size);
+void  *pvPortCalloc(size_t n, size_t size);
+void   vPortFree(void *p);
+size_t xPortGetFreeHeapSize(void);
+size_t xPortGetMinimumEverFreeHeapSize(void);
+
+#endif
+
+/* ffconf.h maps ff_memalloc() onto pvPortMalloc() and then includes this
+ * header; ff.h's UINT prototype would clash with the size_t one from
+ * api/m-os-api-c-*.h on a 64-bit host.  Redirect it (outside the include
+ * guard, since ffconf.h may be reached after the first inclusion). */
+#ifdef ff_memalloc
+#undef ff_memalloc
+#define ff_memalloc host_ff_memalloc
+#endif
@@ -0,0 +1,68 @@
+/*
+ * FRANK OS
+ * Copyright (c) 2026 Mikhail Matveev <xtreme@rh1.tech>
+ * https://rh1.tech
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/* Host build: DispHSTX replaced by a no-op video descriptor.  Only the
+ * scanline counter and vsync wait are observable; the benchmark counts
+ * vsync waits and advances the scanline itself. */
+
+#ifndef HOST_DISPHSTX_H
+#define HOST_DISPHSTX_H
+
+#include <stdint.h>
+#include "hardware/sync.h"
+
+typedef uint8_t  u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+
+typedef struct {
+    volatile int line;
+} sDispHstxVModeState;
+
+typedef struct {
+    int unused;
+} sDispHstxVModeTime;
+
+enum { vmodetime_640x480_fast };
+
+#define DISPHSTX_FORMAT_4_PAL   4
+#define DISPHSTX_FORMAT_8_PAL   8
+#define DISPHSTX_ERR_OK         0
+#define DISPHSTX_DISPMODE_DVI   1
+#define DISPHSTX_DISPMODE_VGA   2
+#define DISPHSTX_USE_DVI        1
+
+extern sDispHstxVModeState  DispHstxVMode;
+extern sDispHstxVModeState *pDispHstxVMode;
+extern const sDispHstxVModeTime DispHstxVModeTimeList[];
+
+static inline void DispHstxVModeInitTime(sDispHstxVModeState *v,
+                                         const sDispHstxVModeTime *t) {
+    (void)v; (void)t;
+}
+static inline void DispHstxVModeAddStrip(sDispHstxVModeState *v, int h) {
+    (void)v; (void)h;
+}
+static inline int DispHstxVModeAddSlot(sDispHstxVModeState *v, int hdbl,
+        int vdbl, int w, int format, void *buf, int pitch, const u16 *pal,
+        const void *palvga, const void *font, int fonth, int gap_col,
+        int gap_len) {
+    (void)v; (void)hdbl; (void)vdbl; (void)w; (void)format; (void)buf;
+    (void)pitch; (void)pal; (void)palvga; (void)font; (void)fonth;
+    (void)gap_col; (void)gap_len;
+    return DISPHSTX_ERR_OK;
+}
+static inline void DispHstxSelDispMode(int mode, sDispHstxVModeState *v) {
+    (void)mode; (void)v;
+}
+static inline void DispHstxDviPrepare(sDispHstxVModeState *v) { (void)v; }
+static inline void DispHstxVgaPrepare(sDispHstxVModeState *v) { (void)v; }
+
+void DispHstxWaitVSync(void);
+
+#endif
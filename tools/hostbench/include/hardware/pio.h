@@ -0,0 +1,19 @@
+/*
+ * FRANK OS
+ * Copyright (c) 2026 Mikhail Matveev <xtreme@rh1.tech>
+ * https://rh1.tech
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef HOST_HARDWARE_PIO_H
+#define HOST_HARDWARE_PIO_H
+
+#include "pico/types.h"
+
+typedef struct host_pio *PIO;
+
+#define pio0  ((PIO)0)
+#define pio1  ((PIO)1)
+
+#endif
@@ -0,0 +1,40 @@
+/*
+ * FRANK OS
+ * Copyright (c) 2026 Mikhail Matveev <xtreme@rh1.tech>
+ * https://rh1.tech
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef HOST_HARDWARE_SYNC_H
+#define HOST_HARDWARE_SYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+static inline uint32_t save_and_disable_interrupts(void) { return 0; }
+static inline void restore_interrupts(uint32_t s) { (void)s; }
+static inline void __dmb(void) { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+static inline void __dsb(void) { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+static inline void __sev(void) { }
+static inline void __wfe(void) { }
+
+typedef volatile uint32_t spin_lock_t;
+
+static inline int spin_lock_claim_unused(bool required) {
+    (void)required;
+    return 0;
+}
+static inline spin_lock_t *spin_lock_init(unsigned num) {
+    static spin_lock_t locks[32];
+    return &locks[num & 31];
+}
+static inline uint32_t spin_lock_blocking(spin_lock_t *l) {
+    (void)l;
+    return 0;
+}
+static inline void spin_unlock(spin_lock_t *l, uint32_t s) {
+    (void)l; (void)s;
+}
+
+#endif
@@ -0,0 +1,12 @@
+/*
+ * FRANK OS
+ * Copyright (c) 2026 Mikhail Matveev <xtreme@rh1.tech>
+ * https://rh1.tech
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef HOST_PICO_H
+#define HOST_PICO_H
+#include "pico/platform.h"
+#endif
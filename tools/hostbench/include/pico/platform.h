@@ -0,0 +1,22 @@
+/*
+ * FRANK OS
+ * Copyright (c) 2026 Mikhail Matveev <xtreme@rh1.tech>
+ * https://rh1.tech
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef HOST_PICO_PLATFORM_H
+#define HOST_PICO_PLATFORM_H
+
+#include "hardware/sync.h"
+
+#define __not_in_flash_func(f)    f
+#define __time_critical_func(f)   f
+#define __scratch_x(n)
+#define __scratch_y(n)
+#define __aligned(n)              __attribute__((aligned(n)))
+
+static inline unsigned get_core_num(void) { return 0; }
+
+#endif
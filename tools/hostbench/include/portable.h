@@ -0,0 +1,12 @@
+/*
+ * FRANK OS
+ * Copyright (c) 2026 Mikhail Matveev <xtreme@rh1.tech>
+ * https://rh1.tech
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef HOST_PORTABLE_H
+#define HOST_PORTABLE_H
+#include "FreeRTOS.h"
+#endif
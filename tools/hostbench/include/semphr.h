@@ -0,0 +1,25 @@
+/*
+ * FRANK OS
+ * Copyright (c) 2026 Mikhail Matveev <xtreme@rh1.tech>
+ * https://rh1.tech
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef HOST_SEMPHR_H
+#define HOST_SEMPHR_H
+
+#include "FreeRTOS.h"
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void);
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t init);
+void              vSemaphoreDelete(SemaphoreHandle_t s);
+BaseType_t        xSemaphoreTake(SemaphoreHandle_t s, TickType_t wait);
+BaseType_t        xSemaphoreGive(SemaphoreHandle_t s);
+BaseType_t        xSemaphoreTakeRecursive(SemaphoreHandle_t s, TickType_t wait);
+BaseType_t        xSemaphoreGiveRecursive(SemaphoreHandle_t s);
+BaseType_t        xSemaphoreGiveFromISR(SemaphoreHandle_t s, BaseType_t *woken);
+
+#endif
@@ -0,0 +1,58 @@
+/*
+ * FRANK OS
+ * Copyright (c) 2026 Mikhail Matveev <xtreme@rh1.tech>
+ * https://rh1.tech
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef HOST_TASK_H
+#define HOST_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void *);
+
+typedef enum {
+    eNoAction = 0,
+    eSetBits,
+    eIncrement,
+    eSetValueWithOverwrite,
+    eSetValueWithoutOverwrite
+} eNotifyAction;
+
+#define taskSCHEDULER_SUSPENDED   ((BaseType_t)0)
+#define taskSCHEDULER_NOT_STARTED ((BaseType_t)1)
+#define taskSCHEDULER_RUNNING     ((BaseType_t)2)
+
+#define taskYIELD()               do { } while (0)
+
+BaseType_t   xTaskCreate(TaskFunction_t fn, const char *name,
+                         uint32_t stack_depth, void *arg,
+                         UBaseType_t prio, TaskHandle_t *out);
+void         vTaskDelete(TaskHandle_t t);
+void         vTaskDelay(TickType_t ticks);
+TickType_t   xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+BaseType_t   xTaskGetSchedulerState(void);
+void         vTaskSuspendAll(void);
+BaseType_t   xTaskResumeAll(void);
+void         vTaskSuspend(TaskHandle_t t);
+void         vTaskResume(TaskHandle_t t);
+UBaseType_t  uxTaskPriorityGet(TaskHandle_t t);
+void         vTaskPrioritySet(TaskHandle_t t, UBaseType_t prio);
+char        *pcTaskGetName(TaskHandle_t t);
+
+void  vTaskSetThreadLocalStoragePointer(TaskHandle_t t, BaseType_t i, void *v);
+void *pvTaskGetThreadLocalStoragePointer(TaskHandle_t t, BaseType_t i);
+
+BaseType_t xTaskNotifyGive(TaskHandle_t t);
+void       vTaskNotifyGiveFromISR(TaskHandle_t t, BaseType_t *woken);
+uint32_t   ulTaskNotifyTake(BaseType_t clear, TickType_t wait);
+BaseType_t xTaskNotify(TaskHandle_t t, uint32_t value, eNotifyAction action);
+BaseType_t xTaskNotifyFromISR(TaskHandle_t t, uint32_t value,
+                              eNotifyAction action, BaseType_t *woken);
+BaseType_t xTaskNotifyWait(uint32_t clear_entry, uint32_t clear_exit,
+                           uint32_t *value, TickType_t wait);
+
+#endif
@@ -0,0 +1,30 @@
+/*
+ * FRANK OS
+ * Copyright (c) 2026 Mikhail Matveev <xtreme@rh1.tech>
+ * https://rh1.tech
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef HOST_TIMERS_H
+#define HOST_TIMERS_H
+
+#include "FreeRTOS.h"
+
+/* Host timers never fire on their own; the benchmark drives them
+ * explicitly with host_timers_fire(). */
+
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t t);
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period,
+                           UBaseType_t reload, void *id,
+                           TimerCallbackFunction_t cb);
+BaseType_t    xTimerStart(TimerHandle_t t, TickType_t wait);
+BaseType_t    xTimerStop(TimerHandle_t t, TickType_t wait);
+BaseType_t    xTimerReset(TimerHandle_t t, TickType_t wait);
+BaseType_t    xTimerDelete(TimerHandle_t t, TickType_t wait);
+BaseType_t    xTimerChangePeriod(TimerHandle_t t, TickType_t period,
+                                 TickType_t wait);
+void         *pvTimerGetTimerID(TimerHandle_t t);
+
+#endif
@@ -0,0 +1,272 @@
+/*
+ * FRANK OS
+ * Copyright (c) 2026 Mikhail Matveev <xtreme@rh1.tech>
+ * https://rh1.tech
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/* mixbench — run the sound mixer (src/snd.c, unmodified) against the
+ * per-sample mixer it replaced, on the same input.
+ *
+ * Each scenario opens a few channels at the rates FrankAmp, the system
+ * sounds and the emulators use, feeds them full-scale noise (so the mix
+ * clips) at a given share of what they play, and fills DMA buffers.  It
+ * prints the time per 1024-frame buffer for both mixers, the frames the
+ * channels ran dry, and whether the output matched bit for bit ("same",
+ * must be "yes").  In "pan" the channel is panned hard left: the left
+ * side must match and the right one be silent.  In "inplace" the first
+ * channel has its own ring with a span and is fed through snd_acquire()
+ * and snd_commit().  "mute" is the taskbar mute (volume 4): the output
+ * is silent, but the channels must keep playing their rings or the bench
+ * stops with a writer blocked on a full ring. */
+
+#include "snd.h"
+#include "audio.h"
+#include "task.h"
+#include "psram.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DMA_FRAMES   1024
+#define CHAN_FRAMES  2048
+#define CHAN_MASK    (CHAN_FRAMES - 1)
+#define FILLS        4000
+
+/*==========================================================================
+ * Stand-ins for the I2S driver: the bench calls the fill callback itself
+ *=========================================================================*/
+
+static i2s_fill_cb_t fill_cb;
+
+void i2s_init(i2s_config_t *config) { (void)config; }
+void i2s_deinit(i2s_config_t *config) { (void)config; }
+void i2s_set_fill_callback(i2s_fill_cb_t cb) { fill_cb = cb; }
+void i2s_start(void) { }
+
+/* The bench never fills a ring, so nothing may wait for space */
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait) {
+    (void)clear; (void)wait;
+    fprintf(stderr, "mixbench: a writer blocked on a full ring\n");
+    exit(1);
+}
+TaskHandle_t xTaskGetCurrentTaskHandle(void) { return (TaskHandle_t)1; }
+void vTaskNotifyGiveFromISR(TaskHandle_t t, BaseType_t *woken) {
+    (void)t; (void)woken;
+}
+
+void *pvPortMalloc(size_t size) { return malloc(size); }
+void vPortFree(void *p) { free(p); }
+bool psram_is_available(void) { return false; }
+void *psram_alloc(size_t size) { (void)size; return NULL; }
+void psram_free(void *p) { (void)p; }
+
+/*==========================================================================
+ * Reference: the per-sample mixer snd_fill_dma used before
+ *=========================================================================*/
+
+typedef struct {
+    int16_t  buf[CHAN_FRAMES * 2];
+    uint32_t rd, wr;
+    uint32_t phase, phase_inc;
+    int16_t  hold_l, hold_r;
+    bool     active;
+} ref_channel_t;
+
+static ref_channel_t ref[SND_MAX_CHANNELS];
+static uint8_t ref_volume;
+
+static void ref_open(int ch, uint32_t rate) {
+    memset(&ref[ch], 0, sizeof ref[ch]);
+    ref[ch].phase_inc = (rate << 16) / SND_SYSTEM_RATE;
+    ref[ch].active = true;
+}
+
+static void ref_write(int ch, const int16_t *s, uint32_t n) {
+    ref_channel_t *c = &ref[ch];
+    for (uint32_t i = 0; i < n; i++, c->wr++) {
+        c->buf[(c->wr & CHAN_MASK) * 2]     = s[i * 2];
+        c->buf[(c->wr & CHAN_MASK) * 2 + 1] = s[i * 2 + 1];
+    }
+}
+
+static void ref_fill(int16_t *out, uint32_t frames) {
+    uint32_t ch_avail[SND_MAX_CHANNELS];
+    for (int ch = 0; ch < SND_MAX_CHANNELS; ch++)
+        ch_avail[ch] = ref[ch].active ? ref[ch].wr - ref[ch].rd : 0;
+
+    for (uint32_t i = 0; i < frames; i++) {
+        int32_t left = 0, right = 0;
+        for (int ch = 0; ch < SND_MAX_CHANNELS; ch++) {
+            ref_channel_t *c = &ref[ch];
+            if (!c->active) continue;
+            uint32_t src_idx = c->phase >> 16;
+            if (ch_avail[ch] == 0 || src_idx >= ch_avail[ch]) {
+                left  += c->hold_l;
+                right += c->hold_r;
+                continue;
+            }
+            uint32_t idx0 = (c->rd + src_idx) & CHAN_MASK;
+            int16_t l0 = c->buf[idx0 * 2];
+            int16_t r0 = c->buf[idx0 * 2 + 1];
+            int16_t sl, sr;
+            if (src_idx + 1 < ch_avail[ch]) {
+                uint32_t idx1 = (c->rd + src_idx + 1) & CHAN_MASK;
+                int32_t frac = (int32_t)((c->phase & 0xFFFF) >> 1);
+                sl = l0 + (((int32_t)(c->buf[idx1 * 2]     - l0) * frac) >> 15);
+                sr = r0 + (((int32_t)(c->buf[idx1 * 2 + 1] - r0) * frac) >> 15);
+            } else {
+                sl = l0;
+                sr = r0;
+            }
+            c->hold_l = sl;
+            c->hold_r = sr;
+            left  += sl;
+            right += sr;
+            c->phase += c->phase_inc;
+        }
+        left  >>= 1;
+        right >>= 1;
+        if (ref_volume >= 4) {
+            left = right = 0;
+        } else if (ref_volume) {
+            left  >>= ref_volume;
+            right >>= ref_volume;
+        }
+        if (left  >  32767) left  =  32767;
+        if (left  < -32768) left  = -32768;
+        if (right >  32767) right =  32767;
+        if (right < -32768) right = -32768;
+        out[i * 2]     = (int16_t)left;
+        out[i * 2 + 1] = (int16_t)right;
+    }
+
+    for (int ch = 0; ch < SND_MAX_CHANNELS; ch++) {
+        ref_channel_t *c = &ref[ch];
+        if (ch_avail[ch] == 0) continue;
+        c->rd    += c->phase >> 16;
+        c->phase &= 0xFFFF;
+    }
+}
+
+/*==========================================================================
+ * Scenarios
+ *=========================================================================*/
+
+typedef struct {
+    uint32_t rate;
+    int      feed;      /* percent of the frames it plays that get written */
+} chan_spec_t;
+
+typedef struct {
+    const char *name;
+    uint8_t     volume;
+    bool        pan_left;   /* pan channel 0 hard left */
+    bool        inplace;    /* channel 0: own ring, snd_acquire/commit */
+    int         nch;
+    chan_spec_t ch[SND_MAX_CHANNELS];
+} scenario_t;
+
+static const scenario_t scenarios[] = {
+    { "amp",     0, false, false, 1, { { 44100, 100 } } },
+    { "emu",     0, false, false, 1, { { 15625, 100 } } },
+    { "amp+sys", 0, false, false, 2, { { 44100, 100 }, { 22050, 100 } } },
+    { "all",     0, false, false, 3, { { 44100, 100 }, { 22050, 100 }, { 15625, 100 } } },
+    { "four",    2, false, false, 4, { { 44100, 100 }, { 48000, 100 }, { 22050, 100 }, { 11025, 100 } } },
+    { "starve",  0, false, false, 3, { { 44100, 60 }, { 22050, 100 }, { 15625, 40 } } },
+    { "pan",     1, true,  false, 1, { { 32000, 100 } } },
+    { "inplace", 0, false, true,  2, { { 44100, 100 }, { 22050, 100 } } },
+    { "mute",    4, false, false, 2, { { 44100, 100 }, { 22050, 100 } } },
+};
+
+static uint32_t rng = 12345;
+
+static int16_t noise(void) {
+    rng = rng * 1103515245u + 12345u;
+    return (int16_t)(rng >> 16);
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static void run(const scenario_t *sc) {
+    static int16_t src[CHAN_FRAMES * 2];
+    static uint32_t out_new[DMA_FRAMES];
+    static int16_t out_ref[DMA_FRAMES * 2];
+    int id[SND_MAX_CHANNELS];
+    uint64_t t_ref = 0, t_new = 0;
+    bool same = true;
+
+    snd_init();
+    snd_set_volume(sc->volume);
+    ref_volume = sc->volume;
+    memset(ref, 0, sizeof ref);
+    for (int k = 0; k < sc->nch; k++) {
+        id[k] = k == 0 && sc->inplace
+              ? snd_open_ring(sc->ch[k].rate, CHAN_FRAMES, 1152)
+              : snd_open(sc->ch[k].rate);
+        ref_open(id[k], sc->ch[k].rate);
+    }
+    if (sc->pan_left) snd_set_gain(id[0], SND_GAIN_UNITY, -127);
+    snd_stats_t st0;
+    snd_get_stats(&st0);
+
+    for (int f = 0; f < FILLS; f++) {
+        for (int k = 0; k < sc->nch; k++) {
+            ref_channel_t *c = &ref[id[k]];
+            /* What a buffer plays, give or take a few frames */
+            uint32_t want = (uint32_t)((uint64_t)DMA_FRAMES * sc->ch[k].rate
+                                       / SND_SYSTEM_RATE) + (noise() & 7);
+            want = want * sc->ch[k].feed / 100;
+            uint32_t space = CHAN_FRAMES - (c->wr - c->rd);
+            if (want > space) want = space;
+            for (uint32_t i = 0; i < want * 2; i++) src[i] = noise();
+            ref_write(id[k], src, want);
+            if (k == 0 && sc->inplace) {
+                int16_t *dst;
+                if (snd_acquire(id[k], &dst, (int)want) != (int)want) same = false;
+                memcpy(dst, src, want * 4);
+                snd_commit(id[k], (int)want);
+            } else {
+                snd_write(id[k], src, (int)want);
+            }
+        }
+        uint64_t t0 = now_ns();
+        ref_fill(out_ref, DMA_FRAMES);
+        uint64_t t1 = now_ns();
+        fill_cb(f & 1, out_new, DMA_FRAMES);
+        uint64_t t2 = now_ns();
+        t_ref += t1 - t0;
+        t_new += t2 - t1;
+
+        for (int i = 0; i < DMA_FRAMES && same; i++) {
+            int16_t l = (int16_t)out_new[i], r = (int16_t)(out_new[i] >> 16);
+            if (l != out_ref[i * 2]) same = false;
+            if (r != (sc->pan_left ? 0 : out_ref[i * 2 + 1])) same = false;
+        }
+    }
+
+    snd_stats_t st;
+    snd_get_stats(&st);
+    for (int k = 0; k < sc->nch; k++) snd_close(id[k]);
+
+    printf("%-8s %5d %6d %10.0f %10.0f %8.2fx %9u %5s\n",
+           sc->name, sc->nch, FILLS,
+           (double)t_ref / FILLS, (double)t_new / FILLS,
+           t_new ? (double)t_ref / (double)t_new : 0.0,
+           st.starved - st0.starved, same ? "yes" : "NO");
+}
+
+int main(void) {
+    printf("%-8s %5s %6s %10s %10s %9s %9s %5s\n",
+           "scenario", "chans", "fills", "ref ns", "new ns", "speedup",
+           "starved", "same");
+    for (size_t i = 0; i < sizeof scenarios / sizeof scenarios[0]; i++)
+        run(&scenarios[i]);
+    return 0;
+}
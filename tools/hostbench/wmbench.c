@@ -0,0 +1,590 @@
+/*
+ * FRANK OS
+ * Copyright (c) 2026 Mikhail Matveev <xtreme@rh1.tech>
+ * https://rh1.tech
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/* wmbench — headless frame-time benchmark for the window manager.
+ *
+ * Each scenario scripts input the way main.c's input and compositor
+ * tasks deliver it, and measures every compositor pass
+ * (wm_dispatch_events + wm_composite):
+ *
+ *   time    host cycles (TSC where available) and nanoseconds
+ *   bytes   framebuffer bytes written by the pass
+ *
+ * Bytes written are found without instrumenting the drawing code: the
+ * pass is run twice from the same state (fork), once on the real
+ * framebuffer and once on its bitwise complement.  A byte the pass did
+ * not touch keeps its old value in both runs; a written byte cannot
+ * match both the original and its complement.
+ *
+ * Every scenario runs in its own child process from the same freshly
+ * booted state: once for timing and once for byte counts, so the fork
+ * per frame never disturbs the timed run.  With -d the final screen of
+ * each scenario is saved as <dir>/<scenario>.ppm.
+ *
+ * After the timed run the final screen is compared with a forced full
+ * repaint of the same state; "stale" counts the bytes that differ and
+ * must be 0 — anything else is an incremental-repaint bug. */
+
+#include "host.h"
+#include "display.h"
+#include "window.h"
+#include "window_event.h"
+#include "window_theme.h"
+#include "cursor.h"
+#include "taskbar.h"
+#include "alttab.h"
+#include "menu.h"
+#include "sysmenu.h"
+#include "terminal.h"
+#include "gfx.h"
+#include "font.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#define FB_BYTES  (FB_STRIDE * FB_HEIGHT)
+
+/*==========================================================================
+ * Measurement
+ *=========================================================================*/
+
+typedef enum { MODE_TIME, MODE_BYTES } bench_mode_t;
+
+typedef struct {
+    uint32_t frames;
+    uint64_t ns_total, ns_max;
+    uint64_t cyc_total, cyc_max;
+    uint64_t bytes_total, bytes_max;
+    uint32_t vsyncs;
+    uint32_t stale;     /* bytes differing from a full repaint */
+} bench_stats_t;
+
+static bench_mode_t  mode;
+static bool          verbose;
+static const char   *dump_dir;
+static bench_stats_t stats;
+static bool          video_dirty;   /* main.c g_video_dirty */
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t now_cycles(void) {
+#ifdef HAVE_TSC
+    return __rdtsc();
+#else
+    return now_ns();
+#endif
+}
+
+/* A full composite, or only the sprites when nothing else changed */
+static void composite_pass(bool composite) {
+    wm_dispatch_events();
+    if (composite) {
+        wm_composite();
+    } else {
+        display_wait_vsync();
+        display_sprites_present();
+    }
+}
+
+/* Count bytes one compositor pass writes — see the header comment */
+static uint32_t measure_bytes(bool composite) {
+    uint8_t *fb = display_draw_buffer_ptr;
+    int fd[2];
+    if (pipe(fd) != 0) { perror("pipe"); exit(1); }
+
+    pid_t pid = fork();
+    if (pid < 0) { perror("fork"); exit(1); }
+    if (pid == 0) {
+        close(fd[0]);
+        uint8_t *orig = malloc(FB_BYTES);
+        memcpy(orig, fb, FB_BYTES);
+        for (int i = 0; i < FB_BYTES; i++) fb[i] = (uint8_t)~orig[i];
+        composite_pass(composite);
+        uint8_t *inv = malloc(FB_BYTES);
+        memcpy(inv, fb, FB_BYTES);
+        ssize_t n = FB_BYTES;
+        if (write(fd[1], inv, n) != n) _exit(1);
+        _exit(0);
+    }
+
+    close(fd[1]);
+    uint8_t *before = malloc(FB_BYTES);
+    uint8_t *inv    = malloc(FB_BYTES);
+    memcpy(before, fb, FB_BYTES);
+    size_t got = 0;
+    while (got < FB_BYTES) {
+        ssize_t r = read(fd[0], inv + got, FB_BYTES - got);
+        if (r <= 0) { fprintf(stderr, "wmbench: probe failed\n"); exit(1); }
+        got += (size_t)r;
+    }
+    close(fd[0]);
+    waitpid(pid, NULL, 0);
+
+    composite_pass(composite);
+
+    uint32_t written = 0;
+    for (int i = 0; i < FB_BYTES; i++)
+        if (fb[i] != before[i] || inv[i] != (uint8_t)~before[i])
+            written++;
+    free(before);
+    free(inv);
+    return written;
+}
+
+/* One iteration of the compositor task loop.  Only passes that
+ * actually run count as frames. */
+static void frame(void) {
+    host_tick++;
+    taskbar_tick();
+
+    wm_dispatch_events();
+    bool composite = wm_needs_composite() || video_dirty;
+    if (!composite && !display_sprites_pending()) return;
+    video_dirty = false;
+
+    uint32_t vs0 = host_vsync_count;
+    uint64_t ns = 0, cyc = 0, bytes = 0;
+
+    if (mode == MODE_TIME) {
+        uint64_t t0 = now_ns();
+        uint64_t c0 = now_cycles();
+        composite_pass(composite);
+        cyc = now_cycles() - c0;
+        ns  = now_ns() - t0;
+    } else {
+        bytes = measure_bytes(composite);
+    }
+
+    stats.frames++;
+    stats.vsyncs += host_vsync_count - vs0;
+    stats.ns_total += ns;
+    stats.cyc_total += cyc;
+    stats.bytes_total += bytes;
+    if (ns > stats.ns_max) stats.ns_max = ns;
+    if (cyc > stats.cyc_max) stats.cyc_max = cyc;
+    if (bytes > stats.bytes_max) stats.bytes_max = bytes;
+
+    if (verbose) {
+        if (mode == MODE_TIME)
+            fprintf(stderr, "  frame %4u  %8llu cyc  %7llu ns\n",
+                    stats.frames, (unsigned long long)cyc,
+                    (unsigned long long)ns);
+        else
+            fprintf(stderr, "  frame %4u  %7llu bytes\n",
+                    stats.frames, (unsigned long long)bytes);
+    }
+}
+
+/* Run frames until the compositor settles */
+static void settle(void) {
+    for (int i = 0; i < 8; i++) frame();
+}
+
+/*==========================================================================
+ * Input — mirrors input_task in main.c
+ *=========================================================================*/
+
+static uint8_t mouse_buttons;
+
+static void mouse(int16_t x, int16_t y, uint8_t buttons) {
+    wm_set_cursor_pos(x, y);
+    wm_set_mouse_buttons(buttons);
+    cursor_move(x, y);
+    wm_handle_mouse_input(WM_MOUSEMOVE, x, y, buttons);
+
+    uint8_t changed = buttons ^ mouse_buttons;
+    if (changed & 0x01)
+        wm_handle_mouse_input((buttons & 0x01) ? WM_LBUTTONDOWN : WM_LBUTTONUP,
+                              x, y, buttons);
+    if (changed & 0x02)
+        wm_handle_mouse_input((buttons & 0x02) ? WM_RBUTTONDOWN : WM_RBUTTONUP,
+                              x, y, buttons);
+    mouse_buttons = buttons;
+
+    if (changed || buttons)
+        video_dirty = true;
+    frame();
+}
+
+static void click(int16_t x, int16_t y) {
+    mouse(x, y, 0);
+    mouse(x, y, 1);
+    mouse(x, y, 0);
+}
+
+/*==========================================================================
+ * Scene setup
+ *=========================================================================*/
+
+static int n_terms = 4;
+static hwnd_t terms[WM_MAX_WINDOWS];
+
+static void boot(void) {
+    display_init();
+    wm_init();
+    host_desktop_init();
+    taskbar_init();
+    cursor_set_type(CURSOR_ARROW);
+    cursor_set_visible(true);
+    wm_force_full_repaint();
+    video_dirty = true;
+    settle();
+}
+
+static void fill_terminal(terminal_t *t, int lines, int seed) {
+    char line[96];
+    for (int l = 0; l < lines; l++) {
+        snprintf(line, sizeof(line),
+                 "%04d: drwxr-xr-x  frank  %6d  Jan %2d 12:%02d  file_%d.txt\n",
+                 seed * 100 + l, (seed * 7919 + l * 104729) % 1000000,
+                 1 + l % 28, l % 60, l);
+        terminal_puts(t, line);
+    }
+}
+
+static void open_terminals(int n) {
+    for (int i = 0; i < n; i++) {
+        terms[i] = terminal_create();
+        if (terms[i] == HWND_NULL) {
+            fprintf(stderr, "wmbench: terminal_create failed\n");
+            exit(1);
+        }
+        wm_move_window(terms[i], (int16_t)(8 + i * 16), (int16_t)(8 + i * 12));
+        wm_set_focus(terms[i]);
+        taskbar_invalidate();
+        fill_terminal(terminal_from_hwnd(terms[i]), 12, i);
+        video_dirty = true;
+        frame();
+    }
+    settle();
+}
+
+static point_t title_point(hwnd_t hwnd) {
+    window_t *w = wm_get_window(hwnd);
+    return (point_t){ (int16_t)(w->frame.x + 60),
+                      (int16_t)(w->frame.y + THEME_BORDER_WIDTH +
+                                THEME_TITLE_HEIGHT / 2) };
+}
+
+/*==========================================================================
+ * Scenarios
+ *=========================================================================*/
+
+/* Full-screen repaint of the N-terminal desktop */
+static void sc_full_repaint(void) {
+    open_terminals(n_terms);
+    memset(&stats, 0, sizeof(stats));
+    for (int i = 0; i < 16; i++) {
+        wm_force_full_repaint();
+        video_dirty = true;
+        frame();
+    }
+}
+
+/* Open N terminals, then stream text into the focused one and blink
+ * the cursors */
+static void sc_terminals(void) {
+    open_terminals(n_terms);
+    terminal_t *t = terminal_from_hwnd(terms[n_terms - 1]);
+    for (int i = 0; i < 64; i++) {
+        fill_terminal(t, 1, 100 + i);
+        frame();
+        if ((i & 7) == 7) {
+            host_timers_fire();
+            frame();
+        }
+    }
+}
+
+/* Drag the top window's title bar across the screen and drop it */
+static void sc_drag(void) {
+    open_terminals(n_terms);
+    memset(&stats, 0, sizeof(stats));
+    point_t p = title_point(terms[n_terms - 1]);
+    mouse(p.x, p.y, 0);
+    mouse(p.x, p.y, 1);
+    for (int i = 1; i <= 40; i++)
+        mouse((int16_t)(p.x + i * 2), (int16_t)(p.y + i * 2), 1);
+    mouse((int16_t)(p.x + 80), (int16_t)(p.y + 80), 0);
+    settle();
+}
+
+/* Walk the terminal's menu bar dropdowns and the system menu */
+static void sc_menus(void) {
+    open_terminals(n_terms);
+    memset(&stats, 0, sizeof(stats));
+    window_t *w = wm_get_window(terms[n_terms - 1]);
+    int16_t bar_y = (int16_t)(w->frame.y + THEME_BORDER_WIDTH +
+                              THEME_TITLE_HEIGHT + THEME_MENU_HEIGHT / 2);
+    int16_t bar_x = (int16_t)(w->frame.x + THEME_BORDER_WIDTH + 8);
+
+    for (int m = 0; m < 2; m++) {
+        int16_t x = (int16_t)(bar_x + m * 40);
+        click(x, bar_y);
+        for (int i = 1; i <= 6; i++)
+            mouse((int16_t)(x + 4), (int16_t)(bar_y + i * 16), 0);
+        menu_close();
+        video_dirty = true;
+        frame();
+    }
+
+    sysmenu_open(terms[n_terms - 1]);
+    video_dirty = true;
+    frame();
+    sysmenu_close();
+    video_dirty = true;
+    settle();
+}
+
+/* Alt+Tab through every window and commit */
+static void sc_alttab(void) {
+    open_terminals(n_terms);
+    memset(&stats, 0, sizeof(stats));
+    alttab_open();
+    video_dirty = true;
+    frame();
+    for (int i = 0; i < n_terms * 2; i++) {
+        alttab_cycle();
+        video_dirty = true;
+        frame();
+    }
+    alttab_commit();
+    video_dirty = true;
+    settle();
+}
+
+/* Write the 640x480x16 framebuffer as a binary PPM */
+static void dump_ppm(const char *name) {
+    static const uint32_t pal[16] = {
+        0x000000, 0x000080, 0x008000, 0x008080,
+        0x800000, 0x800080, 0x808000, 0xC0C0C0,
+        0x808080, 0x0000FF, 0x00FF00, 0x00FFFF,
+        0xFF0000, 0xFF00FF, 0xFFFF00, 0xFFFFFF,
+    };
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s.ppm", dump_dir, name);
+    FILE *f = fopen(path, "wb");
+    if (!f) { perror(path); return; }
+    fprintf(f, "P6\n%d %d\n255\n", DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    for (int y = 0; y < DISPLAY_HEIGHT; y++)
+        for (int x = 0; x < DISPLAY_WIDTH; x++) {
+            uint8_t b = display_draw_buffer_ptr[y * FB_STRIDE + (x >> 1)];
+            uint32_t c = pal[(x & 1) ? (b & 0x0F) : (b >> 4)];
+            fputc((int)(c >> 16) & 0xFF, f);
+            fputc((int)(c >> 8) & 0xFF, f);
+            fputc((int)c & 0xFF, f);
+        }
+    fclose(f);
+}
+
+typedef struct {
+    const char *name;
+    void (*fn)(void);
+    const char *desc;
+} scenario_t;
+
+static const scenario_t scenarios[] = {
+    { "full",      sc_full_repaint, "full-screen repaint, N terminals" },
+    { "terminals", sc_terminals,    "open N terminals, stream text, blink" },
+    { "drag",      sc_drag,         "drag top window by its title bar" },
+    { "menus",     sc_menus,        "menu bar dropdowns + system menu" },
+    { "alttab",    sc_alttab,       "Alt+Tab cycle through all windows" },
+};
+#define N_SCENARIOS (int)(sizeof(scenarios) / sizeof(scenarios[0]))
+
+/* Bytes of the current screen that a full repaint would change */
+static uint32_t stale_bytes(void) {
+    uint8_t *fb = display_draw_buffer_ptr;
+    uint8_t *shown = malloc(FB_BYTES);
+    memcpy(shown, fb, FB_BYTES);
+    wm_force_full_repaint();
+    composite_pass(true);
+    uint32_t n = 0;
+    for (int i = 0; i < FB_BYTES; i++)
+        if (fb[i] != shown[i]) n++;
+    free(shown);
+    return n;
+}
+
+/*==========================================================================
+ * Drawing primitives (-k) — best-of-N time per call, straight on the
+ * framebuffer with the full-screen clip
+ *=========================================================================*/
+
+static const char prim_text[] = "The quick brown fox jumps over the lazy";
+
+static void pk_fill(int i)     { gfx_fill_rect(17 + (i & 1), 40, 301, 200, i & 15); }
+static void pk_fill_s(int i) {
+    for (int k = 0; k < 50; k++)
+        gfx_fill_rect(11 + k * 11 + (i & 1), 60 + (k & 7) * 20, 37, 13, i & 15);
+}
+static void pk_dither(int i)   { gfx_fill_rect_dithered(17 + (i & 1), 40, 301, 200, i & 15); }
+static void pk_vline(int i)    { gfx_vline(101 + (i & 1), 10, 400, i & 15); }
+static void pk_rect(int i)     { gfx_rect(33 + (i & 1), 20, 400, 300, i & 15); }
+static void pk_text(int i)     { gfx_text(16, 100 + (i & 7), prim_text, 15, i & 15); }
+static void pk_text_ui(int i)  { gfx_text_ui(16, 200 + (i & 7), prim_text, 0, i & 15); }
+static void pk_text_ui_b(int i) { gfx_text_ui_bold(16, 300 + (i & 7), prim_text, 0, i & 15); }
+static void pk_glyph16(int i) {
+    const uint8_t *g = font8x16_get_glyph((uint8_t)('A' + (i & 15)));
+    for (int c = 0; c < 70; c++)
+        display_blit_glyph_8wide(8 + c * 8, 400, g, 16, 15, i & 15);
+}
+
+typedef struct {
+    const char *name;
+    void (*fn)(int i);
+    const char *desc;
+} prim_t;
+
+static const prim_t prims[] = {
+    { "fill",      pk_fill,      "gfx_fill_rect 301x200" },
+    { "fill_s",    pk_fill_s,    "50 x gfx_fill_rect 37x13" },
+    { "dither",    pk_dither,    "gfx_fill_rect_dithered 301x200" },
+    { "vline",     pk_vline,     "gfx_vline 400" },
+    { "rect",      pk_rect,      "gfx_rect 400x300 outline" },
+    { "text8",     pk_text,      "gfx_text 39 chars (8x8)" },
+    { "text_ui",   pk_text_ui,   "gfx_text_ui 39 chars" },
+    { "text_uib",  pk_text_ui_b, "gfx_text_ui_bold 39 chars" },
+    { "glyph16",   pk_glyph16,   "70 x display_blit_glyph_8wide 8x16" },
+};
+
+static void run_prims(void) {
+    display_reset_clip();
+    printf("%-10s %12s  %s\n", "kernel", "ns/call", "what");
+    for (size_t k = 0; k < sizeof(prims) / sizeof(prims[0]); k++) {
+        uint64_t best = UINT64_MAX;
+        for (int rep = 0; rep < 20; rep++) {
+            uint64_t t0 = now_ns();
+            for (int i = 0; i < 100; i++)
+                prims[k].fn(i);
+            uint64_t dt = (now_ns() - t0) / 100;
+            if (dt < best) best = dt;
+        }
+        printf("%-10s %12llu  %s\n", prims[k].name,
+               (unsigned long long)best, prims[k].desc);
+    }
+}
+
+/*==========================================================================
+ * Driver
+ *=========================================================================*/
+
+static bench_stats_t run_child(const scenario_t *s, bench_mode_t m) {
+    bench_stats_t out;
+    int fd[2];
+    if (pipe(fd) != 0) { perror("pipe"); exit(1); }
+    fflush(NULL);
+
+    pid_t pid = fork();
+    if (pid < 0) { perror("fork"); exit(1); }
+    if (pid == 0) {
+        close(fd[0]);
+        mode = m;
+        s->fn();
+        if (dump_dir && m == MODE_TIME) dump_ppm(s->name);
+        if (m == MODE_TIME) stats.stale = stale_bytes();
+        if (write(fd[1], &stats, sizeof(stats)) != sizeof(stats)) _exit(1);
+        _exit(0);
+    }
+
+    close(fd[1]);
+    int status = 0;
+    ssize_t r = read(fd[0], &out, sizeof(out));
+    close(fd[0]);
+    waitpid(pid, &status, 0);
+    if (r != sizeof(out) || !WIFEXITED(status) || WEXITSTATUS(status)) {
+        fprintf(stderr, "wmbench: scenario '%s' failed\n", s->name);
+        exit(1);
+    }
+    return out;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr, "usage: %s [-n terminals] [-d dir] [-k] [-v] [scenario...]\n\n", argv0);
+    for (int i = 0; i < N_SCENARIOS; i++)
+        fprintf(stderr, "  %-10s %s\n", scenarios[i].name, scenarios[i].desc);
+    fprintf(stderr, "\n  -k         time the drawing primitives instead\n");
+}
+
+int main(int argc, char **argv) {
+    int opt;
+    bool kernels = false;
+    while ((opt = getopt(argc, argv, "n:d:kvh")) != -1) {
+        switch (opt) {
+        case 'n':
+            n_terms = atoi(optarg);
+            if (n_terms < 1) n_terms = 1;
+            if (n_terms > WM_MAX_WINDOWS - 2) n_terms = WM_MAX_WINDOWS - 2;
+            break;
+        case 'd':
+            dump_dir = optarg;
+            break;
+        case 'k':
+            kernels = true;
+            break;
+        case 'v':
+            verbose = true;
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+
+    boot();
+
+    if (kernels) {
+        run_prims();
+        return 0;
+    }
+
+    printf("%-10s %6s %12s %12s %10s %10s %10s %7s %6s\n",
+           "scenario", "frames",
+#ifdef HAVE_TSC
+           "avg cyc", "max cyc",
+#else
+           "avg ns", "max ns",
+#endif
+           "avg us", "avg bytes", "max bytes", "vsyncs", "stale");
+
+    for (int i = 0; i < N_SCENARIOS; i++) {
+        const scenario_t *s = &scenarios[i];
+        if (optind < argc) {
+            bool want = false;
+            for (int a = optind; a < argc; a++)
+                if (strcmp(argv[a], s->name) == 0) want = true;
+            if (!want) continue;
+        }
+
+        bench_stats_t t = run_child(s, MODE_TIME);
+        bench_stats_t b = run_child(s, MODE_BYTES);
+        uint32_t f = t.frames ? t.frames : 1;
+
+        printf("%-10s %6u %12llu %12llu %10.1f %10llu %10llu %7u %6u\n",
+               s->name, t.frames,
+               (unsigned long long)(t.cyc_total / f),
+               (unsigned long long)t.cyc_max,
+               (double)t.ns_total / f / 1000.0,
+               (unsigned long long)(b.bytes_total / (b.frames ? b.frames : 1)),
+               (unsigned long long)b.bytes_max,
+               t.vsyncs, t.stale);
+    }
+    return 0;
+}